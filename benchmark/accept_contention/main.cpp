@@ -0,0 +1,158 @@
+#include <uringpp/uringpp.h>
+
+#include <benchmark.h>
+#include <loopback.h>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <thread>
+
+// Accept rate of several rings accepting from the same listening socket while
+// client threads connect and disconnect as fast as they can.
+//
+// The fd variant accepts into the process file descriptor table and closes with
+// close(2), all threads contend on the fd table lock. The direct variant accepts
+// with a multishot accept into the registered file table of each ring and closes
+// with close_direct, the process fd table is not touched.
+
+struct AcceptOp : uringpp::op::Accept {
+};
+struct AcceptDirectOp : uringpp::op::AcceptDirect {
+};
+struct CloseDirectOp : uringpp::op::CloseDirect {
+};
+using Operations = uringpp::OperationSet<AcceptOp, AcceptDirectOp, CloseDirectOp>;
+using Ring = uringpp::Ring<void, uringpp::FastRingPolicy>;
+
+auto client(sockaddr_in address, const std::atomic<bool>& stop) -> void
+{
+    // Reset instead of close, so the client ports do not pile up in TIME_WAIT
+    const linger reset { 1, 0 };
+    while (!stop.load(std::memory_order_relaxed)) {
+        auto fd = socket(AF_INET, SOCK_STREAM, 0);
+        setsockopt(fd, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset));
+        connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        close(fd);
+    }
+}
+
+auto serveFd(int listenFd, std::atomic<std::uint64_t>& accepted) -> void
+{
+    Ring ring { 64 };
+    AcceptOp accept {};
+    accept.fd = listenFd;
+    ring.prepare_operation<Operations>(accept);
+    ring.submit();
+
+    while (true) {
+        auto completion = ring.wait();
+        auto result = AcceptOp::result(completion.get());
+        ring.seen(completion);
+        if (!result.ok()) {
+            // The listening socket was shut down
+            return;
+        }
+
+        close(result.value());
+        accepted.fetch_add(1, std::memory_order_relaxed);
+        ring.prepare_operation<Operations>(accept);
+        ring.submit();
+    }
+}
+
+auto serveDirect(int listenFd, std::atomic<std::uint64_t>& accepted) -> void
+{
+    Ring ring { 64 };
+    ring.register_files_sparse(1024);
+
+    AcceptDirectOp accept {};
+    accept.fd = listenFd;
+    accept.multishot = true;
+    ring.prepare_operation<Operations>(accept);
+    ring.submit();
+
+    std::vector<CloseDirectOp> closes(1024);
+    auto handler = uringpp::Overloaded {
+        [&](AcceptDirectOp&, AcceptDirectOp::result_type result) {
+            if (!result.ok() && result.error() != ENFILE) {
+                // The listening socket was shut down
+                return false;
+            }
+            if (!result.has_more()) {
+                ring.prepare_operation<Operations>(accept);
+            }
+            if (!result.ok()) {
+                // All slots wait for their close_direct
+                return true;
+            }
+
+            auto& close = closes[result.value()];
+            close.fileIndex = result.value();
+            ring.prepare_operation<Operations>(close);
+            accepted.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        },
+        [](CloseDirectOp&, CloseDirectOp::result_type) { return true; },
+        [](AcceptOp&, AcceptOp::result_type) { return true; }
+    };
+
+    while (true) {
+        auto completion = ring.wait();
+        bool running = true;
+        Operations::dispatch(completion.get(), [&](auto& op, auto result) {
+            running = handler(op, result);
+        });
+        ring.seen(completion);
+        if (!running) {
+            return;
+        }
+        ring.submit();
+    }
+}
+
+template <class Serve>
+auto run(const std::string& name, Serve serve, std::size_t servers, std::size_t clients, double seconds)
+    -> void
+{
+    const auto listenFd = bench::listenOnLoopback();
+    const auto address = bench::addressOf(listenFd);
+
+    std::atomic<std::uint64_t> accepted { 0 };
+    std::atomic<bool> stop { false };
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < servers; i++) {
+        threads.emplace_back([&] { serve(listenFd, accepted); });
+    }
+    for (std::size_t i = 0; i < clients; i++) {
+        threads.emplace_back([&] { client(address, stop); });
+    }
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    const auto total = accepted.load();
+    stop = true;
+
+    // Fails the armed accepts, so the servers return
+    shutdown(listenFd, SHUT_RDWR);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    close(listenFd);
+
+    bench::report(name + " accepts", total / seconds, "accepts/s");
+}
+
+int main(int argc, char** argv)
+{
+    const std::size_t servers = argc > 1 ? std::stoul(argv[1]) : 4;
+    const std::size_t clients = argc > 2 ? std::stoul(argv[2]) : 8;
+    const double seconds = argc > 3 ? std::stod(argv[3]) : 5.0;
+
+    run("fd accept", serveFd, servers, clients, seconds);
+    run("direct accept", serveDirect, servers, clients, seconds);
+
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include <uringpp/uringpp.h>
+
+#include <benchmark.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Durable appends of small records to a write ahead log. A number of clients
+// each append a record and append the next one once the previous is durable.
+// Compares a blocking pwrite + fdatasync per append with the group commit of
+// AsyncAppendLog. Reports appends/s and the commit latency from append to
+// durability.
+//
+// Usage: append_log_benchmark [SECONDS] [FILE]
+
+constexpr std::size_t recordSize = 128;
+constexpr std::size_t clients = 64;
+
+auto syncPerAppend(const std::filesystem::path& file, double seconds) -> void
+{
+    auto fd = open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    std::vector<std::uint8_t> record(recordSize, 'x');
+    std::vector<double> latencies;
+    std::uint64_t offset = 0;
+
+    bench::Stopwatch stopwatch;
+    while (stopwatch.seconds() < seconds) {
+        bench::Stopwatch commit;
+        if (pwrite(fd, record.data(), record.size(), offset) < 0 || fdatasync(fd) < 0) {
+            throw std::runtime_error("failed to append");
+        }
+        offset += record.size();
+        latencies.push_back(commit.elapsed().count());
+    }
+
+    bench::report("pwrite + fdatasync", latencies.size() / stopwatch.seconds(), "appends/s");
+    bench::reportLatency("pwrite + fdatasync commit", latencies);
+    close(fd);
+}
+
+auto groupCommit(
+    const std::string& name,
+    const std::filesystem::path& file,
+    double seconds,
+    uringpp::AppendLogOptions options) -> void
+{
+    std::filesystem::remove(file);
+    uringpp::AsyncAppendLog log(file, options);
+    std::vector<std::uint8_t> record(recordSize, 'x');
+    std::vector<double> latencies;
+    bool running = true;
+
+    std::function<void()> append = [&] {
+        const auto start = bench::Clock::now();
+        log.append(record, [&, start](int error) {
+            if (error) {
+                throw std::runtime_error("failed to append");
+            }
+            latencies.push_back((bench::Clock::now() - start).count());
+            if (running) {
+                append();
+            }
+        });
+    };
+
+    bench::Stopwatch stopwatch;
+    for (std::size_t client = 0; client < clients; client++) {
+        append();
+    }
+    while (stopwatch.seconds() < seconds) {
+        log.wait();
+    }
+    const auto elapsed = stopwatch.seconds();
+    const auto appends = latencies.size();
+    running = false;
+    log.flush();
+
+    bench::report(name, appends / elapsed, "appends/s");
+    bench::report(
+        name + " per sync", double(latencies.size()) / log.groups_committed(), "appends");
+    bench::reportLatency(name + " commit", latencies);
+}
+
+int main(int argc, char** argv)
+{
+    const double seconds = argc > 1 ? std::stod(argv[1]) : 5.0;
+    const std::filesystem::path file = argc > 2 ? argv[2] : "uringpp_append_log_benchmark.log";
+
+    syncPerAppend(file, seconds);
+    groupCommit("group commit 1 in flight", file, seconds, { .maxGroupsInFlight = 1 });
+    groupCommit("group commit 2 in flight", file, seconds, { .maxGroupsInFlight = 2 });
+    groupCommit(
+        "group commit sync_file_range",
+        file,
+        seconds,
+        { .durability = uringpp::Durability::SyncFileRange, .maxGroupsInFlight = 2 });
+
+    std::filesystem::remove(file);
+    return 0;
+}
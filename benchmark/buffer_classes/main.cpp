@@ -0,0 +1,141 @@
+#include <uringpp/uringpp.h>
+
+#include <benchmark.h>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <array>
+
+// Echo style receive path over socket pairs with a mix of small and large
+// messages. Compares a single group of 1 KiB buffers like the echo examples
+// used to against size classes selected per socket. Reports receives per
+// message and the memory provided to the kernel.
+
+struct RecvOp : uringpp::op::RecvBp {
+    std::size_t sizeClass;
+};
+
+using ProvideBuffersOp = uringpp::BufferPoolManager::ProvideBuffersOp;
+using Operations = uringpp::OperationSet<RecvOp, ProvideBuffersOp>;
+using Ring = uringpp::Ring<void, uringpp::FastRingPolicy>;
+
+struct Socket {
+    std::array<int, 2> fds;
+    std::size_t messageSize;
+    uringpp::SizeClassSelector sizeClass;
+};
+
+auto drain(Ring& ring) -> void
+{
+    while (auto completion = ring.peek()) {
+        ring.seen(*completion);
+    }
+}
+
+auto run(
+    const std::string& name,
+    std::vector<uringpp::SizeClass> sizeClasses,
+    std::vector<Socket>& sockets,
+    std::size_t rounds) -> void
+{
+    Ring ring { 64 };
+    uringpp::BufferPoolManager buffers(std::move(sizeClasses));
+    buffers.provide<Operations>(ring);
+    ring.submit();
+    for (std::size_t i = 0; i < buffers.size_classes(); i++) {
+        ring.seen(ring.wait());
+    }
+
+    std::vector<std::uint8_t> message(64 * 1024, 'x');
+    std::uint64_t receives = 0;
+    std::uint64_t messages = 0;
+    RecvOp recv {};
+
+    bench::Stopwatch stopwatch;
+    for (std::size_t round = 0; round < rounds; round++) {
+        for (auto& socket : sockets) {
+            if (write(socket.fds[1], message.data(), socket.messageSize)
+                != static_cast<ssize_t>(socket.messageSize)) {
+                throw std::runtime_error("failed to write message");
+            }
+
+            for (std::size_t received = 0; received < socket.messageSize;) {
+                recv.fd = socket.fds[0];
+                recv.sizeClass = buffers.size_class_for(socket.sizeClass);
+                recv.bufferPool = &buffers.pool(recv.sizeClass);
+                ring.prepare_operation<Operations>(recv);
+                ring.submit();
+
+                auto completion = ring.wait();
+                auto result = RecvOp::result(completion.get());
+                ring.seen(completion);
+
+                if (result.error() == ENOBUFS) {
+                    buffers.grow<Operations>(ring, recv.sizeClass);
+                    ring.submit();
+                    auto provided = ring.wait();
+                    Operations::dispatch(
+                        provided.get(),
+                        uringpp::Overloaded {
+                            [](RecvOp&, RecvOp::result_type) {},
+                            [&](ProvideBuffersOp& provide, ProvideBuffersOp::result_type) {
+                                buffers.provided(provide);
+                            } });
+                    ring.seen(provided);
+                    continue;
+                }
+
+                const auto bufferSize = buffers.buffer_size(recv.sizeClass);
+                buffers.acquired(recv.sizeClass, result.value());
+                socket.sizeClass.observe(result.value(), result.value() == bufferSize);
+                buffers.release<Operations>(ring, recv.sizeClass, result.buffer_idx());
+                ring.submit();
+                drain(ring);
+
+                received += result.value();
+                receives++;
+            }
+            messages++;
+        }
+    }
+    const auto seconds = stopwatch.seconds();
+
+    std::size_t providedBytes = 0;
+    for (const auto& usage : buffers.usage()) {
+        providedBytes += usage.buffers * usage.bufferSize;
+    }
+
+    bench::report(name + " receives per message", static_cast<double>(receives) / messages, "");
+    bench::report(name + " messages", messages / seconds, "msg/s");
+    bench::report(name + " provided memory", providedBytes / 1024.0, "KiB");
+    buffers.report(std::cout);
+}
+
+int main(int argc, char** argv)
+{
+    const std::size_t rounds = argc > 1 ? std::stoul(argv[1]) : 10000;
+
+    // Mostly small request/response traffic and a few bulk transfers
+    std::vector<Socket> sockets;
+    for (std::size_t messageSize : { 64, 64, 64, 64, 200, 200, 2048, 32768 }) {
+        auto& socket = sockets.emplace_back();
+        socket.messageSize = messageSize;
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, socket.fds.data()) < 0) {
+            throw std::runtime_error("failed to create socket pair");
+        }
+    }
+
+    run("fixed 1 KiB", { { 1024, 64 } }, sockets, rounds);
+
+    for (auto& socket : sockets) {
+        socket.sizeClass = {};
+    }
+    run("size classes", { { 256, 16 }, { 4 * 1024, 4 }, { 64 * 1024, 1 } }, sockets, rounds);
+
+    for (auto& socket : sockets) {
+        close(socket.fds[0]);
+        close(socket.fds[1]);
+    }
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include <uringpp/uringpp.h>
+
+#include <benchmark.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+// Startup loading of many small files. A directory of files of 200 B to 8 KiB is
+// loaded with a sequential std::ifstream loop and with load_all, which keeps
+// batches of linked open, statx, read and close chains in flight. Before each
+// run the page cache of the files is dropped with POSIX_FADV_DONTNEED, so the
+// contents come from the device as on a cold start. The directory entries stay
+// cached.
+//
+// Usage: bulk_load_benchmark [FILES] [DIRECTORY]
+
+auto createFiles(const std::filesystem::path& directory, std::size_t count)
+    -> std::vector<std::filesystem::path>
+{
+    std::filesystem::create_directories(directory);
+    std::mt19937 random(42);
+    std::uniform_int_distribution<std::size_t> sizes(200, 8192);
+
+    std::vector<std::filesystem::path> paths;
+    for (std::size_t i = 0; i < count; i++) {
+        auto path = directory / ("file" + std::to_string(i) + ".conf");
+        if (!std::filesystem::exists(path)) {
+            std::ofstream(path, std::ios::binary) << std::string(sizes(random), 'x');
+        }
+        paths.push_back(std::move(path));
+    }
+    return paths;
+}
+
+auto dropCaches(const std::vector<std::filesystem::path>& paths) -> void
+{
+    for (const auto& path : paths) {
+        const auto fd = ::open(path.c_str(), O_RDONLY);
+        if (fd >= 0) {
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            ::close(fd);
+        }
+    }
+}
+
+template <class Load>
+auto measure(const std::string& name, const std::vector<std::filesystem::path>& paths, Load&& load)
+    -> void
+{
+    dropCaches(paths);
+    bench::Stopwatch stopwatch;
+    const auto bytes = load();
+    const auto seconds = stopwatch.seconds();
+
+    bench::report(name + " time", seconds * 1e3, "ms");
+    bench::report(name + " files", paths.size() / seconds / 1e3, "k/s");
+    bench::report(name + " throughput", bytes / seconds / 1e6, "MB/s");
+}
+
+int main(int argc, char** argv)
+{
+    const std::size_t count = argc > 1 ? std::stoul(argv[1]) : 50'000;
+    const std::filesystem::path directory = argc > 2
+        ? std::filesystem::path(argv[2])
+        : std::filesystem::temp_directory_path() / "uringpp_bulk_load";
+    const auto paths = createFiles(directory, count);
+
+    measure("ifstream", paths, [&] {
+        std::vector<std::string> contents;
+        std::size_t bytes = 0;
+        for (const auto& path : paths) {
+            std::ifstream file(path, std::ios::binary);
+            contents.emplace_back(
+                std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            bytes += contents.back().size();
+        }
+        return bytes;
+    });
+
+    for (std::size_t batchSize : { 32, 256, 1024 }) {
+        measure("load_all batch " + std::to_string(batchSize), paths, [&] {
+            const auto files = uringpp::load_all(paths, { .batchSize = batchSize });
+            return files.bytes();
+        });
+    }
+
+    if (argc <= 2) {
+        std::filesystem::remove_all(directory);
+    }
+    return 0;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+using Clock = std::chrono::steady_clock;
+
+class Stopwatch {
+  public:
+    Stopwatch()
+        : m_start(Clock::now())
+    {
+    }
+
+    auto restart() -> void
+    {
+        m_start = Clock::now();
+    }
+
+    auto elapsed() const -> std::chrono::nanoseconds
+    {
+        return Clock::now() - m_start;
+    }
+
+    auto seconds() const -> double
+    {
+        return std::chrono::duration<double>(elapsed()).count();
+    }
+
+  private:
+    Clock::time_point m_start;
+};
+
+/*
+ * Prevents the compiler from optimizing away the computation of value
+ */
+template <class T> inline auto doNotOptimize(const T& value) -> void
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/*
+ * Returns the p-th percentile (0 <= p <= 100) of the samples
+ */
+inline auto percentile(std::vector<double> samples, double p) -> double
+{
+    if (samples.empty()) {
+        return 0;
+    }
+
+    const auto rank = static_cast<std::size_t>(p / 100.0 * (samples.size() - 1));
+    std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+    return samples[rank];
+}
+
+inline auto report(const std::string& name, double value, const std::string& unit) -> void
+{
+    std::cout << std::left << std::setw(48) << name << std::right << std::setw(14) << std::fixed
+              << std::setprecision(2) << value << " " << unit << std::endl;
+}
+
+inline auto reportLatency(const std::string& name, const std::vector<double>& samplesNs) -> void
+{
+    report(name + " p50", percentile(samplesNs, 50), "ns");
+    report(name + " p99", percentile(samplesNs, 99), "ns");
+    report(name + " p99.9", percentile(samplesNs, 99.9), "ns");
+}
+
+/*
+ * Returns the resident set size of the process in bytes
+ */
+inline auto residentSetSize() -> std::size_t
+{
+    std::ifstream statm("/proc/self/statm");
+    std::size_t pages = 0;
+    std::size_t residentPages = 0;
+    statm >> pages >> residentPages;
+    return residentPages * 4096;
+}
+
+} // namespace bench
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <cstdint>
+#include <stdexcept>
+
+namespace bench {
+
+inline auto loopback(std::uint16_t port) -> sockaddr_in
+{
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    return address;
+}
+
+/*
+ * Returns a socket listening on an ephemeral loopback port, see addressOf()
+ */
+inline auto listenOnLoopback() -> int
+{
+    auto fd = socket(AF_INET, SOCK_STREAM, 0);
+    auto address = loopback(0);
+    if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0
+        || listen(fd, 4096) < 0) {
+        throw std::runtime_error("failed to listen on loopback");
+    }
+    return fd;
+}
+
+inline auto addressOf(int fd) -> sockaddr_in
+{
+    sockaddr_in address {};
+    socklen_t length = sizeof(address);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length);
+    return address;
+}
+
+} // namespace bench
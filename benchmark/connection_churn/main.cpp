@@ -0,0 +1,119 @@
+#include <uringpp/uringpp.h>
+
+#include <benchmark.h>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <array>
+#include <map>
+#include <memory>
+#include <unordered_map>
+
+// Opens and closes connections on real socket file descriptors and tracks the
+// per-connection state either in a ConnectionTable or in a map of heap allocated
+// state like the echo examples used to. Reports open+close latency of the state
+// bookkeeping and the resident set size while churning.
+
+struct Connection {
+    uringpp::op::RecvBp recv;
+    uringpp::op::Send send;
+    std::uint64_t bytes = 0;
+};
+
+template <class Store>
+auto churn(const std::string& name, Store& store, std::size_t numberOfConnections) -> void
+{
+    std::vector<double> latencies;
+    latencies.reserve(numberOfConnections);
+    const auto rssBefore = bench::residentSetSize();
+    std::size_t rssMax = rssBefore;
+
+    for (std::size_t i = 0; i < numberOfConnections; i++) {
+        std::array<int, 2> fds;
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds.data()) < 0) {
+            throw std::runtime_error("failed to create socket pair");
+        }
+
+        bench::Stopwatch stopwatch;
+        store.open(fds[0]);
+        store.use(fds[0]);
+        store.close(fds[0]);
+        latencies.push_back(static_cast<double>(stopwatch.elapsed().count()));
+
+        close(fds[0]);
+        close(fds[1]);
+
+        if (i % 100000 == 0) {
+            rssMax = std::max(rssMax, bench::residentSetSize());
+        }
+    }
+
+    bench::reportLatency(name + " open+close", latencies);
+    bench::report(name + " rss growth", (rssMax - rssBefore) / 1024.0, "KiB");
+}
+
+struct TableStore {
+    explicit TableStore(std::size_t capacity)
+        : connections(capacity)
+    {
+    }
+
+    auto open(int fd) -> void
+    {
+        connections.open(fd);
+    }
+
+    auto use(int fd) -> void
+    {
+        auto& connection = connections.at(fd);
+        connections.acquire(fd);
+        connection.bytes++;
+        bench::doNotOptimize(connection);
+        connections.release(fd);
+    }
+
+    auto close(int fd) -> void
+    {
+        connections.close(fd);
+    }
+
+    uringpp::ConnectionTable<Connection> connections;
+};
+
+struct MapStore {
+    auto open(int fd) -> void
+    {
+        connections.emplace(fd, std::make_shared<Connection>());
+    }
+
+    auto use(int fd) -> void
+    {
+        // Each operation used to allocate its own user data
+        auto op = std::make_shared<Connection>();
+        auto& connection = *connections.at(fd);
+        connection.bytes++;
+        bench::doNotOptimize(connection);
+        bench::doNotOptimize(op);
+    }
+
+    auto close(int fd) -> void
+    {
+        connections.erase(fd);
+    }
+
+    std::unordered_map<int, std::shared_ptr<Connection>> connections;
+};
+
+int main(int argc, char** argv)
+{
+    const std::size_t numberOfConnections = argc > 1 ? std::stoul(argv[1]) : 1000000;
+
+    TableStore table(4096);
+    churn("connection table", table, numberOfConnections);
+
+    MapStore map;
+    churn("map of shared_ptr", map, numberOfConnections);
+
+    return 0;
+}
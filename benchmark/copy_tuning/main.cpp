@@ -0,0 +1,65 @@
+#include <uringpp/uringpp.h>
+
+#include <benchmark.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Copy throughput of fixed queue depth and block size configurations versus the
+// auto tuned configuration. The best configuration depends on the filesystem, so
+// the benchmark takes the directory to copy in, by default tmpfs.
+//
+// Usage: copy_tuning_benchmark [SIZE_MB] [DIRECTORY]
+
+auto writeFile(const std::filesystem::path& file, std::size_t size) -> void
+{
+    std::ofstream stream(file, std::ios::binary);
+    std::vector<char> block(1024 * 1024, 'x');
+    for (std::size_t written = 0; written < size; written += block.size()) {
+        stream.write(block.data(), block.size());
+    }
+}
+
+auto run(
+    const std::string& name,
+    const std::filesystem::path& input,
+    const std::filesystem::path& output,
+    uringpp::CopyOptions options) -> void
+{
+    uringpp::CopyEngine copyEngine(options);
+
+    bench::Stopwatch stopwatch;
+    const auto copied = copyEngine.copy(input, output);
+    bench::report(name, copied / stopwatch.seconds() / 1e9, "GB/s");
+
+    if (options.autoTune) {
+        bench::report(name + " probes", copyEngine.probes().size(), "");
+        bench::report(name + " queue depth", copyEngine.options().queueDepth, "");
+        bench::report(name + " block size", copyEngine.options().blockSize / 1024.0, "KiB");
+
+        // The tuned configuration on a second copy, without the probes
+        stopwatch.restart();
+        copyEngine.copy(input, output);
+        bench::report(name + " second copy", copied / stopwatch.seconds() / 1e9, "GB/s");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const std::size_t size = (argc > 1 ? std::stoul(argv[1]) : 1024) * 1024 * 1024;
+    const std::filesystem::path directory = argc > 2 ? argv[2] : "/dev/shm";
+    const auto input = directory / "uringpp_copy_tuning_input";
+    const auto output = directory / "uringpp_copy_tuning_output";
+    writeFile(input, size);
+
+    run("fixed 1 x 4 KiB", input, output, { .queueDepth = 1, .blockSize = 4 * 1024 });
+    run("fixed 64 x 32 KiB", input, output, { .queueDepth = 64, .blockSize = 32 * 1024 });
+    run("fixed 16 x 1 MiB", input, output, { .queueDepth = 16, .blockSize = 1024 * 1024 });
+    run("auto tuned", input, output, { .autoTune = true });
+
+    std::filesystem::remove(input);
+    std::filesystem::remove(output);
+    return 0;
+}
@@ -0,0 +1,209 @@
+#include <uringpp/uringpp.h>
+
+#include <benchmark.h>
+
+#include <deque>
+#include <iostream>
+#include <map>
+#include <random>
+#include <vector>
+
+// Compares the completion dispatch of the examples (runtime CompletionType enum
+// stored in a heap allocated user data object) with the typed OperationSet dispatch.
+
+enum class CompletionType : std::uint8_t { Read = 0, Write = 1, Accept = 2, Recv = 3 };
+
+struct Data {
+    Data(CompletionType type)
+        : type(type)
+    {
+    }
+    CompletionType type;
+    std::int64_t value = 0;
+};
+
+struct ReadOp : uringpp::op::Read {
+    std::int64_t value = 0;
+};
+struct WriteOp : uringpp::op::Write {
+    std::int64_t value = 0;
+};
+struct AcceptOp : uringpp::op::Accept {
+    std::int64_t value = 0;
+};
+struct RecvOp : uringpp::op::Recv {
+    std::int64_t value = 0;
+};
+
+using Operations = uringpp::OperationSet<ReadOp, WriteOp, AcceptOp, RecvOp>;
+
+struct Counters {
+    std::int64_t read = 0;
+    std::int64_t write = 0;
+    std::int64_t accept = 0;
+    std::int64_t recv = 0;
+};
+
+auto enumDispatch(const io_uring_cqe& cqe, Counters& counters) -> void
+{
+    auto data = reinterpret_cast<Data*>(cqe.user_data);
+    switch (data->type) {
+    case CompletionType::Read:
+        counters.read += cqe.res + data->value;
+        break;
+    case CompletionType::Write:
+        counters.write += cqe.res + data->value;
+        break;
+    case CompletionType::Accept:
+        counters.accept += cqe.res + data->value;
+        break;
+    case CompletionType::Recv:
+        counters.recv += cqe.res + data->value;
+        break;
+    }
+}
+
+auto typedDispatch(const io_uring_cqe& cqe, Counters& counters) -> void
+{
+    Operations::dispatch(
+        &cqe,
+        uringpp::Overloaded {
+            [&](ReadOp& op, ReadOp::result_type r) { counters.read += r.value() + op.value; },
+            [&](WriteOp& op, WriteOp::result_type r) { counters.write += r.value() + op.value; },
+            [&](AcceptOp& op, AcceptOp::result_type r) { counters.accept += r.value() + op.value; },
+            [&](RecvOp& op, RecvOp::result_type r) { counters.recv += r.value() + op.value; } });
+}
+
+/*
+ * Dispatches synthetic completion queue entries of a random operation mix
+ * to isolate the dispatch cost from the cost of the system calls.
+ */
+auto benchmarkSyntheticDispatch(std::size_t numberOfCompletions, std::size_t rounds) -> void
+{
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> type(0, 3);
+
+    std::vector<std::shared_ptr<Data>> data;
+    std::deque<ReadOp> reads;
+    std::deque<WriteOp> writes;
+    std::deque<AcceptOp> accepts;
+    std::deque<RecvOp> recvs;
+    std::vector<io_uring_cqe> enumCqes(numberOfCompletions);
+    std::vector<io_uring_cqe> typedCqes(numberOfCompletions);
+
+    for (std::size_t i = 0; i < numberOfCompletions; i++) {
+        const auto t = type(random);
+        data.push_back(std::make_shared<Data>(static_cast<CompletionType>(t)));
+        enumCqes[i].user_data = reinterpret_cast<std::uint64_t>(data.back().get());
+        enumCqes[i].res = static_cast<std::int32_t>(i & 0xff);
+
+        switch (t) {
+        case 0:
+            typedCqes[i].user_data = Operations::encode(reads.emplace_back());
+            break;
+        case 1:
+            typedCqes[i].user_data = Operations::encode(writes.emplace_back());
+            break;
+        case 2:
+            typedCqes[i].user_data = Operations::encode(accepts.emplace_back());
+            break;
+        default:
+            typedCqes[i].user_data = Operations::encode(recvs.emplace_back());
+            break;
+        }
+        typedCqes[i].res = enumCqes[i].res;
+    }
+
+    Counters enumCounters;
+    bench::Stopwatch stopwatch;
+    for (std::size_t round = 0; round < rounds; round++) {
+        for (const auto& cqe : enumCqes) {
+            enumDispatch(cqe, enumCounters);
+        }
+    }
+    const auto enumNs = stopwatch.elapsed().count();
+    bench::doNotOptimize(enumCounters);
+
+    Counters typedCounters;
+    stopwatch.restart();
+    for (std::size_t round = 0; round < rounds; round++) {
+        for (const auto& cqe : typedCqes) {
+            typedDispatch(cqe, typedCounters);
+        }
+    }
+    const auto typedNs = stopwatch.elapsed().count();
+    bench::doNotOptimize(typedCounters);
+
+    const auto total = static_cast<double>(numberOfCompletions * rounds);
+    bench::report("synthetic dispatch enum switch", enumNs / total, "ns/completion");
+    bench::report("synthetic dispatch OperationSet", typedNs / total, "ns/completion");
+}
+
+/*
+ * Runs nops through a ring. The enum style allocates and tracks a user data object
+ * per operation like the examples do, the typed style reuses embedded operations.
+ */
+auto benchmarkRingDispatch(std::size_t queueSize, std::size_t numberOfOperations) -> void
+{
+    {
+        uringpp::Ring<Data> ring { queueSize };
+        std::map<Data*, std::shared_ptr<Data>> userData;
+        std::int64_t completed = 0;
+        bench::Stopwatch stopwatch;
+        for (std::size_t done = 0; done < numberOfOperations; done += queueSize) {
+            while (ring.capacity()) {
+                auto data = std::make_shared<Data>(CompletionType::Read);
+                userData.emplace(data.get(), data);
+                ring.prepare_nop(data);
+            }
+            ring.submit();
+            while (ring.submittedQueueEntries()) {
+                auto completion = ring.wait();
+                switch (completion.userData()->type) {
+                case CompletionType::Read:
+                    completed++;
+                    break;
+                default:
+                    break;
+                }
+                userData.erase(completion.userData());
+                ring.seen(completion);
+            }
+        }
+        bench::report("ring nop enum switch", completed / stopwatch.seconds(), "ops/s");
+    }
+
+    {
+        struct NopOp : uringpp::op::Nop {
+        };
+        using NopOperations = uringpp::OperationSet<NopOp>;
+        uringpp::Ring<void> ring { queueSize };
+        std::vector<NopOp> nops(queueSize);
+        std::int64_t completed = 0;
+        bench::Stopwatch stopwatch;
+        for (std::size_t done = 0; done < numberOfOperations; done += queueSize) {
+            for (auto& nop : nops) {
+                ring.prepare_operation<NopOperations>(nop);
+            }
+            ring.submit();
+            while (ring.submittedQueueEntries()) {
+                auto completion = ring.wait();
+                NopOperations::dispatch(
+                    completion.get(), [&](NopOp&, NopOp::result_type) { completed++; });
+                ring.seen(completion);
+            }
+        }
+        bench::report("ring nop OperationSet", completed / stopwatch.seconds(), "ops/s");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const std::size_t numberOfCompletions = argc > 1 ? std::stoul(argv[1]) : 4096;
+    const std::size_t rounds = argc > 2 ? std::stoul(argv[2]) : 2000;
+
+    benchmarkSyntheticDispatch(numberOfCompletions, rounds);
+    benchmarkRingDispatch(64, 1000000);
+
+    return 0;
+}
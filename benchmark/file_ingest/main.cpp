@@ -0,0 +1,95 @@
+#include <uringpp/uringpp.h>
+
+#include <benchmark.h>
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+
+// Line ingestion throughput of a log file, by default on tmpfs so the storage
+// does not dominate. Compares std::ifstream/getline with an AsyncFileReader
+// feeding a LineSplitter at different read ahead depths.
+//
+// Usage: file_ingest_benchmark [SIZE_MB] [FILE]
+
+auto writeLogFile(const std::filesystem::path& file, std::size_t size) -> void
+{
+    std::ofstream stream(file, std::ios::binary);
+    std::mt19937 random(42);
+    std::string line;
+    std::size_t written = 0;
+    while (written < size) {
+        line.assign(20 + random() % 200, 'a' + random() % 26);
+        line.back() = '\n';
+        stream << line;
+        written += line.size();
+    }
+}
+
+struct Count {
+    std::size_t lines = 0;
+    std::size_t bytes = 0;
+};
+
+auto getline(const std::filesystem::path& file) -> Count
+{
+    std::ifstream stream(file, std::ios::binary);
+    std::string line;
+    Count count;
+    while (std::getline(stream, line)) {
+        count.lines++;
+        count.bytes += line.size() + 1;
+    }
+    return count;
+}
+
+auto asyncFileReader(const std::filesystem::path& file, uringpp::ReaderOptions options) -> Count
+{
+    uringpp::AsyncFileReader reader(file, options);
+    uringpp::LineSplitter splitter;
+    Count count;
+    auto onLine = [&](std::string_view line) {
+        count.lines++;
+        count.bytes += line.size() + 1;
+    };
+
+    while (auto chunk = reader.next()) {
+        splitter.feed(*chunk, onLine);
+    }
+    splitter.finish(onLine);
+    return count;
+}
+
+template <class Ingest> auto run(const std::string& name, std::size_t size, Ingest ingest) -> void
+{
+    bench::Stopwatch stopwatch;
+    const auto count = ingest();
+    const auto seconds = stopwatch.seconds();
+    bench::doNotOptimize(count);
+
+    if (count.bytes != size) {
+        throw std::runtime_error(name + " ingested " + std::to_string(count.bytes) + " bytes");
+    }
+    bench::report(name, size / seconds / 1e9, "GB/s");
+    bench::report(name + " lines", count.lines / seconds / 1e6, "M lines/s");
+}
+
+int main(int argc, char** argv)
+{
+    const std::size_t size = (argc > 1 ? std::stoul(argv[1]) : 1024) * 1024 * 1024;
+    const std::filesystem::path file = argc > 2 ? argv[2] : "/dev/shm/uringpp_file_ingest.log";
+
+    writeLogFile(file, size);
+    const auto fileSize = std::filesystem::file_size(file);
+
+    run("ifstream getline", fileSize, [&] { return getline(file); });
+    for (std::size_t readAhead : { 1, 4, 16 }) {
+        run("async reader read ahead " + std::to_string(readAhead), fileSize, [&] {
+            return asyncFileReader(file, { .readAhead = readAhead, .chunkSize = 256 * 1024 });
+        });
+    }
+
+    std::filesystem::remove(file);
+    return 0;
+}
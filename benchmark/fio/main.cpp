@@ -0,0 +1,454 @@
+#include <uringpp/uringpp.h>
+
+#include <benchmark.h>
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// fio style file I/O workloads on Ring.
+//
+//   fio [--directory D] [--runtime S] [JOB ...]
+//
+// A job is given as name:key=value,key=value,... with the keys
+//   rw          read, write, randread, randwrite, rw (sequential mix), randrw (default randread)
+//   rwmixread   percentage of reads of the mixes (default 50)
+//   bs          block size (default 4k)
+//   iodepth     operations in flight (default 32)
+//   nrfiles     number of files (default 1)
+//   size        size per file (default 256m)
+//   direct      1 opens the files with O_DIRECT
+//   fixedbufs   1 registers the buffers and uses read_fixed/write_fixed
+//   fixedfiles  1 registers the files and addresses them by index
+//   sqpoll      1 lets a kernel thread poll the submission queue
+//   runtime     seconds (default --runtime or 5)
+//
+// Without jobs a 4k random read job runs in each library mode. The results are
+// written as JSON to stdout in the layout of fio --output-format=json, with
+// IOPS, bandwidth and latency percentiles per direction of each job.
+
+using Clock = bench::Clock;
+
+struct ReadOp : uringpp::op::Read {
+    std::size_t slot;
+};
+
+struct WriteOp : uringpp::op::Write {
+    std::size_t slot;
+};
+
+struct ReadFixedOp : uringpp::op::ReadFixed {
+    std::size_t slot;
+};
+
+struct WriteFixedOp : uringpp::op::WriteFixed {
+    std::size_t slot;
+};
+
+using Operations = uringpp::OperationSet<ReadOp, WriteOp, ReadFixedOp, WriteFixedOp>;
+using Ring = uringpp::Ring<void>;
+
+struct Job {
+    std::string name;
+    std::string rw = "randread";
+    unsigned rwMixRead = 50;
+    std::size_t blockSize = 4096;
+    std::size_t ioDepth = 32;
+    std::size_t numberOfFiles = 1;
+    std::size_t fileSize = 256 << 20;
+    bool direct = false;
+    bool fixedBuffers = false;
+    bool fixedFiles = false;
+    bool sqPoll = false;
+    double runtime = 5;
+    // Given on the command line, reported in the options of the job
+    std::map<std::string, std::string> options;
+};
+
+struct DirectionStats {
+    std::uint64_t ios = 0;
+    std::uint64_t bytes = 0;
+    uringpp::LatencyHistogram latency;
+};
+
+struct JobResult {
+    DirectionStats read;
+    DirectionStats write;
+    double seconds = 0;
+    std::string error;
+};
+
+auto parseSize(const std::string& value) -> std::size_t
+{
+    std::size_t end = 0;
+    auto size = std::stoull(value, &end);
+    switch (end < value.size() ? std::tolower(value[end]) : 0) {
+    case 'k':
+        return size << 10;
+    case 'm':
+        return size << 20;
+    case 'g':
+        return size << 30;
+    default:
+        return size;
+    }
+}
+
+auto parseJob(const std::string& spec, double runtime) -> Job
+{
+    Job job;
+    job.runtime = runtime;
+    const auto colon = spec.find(':');
+    job.name = spec.substr(0, colon);
+
+    std::istringstream options(colon == std::string::npos ? "" : spec.substr(colon + 1));
+    for (std::string option; std::getline(options, option, ',');) {
+        const auto equals = option.find('=');
+        if (equals == std::string::npos) {
+            throw std::invalid_argument("option without value in job " + spec);
+        }
+        const auto key = option.substr(0, equals);
+        const auto value = option.substr(equals + 1);
+        job.options[key] = value;
+
+        if (key == "rw") {
+            job.rw = value;
+        } else if (key == "rwmixread") {
+            job.rwMixRead = std::stoul(value);
+        } else if (key == "bs") {
+            job.blockSize = parseSize(value);
+        } else if (key == "iodepth") {
+            job.ioDepth = std::stoul(value);
+        } else if (key == "nrfiles") {
+            job.numberOfFiles = std::stoul(value);
+        } else if (key == "size") {
+            job.fileSize = parseSize(value);
+        } else if (key == "direct") {
+            job.direct = value == "1";
+        } else if (key == "fixedbufs") {
+            job.fixedBuffers = value == "1";
+        } else if (key == "fixedfiles") {
+            job.fixedFiles = value == "1";
+        } else if (key == "sqpoll") {
+            job.sqPoll = value == "1";
+        } else if (key == "runtime") {
+            job.runtime = std::stod(value);
+        } else {
+            throw std::invalid_argument("unknown option " + key + " in job " + spec);
+        }
+    }
+
+    static const std::vector<std::string> patterns {
+        "read", "write", "randread", "randwrite", "rw", "randrw"
+    };
+    if (std::find(patterns.begin(), patterns.end(), job.rw) == patterns.end()) {
+        throw std::invalid_argument("unknown rw pattern " + job.rw);
+    }
+    if (!job.blockSize || !job.ioDepth || !job.numberOfFiles || job.fileSize < job.blockSize) {
+        throw std::invalid_argument(
+            "job " + job.name + " needs bs, iodepth, nrfiles >= 1 and size >= bs");
+    }
+    return job;
+}
+
+/*
+ * Creates the file with the given size, filled with data so reads hit allocated blocks
+ */
+auto layOutFile(const std::filesystem::path& path, std::size_t size) -> void
+{
+    if (std::filesystem::exists(path) && std::filesystem::file_size(path) >= size) {
+        return;
+    }
+
+    const auto fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("failed to create " + path.string() + ": " + strerror(errno));
+    }
+    std::vector<std::uint8_t> chunk(1 << 20);
+    std::mt19937_64 random { 42 };
+    for (auto& byte : chunk) {
+        byte = static_cast<std::uint8_t>(random());
+    }
+    for (std::size_t offset = 0; offset < size; offset += chunk.size()) {
+        const auto length = std::min(chunk.size(), size - offset);
+        if (pwrite(fd, chunk.data(), length, offset) != static_cast<ssize_t>(length)) {
+            close(fd);
+            throw std::runtime_error("failed to lay out " + path.string());
+        }
+    }
+    fsync(fd);
+    close(fd);
+}
+
+class JobRunner {
+  public:
+    JobRunner(const Job& job, const std::filesystem::path& directory)
+        : m_job(job)
+        , m_buffers(static_cast<std::uint8_t*>(
+              std::aligned_alloc(4096, job.ioDepth * alignedBlockSize())))
+        , m_slots(job.ioDepth)
+        , m_cursors(job.numberOfFiles, 0)
+        , m_random(std::random_device {}())
+        , m_ring(job.ioDepth, job.sqPoll ? IORING_SETUP_SQPOLL : 0)
+    {
+        if (!m_buffers) {
+            throw std::runtime_error("failed to allocate buffers");
+        }
+        std::memset(m_buffers.get(), 0x5a, job.ioDepth * alignedBlockSize());
+
+        for (std::size_t i = 0; i < job.numberOfFiles; i++) {
+            const auto path = directory / ("fio." + job.name + "." + std::to_string(i));
+            layOutFile(path, job.fileSize);
+            const auto fd = open(path.c_str(), O_RDWR | (job.direct ? O_DIRECT : 0));
+            if (fd < 0) {
+                throw std::runtime_error("failed to open " + path.string() + ": " + strerror(errno));
+            }
+            m_files.fds.push_back(fd);
+        }
+
+        if (job.fixedFiles) {
+            m_ring.register_files(m_files.fds);
+        }
+        if (job.fixedBuffers) {
+            std::vector<iovec> buffers(job.ioDepth);
+            for (std::size_t slot = 0; slot < job.ioDepth; slot++) {
+                buffers[slot] = { buffer(slot).data(), job.blockSize };
+            }
+            m_ring.register_buffers(buffers);
+        }
+    }
+
+    auto run() -> JobResult
+    {
+        JobResult result;
+        std::size_t inFlight = 0;
+        std::size_t completedSlot = 0;
+
+        auto handler = [&](auto& operation, auto ioResult) {
+            if (!ioResult.ok()) {
+                throw std::runtime_error(std::string("I/O failed: ") + strerror(ioResult.error()));
+            }
+            using Operation = std::remove_cvref_t<decltype(operation)>;
+            constexpr bool isRead
+                = std::is_same_v<Operation, ReadOp> || std::is_same_v<Operation, ReadFixedOp>;
+            auto& stats = isRead ? result.read : result.write;
+            stats.ios++;
+            stats.bytes += ioResult.value();
+            stats.latency.record((Clock::now() - m_slots[operation.slot].issued).count());
+            inFlight--;
+            completedSlot = operation.slot;
+        };
+
+        const auto start = Clock::now();
+        const auto end = start
+            + std::chrono::duration_cast<Clock::duration>(
+                             std::chrono::duration<double>(m_job.runtime));
+
+        for (std::size_t slot = 0; slot < m_job.ioDepth; slot++) {
+            issue(slot);
+            inFlight++;
+        }
+        m_ring.submit();
+
+        while (inFlight) {
+            auto completion = m_ring.wait();
+            Operations::dispatch(completion.get(), handler);
+            m_ring.seen(completion);
+
+            if (Clock::now() < end) {
+                issue(completedSlot);
+                inFlight++;
+            }
+
+            // Batch the submissions of the completions which are ready already
+            if (!m_ring.peek()) {
+                m_ring.submit();
+            }
+        }
+
+        result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        return result;
+    }
+
+  private:
+    struct Slot {
+        ReadOp read {};
+        WriteOp write {};
+        ReadFixedOp readFixed {};
+        WriteFixedOp writeFixed {};
+        Clock::time_point issued;
+    };
+
+    // Closes the files also if the constructor fails after opening some of them
+    struct Files {
+        ~Files()
+        {
+            for (auto fd : fds) {
+                close(fd);
+            }
+        }
+
+        std::vector<int> fds;
+    };
+
+    struct Free {
+        auto operator()(std::uint8_t* buffer) const -> void
+        {
+            std::free(buffer);
+        }
+    };
+
+    auto alignedBlockSize() const -> std::size_t
+    {
+        return (m_job.blockSize + 4095) / 4096 * 4096;
+    }
+
+    auto buffer(std::size_t slot) -> std::span<std::uint8_t>
+    {
+        return { m_buffers.get() + slot * alignedBlockSize(), m_job.blockSize };
+    }
+
+    auto issue(std::size_t index) -> void
+    {
+        const bool random = m_job.rw.starts_with("rand");
+        const bool read = m_job.rw == "read" || m_job.rw == "randread"
+            || ((m_job.rw == "rw" || m_job.rw == "randrw") && m_random() % 100 < m_job.rwMixRead);
+
+        const auto blocksPerFile = m_job.fileSize / m_job.blockSize;
+        std::size_t file;
+        std::uint64_t offset;
+        if (random) {
+            file = m_random() % m_files.fds.size();
+            offset = (m_random() % blocksPerFile) * m_job.blockSize;
+        } else {
+            file = m_nextFile;
+            m_nextFile = (m_nextFile + 1) % m_files.fds.size();
+            offset = m_cursors[file];
+            m_cursors[file] = (offset + m_job.blockSize) % (blocksPerFile * m_job.blockSize);
+        }
+        const int fd = m_job.fixedFiles ? static_cast<int>(file) : m_files.fds[file];
+
+        auto& slot = m_slots[index];
+        slot.issued = Clock::now();
+        auto prepare = [&](auto& operation) {
+            operation.fd = fd;
+            operation.fixedFile = m_job.fixedFiles;
+            operation.buffer = buffer(index);
+            operation.offset = offset;
+            operation.slot = index;
+            m_ring.prepare_operation<Operations>(operation);
+        };
+
+        if (m_job.fixedBuffers) {
+            slot.readFixed.bufferIndex = slot.writeFixed.bufferIndex = static_cast<int>(index);
+            read ? prepare(slot.readFixed) : prepare(slot.writeFixed);
+        } else {
+            read ? prepare(slot.read) : prepare(slot.write);
+        }
+    }
+
+    Job m_job;
+    std::unique_ptr<std::uint8_t[], Free> m_buffers;
+    std::vector<Slot> m_slots;
+    Files m_files;
+    std::vector<std::uint64_t> m_cursors;
+    std::size_t m_nextFile = 0;
+    std::mt19937_64 m_random;
+    // Declared last, so it is destroyed first and cancels the operations in flight
+    Ring m_ring;
+};
+
+auto writeDirection(std::ostream& out, const DirectionStats& stats, double seconds) -> void
+{
+    const auto& latency = stats.latency;
+    out << "{\"io_bytes\":" << stats.bytes << ",\"total_ios\":" << stats.ios
+        << ",\"bw_bytes\":" << static_cast<std::uint64_t>(stats.bytes / seconds)
+        << ",\"iops\":" << std::fixed << std::setprecision(2) << stats.ios / seconds
+        << ",\"lat_ns\":{\"min\":" << latency.min() << ",\"max\":" << latency.max()
+        << ",\"mean\":" << latency.mean() << ",\"percentile\":{";
+    const char* separator = "";
+    for (auto percentile : { 1.0, 10.0, 50.0, 90.0, 99.0, 99.9, 99.99 }) {
+        out << separator << "\"" << std::setprecision(6) << percentile
+            << "\":" << latency.percentile(percentile);
+        separator = ",";
+    }
+    out << "}}}";
+}
+
+auto writeJob(std::ostream& out, const Job& job, const JobResult& result) -> void
+{
+    out << "{\"jobname\":\"" << job.name << "\",\"job options\":{";
+    const char* separator = "";
+    for (const auto& [key, value] : job.options) {
+        out << separator << "\"" << key << "\":\"" << value << "\"";
+        separator = ",";
+    }
+    out << "}";
+    if (!result.error.empty()) {
+        out << ",\"error\":\"" << result.error << "\"}";
+        return;
+    }
+    out << ",\"job_runtime\":" << static_cast<std::uint64_t>(result.seconds * 1000) << ",\"read\":";
+    writeDirection(out, result.read, result.seconds);
+    out << ",\"write\":";
+    writeDirection(out, result.write, result.seconds);
+    out << "}";
+}
+
+int main(int argc, char** argv)
+{
+    std::filesystem::path directory = ".";
+    double runtime = 5;
+    std::vector<std::string> specs;
+    for (int i = 1; i < argc; i++) {
+        const std::string argument = argv[i];
+        if (argument == "--directory" && i + 1 < argc) {
+            directory = argv[++i];
+        } else if (argument == "--runtime" && i + 1 < argc) {
+            runtime = std::stod(argv[++i]);
+        } else {
+            specs.push_back(argument);
+        }
+    }
+
+    if (specs.empty()) {
+        specs = { "randread:rw=randread,bs=4k,iodepth=32",
+                  "randread-fixedbufs:rw=randread,bs=4k,iodepth=32,fixedbufs=1",
+                  "randread-fixedfiles:rw=randread,bs=4k,iodepth=32,fixedfiles=1",
+                  "randread-sqpoll:rw=randread,bs=4k,iodepth=32,sqpoll=1,fixedbufs=1,fixedfiles=1",
+                  "seqread:rw=read,bs=128k,iodepth=8",
+                  "randrw:rw=randrw,rwmixread=70,bs=4k,iodepth=32" };
+    }
+
+    std::vector<Job> jobs;
+    for (const auto& spec : specs) {
+        jobs.push_back(parseJob(spec, runtime));
+    }
+
+    std::cout << "{\"jobs\":[";
+    for (std::size_t i = 0; i < jobs.size(); i++) {
+        JobResult result;
+        try {
+            JobRunner runner(jobs[i], directory);
+            result = runner.run();
+        } catch (const std::exception& error) {
+            // e.g. O_DIRECT on tmpfs or SQPOLL without privileges, the other jobs still run
+            result.error = error.what();
+        }
+        std::cout << (i ? ",\n" : "\n");
+        writeJob(std::cout, jobs[i], result);
+    }
+    std::cout << "\n]}" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,176 @@
+#include <uringpp/uringpp.h>
+
+#include <benchmark.h>
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+// Frame decoding throughput over provided buffers for frame sizes from 16 bytes
+// to 64 KiB. The stream is copied into the 16 KiB buffers of a pool the way the
+// kernel receives into them, and decoded with a FrameDecoder, which copies only
+// the frames straddling buffers, versus appending every buffer to a contiguous
+// std::vector and parsing the frames from there.
+//
+// Usage: framing_benchmark [STREAM_MB]
+
+constexpr std::size_t bufferSize = 16 * 1024;
+
+auto lengthPrefixedStream(std::size_t frameSize, std::size_t size) -> std::vector<std::uint8_t>
+{
+    uringpp::LengthPrefixFraming framing;
+    std::vector<std::uint8_t> stream;
+    std::mt19937 random(42);
+    std::uint8_t prefix[8];
+    while (stream.size() < size) {
+        stream.insert(stream.end(), prefix, prefix + framing.encode(frameSize, prefix));
+        stream.resize(stream.size() + frameSize, static_cast<std::uint8_t>(random()));
+    }
+    return stream;
+}
+
+auto delimitedStream(std::size_t frameSize, std::size_t size) -> std::vector<std::uint8_t>
+{
+    std::vector<std::uint8_t> stream;
+    while (stream.size() < size) {
+        stream.resize(stream.size() + frameSize, 'x');
+        stream.push_back('\n');
+    }
+    return stream;
+}
+
+struct Count {
+    std::size_t frames = 0;
+    std::size_t bytes = 0;
+};
+
+/*
+ * Calls onBuffer(bufferId, data) for each buffer the stream was received into
+ */
+template <class OnBuffer>
+auto receive(BufferPool& pool, const std::vector<std::uint8_t>& stream, OnBuffer&& onBuffer)
+    -> void
+{
+    std::size_t bufferId = 0;
+    for (std::size_t offset = 0; offset < stream.size(); offset += bufferSize) {
+        const auto length = std::min(bufferSize, stream.size() - offset);
+        auto buffer = pool.at(bufferId);
+        std::memcpy(buffer.data(), stream.data() + offset, length);
+        onBuffer(bufferId, std::span<const std::uint8_t>(buffer.data(), length));
+        bufferId = (bufferId + 1) % pool.pool_size();
+    }
+}
+
+template <class Framing>
+auto frameDecoder(BufferPool& pool, const std::vector<std::uint8_t>& stream, Framing framing)
+    -> Count
+{
+    uringpp::FrameDecoder<Framing> decoder(framing);
+    Count count;
+    receive(pool, stream, [&](std::size_t bufferId, std::span<const std::uint8_t> data) {
+        decoder.feed(
+            bufferId,
+            data,
+            [&](std::span<const std::uint8_t> frame) {
+                bench::doNotOptimize(frame.data());
+                count.frames++;
+                count.bytes += frame.size();
+            },
+            [](std::size_t) {});
+    });
+    return count;
+}
+
+/*
+ * The usual approach: append everything to a vector, parse from its front and
+ * move the incomplete rest to the front after each buffer
+ */
+auto contiguousCopy(BufferPool& pool, const std::vector<std::uint8_t>& stream, bool delimited)
+    -> Count
+{
+    std::vector<std::uint8_t> received;
+    Count count;
+    receive(pool, stream, [&](std::size_t, std::span<const std::uint8_t> data) {
+        received.insert(received.end(), data.begin(), data.end());
+
+        std::size_t offset = 0;
+        while (true) {
+            std::size_t header = 0;
+            std::size_t payload = 0;
+            std::size_t trailer = 0;
+            if (delimited) {
+                const auto end = received.data() + received.size();
+                const auto newline = uringpp::findByte(received.data() + offset, end, '\n');
+                if (newline == end) {
+                    break;
+                }
+                payload = newline - received.data() - offset;
+                trailer = 1;
+            } else {
+                if (received.size() - offset < 4) {
+                    break;
+                }
+                header = 4;
+                for (std::size_t i = 0; i < 4; i++) {
+                    payload = (payload << 8) | received[offset + i];
+                }
+                if (received.size() - offset < header + payload) {
+                    break;
+                }
+            }
+            bench::doNotOptimize(received.data() + offset + header);
+            count.frames++;
+            count.bytes += payload;
+            offset += header + payload + trailer;
+        }
+        received.erase(received.begin(), received.begin() + offset);
+    });
+    return count;
+}
+
+template <class Run>
+auto measure(const std::string& name, std::size_t streamSize, Run&& run) -> void
+{
+    // Warm up, then take the best of three
+    run();
+    double best = 0;
+    Count count;
+    for (int i = 0; i < 3; i++) {
+        bench::Stopwatch stopwatch;
+        count = run();
+        best = std::max(best, streamSize / stopwatch.seconds());
+    }
+    bench::report(name, best / 1e9, "GB/s");
+    bench::report(name + " frames", best / streamSize * count.frames / 1e6, "M/s");
+}
+
+int main(int argc, char** argv)
+{
+    const std::size_t streamSize = (argc > 1 ? std::stoul(argv[1]) : 256) * 1024 * 1024;
+    BufferPool pool(64, bufferSize, 0);
+
+    for (std::size_t frameSize : { 16, 64, 256, 1024, 4096, 16384, 65536 }) {
+        const auto stream = lengthPrefixedStream(frameSize, streamSize);
+        const auto label = "length prefix " + std::to_string(frameSize) + " B";
+        measure(label + " contiguous copy", stream.size(), [&] {
+            return contiguousCopy(pool, stream, false);
+        });
+        measure(label + " frame decoder", stream.size(), [&] {
+            return frameDecoder(pool, stream, uringpp::LengthPrefixFraming {});
+        });
+    }
+
+    for (std::size_t frameSize : { 64, 1024, 16384 }) {
+        const auto stream = delimitedStream(frameSize, streamSize);
+        const auto label = "delimiter " + std::to_string(frameSize) + " B";
+        measure(label + " contiguous copy", stream.size(), [&] {
+            return contiguousCopy(pool, stream, true);
+        });
+        measure(label + " frame decoder", stream.size(), [&] {
+            return frameDecoder(pool, stream, uringpp::DelimiterFraming { '\n', 1024 * 1024 });
+        });
+    }
+
+    return 0;
+}
@@ -0,0 +1,182 @@
+#include <uringpp/uringpp.h>
+
+#include <benchmark.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Handoff latency between two threads which pass a token back and forth.
+//
+// The token is passed with a std::mutex and std::condition_variable, with
+// AsyncSemaphore blocking in the futex system call, and with AsyncSemaphore on
+// rings: each thread owns a ring, waits for the token with an op::FutexWait and
+// hands it over with an op::FutexWake, so it could complete I/O while it waits.
+// A handoff is half a round trip.
+//
+// Usage: futex_handoff_benchmark [ROUND_TRIPS]
+
+using Operations = uringpp::OperationSet<uringpp::op::FutexWait, uringpp::op::FutexWake>;
+
+/*
+ * Measures round trips of ping which is answered by the pong thread and reports
+ * the handoff latency
+ */
+template <class Ping, class Pong>
+auto measure(const std::string& name, std::size_t roundTrips, Ping&& ping, Pong&& pong) -> void
+{
+    std::thread peer([&] {
+        for (std::size_t i = 0; i < roundTrips; i++) {
+            pong();
+        }
+    });
+
+    std::vector<double> handoffs;
+    handoffs.reserve(roundTrips);
+    bench::Stopwatch total;
+    for (std::size_t i = 0; i < roundTrips; i++) {
+        bench::Stopwatch roundTrip;
+        ping();
+        handoffs.push_back(roundTrip.elapsed().count() / 2.0);
+    }
+    const auto seconds = total.seconds();
+    peer.join();
+
+    bench::report(name + " handoffs", 2 * roundTrips / seconds / 1e6, "M/s");
+    bench::reportLatency(name + " handoff", handoffs);
+}
+
+/*
+ * Token of a thread pair, passed with a condition variable
+ */
+class ConditionToken {
+  public:
+    auto give() -> void
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_available = true;
+        }
+        m_condition.notify_one();
+    }
+
+    auto take() -> void
+    {
+        std::unique_lock lock(m_mutex);
+        m_condition.wait(lock, [this] { return m_available; });
+        m_available = false;
+    }
+
+  private:
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_available = false;
+};
+
+/*
+ * Ring of one thread, which waits for tokens and hands them over through it
+ */
+class RingToken {
+  public:
+    RingToken()
+        : m_ring(8)
+    {
+    }
+
+    auto give(uringpp::AsyncSemaphore& semaphore) -> void
+    {
+        semaphore.release<Operations>(m_ring, m_wake);
+        m_ring.submit();
+    }
+
+    auto take(uringpp::AsyncSemaphore& semaphore) -> void
+    {
+        auto status = semaphore.acquire<Operations>(m_ring, m_wait);
+        while (status != uringpp::AcquireStatus::Acquired) {
+            m_ring.submit();
+            if (status == uringpp::AcquireStatus::QueueFull) {
+                status = semaphore.complete<Operations>(m_ring, m_wait);
+                continue;
+            }
+
+            auto completion = m_ring.wait();
+            Operations::dispatch(
+                completion.get(),
+                uringpp::Overloaded {
+                    [&](uringpp::op::FutexWait&, uringpp::op::FutexWait::result_type) {
+                        status = semaphore.complete<Operations>(m_ring, m_wait);
+                    },
+                    [](uringpp::op::FutexWake&, uringpp::op::FutexWake::result_type) {} });
+            m_ring.seen(completion);
+        }
+    }
+
+  private:
+    uringpp::Ring<void> m_ring;
+    uringpp::op::FutexWait m_wait;
+    uringpp::op::FutexWake m_wake;
+};
+
+int main(int argc, char** argv)
+{
+    const std::size_t roundTrips = argc > 1 ? std::stoul(argv[1]) : 100'000;
+
+    {
+        ConditionToken ping;
+        ConditionToken pong;
+        measure(
+            "condition variable",
+            roundTrips,
+            [&] {
+                ping.give();
+                pong.take();
+            },
+            [&] {
+                ping.take();
+                pong.give();
+            });
+    }
+
+    {
+        uringpp::AsyncSemaphore ping;
+        uringpp::AsyncSemaphore pong;
+        measure(
+            "futex syscall",
+            roundTrips,
+            [&] {
+                ping.release();
+                pong.acquire();
+            },
+            [&] {
+                ping.acquire();
+                pong.release();
+            });
+    }
+
+    if (!uringpp::Capabilities::get().has_futex()) {
+        std::cout << "io_uring futex operations unsupported, skipping ring handoff" << std::endl;
+        return 0;
+    }
+
+    {
+        uringpp::AsyncSemaphore ping;
+        uringpp::AsyncSemaphore pong;
+        RingToken first;
+        RingToken second;
+        measure(
+            "io_uring futex",
+            roundTrips,
+            [&] {
+                first.give(ping);
+                first.take(pong);
+            },
+            [&] {
+                second.take(ping);
+                second.give(pong);
+            });
+    }
+
+    return 0;
+}
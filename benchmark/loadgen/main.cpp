@@ -0,0 +1,614 @@
+#include <uringpp/uringpp.h>
+
+#include <benchmark.h>
+#include <loopback.h>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Load generator for echo and request/response servers on the loopback interface.
+//
+//   loadgen [--port P] [--connections N] [--size B] [--pipeline D] [--rate R] [--duration S]
+//           [--protocol echo|memcache] [--keys K]
+//
+// Opens N connections to 127.0.0.1:P and sends requests of B bytes, at most D of
+// them in flight per connection. A request is answered once B bytes came back.
+// Without --port an io_uring echo server is started in the process.
+//
+// With --protocol memcache the requests are memcached gets of K keys which are
+// set to values of B bytes before the run. Without --port a KeyValueServer is
+// started in the process.
+//
+// Closed loop (default): each connection sends its next request as soon as a
+// response arrived. The latencies are corrected for coordinated omission with the
+// mean latency as the expected interval between requests.
+//
+// Open loop (--rate R): R requests per second are scheduled round robin over the
+// connections independent of the responses. The latency is measured from the
+// scheduled time, so a request which waited behind a slow one counts the wait.
+// The service time is measured from the actual send.
+
+using Clock = bench::Clock;
+
+struct ConnectOp : uringpp::op::Connect {
+    std::size_t connection;
+};
+
+struct SendOp : uringpp::op::Send {
+    std::size_t connection;
+};
+
+struct RecvOp : uringpp::op::Recv {
+    std::size_t connection;
+};
+
+struct TickOp : uringpp::op::Timeout {
+};
+
+using Operations = uringpp::OperationSet<ConnectOp, SendOp, RecvOp, TickOp>;
+using Ring = uringpp::Ring<void, uringpp::OverflowRingPolicy>;
+
+struct Options {
+    std::uint16_t port = 0;
+    std::size_t connections = 1000;
+    std::size_t size = 64;
+    std::size_t pipeline = 1;
+    double rate = 0;
+    double duration = 10;
+    bool memcache = false;
+    std::size_t keys = 1000;
+};
+
+struct Request {
+    Clock::time_point scheduled;
+    Clock::time_point sent;
+};
+
+struct Connection {
+    ConnectOp connect {};
+    SendOp send {};
+    RecvOp recv {};
+    std::vector<std::uint8_t> requests;
+    std::vector<std::uint8_t> responses;
+    // Scheduled but not yet sent
+    std::deque<Clock::time_point> backlog;
+    std::deque<Request> inFlight;
+    std::size_t sending = 0;
+    std::size_t received = 0;
+    bool connected = false;
+};
+
+auto raiseFileDescriptorLimit(std::size_t required) -> void
+{
+    rlimit limit;
+    getrlimit(RLIMIT_NOFILE, &limit);
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+    if (limit.rlim_cur < required) {
+        throw std::runtime_error(
+            "file descriptor limit " + std::to_string(limit.rlim_cur) + " is too low for "
+            + std::to_string(required) + " connections");
+    }
+}
+
+//***************************************************************************
+// ECHO SERVER
+//***************************************************************************
+
+struct AcceptOp : uringpp::op::Accept {
+};
+
+struct EchoRecvOp : uringpp::op::Recv {
+};
+
+struct EchoSendOp : uringpp::op::Send {
+};
+
+using EchoOperations = uringpp::OperationSet<AcceptOp, EchoRecvOp, EchoSendOp>;
+
+struct EchoConnection {
+    EchoRecvOp recv {};
+    EchoSendOp send {};
+    std::array<std::uint8_t, 16 * 1024> buffer;
+};
+
+auto echoServer(int listenFd) -> void
+{
+    Ring ring { 1024 };
+    std::map<int, std::unique_ptr<EchoConnection>> connections;
+
+    AcceptOp accept {};
+    accept.fd = listenFd;
+    ring.prepare_operation<EchoOperations>(accept);
+    ring.submit();
+
+    auto recv = [&](EchoConnection& connection) {
+        connection.recv.buffer = connection.buffer;
+        ring.prepare_operation<EchoOperations>(connection.recv);
+    };
+    auto closeConnection = [&](int fd) {
+        close(fd);
+        connections.erase(fd);
+    };
+
+    auto handler = uringpp::Overloaded {
+        [&](AcceptOp& acceptOp, AcceptOp::result_type result) {
+            ring.prepare_operation<EchoOperations>(acceptOp);
+            if (!result.ok()) {
+                return;
+            }
+            const int one = 1;
+            setsockopt(result.value(), IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+            auto& connection = *connections.emplace(result.value(), std::make_unique<EchoConnection>())
+                                    .first->second;
+            connection.recv.fd = result.value();
+            connection.send.fd = result.value();
+            recv(connection);
+        },
+        [&](EchoRecvOp& recvOp, EchoRecvOp::result_type result) {
+            if (!result.ok() || result.value() == 0) {
+                closeConnection(recvOp.fd);
+                return;
+            }
+            auto& connection = *connections.at(recvOp.fd);
+            connection.send.buffer = std::span(connection.buffer).first(result.value());
+            ring.prepare_operation<EchoOperations>(connection.send);
+        },
+        [&](EchoSendOp& sendOp, EchoSendOp::result_type result) {
+            if (!result.ok()) {
+                closeConnection(sendOp.fd);
+                return;
+            }
+            auto& connection = *connections.at(sendOp.fd);
+            if (result.value() < sendOp.buffer.size()) {
+                sendOp.buffer = sendOp.buffer.subspan(result.value());
+                ring.prepare_operation<EchoOperations>(sendOp);
+                return;
+            }
+            recv(connection);
+        }
+    };
+
+    while (true) {
+        auto completion = ring.wait();
+        EchoOperations::dispatch(completion.get(), handler);
+        ring.seen(completion);
+        ring.submit();
+    }
+}
+
+//***************************************************************************
+// MEMCACHE
+//***************************************************************************
+
+auto memcacheKey(std::size_t index) -> std::string
+{
+    // Equal length keys give equal length requests and responses
+    auto number = std::to_string(index);
+    return "key:" + std::string(8 - std::min<std::size_t>(number.size(), 8), '0') + number;
+}
+
+auto memcacheGet(std::size_t index) -> std::string
+{
+    return "get " + memcacheKey(index) + "\r\n";
+}
+
+auto memcacheResponseSize(const Options& options) -> std::size_t
+{
+    const auto header = "VALUE " + memcacheKey(0) + " 0 " + std::to_string(options.size) + "\r\n";
+    return header.size() + options.size + std::string_view("\r\nEND\r\n").size();
+}
+
+/*
+ * Sets the keys with one pipelined stream of requests
+ */
+auto preloadKeys(const Options& options) -> void
+{
+    const auto fd = socket(AF_INET, SOCK_STREAM, 0);
+    const auto address = bench::loopback(options.port);
+    if (fd < 0 || connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0) {
+        throw std::runtime_error(std::string("failed to connect ") + strerror(errno));
+    }
+
+    const std::string value(options.size, 'x');
+    std::thread writer([&] {
+        for (std::size_t i = 0; i < options.keys; i++) {
+            const auto request = "set " + memcacheKey(i) + " 0 0 " + std::to_string(options.size)
+                + "\r\n" + value + "\r\n";
+            for (std::size_t written = 0; written < request.size();) {
+                const auto result = write(fd, request.data() + written, request.size() - written);
+                if (result <= 0) {
+                    return;
+                }
+                written += result;
+            }
+        }
+    });
+
+    const auto expected = options.keys * std::string_view("STORED\r\n").size();
+    std::size_t received = 0;
+    char buffer[4096];
+    for (ssize_t result; received < expected && (result = read(fd, buffer, sizeof(buffer))) > 0;) {
+        received += result;
+    }
+    writer.join();
+    close(fd);
+
+    if (received != expected) {
+        throw std::runtime_error("failed to preload the keys");
+    }
+}
+
+//***************************************************************************
+// LOAD GENERATOR
+//***************************************************************************
+
+class LoadGenerator {
+  public:
+    explicit LoadGenerator(const Options& options)
+        : m_options(options)
+        , m_address(bench::loopback(options.port))
+        , m_requestSize(options.memcache ? memcacheGet(0).size() : options.size)
+        , m_responseSize(options.memcache ? memcacheResponseSize(options) : options.size)
+        , m_connections(options.connections)
+        , m_ring(1024)
+    {
+        for (std::size_t i = 0; i < m_connections.size(); i++) {
+            auto& connection = m_connections[i];
+            if (options.memcache) {
+                const auto request = memcacheGet(i % options.keys);
+                for (std::size_t j = 0; j < options.pipeline; j++) {
+                    connection.requests.insert(
+                        connection.requests.end(), request.begin(), request.end());
+                }
+            } else {
+                connection.requests.assign(options.size * options.pipeline, 'x');
+            }
+            connection.responses.resize(m_responseSize * options.pipeline);
+            connection.connect.connection = i;
+            connection.send.connection = i;
+            connection.recv.connection = i;
+
+            const auto fd = socket(AF_INET, SOCK_STREAM, 0);
+            if (fd < 0) {
+                throw std::runtime_error(std::string("failed to create socket ") + strerror(errno));
+            }
+            const int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            connection.connect.fd = fd;
+            connection.connect.addr = reinterpret_cast<const sockaddr*>(&m_address);
+            connection.connect.addrlen = sizeof(m_address);
+            connection.send.fd = fd;
+            connection.recv.fd = fd;
+        }
+    }
+
+    ~LoadGenerator()
+    {
+        for (auto& connection : m_connections) {
+            close(connection.connect.fd);
+        }
+    }
+
+    auto run() -> void
+    {
+        connectAll();
+
+        const auto openLoop = m_options.rate > 0;
+        const auto interval = openLoop
+            ? std::chrono::nanoseconds(std::max<std::int64_t>(1, 1e9 / m_options.rate))
+            : std::chrono::nanoseconds(0);
+        const auto tick = std::clamp<std::chrono::nanoseconds>(
+            interval, std::chrono::microseconds(50), std::chrono::milliseconds(1));
+
+        TickOp ticker {};
+        ticker.ts.tv_nsec = tick.count();
+        m_ring.prepare_operation<Operations>(ticker);
+
+        m_start = Clock::now();
+        m_end = m_start + std::chrono::duration_cast<Clock::duration>(
+                              std::chrono::duration<double>(m_options.duration));
+        auto nextScheduled = m_start;
+        std::size_t nextConnection = 0;
+
+        if (!openLoop) {
+            for (std::size_t i = 0; i < m_connections.size(); i++) {
+                m_connections[i].backlog.assign(m_options.pipeline, m_start);
+                send(i);
+            }
+        }
+        m_ring.submit();
+
+        auto handler = uringpp::Overloaded {
+            [&](ConnectOp&, ConnectOp::result_type) {},
+            [&](SendOp& sendOp, SendOp::result_type result) { onSent(sendOp, result); },
+            [&](RecvOp& recvOp, RecvOp::result_type result) { onReceived(recvOp, result); },
+            [&](TickOp&, TickOp::result_type) {
+                const auto now = Clock::now();
+                if (now >= m_end) {
+                    m_stopped = true;
+                    return;
+                }
+                for (; openLoop && nextScheduled <= now; nextScheduled += interval) {
+                    m_connections[nextConnection].backlog.push_back(nextScheduled);
+                    send(nextConnection);
+                    nextConnection = (nextConnection + 1) % m_connections.size();
+                }
+                m_ring.prepare_operation<Operations>(ticker);
+            }
+        };
+
+        while (!m_stopped) {
+            auto completion = m_ring.wait();
+            Operations::dispatch(completion.get(), handler);
+            m_ring.seen(completion);
+            m_ring.submit();
+        }
+
+        report(openLoop);
+    }
+
+  private:
+    /*
+     * Connects the sockets, at most 64 at a time to stay below the accept backlog
+     */
+    auto connectAll() -> void
+    {
+        constexpr std::size_t maxConnecting = 64;
+        std::size_t next = 0;
+        std::size_t connected = 0;
+        std::size_t connecting = 0;
+
+        auto handler = uringpp::Overloaded {
+            [&](ConnectOp& connect, ConnectOp::result_type result) {
+                if (!result.ok()) {
+                    throw std::runtime_error(std::string("failed to connect ") + strerror(result.error()));
+                }
+                auto& connection = m_connections[connect.connection];
+                connection.connected = true;
+                connection.recv.buffer = connection.responses;
+                m_ring.prepare_operation<Operations>(connection.recv);
+                connected++;
+                connecting--;
+            },
+            [&](RecvOp& recvOp, RecvOp::result_type result) { onReceived(recvOp, result); },
+            [&](auto&, auto) {}
+        };
+
+        while (connected < m_connections.size()) {
+            for (; connecting < maxConnecting && next < m_connections.size(); next++, connecting++) {
+                m_ring.prepare_operation<Operations>(m_connections[next].connect);
+            }
+            m_ring.submit();
+
+            auto completion = m_ring.wait();
+            Operations::dispatch(completion.get(), handler);
+            m_ring.seen(completion);
+        }
+    }
+
+    /*
+     * Sends the scheduled requests of the connection which fit into its pipeline in
+     * one send
+     */
+    auto send(std::size_t index) -> void
+    {
+        auto& connection = m_connections[index];
+        if (connection.sending || !connection.connected) {
+            return;
+        }
+
+        const auto requests
+            = std::min(connection.backlog.size(), m_options.pipeline - connection.inFlight.size());
+        if (!requests) {
+            return;
+        }
+
+        const auto now = Clock::now();
+        for (std::size_t i = 0; i < requests; i++) {
+            connection.inFlight.push_back({ connection.backlog.front(), now });
+            connection.backlog.pop_front();
+        }
+        connection.sending = requests;
+        connection.send.buffer = std::span(connection.requests).first(requests * m_requestSize);
+        m_ring.prepare_operation<Operations>(connection.send);
+    }
+
+    auto onSent(SendOp& sendOp, SendOp::result_type result) -> void
+    {
+        auto& connection = m_connections[sendOp.connection];
+        if (!result.ok()) {
+            fail(sendOp.connection, result.error());
+            return;
+        }
+
+        if (result.value() < sendOp.buffer.size()) {
+            sendOp.buffer = sendOp.buffer.subspan(result.value());
+            m_ring.prepare_operation<Operations>(sendOp);
+            return;
+        }
+
+        m_sentBytes += connection.sending * m_requestSize;
+        connection.sending = 0;
+        send(sendOp.connection);
+    }
+
+    auto onReceived(RecvOp& recvOp, RecvOp::result_type result) -> void
+    {
+        auto& connection = m_connections[recvOp.connection];
+        if (!result.ok() || result.value() == 0) {
+            fail(recvOp.connection, result.ok() ? ECONNRESET : result.error());
+            return;
+        }
+
+        const auto now = Clock::now();
+        connection.received += result.value();
+        while (connection.received >= m_responseSize && !connection.inFlight.empty()) {
+            const auto& request = connection.inFlight.front();
+            if (now < m_end) {
+                m_latency.record((now - request.scheduled).count());
+                m_serviceTime.record((now - request.sent).count());
+            }
+            connection.inFlight.pop_front();
+            connection.received -= m_responseSize;
+
+            if (m_options.rate == 0 && now < m_end) {
+                connection.backlog.push_back(now);
+            }
+        }
+
+        m_ring.prepare_operation<Operations>(recvOp);
+        send(recvOp.connection);
+    }
+
+    auto fail(std::size_t index, int error) -> void
+    {
+        auto& connection = m_connections[index];
+        if (connection.connected) {
+            std::cout << "* Connection " << index << " failed: " << strerror(error) << std::endl;
+            connection.connected = false;
+            m_failedConnections++;
+        }
+    }
+
+    auto report(bool openLoop) -> void
+    {
+        const auto seconds = std::chrono::duration<double>(m_end - m_start).count();
+        std::size_t unsent = 0;
+        std::size_t pending = 0;
+        for (const auto& connection : m_connections) {
+            unsent += connection.backlog.size();
+            pending += connection.inFlight.size();
+        }
+
+        bench::report("connections", m_options.connections, "");
+        bench::report("failed connections", m_failedConnections, "");
+        bench::report("requests", m_latency.count(), "");
+        bench::report("throughput", m_latency.count() / seconds, "req/s");
+        bench::report("bandwidth", m_sentBytes / seconds / 1e6, "MB/s");
+        if (openLoop) {
+            bench::report("scheduled rate", m_options.rate, "req/s");
+            bench::report("scheduled but unsent at end", unsent, "");
+        }
+        bench::report("in flight at end", pending, "");
+
+        // In the closed loop every slot of a pipeline would send a request every
+        // mean latency if no response was late
+        const auto latency = openLoop
+            ? m_latency
+            : m_serviceTime.corrected(static_cast<std::uint64_t>(m_serviceTime.mean()));
+        reportPercentiles("latency", latency);
+        reportPercentiles("service time", m_serviceTime);
+    }
+
+    static auto reportPercentiles(const std::string& name, const uringpp::LatencyHistogram& histogram)
+        -> void
+    {
+        for (auto percentile : { 50.0, 90.0, 99.0, 99.9, 99.99 }) {
+            std::ostringstream label;
+            label << name << " p" << percentile;
+            bench::report(label.str(), histogram.percentile(percentile) / 1e3, "us");
+        }
+        bench::report(name + " max", histogram.max() / 1e3, "us");
+    }
+
+    Options m_options;
+    sockaddr_in m_address;
+    std::size_t m_requestSize;
+    std::size_t m_responseSize;
+    // The ring is destroyed first, it cancels the receives into the connections
+    std::vector<Connection> m_connections;
+    Ring m_ring;
+    Clock::time_point m_start;
+    Clock::time_point m_end;
+    bool m_stopped = false;
+    uringpp::LatencyHistogram m_latency;
+    uringpp::LatencyHistogram m_serviceTime;
+    std::size_t m_sentBytes = 0;
+    std::size_t m_failedConnections = 0;
+};
+
+auto parseOptions(int argc, char** argv) -> Options
+{
+    Options options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string name = argv[i];
+        const std::string value = argv[i + 1];
+        if (name == "--port") {
+            options.port = std::stoi(value);
+        } else if (name == "--connections") {
+            options.connections = std::stoul(value);
+        } else if (name == "--size") {
+            options.size = std::stoul(value);
+        } else if (name == "--pipeline") {
+            options.pipeline = std::stoul(value);
+        } else if (name == "--rate") {
+            options.rate = std::stod(value);
+        } else if (name == "--duration") {
+            options.duration = std::stod(value);
+        } else if (name == "--protocol" && (value == "echo" || value == "memcache")) {
+            options.memcache = value == "memcache";
+        } else if (name == "--keys") {
+            options.keys = std::stoul(value);
+        } else {
+            throw std::invalid_argument("unknown option " + name);
+        }
+    }
+
+    if (!options.connections || !options.size || !options.pipeline || !options.keys) {
+        throw std::invalid_argument("connections, size, pipeline and keys must be at least 1");
+    }
+    return options;
+}
+
+int main(int argc, char** argv)
+{
+    auto options = parseOptions(argc, argv);
+    raiseFileDescriptorLimit(2 * options.connections + 64);
+
+    if (!options.port) {
+        const auto listenFd = bench::listenOnLoopback();
+        sockaddr_in address {};
+        socklen_t length = sizeof(address);
+        getsockname(listenFd, reinterpret_cast<sockaddr*>(&address), &length);
+        options.port = ntohs(address.sin_port);
+        if (options.memcache) {
+            std::thread([listenFd] {
+                uringpp::KeyValueServer server(listenFd, { .queueDepth = 1024 });
+                server.run();
+            }).detach();
+        } else {
+            std::thread(echoServer, listenFd).detach();
+        }
+    }
+
+    if (options.memcache) {
+        preloadKeys(options);
+    }
+
+    std::cout << "* " << options.connections << " connections to 127.0.0.1:" << options.port << ", "
+              << options.size << (options.memcache ? " byte values, " : " byte requests, ")
+              << "pipeline " << options.pipeline << ", "
+              << (options.rate > 0 ? "open loop at " + std::to_string(options.rate) + " req/s"
+                                   : std::string("closed loop"))
+              << std::endl;
+
+    LoadGenerator loadGenerator(options);
+    loadGenerator.run();
+
+    return 0;
+}
@@ -0,0 +1,148 @@
+#include <uringpp/uringpp.h>
+
+#include <benchmark.h>
+#include <loopback.h>
+
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// Throughput and CPU time per GB of a TcpProxy over loopback.
+//
+// Client threads stream data through the proxy into a sink which discards it. The
+// direct variant connects the clients to the sink without a proxy, so the CPU time
+// of the clients and the sink can be subtracted from the proxy variants. The CPU
+// time is the one of the whole process, which includes the io-wq workers running
+// the splices.
+
+auto cpuSeconds() -> double
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    auto seconds = [](const timeval& time) { return time.tv_sec + time.tv_usec / 1e6; };
+    return seconds(usage.ru_utime) + seconds(usage.ru_stime);
+}
+
+struct Transfer {
+    double seconds;
+    double cpuSeconds;
+};
+
+/*
+ * Streams bytes over the connections to targetFd, which forwards them to the sink
+ */
+auto transfer(int targetFd, int sinkFd, std::size_t connections, std::size_t bytes) -> Transfer
+{
+    std::thread sink([&] {
+        std::vector<std::thread> readers;
+        for (std::size_t i = 0; i < connections; i++) {
+            const auto fd = accept(sinkFd, nullptr, nullptr);
+            readers.emplace_back([fd] {
+                std::vector<char> buffer(256 * 1024);
+                while (read(fd, buffer.data(), buffer.size()) > 0) {
+                }
+                close(fd);
+            });
+        }
+        for (auto& reader : readers) {
+            reader.join();
+        }
+    });
+
+    std::vector<int> clients;
+    const auto address = bench::addressOf(targetFd);
+    for (std::size_t i = 0; i < connections; i++) {
+        const auto fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0) {
+            throw std::runtime_error("failed to connect");
+        }
+        clients.push_back(fd);
+    }
+
+    const auto cpuStart = cpuSeconds();
+    bench::Stopwatch stopwatch;
+
+    std::vector<std::thread> writers;
+    for (auto fd : clients) {
+        writers.emplace_back([fd, bytes, connections] {
+            std::vector<char> buffer(256 * 1024, 'x');
+            for (std::size_t written = 0; written < bytes / connections;) {
+                const auto length = std::min(buffer.size(), bytes / connections - written);
+                const auto result = write(fd, buffer.data(), length);
+                if (result <= 0) {
+                    throw std::runtime_error("failed to write");
+                }
+                written += result;
+            }
+            // Wait until the end of the data was forwarded and the sink closed
+            shutdown(fd, SHUT_WR);
+            char byte;
+            while (read(fd, &byte, 1) > 0) {
+            }
+            close(fd);
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    sink.join();
+
+    return { stopwatch.seconds(), cpuSeconds() - cpuStart };
+}
+
+auto report(
+    const std::string& name, const Transfer& result, const Transfer& direct, std::size_t bytes)
+    -> void
+{
+    const auto gigabytes = bytes / 1e9;
+    bench::report(name + " throughput", gigabytes / result.seconds, "GB/s");
+    bench::report(name + " process cpu", result.cpuSeconds / gigabytes, "s/GB");
+    if (&result != &direct) {
+        bench::report(
+            name + " proxy cpu", (result.cpuSeconds - direct.cpuSeconds) / gigabytes, "s/GB");
+    }
+}
+
+auto throughProxy(
+    uringpp::ProxyOptions options, int sinkFd, std::size_t connections, std::size_t bytes)
+    -> Transfer
+{
+    const auto proxyFd = bench::listenOnLoopback();
+    uringpp::TcpProxy proxy(proxyFd, bench::addressOf(sinkFd), options);
+    std::thread proxyThread([&] { proxy.run(); });
+
+    const auto result = transfer(proxyFd, sinkFd, connections, bytes);
+
+    proxy.stop();
+    proxyThread.join();
+    close(proxyFd);
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    const std::size_t bytes = (argc > 1 ? std::stoul(argv[1]) : 4ul) << 30;
+    const std::size_t connections = argc > 2 ? std::stoul(argv[2]) : 4;
+    signal(SIGPIPE, SIG_IGN);
+
+    const auto sinkFd = bench::listenOnLoopback();
+
+    const auto direct = transfer(sinkFd, sinkFd, connections, bytes);
+    report("direct", direct, direct, bytes);
+
+    const auto splice = throughProxy({ .splice = true }, sinkFd, connections, bytes);
+    report("splice proxy", splice, direct, bytes);
+
+    const auto buffers
+        = throughProxy({ .splice = false, .bufferSize = 64 * 1024 }, sinkFd, connections, bytes);
+    report("provided buffer proxy", buffers, direct, bytes);
+
+    close(sinkFd);
+    return 0;
+}
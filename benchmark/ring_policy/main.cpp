@@ -0,0 +1,74 @@
+#include <uringpp/uringpp.h>
+
+#include <benchmark.h>
+
+#include <string>
+
+// Measures the overhead of the Ring policies on a nop prepare/submit/reap loop.
+// The prepare loop is timed separately since it contains the checks the policies
+// add or remove, while submit and wait are dominated by the system call.
+
+struct NopOp : uringpp::op::Nop {
+};
+using Operations = uringpp::OperationSet<NopOp>;
+
+template <class Policy>
+auto benchmarkPolicy(const std::string& name, std::size_t queueSize, std::size_t numberOfOperations)
+    -> void
+{
+    uringpp::Ring<void, Policy> ring { queueSize };
+    std::vector<NopOp> nops(queueSize);
+    std::chrono::nanoseconds prepareTime { 0 };
+    std::size_t completed = 0;
+
+    bench::Stopwatch total;
+    while (completed < numberOfOperations) {
+        bench::Stopwatch prepare;
+        for (auto& nop : nops) {
+            ring.template prepare_operation<Operations>(nop);
+        }
+        prepareTime += prepare.elapsed();
+
+        ring.submit();
+        for (std::size_t i = 0; i < queueSize; i++) {
+            auto completion = ring.wait();
+            if constexpr (std::is_same_v<typename Policy::error, uringpp::policy::ExpectedOnError>) {
+                ring.seen(*completion);
+            } else {
+                ring.seen(completion);
+            }
+            completed++;
+        }
+    }
+    const auto totalNs = static_cast<double>(total.elapsed().count());
+
+    bench::report(name + " prepare", prepareTime.count() / static_cast<double>(completed), "ns/op");
+    bench::report(name + " total", totalNs / completed, "ns/op");
+}
+
+int main(int argc, char** argv)
+{
+    using namespace uringpp;
+    const std::size_t queueSize = 256;
+    const std::size_t numberOfOperations = argc > 1 ? std::stoul(argv[1]) : 2000000;
+
+    benchmarkPolicy<DefaultRingPolicy>("throw/fail/none", queueSize, numberOfOperations);
+    benchmarkPolicy<RingPolicy<policy::AbortOnError>>(
+        "abort/fail/none", queueSize, numberOfOperations);
+    benchmarkPolicy<RingPolicy<policy::ExpectedOnError>>(
+        "expected/fail/none", queueSize, numberOfOperations);
+    benchmarkPolicy<RingPolicy<policy::AbortOnError, policy::FlushWhenFull>>(
+        "abort/flush/none", queueSize, numberOfOperations);
+    benchmarkPolicy<FastRingPolicy>("abort/spin/none", queueSize, numberOfOperations);
+    benchmarkPolicy<RingPolicy<policy::ThrowOnError, policy::FailWhenFull, policy::CountingInstrumentation>>(
+        "throw/fail/counting", queueSize, numberOfOperations);
+
+    using TracingPolicy
+        = RingPolicy<policy::ThrowOnError, policy::FailWhenFull, policy::TracingInstrumentation>;
+    benchmarkPolicy<TracingPolicy>("throw/fail/tracing-off", queueSize, numberOfOperations);
+    Tracer::enable();
+    benchmarkPolicy<TracingPolicy>("throw/fail/tracing-on", queueSize, numberOfOperations);
+    Tracer::disable();
+
+    return 0;
+}
@@ -0,0 +1,178 @@
+#include <uringpp/uringpp.h>
+
+#include <benchmark.h>
+
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Cost of many connection timeouts. A TimerWheel and a std::multimap keyed by
+// deadline, the usual ordered timer queue, schedule, reschedule (a keepalive
+// which is pushed back on every request), cancel and expire the same timers.
+// Then a ring drives timers through the single timeout the wheel arms, which
+// reports the timeouts submitted per timer and how late timers expired.
+//
+// Usage: timer_wheel_benchmark [TIMERS]
+
+using Clock = uringpp::TimerWheel::Clock;
+using namespace std::chrono_literals;
+
+struct WheelTimer : uringpp::Timer {
+    Clock::time_point deadline;
+};
+
+struct MapTimer {
+    std::multimap<Clock::time_point, MapTimer*>::iterator position;
+};
+
+auto randomDelays(std::size_t count, Clock::duration max, unsigned seed = 42)
+    -> std::vector<Clock::duration>
+{
+    std::mt19937_64 random(seed);
+    std::uniform_int_distribution<Clock::rep> distribution(1, max.count());
+    std::vector<Clock::duration> delays(count);
+    for (auto& delay : delays) {
+        delay = Clock::duration(distribution(random));
+    }
+    return delays;
+}
+
+auto report(const std::string& name, std::size_t count, const bench::Stopwatch& stopwatch) -> void
+{
+    bench::report(name, static_cast<double>(stopwatch.elapsed().count()) / count, "ns/timer");
+}
+
+auto wheel(const std::vector<Clock::duration>& delays, const std::vector<Clock::duration>& later)
+    -> void
+{
+    const auto start = Clock::now();
+    uringpp::TimerWheel wheel(1ms, start, uringpp::Capabilities::none());
+    std::vector<WheelTimer> timers(delays.size());
+
+    bench::Stopwatch stopwatch;
+    for (std::size_t i = 0; i < timers.size(); i++) {
+        wheel.schedule(timers[i], start + delays[i]);
+    }
+    report("wheel schedule", timers.size(), stopwatch);
+
+    stopwatch.restart();
+    for (std::size_t i = 0; i < timers.size(); i++) {
+        wheel.schedule(timers[i], start + later[i]);
+    }
+    report("wheel reschedule", timers.size(), stopwatch);
+
+    stopwatch.restart();
+    for (std::size_t i = 0; i < timers.size(); i += 2) {
+        wheel.cancel(timers[i]);
+    }
+    report("wheel cancel", timers.size() / 2, stopwatch);
+
+    // Expire in steps of a tick, the way an armed timeout completes
+    stopwatch.restart();
+    std::size_t expired = 0;
+    for (auto now = start; !wheel.empty(); now += 1ms) {
+        expired += wheel.expire(now, [](uringpp::Timer& timer) { bench::doNotOptimize(timer); });
+    }
+    report("wheel expire", expired, stopwatch);
+}
+
+auto map(const std::vector<Clock::duration>& delays, const std::vector<Clock::duration>& later)
+    -> void
+{
+    const auto start = Clock::now();
+    std::multimap<Clock::time_point, MapTimer*> queue;
+    std::vector<MapTimer> timers(delays.size());
+
+    bench::Stopwatch stopwatch;
+    for (std::size_t i = 0; i < timers.size(); i++) {
+        timers[i].position = queue.emplace(start + delays[i], &timers[i]);
+    }
+    report("multimap schedule", timers.size(), stopwatch);
+
+    stopwatch.restart();
+    for (std::size_t i = 0; i < timers.size(); i++) {
+        queue.erase(timers[i].position);
+        timers[i].position = queue.emplace(start + later[i], &timers[i]);
+    }
+    report("multimap reschedule", timers.size(), stopwatch);
+
+    stopwatch.restart();
+    for (std::size_t i = 0; i < timers.size(); i += 2) {
+        queue.erase(timers[i].position);
+    }
+    report("multimap cancel", timers.size() / 2, stopwatch);
+
+    stopwatch.restart();
+    std::size_t expired = 0;
+    for (auto now = start; !queue.empty(); now += 1ms) {
+        while (!queue.empty() && queue.begin()->first <= now) {
+            bench::doNotOptimize(queue.begin()->second);
+            queue.erase(queue.begin());
+            expired++;
+        }
+    }
+    report("multimap expire", expired, stopwatch);
+}
+
+/*
+ * Expires timers with deadlines over a second through the timeout of the ring
+ */
+auto ring(std::size_t count) -> void
+{
+    using Operations = uringpp::OperationSet<uringpp::TimerWheel::TimeoutOp>;
+    uringpp::Ring<void> ring(64);
+    uringpp::TimerWheel wheel;
+
+    const auto delays = randomDelays(count, 1s);
+    std::vector<WheelTimer> timers(count);
+    const auto start = Clock::now();
+    for (std::size_t i = 0; i < count; i++) {
+        timers[i].deadline = start + delays[i];
+        wheel.schedule(timers[i], timers[i].deadline);
+    }
+
+    std::vector<double> lateness;
+    lateness.reserve(count);
+    const auto onExpired = [&](uringpp::Timer& timer) {
+        const auto late = Clock::now() - static_cast<WheelTimer&>(timer).deadline;
+        lateness.push_back(std::chrono::duration<double, std::nano>(late).count());
+    };
+
+    std::size_t expired = 0;
+    wheel.arm<Operations>(ring);
+    ring.submit();
+    while (expired < count) {
+        auto completion = ring.wait();
+        Operations::dispatch(
+            completion.get(),
+            [&](uringpp::TimerWheel::TimeoutOp& timeout,
+                uringpp::TimerWheel::TimeoutOp::result_type result) {
+                expired += wheel.complete(timeout, result, onExpired);
+            });
+        ring.seen(completion);
+        wheel.arm<Operations>(ring);
+        ring.submit();
+    }
+
+    bench::report("ring timers", count, "");
+    bench::report("ring timeouts armed", wheel.arms(), "");
+    bench::reportLatency("ring lateness", lateness);
+}
+
+int main(int argc, char** argv)
+{
+    const std::size_t count = argc > 1 ? std::stoul(argv[1]) : 1'000'000;
+
+    const auto delays = randomDelays(count, 60s);
+    auto later = randomDelays(count, 30s, 43);
+    for (auto& delay : later) {
+        delay += 60s;
+    }
+
+    wheel(delays, later);
+    map(delays, later);
+    ring(std::min<std::size_t>(count, 100'000));
+    return 0;
+}
@@ -0,0 +1,209 @@
+#include <uringpp/uringpp.h>
+
+#include <benchmark.h>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <thread>
+
+// Packets per second of small datagrams over loopback.
+//
+// A receiver thread counts datagrams with a single multishot recvmsg into provided
+// buffers. The sender either prepares one sendmsg per datagram or one sendmsg per
+// GsoBatch of 64 datagrams. A zero length datagram stops the receiver.
+
+struct RecvOp : uringpp::op::RecvMsgMultishot {
+};
+struct SendOp : uringpp::op::SendMsg {
+    msghdr message;
+};
+struct ProvideBuffersOp : uringpp::op::ProvideBuffers {
+};
+using Operations = uringpp::OperationSet<RecvOp, SendOp, ProvideBuffersOp>;
+using Ring = uringpp::Ring<void, uringpp::FastRingPolicy>;
+
+constexpr std::size_t datagramSize = 64;
+
+auto bindLoopback() -> int
+{
+    auto fd = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        throw std::runtime_error("failed to bind udp socket");
+    }
+
+    const int bufferSize = 16 * 1024 * 1024;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+    return fd;
+}
+
+auto receive(int fd, std::atomic<std::uint64_t>& received, std::atomic<bool>& done) -> void
+{
+    Ring ring { 1024 };
+    BufferPool bufferPool(4096, sizeof(io_uring_recvmsg_out) + sizeof(sockaddr_storage) + 256, 0);
+
+    ProvideBuffersOp provide {};
+    provide.bufferPool = &bufferPool;
+    provide.numberOfBuffers = bufferPool.pool_size();
+    ring.prepare_operation<Operations>(provide);
+
+    msghdr message {};
+    message.msg_namelen = sizeof(sockaddr_storage);
+    RecvOp recv {};
+    recv.fd = fd;
+    recv.msg = &message;
+    recv.bufferPool = &bufferPool;
+    ring.prepare_operation<Operations>(recv);
+    ring.submit();
+
+    std::vector<ProvideBuffersOp> readds(bufferPool.pool_size());
+    bool recvArmed = true;
+    bool stop = false;
+
+    auto handler = uringpp::Overloaded {
+        [&](RecvOp&, RecvOp::result_type result) {
+            if (!result.has_more()) {
+                recvArmed = result.error() != ENOBUFS;
+                if (recvArmed) {
+                    ring.prepare_operation<Operations>(recv);
+                }
+            }
+            if (!result.ok()) {
+                return;
+            }
+
+            uringpp::RecvMsgOut datagram(bufferPool.at(result.buffer_idx()), result.value(), message);
+            if (datagram.valid() && datagram.payload().empty()) {
+                stop = true;
+            }
+            received.fetch_add(1, std::memory_order_relaxed);
+
+            auto& readd = readds[result.buffer_idx()];
+            readd.bufferPool = &bufferPool;
+            readd.bufferIdx = result.buffer_idx();
+            ring.prepare_operation<Operations>(readd);
+        },
+        [&](ProvideBuffersOp&, ProvideBuffersOp::result_type) {
+            if (!recvArmed) {
+                ring.prepare_operation<Operations>(recv);
+                recvArmed = true;
+            }
+        },
+        [](SendOp&, SendOp::result_type) {}
+    };
+
+    while (!stop) {
+        auto completion = ring.wait();
+        Operations::dispatch(completion.get(), handler);
+        ring.seen(completion);
+        while (auto next = ring.peek()) {
+            Operations::dispatch(next->get(), handler);
+            ring.seen(*next);
+        }
+        ring.submit();
+    }
+    done = true;
+}
+
+auto sendPerDatagram(Ring& ring, std::vector<SendOp>& sends) -> std::size_t
+{
+    for (auto& send : sends) {
+        ring.prepare_operation<Operations>(send);
+    }
+    ring.submit();
+
+    std::size_t sent = 0;
+    for (std::size_t i = 0; i < sends.size(); i++) {
+        auto completion = ring.wait();
+        sent += SendOp::result(completion.get()).ok();
+        ring.seen(completion);
+    }
+    return sent;
+}
+
+template <class Send>
+auto run(const std::string& name, int receiver, int sender, double seconds, Send send) -> void
+{
+    std::atomic<std::uint64_t> received { 0 };
+    std::atomic<bool> done { false };
+    std::thread receiverThread([&] { receive(receiver, received, done); });
+
+    std::uint64_t sent = 0;
+    bench::Stopwatch stopwatch;
+    while (stopwatch.seconds() < seconds) {
+        sent += send();
+    }
+    const auto elapsed = stopwatch.seconds();
+    const auto receivedInTime = received.load();
+
+    sockaddr_in address {};
+    socklen_t length = sizeof(address);
+    getsockname(receiver, reinterpret_cast<sockaddr*>(&address), &length);
+    while (!done) {
+        sendto(sender, nullptr, 0, 0, reinterpret_cast<sockaddr*>(&address), length);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    receiverThread.join();
+
+    // Drop the datagrams still queued, so they do not count for the next run
+    std::array<std::uint8_t, 256> drain;
+    while (::recv(receiver, drain.data(), drain.size(), MSG_DONTWAIT) >= 0) {
+    }
+
+    bench::report(name + " sent", sent / elapsed, "datagrams/s");
+    bench::report(name + " received", receivedInTime / elapsed, "datagrams/s");
+}
+
+int main(int argc, char** argv)
+{
+    const double seconds = argc > 1 ? std::stod(argv[1]) : 5.0;
+    const std::size_t batchSize = uringpp::GsoBatch::maxSegments;
+
+    const auto receiver = bindLoopback();
+    const auto sender = bindLoopback();
+    sockaddr_in address {};
+    socklen_t length = sizeof(address);
+    getsockname(receiver, reinterpret_cast<sockaddr*>(&address), &length);
+
+    Ring ring { 256 };
+    std::vector<std::uint8_t> payload(datagramSize, 'x');
+
+    // One sendmsg per datagram, a batch of them per submit
+    iovec vec { payload.data(), payload.size() };
+    std::vector<SendOp> sends(batchSize);
+    for (auto& send : sends) {
+        send.message = {};
+        send.message.msg_name = &address;
+        send.message.msg_namelen = length;
+        send.message.msg_iov = &vec;
+        send.message.msg_iovlen = 1;
+        send.fd = sender;
+        send.msg = &send.message;
+    }
+    run("sendmsg", receiver, sender, seconds, [&] { return sendPerDatagram(ring, sends); });
+
+    // One sendmsg per batch of datagrams with segmentation offload
+    std::vector<std::unique_ptr<uringpp::GsoBatch>> batches;
+    std::vector<SendOp> gsoSends(4);
+    for (auto& send : gsoSends) {
+        auto& batch = batches.emplace_back(std::make_unique<uringpp::GsoBatch>(datagramSize));
+        batch->set_destination(reinterpret_cast<sockaddr*>(&address), length);
+        while (batch->append(payload)) {
+        }
+        send.fd = sender;
+        send.msg = batch->message();
+    }
+    run("gso sendmsg", receiver, sender, seconds, [&] {
+        return sendPerDatagram(ring, gsoSends) * batchSize;
+    });
+
+    close(receiver);
+    close(sender);
+    return 0;
+}
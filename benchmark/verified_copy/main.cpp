@@ -0,0 +1,86 @@
+#include <uringpp/uringpp.h>
+
+#include <benchmark.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Throughput of a copy with and without CRC32C verification, by default on tmpfs
+// so the copy itself is as fast as possible and the checksum overhead shows.
+// The checksum runs on the completion thread or on worker threads while the ring
+// keeps copying. A second read pass over the output is the baseline which the
+// overlapped checksum replaces.
+//
+// Usage: verified_copy_benchmark [SIZE_MB] [DIRECTORY]
+
+auto writeFile(const std::filesystem::path& file, std::size_t size) -> void
+{
+    std::ofstream stream(file, std::ios::binary);
+    std::vector<char> block(1024 * 1024);
+    for (std::size_t i = 0; i < block.size(); i++) {
+        block[i] = static_cast<char>(i * 131 + 17);
+    }
+    for (std::size_t written = 0; written < size; written += block.size()) {
+        stream.write(block.data(), block.size());
+    }
+}
+
+auto readPassDigest(const std::filesystem::path& file) -> std::uint32_t
+{
+    uringpp::AsyncFileReader reader(file);
+    std::uint32_t digest = 0;
+    while (auto chunk = reader.next()) {
+        digest = uringpp::crc32c(*chunk, digest);
+    }
+    return digest;
+}
+
+auto run(
+    const std::string& name,
+    const std::filesystem::path& input,
+    const std::filesystem::path& output,
+    uringpp::CopyOptions options,
+    bool readPass = false) -> double
+{
+    uringpp::CopyEngine copyEngine(options);
+    copyEngine.copy(input, output);
+
+    bench::Stopwatch stopwatch;
+    const auto copied = copyEngine.copy(input, output);
+    if (readPass) {
+        bench::doNotOptimize(readPassDigest(output));
+    }
+    const auto seconds = stopwatch.seconds();
+
+    bench::report(name, copied / seconds / 1e9, "GB/s");
+    return seconds;
+}
+
+int main(int argc, char** argv)
+{
+    const std::size_t size = (argc > 1 ? std::stoul(argv[1]) : 1024) * 1024 * 1024;
+    const std::filesystem::path directory = argc > 2 ? argv[2] : "/dev/shm";
+    const auto input = directory / "uringpp_verified_copy_input";
+    const auto output = directory / "uringpp_verified_copy_output";
+
+    writeFile(input, size);
+    const uringpp::CopyOptions options { .queueDepth = 64, .blockSize = 128 * 1024 };
+
+    const auto unverified = run("copy", input, output, options);
+    const auto readPass = run("copy + read pass crc32c", input, output, options, true);
+    auto checksum = options;
+    checksum.checksum = true;
+    const auto completionThread = run("copy with crc32c on completion thread", input, output, checksum);
+    checksum.checksumThreads = 2;
+    const auto threads = run("copy with crc32c on 2 threads", input, output, checksum);
+
+    bench::report("read pass overhead", (readPass / unverified - 1) * 100, "%");
+    bench::report("completion thread overhead", (completionThread / unverified - 1) * 100, "%");
+    bench::report("2 threads overhead", (threads / unverified - 1) * 100, "%");
+
+    std::filesystem::remove(input);
+    std::filesystem::remove(output);
+    return 0;
+}
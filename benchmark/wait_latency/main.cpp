@@ -0,0 +1,106 @@
+#include <uringpp/uringpp.h>
+
+#include <benchmark.h>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <thread>
+
+// Request/response latency of a recv completion for the wait strategies.
+//
+// A peer thread sends a timestamp over a unix socket pair, the ring receives it
+// and acknowledges with a plain write, after which the peer waits the think time
+// and sends the next timestamp. The latency is the time from the send of the peer
+// until the completion was returned by the wait strategy.
+
+struct RecvOp : uringpp::op::Recv {
+};
+using Operations = uringpp::OperationSet<RecvOp>;
+
+auto nowNs() -> std::int64_t
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               bench::Clock::now().time_since_epoch())
+        .count();
+}
+
+auto peer(int fd, std::size_t messages, std::chrono::nanoseconds thinkTime) -> void
+{
+    std::uint8_t ack;
+    for (std::size_t i = 0; i < messages; i++) {
+        const auto until = bench::Clock::now() + thinkTime;
+        while (bench::Clock::now() < until) {
+            uringpp::cpuRelax();
+        }
+
+        const auto timestamp = nowNs();
+        if (write(fd, &timestamp, sizeof(timestamp)) != sizeof(timestamp)) {
+            return;
+        }
+        if (read(fd, &ack, sizeof(ack)) != sizeof(ack)) {
+            return;
+        }
+    }
+}
+
+template <class Strategy>
+auto benchmarkStrategy(
+    const std::string& name,
+    Strategy strategy,
+    std::size_t messages,
+    std::chrono::nanoseconds thinkTime) -> void
+{
+    std::array<int, 2> fds;
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds.data()) < 0) {
+        throw std::runtime_error("failed to create socket pair");
+    }
+
+    uringpp::Ring<void> ring { 4 };
+    std::int64_t timestamp = 0;
+    RecvOp recv {};
+    recv.fd = fds[0];
+    recv.buffer = std::span(reinterpret_cast<std::uint8_t*>(&timestamp), sizeof(timestamp));
+
+    std::vector<double> latencies;
+    latencies.reserve(messages);
+    std::thread peerThread(peer, fds[1], messages, thinkTime);
+
+    for (std::size_t i = 0; i < messages; i++) {
+        ring.prepare_operation<Operations>(recv);
+        ring.submit();
+        auto completion = ring.wait(strategy);
+        latencies.push_back(static_cast<double>(nowNs() - timestamp));
+        ring.seen(completion);
+
+        const std::uint8_t ack = 0;
+        if (write(fds[0], &ack, sizeof(ack)) != sizeof(ack)) {
+            break;
+        }
+    }
+
+    peerThread.join();
+    close(fds[0]);
+    close(fds[1]);
+
+    bench::reportLatency(name, latencies);
+}
+
+int main(int argc, char** argv)
+{
+    const std::size_t messages = argc > 1 ? std::stoul(argv[1]) : 100000;
+    const auto thinkTime = std::chrono::microseconds(argc > 2 ? std::stoul(argv[2]) : 5);
+
+    benchmarkStrategy("blocking wait", uringpp::BlockingWait {}, messages, thinkTime);
+    benchmarkStrategy(
+        "spin 100us then block",
+        uringpp::SpinThenBlockWait { std::numeric_limits<std::uint64_t>::max(),
+                                     std::chrono::microseconds(100) },
+        messages,
+        thinkTime);
+    benchmarkStrategy("adaptive spin", uringpp::AdaptiveSpinWait {}, messages, thinkTime);
+
+    return 0;
+}
@@ -0,0 +1,56 @@
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <uringpp/uringpp.h>
+
+#include <iostream>
+#include <string>
+
+int listen(std::uint16_t port)
+{
+    int listenFd;
+    struct sockaddr_in address;
+    int opt = 1;
+
+    if ((listenFd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
+        throw std::runtime_error("failed create socket");
+    }
+
+    if (setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR | SO_REUSEPORT, &opt, sizeof(opt))) {
+        throw std::runtime_error("failed to setsocketopt");
+    }
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = INADDR_ANY;
+    address.sin_port = htons(port);
+
+    if (bind(listenFd, (struct sockaddr*)&address, sizeof(address)) < 0) {
+        throw std::runtime_error("failed to bind");
+    }
+
+    if (listen(listenFd, SOMAXCONN) < 0) {
+        throw std::runtime_error("failed to listen");
+    }
+
+    return listenFd;
+}
+
+int main(int argc, char const* argv[])
+{
+    if (argc < 2) {
+        std::cout << "Usage: kv_server <PORT>" << std::endl;
+        return 1;
+    }
+
+    // A client which closed its socket must not kill the server
+    signal(SIGPIPE, SIG_IGN);
+
+    const auto port = std::stoi(argv[1]);
+    uringpp::KeyValueServer server(listen(port), { .queueDepth = 1024, .capacity = 1 << 20 });
+
+    std::cout << "Key-value server started. Listening on port " << port
+              << ", try: printf 'set key 0 0 5\\r\\nvalue\\r\\nget key\\r\\n' | nc -q1 localhost "
+              << port << std::endl;
+    server.run();
+
+    return 0;
+}
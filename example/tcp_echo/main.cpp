@@ -2,36 +2,47 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/resource.h>
 #include <sys/socket.h>
 #include <unistd.h>
 #include <uringpp/uringpp.h>
 
-#include <array>
-#include <map>
+#include <algorithm>
 #include <string>
+#include <string_view>
+#include <vector>
 
-enum class CompletionType : std::uint8_t {
-    Accept = 0,
-    Recv = 1,
-    Send = 2,
-    CreateBufferPool = 4,
-    ReaddBufferPool = 5
+struct AcceptOp : uringpp::op::AcceptDirect {
 };
 
-struct Data {
-    Data(CompletionType type, int fd = 0, std::size_t bufferIdx = 0)
-        : type(type)
-        , bufferIdx(bufferIdx)
-        , fd(fd)
-    {
-    }
+struct RecvOp : uringpp::op::RecvBp {
+    std::size_t sizeClass;
+};
 
-    CompletionType type;
-    int fd;
+struct SendOp : uringpp::op::Send {
+    std::size_t sizeClass;
     std::size_t bufferIdx;
 };
 
-using Ring = uringpp::Ring<Data>;
+struct CloseOp : uringpp::op::CloseDirect {
+};
+
+using ProvideBuffersOp = uringpp::BufferPoolManager::ProvideBuffersOp;
+using Operations = uringpp::OperationSet<AcceptOp, RecvOp, SendOp, CloseOp, ProvideBuffersOp>;
+
+// The operations of a connection are embedded into its slot of the connection
+// table, so serving a connection neither allocates nor looks up user data.
+// Connections live in the registered file table of the ring and are indexed by
+// their direct descriptor, the process fd table is never touched.
+struct Connection {
+    RecvOp recv;
+    SendOp send;
+    CloseOp close;
+    uringpp::SizeClassSelector sizeClass;
+};
+
+using Ring = uringpp::Ring<void>;
+using Connections = uringpp::ConnectionTable<Connection>;
 
 int listen(std::uint16_t port)
 {
@@ -61,136 +72,225 @@ int listen(std::uint16_t port)
     return listenFd;
 }
 
-void accept(Ring& ring, std::map<Data*, std::shared_ptr<Data>>& userData, int listenFd)
+auto maxFileDescriptors() -> std::size_t
 {
-    while (ring.capacity()) {
-        auto data = std::make_shared<Data>(CompletionType::Accept);
-        userData.emplace(data.get(), data);
-        ring.prepare_accept(listenFd, nullptr, nullptr, data);
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) < 0) {
+        throw std::runtime_error("failed to get file descriptor limit");
     }
+    return std::min<std::size_t>(limit.rlim_cur, 1 << 20);
 }
 
-void recv(
-    Ring& ring, std::map<Data*, std::shared_ptr<Data>>& userData, int fd, BufferPool& bufferPool)
+void recv(Ring& ring, Connections& connections, int fd, uringpp::BufferPoolManager& buffers)
 {
-    auto data = std::make_shared<Data>(CompletionType::Recv, fd);
-    userData.emplace(data.get(), data);
-    ring.prepare_recv_bp(fd, bufferPool, data);
+    auto& connection = connections.at(fd);
+    connection.recv.fd = fd;
+    connection.recv.fixedFile = true;
+    connection.recv.sizeClass = buffers.size_class_for(connection.sizeClass);
+    connection.recv.bufferPool = &buffers.pool(connection.recv.sizeClass);
+    connections.acquire(fd);
+    ring.prepare_operation<Operations>(connection.recv);
 }
 
 void send(
     Ring& ring,
-    std::map<Data*, std::shared_ptr<Data>>& userData,
+    Connections& connections,
     int fd,
-    BufferPool& bufferPool,
-    std::size_t bufferIdx)
+    uringpp::BufferPoolManager& buffers,
+    std::size_t sizeClass,
+    std::size_t bufferIdx,
+    std::size_t length)
 {
-    auto data = std::make_shared<Data>(CompletionType::Send, fd, bufferIdx);
-    userData.emplace(data.get(), data);
-    ring.prepare_send_bp(fd, bufferPool.at(bufferIdx), data);
+    auto& connection = connections.at(fd);
+    connection.send.fd = fd;
+    connection.send.fixedFile = true;
+    connection.send.buffer = buffers.buffer(sizeClass, bufferIdx).first(length);
+    connection.send.sizeClass = sizeClass;
+    connection.send.bufferIdx = bufferIdx;
+    connections.acquire(fd);
+    ring.prepare_operation<Operations>(connection.send);
 }
 
-auto createBufferPool(
-    Ring& ring,
-    std::map<Data*, std::shared_ptr<Data>>& userData,
-    std::size_t numberOfBuffers,
-    std::size_t sizePerBuffer) -> BufferPool
+void closeDirect(Ring& ring, Connections& connections, int fd)
 {
-    auto data = std::make_shared<Data>(CompletionType::CreateBufferPool);
-    userData.emplace(data.get(), data);
-    return ring.prepare_create_buffer_pool(numberOfBuffers, sizePerBuffer, data);
+    // The direct descriptor is only closed once the slot is released, so the kernel
+    // can not hand out the same slot while operations of the old connection are still
+    // in flight. The slot is claimed again until the close completed, so a single shot
+    // accept can not allocate it while the close is still queued.
+    connections.open(fd);
+    auto& connection = connections.at(fd);
+    connection.close.fileIndex = fd;
+    ring.prepare_operation<Operations>(connection.close);
 }
 
-void readdBufferPool(
-    Ring& ring,
-    std::map<Data*, std::shared_ptr<Data>>& userData,
-    BufferPool& bufferPool,
-    std::size_t bufferIdx)
+void closeConnection(Ring& ring, Connections& connections, int fd)
 {
-    auto data = std::make_shared<Data>(CompletionType::ReaddBufferPool);
-    data->bufferIdx = bufferIdx;
-    userData.emplace(data.get(), data);
-    ring.prepare_readd_buffer(bufferPool, bufferIdx, data);
+    // A receive may still complete on a connection a failed send already closes
+    if (connections.closing(fd)) {
+        return;
+    }
+    if (connections.close(fd)) {
+        closeDirect(ring, connections, fd);
+    }
 }
 
-auto echo(Ring& ring, std::size_t bufferPoolSize, int listenFd) -> auto
+void complete(Ring& ring, Connections& connections, int fd)
 {
-    std::map<Data*, std::shared_ptr<Data>> userData;
-    auto bufferPool = createBufferPool(ring, userData, bufferPoolSize, 1024);
+    if (connections.release(fd)) {
+        closeDirect(ring, connections, fd);
+    }
+}
 
-    accept(ring, userData, listenFd);
+auto echo(Ring& ring, std::size_t bufferPoolSize, int listenFd) -> auto
+{
+    Connections connections(maxFileDescriptors());
+    ring.register_files_sparse(connections.capacity());
+
+    // Small requests are served from small buffers, bulk transfers from large ones
+    uringpp::BufferPoolManager buffers({ { 256, bufferPoolSize * 4 },
+                                         { 4 * 1024, bufferPoolSize },
+                                         { 64 * 1024, bufferPoolSize / 4 + 1 } });
+    buffers.provide<Operations>(ring);
+    // Connections whose receive ran out of buffers, they keep their slot acquired
+    uringpp::ParkedReceives<int> parked(buffers.size_classes());
+
+    // A single multishot accept posts a completion per connection and lets the kernel
+    // allocate the direct descriptors. Older kernels accept one connection at a time
+    // into a slot allocated from the connection table.
+    const auto multishot = uringpp::Capabilities::get().has_multishot_accept();
+    uringpp::logSelectedPath("accept loop", multishot ? "multishot accept" : "single shot accept");
+
+    AcceptOp accept {};
+    accept.fd = listenFd;
+    accept.multishot = multishot;
+    bool acceptPaused = false;
+    auto armAccept = [&] {
+        if (!multishot) {
+            const auto slot = connections.allocate();
+            acceptPaused = slot < 0;
+            if (acceptPaused) {
+                std::cout << "* Accept paused: no free direct descriptor" << std::endl;
+                return;
+            }
+            accept.fileIndex = slot;
+        }
+        ring.prepare_operation<Operations>(accept);
+    };
+    armAccept();
     ring.submit();
 
-    while (true) {
-        auto completion = ring.wait();
+    auto handler = uringpp::Overloaded {
+        [&](AcceptOp& accept, AcceptOp::result_type result) {
+            // A single shot accept into a given slot completes with 0
+            const int acceptedSocketFd = multishot ? result.value() : accept.fileIndex;
 
-        switch (completion.userData()->type) {
-        case CompletionType::Accept: {
-            if (completion.result() < 0) {
-                throw std::runtime_error(
-                    std::string("failed to accept ") + strerror(-completion.result()));
+            if (!result.has_more()) {
+                armAccept();
+            }
+
+            if (!result.ok() && !multishot) {
+                connections.close(acceptedSocketFd);
             }
 
-            auto acceptedSocketFd = completion.result();
+            if (result.error() == ENFILE) {
+                // The registered file table is full, the connection was dropped
+                std::cout << "* Accept failed: no free direct descriptor" << std::endl;
+                return;
+            }
+
+            if (!result.ok()) {
+                throw std::runtime_error(std::string("failed to accept ") + strerror(result.error()));
+            }
 
             std::cout << "* Accepted[" << acceptedSocketFd << "]" << std::endl;
 
-            recv(ring, userData, acceptedSocketFd, bufferPool);
-            accept(ring, userData, listenFd);
-            break;
-        }
+            if (multishot) {
+                connections.open(acceptedSocketFd);
+            }
+            recv(ring, connections, acceptedSocketFd, buffers);
+        },
+        [&](RecvOp& recvOp, RecvOp::result_type result) {
+            const auto fd = recvOp.fd;
+            const auto sizeClass = recvOp.sizeClass;
+
+            if (result.error() == ENOBUFS && !connections.closing(fd)) {
+                // All buffers of the size class are in use, grow the size class. The
+                // receive is retried once the grown chunk or an echoed buffer is provided.
+                parked.park<Operations>(ring, buffers, sizeClass, fd);
+                return;
+            }
 
-        case CompletionType::Recv: {
-            if (completion.result() < 0) {
-                throw std::runtime_error(
-                    std::string("failed to recv from socket ") + strerror(-completion.result()));
+            if (!result.ok() || result.value() == 0 || connections.closing(fd)) {
+                if (result.ok() && result.value()) {
+                    buffers.acquired(sizeClass, result.value());
+                    buffers.release<Operations>(ring, sizeClass, result.buffer_idx());
+                }
+                closeConnection(ring, connections, fd);
+                complete(ring, connections, fd);
+                return;
             }
 
-            int bufferIdx = completion.get()->flags >> 16;
+            auto buffer = buffers.buffer(sizeClass, result.buffer_idx());
+            buffers.acquired(sizeClass, result.value());
+            connections.at(fd).sizeClass.observe(result.value(), result.value() == buffer.size());
 
-            std::cout << "* Received[" << completion.userData()->fd
-                      << "]: " << bufferPool.at(completion.userData()->bufferIdx).data()
+            std::cout << "* Received[" << fd << "]: "
+                      << std::string_view(reinterpret_cast<const char*>(buffer.data()), result.value())
                       << std::endl;
 
-            send(ring, userData, completion.userData()->fd, bufferPool, bufferIdx);
-            break;
-        }
-
-        case CompletionType::Send: {
-            if (completion.result() < 0) {
-                throw std::runtime_error(
-                    std::string("failed to send to socket") + strerror(-completion.result()));
+            send(ring, connections, fd, buffers, sizeClass, result.buffer_idx(), result.value());
+            complete(ring, connections, fd);
+        },
+        [&](SendOp& sendOp, SendOp::result_type result) {
+            const auto fd = sendOp.fd;
+            buffers.release<Operations>(ring, sendOp.sizeClass, sendOp.bufferIdx);
+
+            if (!result.ok()) {
+                std::cout << "* Send[" << fd << "] failed: " << strerror(result.error()) << std::endl;
+                closeConnection(ring, connections, fd);
+            } else {
+                std::cout << "* Send[" << fd << "]: " << result.value() << " bytes" << std::endl;
+                if (!connections.closing(fd)) {
+                    recv(ring, connections, fd, buffers);
+                }
             }
+            complete(ring, connections, fd);
+        },
+        [&](CloseOp& close, CloseOp::result_type result) {
+            if (!result.ok()) {
+                throw std::runtime_error(std::string("failed to close ") + strerror(result.error()));
+            }
+            std::cout << "* Closed[" << close.fileIndex << "]" << std::endl;
 
-            std::cout << "* Send[" << completion.userData()->fd
-                      << "]: " << bufferPool.at(completion.userData()->bufferIdx).data()
-                      << std::endl;
-            readdBufferPool(ring, userData, bufferPool, completion.userData()->bufferIdx);
-            recv(ring, userData, completion.userData()->fd, bufferPool);
-            break;
-        }
-
-        case CompletionType::CreateBufferPool: {
-            if (completion.result() < 0) {
+            // The slot can be handed out again
+            connections.close(close.fileIndex);
+            if (acceptPaused) {
+                armAccept();
+            }
+        },
+        [&](ProvideBuffersOp& provideBuffers, ProvideBuffersOp::result_type result) {
+            if (!result.ok()) {
                 throw std::runtime_error(
-                    std::string("failed to create buffer pool ") + strerror(-completion.result()));
+                    std::string("failed to provide buffers ") + strerror(result.error()));
             }
 
-            std::cout << "* Create buffer pool" << std::endl;
-            break;
-        }
-
-        case CompletionType::ReaddBufferPool: {
-            if (completion.result() < 0) {
-                throw std::runtime_error(
-                    std::string("failed to add buffer pool ") + strerror(-completion.result()));
+            if (provideBuffers.numberOfBuffers > 1) {
+                std::cout << "* Provided " << provideBuffers.numberOfBuffers << " buffers of "
+                          << buffers.buffer_size(provideBuffers.sizeClass) << " bytes" << std::endl;
             }
 
-            std::cout << "* Readded buffer pool " << completion.userData()->bufferIdx << std::endl;
-            break;
-        }
+            parked.provided(buffers, provideBuffers, [&](int fd) {
+                if (!connections.closing(fd)) {
+                    recv(ring, connections, fd, buffers);
+                }
+                complete(ring, connections, fd);
+            });
         }
-        userData.erase(completion.userData());
+    };
+
+    while (true) {
+        auto completion = ring.wait();
+        Operations::dispatch(completion.get(), handler);
         ring.seen(completion);
         ring.submit();
     }
@@ -207,6 +307,7 @@ int main(int argc, char const* argv[])
     const auto queueSize = 64;
     const auto bufferPoolSize = 2;
     Ring ring { queueSize};
+    uringpp::enablePathLogging();
 
     std::cout << "Tcp echo server started. Listening on port " << port << "." << std::endl;
     std::cout << "Io uring fast poll enabled: " << ring.has_fast_poll() << std::endl;
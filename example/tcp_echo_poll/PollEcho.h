@@ -0,0 +1,415 @@
+#pragma once
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <uringpp/uringpp.h>
+
+#include <array>
+#include <iostream>
+#include <map>
+#include <string>
+#include <string_view>
+
+enum class CompletionType : std::uint8_t {
+    Accept = 0,
+    Recv = 1,
+    Send = 2,
+    Poll = 3,
+    CreateBufferPool = 4,
+    ReaddBufferPool = 5,
+    PollUpdate = 6,
+    PollRemove = 7
+};
+
+struct Data {
+    Data(CompletionType type, int fd = 0, std::size_t bufferIdx = 0)
+        : type(type)
+        , fd(fd)
+        , bufferIdx(bufferIdx)
+    {
+    }
+
+    CompletionType type;
+    int fd;
+    std::size_t bufferIdx;
+    std::size_t offset = 0;
+    std::size_t length = 0;
+};
+
+// A connection is watched by a single multishot poll for its whole lifetime.
+// Write readiness is only watched while a send is incomplete. A connection has
+// one receive at a time, readiness while it is in flight receives once more.
+struct Connection {
+    std::shared_ptr<Data> poll;
+    std::shared_ptr<Data> pendingSend;
+    bool receiving = false;
+    bool readable = false;
+    // Sends in flight
+    std::size_t sends = 0;
+    // The peer shut its sending side down, it is received from until its end
+    bool peerClosed = false;
+    // A receive returned the end of the data of the peer
+    bool drained = false;
+    bool closing = false;
+};
+
+using Ring = uringpp::Ring<Data>;
+using UserDataMap = std::map<Data*, std::shared_ptr<Data>>;
+using ParkedReceives = uringpp::ParkedReceives<int>;
+
+const unsigned readMask = POLLIN | POLLRDHUP;
+const unsigned readWriteMask = readMask | POLLOUT;
+
+inline int listen(std::uint16_t port)
+{
+    int listenFd;
+    struct sockaddr_in address;
+    int opt = 1;
+
+    if ((listenFd = socket(AF_INET, SOCK_STREAM, 0)) == 0) {
+        throw std::runtime_error("failed create socket");
+    }
+
+    if (setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR | SO_REUSEPORT, &opt, sizeof(opt))) {
+        throw std::runtime_error("failed to setsocketopt");
+    }
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = INADDR_ANY;
+    address.sin_port = htons(port);
+
+    if (bind(listenFd, (struct sockaddr*)&address, sizeof(address)) < 0) {
+        throw std::runtime_error("failed to bind");
+    }
+
+    if (listen(listenFd, 3) < 0) {
+        throw std::runtime_error("failed to listen");
+    }
+
+    return listenFd;
+}
+
+inline void accept(Ring& ring, UserDataMap& userData, int listenFd)
+{
+    while (ring.capacity()) {
+        auto data = std::make_shared<Data>(CompletionType::Accept);
+        userData.emplace(data.get(), data);
+        ring.prepare_accept(listenFd, nullptr, nullptr, data);
+    }
+}
+
+inline void recv(
+    Ring& ring, UserDataMap& userData, int fd, BufferPool& bufferPool)
+{
+    auto data = std::make_shared<Data>(CompletionType::Recv, fd);
+    userData.emplace(data.get(), data);
+    ring.prepare_recv_bp(fd, bufferPool, data);
+}
+
+inline void send(
+    Ring& ring,
+    UserDataMap& userData,
+    int fd,
+    BufferPool& bufferPool,
+    std::size_t bufferIdx,
+    std::size_t offset,
+    std::size_t length)
+{
+    auto data = std::make_shared<Data>(CompletionType::Send, fd, bufferIdx);
+    data->offset = offset;
+    data->length = length;
+    userData.emplace(data.get(), data);
+    ring.prepare_send_bp(fd, bufferPool.at(bufferIdx).subspan(offset, length), data);
+}
+
+inline void receive(
+    Ring& ring, UserDataMap& userData, Connection& connection, int fd, BufferPool& bufferPool)
+{
+    if (connection.closing) {
+        return;
+    }
+    if (connection.receiving) {
+        connection.readable = true;
+        return;
+    }
+    connection.receiving = true;
+    connection.readable = false;
+    recv(ring, userData, fd, bufferPool);
+}
+
+inline auto poll(Ring& ring, UserDataMap& userData, int fd) -> std::shared_ptr<Data>
+{
+    auto data = std::make_shared<Data>(CompletionType::Poll, fd);
+    userData.emplace(data.get(), data);
+    ring.prepare_poll_multishot(fd, readMask, data);
+    return data;
+}
+
+inline void pollUpdate(Ring& ring, UserDataMap& userData, Connection& connection, unsigned pollMask)
+{
+    auto data = std::make_shared<Data>(CompletionType::PollUpdate, connection.poll->fd);
+    userData.emplace(data.get(), data);
+    ring.prepare_poll_update(
+        connection.poll,
+        connection.poll,
+        pollMask,
+        IORING_POLL_UPDATE_EVENTS | IORING_POLL_ADD_MULTI,
+        data);
+}
+
+inline void pollRemove(Ring& ring, UserDataMap& userData, Connection& connection)
+{
+    auto data = std::make_shared<Data>(CompletionType::PollRemove, connection.poll->fd);
+    userData.emplace(data.get(), data);
+    connection.closing = true;
+    ring.prepare_poll_remove(connection.poll, data);
+}
+
+// Closes the connection once all data of the peer was received and echoed
+inline void closeIfEchoed(Ring& ring, UserDataMap& userData, Connection& connection)
+{
+    if (connection.drained && !connection.sends && !connection.pendingSend
+        && !connection.closing) {
+        pollRemove(ring, userData, connection);
+    }
+}
+
+inline auto createBufferPool(
+    Ring& ring,
+    UserDataMap& userData,
+    std::size_t numberOfBuffers,
+    std::size_t sizePerBuffer) -> BufferPool
+{
+    auto data = std::make_shared<Data>(CompletionType::CreateBufferPool);
+    userData.emplace(data.get(), data);
+    return ring.prepare_create_buffer_pool(numberOfBuffers, sizePerBuffer, data);
+}
+
+inline void readdBufferPool(
+    Ring& ring,
+    UserDataMap& userData,
+    BufferPool& bufferPool,
+    std::size_t bufferIdx)
+{
+    auto data = std::make_shared<Data>(CompletionType::ReaddBufferPool);
+    data->bufferIdx = bufferIdx;
+    userData.emplace(data.get(), data);
+    ring.prepare_readd_buffer(bufferPool, bufferIdx, data);
+}
+
+/*
+ * Echoes the connections accepted on listenFd
+ *
+ * @param[in] maxConnections number of connections to serve until it returns, 0 to
+ *            serve forever
+ */
+inline auto echo(
+    Ring& ring, std::size_t bufferPoolSize, int listenFd, std::size_t maxConnections = 0) -> void
+{
+    UserDataMap userData;
+    std::map<int, Connection> connections;
+    ParkedReceives parked;
+    std::size_t closedConnections = 0;
+    auto bufferPool = createBufferPool(ring, userData, bufferPoolSize, 1024);
+
+    accept(ring, userData, listenFd);
+    ring.submit();
+
+    while (true) {
+        auto completion = ring.wait();
+        auto data = completion.userData();
+
+        switch (data->type) {
+        case CompletionType::Accept: {
+            if (completion.result() < 0) {
+                throw std::runtime_error(
+                    std::string("failed to accept ") + strerror(-completion.result()));
+            }
+
+            auto acceptedSocketFd = completion.result();
+
+            std::cout << "* Accepted[" << acceptedSocketFd << "]" << std::endl;
+
+            connections[acceptedSocketFd].poll = poll(ring, userData, acceptedSocketFd);
+            accept(ring, userData, listenFd);
+            break;
+        }
+
+        case CompletionType::Recv: {
+            auto connection = connections.find(data->fd);
+
+            if (completion.result() == -ENOBUFS && connection != connections.end()
+                && !connection->second.closing) {
+                // No buffer left: the poll does not fire again for data which is already
+                // queued, so the receive is retried once a sent buffer was readded
+                std::cout << "* Recv[" << data->fd << "] no buffer available" << std::endl;
+                parked.park(data->fd);
+                break;
+            }
+
+            if (connection == connections.end() || connection->second.closing) {
+                if (completion.result() > 0) {
+                    const auto bufferIdx = completion.get()->flags >> IORING_CQE_BUFFER_SHIFT;
+                    readdBufferPool(ring, userData, bufferPool, bufferIdx);
+                }
+                break;
+            }
+
+            connection->second.receiving = false;
+            if (completion.result() <= 0) {
+                if (completion.result() < 0) {
+                    std::cout << "* Recv[" << data->fd << "] failed: "
+                              << strerror(-completion.result()) << std::endl;
+                }
+                connection->second.drained = true;
+                closeIfEchoed(ring, userData, connection->second);
+                break;
+            }
+
+            int bufferIdx = completion.get()->flags >> IORING_CQE_BUFFER_SHIFT;
+            const auto length = static_cast<std::size_t>(completion.result());
+
+            std::cout << "* Received[" << data->fd << "]: "
+                      << std::string_view(
+                             reinterpret_cast<const char*>(bufferPool.at(bufferIdx).data()), length)
+                      << std::endl;
+
+            send(ring, userData, data->fd, bufferPool, bufferIdx, 0, length);
+            connection->second.sends++;
+
+            // The poll only triggers on new data, so drain what did not fit into the buffer.
+            // A shut down peer is received from until the end of its data.
+            if (length == bufferPool.buffer_size() || connection->second.readable
+                || connection->second.peerClosed) {
+                receive(ring, userData, connection->second, data->fd, bufferPool);
+            }
+            break;
+        }
+
+        case CompletionType::Send: {
+            if (completion.result() < 0) {
+                throw std::runtime_error(
+                    std::string("failed to send to socket") + strerror(-completion.result()));
+            }
+
+            const auto sent = static_cast<std::size_t>(completion.result());
+            auto connection = connections.find(data->fd);
+            if (connection != connections.end()) {
+                connection->second.sends--;
+            }
+
+            if (sent < data->length && connection != connections.end()
+                && !connection->second.closing) {
+                // Socket buffer is full: continue once the socket is writable again
+                connection->second.pendingSend = userData.at(data);
+                data->offset += sent;
+                data->length -= sent;
+                pollUpdate(ring, userData, connection->second, readWriteMask);
+                break;
+            }
+
+            std::cout << "* Send[" << data->fd << "]: " << sent << " bytes" << std::endl;
+            readdBufferPool(ring, userData, bufferPool, data->bufferIdx);
+            if (connection != connections.end()) {
+                closeIfEchoed(ring, userData, connection->second);
+            }
+            break;
+        }
+
+        case CompletionType::Poll: {
+            auto& connection = connections.at(data->fd);
+            const auto events = completion.result();
+
+            if (events >= 0) {
+                std::cout << "* Poll[" << data->fd << "] " << events << std::endl;
+
+                if (events & POLLOUT && connection.pendingSend) {
+                    auto pendingSend = std::move(connection.pendingSend);
+                    send(
+                        ring,
+                        userData,
+                        data->fd,
+                        bufferPool,
+                        pendingSend->bufferIdx,
+                        pendingSend->offset,
+                        pendingSend->length);
+                    connection.sends++;
+                    pollUpdate(ring, userData, connection, readMask);
+                }
+
+                if (events & (POLLRDHUP | POLLHUP | POLLERR)) {
+                    connection.peerClosed = true;
+                }
+
+                // A shut down connection is closed once a receive returned its end
+                if (events & (POLLIN | POLLRDHUP | POLLHUP | POLLERR)) {
+                    receive(ring, userData, connection, data->fd, bufferPool);
+                }
+            }
+
+            if (!completion.has_more()) {
+                if (connection.closing || events < 0) {
+                    // Last completion of the poll: the connection is gone
+                    std::cout << "* Closed[" << data->fd << "]" << std::endl;
+                    if (connection.pendingSend) {
+                        readdBufferPool(
+                            ring, userData, bufferPool, connection.pendingSend->bufferIdx);
+                    }
+                    close(data->fd);
+                    connections.erase(data->fd);
+                    parked.remove(data->fd);
+                    closedConnections++;
+                } else {
+                    // The kernel may terminate a multishot poll e.g. on completion queue overflow
+                    connection.poll = poll(ring, userData, data->fd);
+                }
+                userData.erase(data);
+            }
+            ring.seen(completion);
+            if (maxConnections && closedConnections == maxConnections) {
+                return;
+            }
+            ring.submit();
+            continue;
+        }
+
+        case CompletionType::PollUpdate:
+        case CompletionType::PollRemove: {
+            if (completion.result() < 0 && completion.result() != -ENOENT) {
+                throw std::runtime_error(
+                    std::string("failed to update poll ") + strerror(-completion.result()));
+            }
+            break;
+        }
+
+        case CompletionType::CreateBufferPool: {
+            if (completion.result() < 0) {
+                throw std::runtime_error(
+                    std::string("failed to create buffer pool ") + strerror(-completion.result()));
+            }
+
+            std::cout << "* Create buffer pool" << std::endl;
+            break;
+        }
+
+        case CompletionType::ReaddBufferPool: {
+            if (completion.result() < 0) {
+                throw std::runtime_error(
+                    std::string("failed to add buffer pool ") + strerror(-completion.result()));
+            }
+
+            std::cout << "* Readded buffer pool " << data->bufferIdx << std::endl;
+            parked.resume(0, 1, [&](int fd) { recv(ring, userData, fd, bufferPool); });
+            break;
+        }
+        }
+        userData.erase(data);
+        ring.seen(completion);
+        ring.submit();
+    }
+}
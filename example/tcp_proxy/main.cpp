@@ -0,0 +1,66 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <uringpp/uringpp.h>
+
+#include <iostream>
+#include <string>
+
+int listen(std::uint16_t port)
+{
+    int listenFd;
+    struct sockaddr_in address;
+    int opt = 1;
+
+    if ((listenFd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
+        throw std::runtime_error("failed create socket");
+    }
+
+    if (setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR | SO_REUSEPORT, &opt, sizeof(opt))) {
+        throw std::runtime_error("failed to setsocketopt");
+    }
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = INADDR_ANY;
+    address.sin_port = htons(port);
+
+    if (bind(listenFd, (struct sockaddr*)&address, sizeof(address)) < 0) {
+        throw std::runtime_error("failed to bind");
+    }
+
+    if (listen(listenFd, SOMAXCONN) < 0) {
+        throw std::runtime_error("failed to listen");
+    }
+
+    return listenFd;
+}
+
+int main(int argc, char const* argv[])
+{
+    if (argc < 4) {
+        std::cout << "Usage: tcp_proxy <PORT> <UPSTREAM_ADDRESS> <UPSTREAM_PORT> [--buffers]"
+                  << std::endl;
+        return 1;
+    }
+
+    sockaddr_in upstream {};
+    upstream.sin_family = AF_INET;
+    upstream.sin_port = htons(std::stoi(argv[3]));
+    if (inet_pton(AF_INET, argv[2], &upstream.sin_addr) != 1) {
+        std::cout << "Invalid upstream address " << argv[2] << std::endl;
+        return 1;
+    }
+
+    // A peer which closed its socket must not kill the proxy
+    signal(SIGPIPE, SIG_IGN);
+
+    const auto port = std::stoi(argv[1]);
+    const bool buffers = argc > 4 && std::string(argv[4]) == "--buffers";
+    uringpp::TcpProxy proxy(listen(port), upstream, { .splice = !buffers });
+
+    std::cout << "Tcp proxy started. Forwarding port " << port << " to " << argv[2] << ":"
+              << argv[3] << "." << std::endl;
+    proxy.run();
+
+    return 0;
+}
@@ -0,0 +1,187 @@
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <uringpp/uringpp.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Udp echo server and sink. A single multishot recvmsg receives all datagrams into
+// provided buffers. The echo mode sends each datagram back to its source from the
+// buffer it was received in, the sink mode only counts the datagrams.
+
+struct RecvOp : uringpp::op::RecvMsgMultishot {
+};
+
+struct SendOp : uringpp::op::SendMsg {
+    std::size_t bufferIdx;
+    msghdr message;
+    iovec payload;
+    sockaddr_storage address;
+};
+
+struct ProvideBuffersOp : uringpp::op::ProvideBuffers {
+};
+
+using Operations = uringpp::OperationSet<RecvOp, SendOp, ProvideBuffersOp>;
+using Ring = uringpp::Ring<void>;
+
+constexpr std::size_t maxDatagramSize = 2048;
+
+int bindUdp(std::uint16_t port)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        throw std::runtime_error("failed create socket");
+    }
+
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = INADDR_ANY;
+    address.sin_port = htons(port);
+
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        throw std::runtime_error("failed to bind");
+    }
+
+    return fd;
+}
+
+auto serve(Ring& ring, int fd, std::size_t bufferPoolSize, bool sink) -> void
+{
+    // Each buffer holds the recvmsg header, the source address and the payload
+    BufferPool bufferPool(
+        bufferPoolSize, sizeof(io_uring_recvmsg_out) + sizeof(sockaddr_storage) + maxDatagramSize, 0);
+
+    ProvideBuffersOp provide {};
+    provide.bufferPool = &bufferPool;
+    provide.numberOfBuffers = bufferPool.pool_size();
+    ring.prepare_operation<Operations>(provide);
+
+    // Buffers are in flight with either a send or a readd, so both are stored per buffer
+    std::vector<SendOp> sends(bufferPool.pool_size());
+    std::vector<ProvideBuffersOp> readds(bufferPool.pool_size());
+
+    msghdr recvMessage {};
+    recvMessage.msg_namelen = sizeof(sockaddr_storage);
+
+    RecvOp recv {};
+    recv.fd = fd;
+    recv.msg = &recvMessage;
+    recv.bufferPool = &bufferPool;
+    ring.prepare_operation<Operations>(recv);
+    bool recvArmed = true;
+    ring.submit();
+
+    std::uint64_t datagrams = 0;
+    auto lastReport = std::chrono::steady_clock::now();
+
+    auto readd = [&](std::size_t bufferIdx) {
+        auto& op = readds[bufferIdx];
+        op.bufferPool = &bufferPool;
+        op.bufferIdx = bufferIdx;
+        ring.prepare_operation<Operations>(op);
+    };
+
+    auto handler = uringpp::Overloaded {
+        [&](RecvOp& recv, RecvOp::result_type result) {
+            if (!result.has_more()) {
+                // Out of buffers the receive is rearmed once a buffer was readded
+                recvArmed = result.error() != ENOBUFS;
+                if (recvArmed) {
+                    ring.prepare_operation<Operations>(recv);
+                }
+            }
+
+            if (!result.ok()) {
+                if (result.error() != ENOBUFS) {
+                    std::cout << "* Recv failed: " << strerror(result.error()) << std::endl;
+                }
+                return;
+            }
+
+            const auto bufferIdx = result.buffer_idx();
+            uringpp::RecvMsgOut datagram(bufferPool.at(bufferIdx), result.value(), recvMessage);
+            if (!datagram.valid() || sink) {
+                readd(bufferIdx);
+                datagrams += datagram.valid();
+                return;
+            }
+
+            if (datagram.payload_truncated()) {
+                std::cout << "* Truncated datagram" << std::endl;
+            }
+
+            auto& send = sends[bufferIdx];
+            std::memcpy(&send.address, datagram.name(), datagram.name_length());
+            send.payload.iov_base = datagram.payload().data();
+            send.payload.iov_len = datagram.payload().size();
+            send.message = {};
+            send.message.msg_name = &send.address;
+            send.message.msg_namelen = datagram.name_length();
+            send.message.msg_iov = &send.payload;
+            send.message.msg_iovlen = 1;
+            send.fd = fd;
+            send.msg = &send.message;
+            send.bufferIdx = bufferIdx;
+            ring.prepare_operation<Operations>(send);
+            datagrams++;
+        },
+        [&](SendOp& send, SendOp::result_type result) {
+            if (!result.ok()) {
+                std::cout << "* Send failed: " << strerror(result.error()) << std::endl;
+            }
+            readd(send.bufferIdx);
+        },
+        [&](ProvideBuffersOp&, ProvideBuffersOp::result_type result) {
+            if (!result.ok()) {
+                throw std::runtime_error(
+                    std::string("failed to provide buffers ") + strerror(result.error()));
+            }
+
+            if (!recvArmed) {
+                ring.prepare_operation<Operations>(recv);
+                recvArmed = true;
+            }
+        }
+    };
+
+    while (true) {
+        auto completion = ring.wait();
+        Operations::dispatch(completion.get(), handler);
+        ring.seen(completion);
+        ring.submit();
+
+        const auto now = std::chrono::steady_clock::now();
+        if (now - lastReport >= std::chrono::seconds(1)) {
+            std::cout << "* " << datagrams << " datagrams/s" << std::endl;
+            datagrams = 0;
+            lastReport = now;
+        }
+    }
+}
+
+int main(int argc, char const* argv[])
+{
+    if (argc < 2) {
+        std::cout << "Usage: udp_echo <PORT> [sink]" << std::endl;
+        return 1;
+    }
+
+    const auto port = std::stoi(argv[1]);
+    const auto sink = argc > 2 && std::string(argv[2]) == "sink";
+    const auto queueSize = 256;
+    const auto bufferPoolSize = 256;
+    Ring ring { queueSize };
+
+    std::cout << "Udp " << (sink ? "sink" : "echo") << " server started. Listening on port " << port
+              << "." << std::endl;
+
+    serve(ring, bindUdp(port), bufferPoolSize, sink);
+
+    return 0;
+}
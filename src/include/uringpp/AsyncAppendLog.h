@@ -0,0 +1,416 @@
+#pragma once
+
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "uringpp/Operation.h"
+#include "uringpp/Ring.h"
+
+namespace uringpp {
+
+enum class Durability {
+    // fsync(2), data and metadata reached the device
+    Fsync,
+    // fdatasync(2), data and the metadata needed to read it back reached the device
+    DataSync,
+    // sync_file_range(2) of the appended range, only writes back the page cache
+    SyncFileRange,
+};
+
+struct AppendLogOptions {
+    Durability durability = Durability::DataSync;
+    // Appends and bytes merged into the writev of one commit group
+    std::size_t maxGroupAppends = 256;
+    std::size_t maxGroupBytes = 1024 * 1024;
+    // Commit groups which write and sync at the same time
+    std::size_t maxGroupsInFlight = 2;
+};
+
+/*
+ * Append only log with group commit.
+ *
+ * append() only queues the data, commit() merges the queued appends into commit
+ * groups. Each group is written with one writev and flushed by a sync which is
+ * linked behind the writev, so one sync covers all appends of the group. Appends
+ * which arrive while groups are in flight wait for the next group.
+ *
+ * The durability callback of an append is called with 0 once the append and all
+ * appends before it are durable, or with the error of the first failed write or
+ * sync. After a failure the log accepts no further appends, since it is unknown
+ * which data reached the device. Callbacks may append, but must not commit, poll
+ * or wait on the log.
+ */
+class AsyncAppendLog {
+  public:
+    using OnDurable = std::function<void(int error)>;
+
+  private:
+    struct Group;
+
+    struct WriteGroup : op::Writev {
+        Group* group;
+    };
+
+    struct SyncGroup : op::Fsync {
+        Group* group;
+    };
+
+    struct SyncGroupRange : op::SyncFileRange {
+        Group* group;
+    };
+
+    using Operations = OperationSet<WriteGroup, SyncGroup, SyncGroupRange>;
+
+    struct Append {
+        iovec vec;
+        OnDurable onDurable;
+    };
+
+    struct Group {
+        std::uint64_t offset = 0;
+        std::size_t bytes = 0;
+        std::size_t written = 0;
+        std::vector<iovec> vecs;
+        std::vector<OnDurable> callbacks;
+        std::size_t pendingCompletions = 0;
+        int error = 0;
+        bool syncCancelled = false;
+        bool durable = false;
+        WriteGroup writeOp;
+        SyncGroup syncOp;
+        SyncGroupRange syncRangeOp;
+    };
+
+  public:
+    /*
+     * @param[in] file log file which is created if it does not exist, appends
+     *            start at its end
+     */
+    explicit AsyncAppendLog(const std::filesystem::path& file, AppendLogOptions options = {})
+        : m_options(checkOptions(options))
+        , m_fd(::open(file.c_str(), O_WRONLY | O_CREAT, 0644))
+        , m_ring(2 * m_options.maxGroupsInFlight)
+    {
+        struct stat fileStat;
+        if (m_fd < 0 || fstat(m_fd, &fileStat) < 0) {
+            const auto error = errno;
+            if (m_fd >= 0) {
+                ::close(m_fd);
+            }
+            throw std::runtime_error(
+                std::string("Failed to open log ") + file.c_str() + ": " + strerror(error));
+        }
+        m_end = fileStat.st_size;
+        m_committedEnd = m_end;
+        m_durableEnd = m_end;
+    }
+
+    AsyncAppendLog(const AsyncAppendLog&) = delete;
+    auto operator=(const AsyncAppendLog&) -> AsyncAppendLog& = delete;
+
+    ~AsyncAppendLog()
+    {
+        // The kernel may still read the appended data of groups in flight
+        while (!m_groups.empty()) {
+            complete(m_ring.wait());
+        }
+        ::close(m_fd);
+    }
+
+    /*
+     * Queues data to be appended to the log
+     *
+     * @param[in] data data which must stay valid until onDurable was called
+     * @param[in] onDurable called once the data is durable or failed
+     * @return offset of the data in the log
+     */
+    auto append(std::span<const std::uint8_t> data, OnDurable onDurable) -> std::uint64_t
+    {
+        if (m_error) {
+            throw std::runtime_error(std::string("Log failed: ") + strerror(m_error));
+        }
+
+        const auto offset = m_end;
+        m_pending.push_back({ { const_cast<std::uint8_t*>(data.data()), data.size() },
+                              std::move(onDurable) });
+        m_end += data.size();
+        return offset;
+    }
+
+    /*
+     * Starts commit groups for the queued appends, as far as maxGroupsInFlight
+     * allows. Remaining appends are committed once groups in flight complete.
+     */
+    auto commit() -> void
+    {
+        while (!m_pending.empty() && m_groups.size() < m_options.maxGroupsInFlight) {
+            startGroup();
+        }
+        m_ring.submit();
+    }
+
+    /*
+     * Handles the completed writes and syncs without blocking
+     *
+     * @return number of appends which became durable or failed
+     */
+    auto poll() -> std::size_t
+    {
+        std::size_t notified = 0;
+        while (auto completion = m_ring.peek()) {
+            notified += complete(*completion);
+        }
+        commit();
+        return notified;
+    }
+
+    /*
+     * Waits for at least one completion unless nothing is in flight
+     *
+     * @return number of appends which became durable or failed
+     */
+    auto wait() -> std::size_t
+    {
+        commit();
+        if (m_groups.empty()) {
+            return 0;
+        }
+        auto notified = complete(m_ring.wait());
+        return notified + poll();
+    }
+
+    /*
+     * Commits all queued appends and waits until they are durable or failed
+     */
+    auto flush() -> void
+    {
+        while (!m_pending.empty() || !m_groups.empty()) {
+            wait();
+        }
+    }
+
+    /*
+     * End of the log including the queued appends
+     */
+    auto size() const -> std::uint64_t
+    {
+        return m_end;
+    }
+
+    /*
+     * End of the durable part of the log
+     */
+    auto durable_size() const -> std::uint64_t
+    {
+        return m_durableEnd;
+    }
+
+    auto pending() const -> std::size_t
+    {
+        return m_pending.size();
+    }
+
+    auto groups_committed() const -> std::uint64_t
+    {
+        return m_groupsCommitted;
+    }
+
+    auto options() const -> const AppendLogOptions&
+    {
+        return m_options;
+    }
+
+  private:
+    static auto checkOptions(AppendLogOptions options) -> AppendLogOptions
+    {
+        if (!options.maxGroupAppends || !options.maxGroupBytes || !options.maxGroupsInFlight) {
+            throw std::invalid_argument("Append log limits need to be positive");
+        }
+        options.maxGroupAppends = std::min<std::size_t>(options.maxGroupAppends, IOV_MAX);
+        return options;
+    }
+
+    auto startGroup() -> void
+    {
+        auto& group = m_groups.emplace_back();
+        group.offset = m_committedEnd;
+
+        // A single append larger than maxGroupBytes forms a group of its own
+        while (!m_pending.empty() && group.vecs.size() < m_options.maxGroupAppends
+               && (group.vecs.empty()
+                   || group.bytes + m_pending.front().vec.iov_len <= m_options.maxGroupBytes)) {
+            auto& append = m_pending.front();
+            group.vecs.push_back(append.vec);
+            group.callbacks.push_back(std::move(append.onDurable));
+            group.bytes += append.vec.iov_len;
+            m_pending.pop_front();
+        }
+
+        m_committedEnd += group.bytes;
+        m_groupsCommitted++;
+        group.writeOp.group = &group;
+        group.syncOp.group = &group;
+        group.syncRangeOp.group = &group;
+        prepareGroup(group);
+    }
+
+    /*
+     * Prepares the write of the unwritten part of the group and the sync linked
+     * behind it
+     */
+    auto prepareGroup(Group& group) -> void
+    {
+        group.writeOp.fd = m_fd;
+        group.writeOp.vecs = group.vecs.data();
+        group.writeOp.numberOfVecs = group.vecs.size();
+        group.writeOp.offset = group.offset + group.written;
+        group.writeOp.link = true;
+        m_ring.prepare_operation<Operations>(group.writeOp);
+
+        if (m_options.durability == Durability::SyncFileRange) {
+            group.syncRangeOp.fd = m_fd;
+            group.syncRangeOp.offset = group.offset;
+            group.syncRangeOp.length = 0;
+            m_ring.prepare_operation<Operations>(group.syncRangeOp);
+        } else {
+            group.syncOp.fd = m_fd;
+            group.syncOp.dataSync = m_options.durability == Durability::DataSync;
+            m_ring.prepare_operation<Operations>(group.syncOp);
+        }
+
+        group.pendingCompletions = 2;
+        group.syncCancelled = false;
+    }
+
+    auto complete(const Completion<void>& completion) -> std::size_t
+    {
+        Group* completed = nullptr;
+        Operations::dispatch(
+            completion.get(),
+            Overloaded {
+                [&](WriteGroup& write, WriteGroup::result_type result) {
+                    onWrite(*write.group, result);
+                    completed = write.group;
+                },
+                [&](SyncGroup& sync, SyncGroup::result_type result) {
+                    onSync(*sync.group, result);
+                    completed = sync.group;
+                },
+                [&](SyncGroupRange& sync, SyncGroupRange::result_type result) {
+                    onSync(*sync.group, result);
+                    completed = sync.group;
+                } });
+        m_ring.seen(completion);
+
+        if (--completed->pendingCompletions) {
+            return 0;
+        }
+
+        if (!completed->error && completed->written < completed->bytes) {
+            // A short write cancelled the linked sync, continue with the rest
+            prepareGroup(*completed);
+            m_ring.submit();
+            return 0;
+        }
+        if (!completed->error && completed->syncCancelled) {
+            completed->error = ECANCELED;
+        }
+        completed->durable = true;
+        return notify();
+    }
+
+    auto onWrite(Group& group, Result<std::size_t> result) -> void
+    {
+        if (!result.ok() || (!result.value() && group.written < group.bytes)) {
+            group.error = group.error ? group.error : (result.ok() ? EIO : result.error());
+            return;
+        }
+
+        group.written += result.value();
+        auto written = result.value();
+        auto vec = group.vecs.begin();
+        for (; vec != group.vecs.end() && written >= vec->iov_len; vec++) {
+            written -= vec->iov_len;
+        }
+        if (vec != group.vecs.end()) {
+            vec->iov_base = static_cast<std::uint8_t*>(vec->iov_base) + written;
+            vec->iov_len -= written;
+        }
+        group.vecs.erase(group.vecs.begin(), vec);
+    }
+
+    auto onSync(Group& group, Result<std::int32_t> result) -> void
+    {
+        // A sync which was cancelled by a short write is issued again
+        if (!result.ok() && result.error() == ECANCELED) {
+            group.syncCancelled = true;
+        } else if (!result.ok() && !group.error) {
+            group.error = result.error();
+        }
+    }
+
+    /*
+     * Notifies the appends of the completed groups in log order. A group can only
+     * be reported durable after all groups before it.
+     */
+    auto notify() -> std::size_t
+    {
+        std::size_t notified = 0;
+        while (!m_groups.empty() && m_groups.front().durable) {
+            auto& group = m_groups.front();
+            m_error = m_error ? m_error : group.error;
+            if (!m_error) {
+                m_durableEnd = group.offset + group.bytes;
+            }
+
+            for (auto& onDurable : group.callbacks) {
+                onDurable(m_error);
+            }
+            notified += group.callbacks.size();
+            m_groups.pop_front();
+        }
+
+        if (m_error) {
+            failPending();
+        }
+        return notified;
+    }
+
+    auto failPending() -> void
+    {
+        while (!m_pending.empty()) {
+            auto onDurable = std::move(m_pending.front().onDurable);
+            m_pending.pop_front();
+            onDurable(m_error);
+        }
+    }
+
+    AppendLogOptions m_options;
+    int m_fd;
+    Ring<void> m_ring;
+
+    std::deque<Append> m_pending;
+    // Groups in flight in log order, the deque keeps the operations at fixed addresses
+    std::deque<Group> m_groups;
+
+    std::uint64_t m_end = 0;
+    std::uint64_t m_committedEnd = 0;
+    std::uint64_t m_durableEnd = 0;
+    std::uint64_t m_groupsCommitted = 0;
+    int m_error = 0;
+};
+
+} // namespace uringpp
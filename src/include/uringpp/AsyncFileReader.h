@@ -0,0 +1,275 @@
+#pragma once
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "uringpp/Generator.h"
+#include "uringpp/Operation.h"
+#include "uringpp/Ring.h"
+
+namespace uringpp {
+
+struct ReaderOptions {
+    // Number of chunks read ahead of the consumer
+    std::size_t readAhead = 8;
+    std::size_t chunkSize = 256 * 1024;
+};
+
+/*
+ * Reads a file sequentially with a number of chunk reads in flight.
+ *
+ * next() hands out the chunks in file order as views into the read buffers. A
+ * chunk stays valid until the following call to next(), which reuses its buffer
+ * for the read of the chunk readAhead positions further. Short reads are
+ * continued, the file ends at the first read which returns no data.
+ */
+class AsyncFileReader {
+    struct Chunk;
+
+    struct ReadChunk : op::Read {
+        Chunk* chunk;
+    };
+
+    using Operations = OperationSet<ReadChunk>;
+
+    enum class State {
+        Idle,
+        Reading,
+        Ready,
+    };
+
+    struct Chunk {
+        std::vector<std::uint8_t> data;
+        std::uint64_t offset = 0;
+        std::size_t length = 0;
+        State state = State::Idle;
+        int error = 0;
+        ReadChunk readOp;
+    };
+
+  public:
+    /*
+     * @param[in] file file which is opened for reading
+     */
+    explicit AsyncFileReader(const std::filesystem::path& file, ReaderOptions options = {})
+        : AsyncFileReader(openFile(file), options, 0, true)
+    {
+    }
+
+    /*
+     * @param[in] fd file descriptor which stays owned by the caller
+     * @param[in] offset offset of the first chunk
+     */
+    AsyncFileReader(int fd, ReaderOptions options, std::uint64_t offset = 0)
+        : AsyncFileReader(fd, options, offset, false)
+    {
+    }
+
+    AsyncFileReader(const AsyncFileReader&) = delete;
+    auto operator=(const AsyncFileReader&) -> AsyncFileReader& = delete;
+
+    ~AsyncFileReader()
+    {
+        // The kernel may still write into the buffers of reads in flight
+        drain();
+        if (m_ownsFd) {
+            ::close(m_fd);
+        }
+    }
+
+    /*
+     * Returns the next chunk of the file or std::nullopt at the end of the file
+     */
+    auto next() -> std::optional<std::span<const std::uint8_t>>
+    {
+        if (m_handedOut) {
+            startRead(*m_handedOut);
+            m_handedOut = nullptr;
+        }
+
+        auto& chunk = m_chunks[m_head];
+        while (chunk.state == State::Reading) {
+            m_ring.submit();
+            complete();
+        }
+
+        if (chunk.error) {
+            const auto error = chunk.error;
+            drain();
+            throw std::runtime_error(std::string("Failed to read file: ") + strerror(error));
+        }
+
+        if (chunk.state == State::Idle || chunk.offset >= m_endOffset || !chunk.length) {
+            return std::nullopt;
+        }
+
+        m_head = (m_head + 1) % m_chunks.size();
+        m_handedOut = &chunk;
+        return std::span<const std::uint8_t>(chunk.data.data(), chunk.length);
+    }
+
+    auto options() const -> const ReaderOptions&
+    {
+        return m_options;
+    }
+
+  private:
+    AsyncFileReader(int fd, ReaderOptions options, std::uint64_t offset, bool ownsFd)
+        : m_options(checkOptions(options, fd, ownsFd))
+        , m_fd(fd)
+        , m_ownsFd(ownsFd)
+        , m_ring(options.readAhead)
+        , m_chunks(options.readAhead)
+        , m_nextOffset(offset)
+    {
+        for (auto& chunk : m_chunks) {
+            chunk.data.resize(options.chunkSize);
+            chunk.readOp.chunk = &chunk;
+        }
+
+        for (auto& chunk : m_chunks) {
+            startRead(chunk);
+        }
+        m_ring.submit();
+    }
+
+    static auto openFile(const std::filesystem::path& file) -> int
+    {
+        auto fd = ::open(file.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error(
+                std::string("Failed to open file ") + file.c_str() + ": " + strerror(errno));
+        }
+        return fd;
+    }
+
+    static auto checkOptions(ReaderOptions options, int fd, bool ownsFd) -> ReaderOptions
+    {
+        if (!options.readAhead || !options.chunkSize) {
+            if (ownsFd) {
+                ::close(fd);
+            }
+            throw std::invalid_argument("Read ahead and chunk size need to be positive");
+        }
+        return options;
+    }
+
+    auto startRead(Chunk& chunk) -> void
+    {
+        chunk.state = State::Idle;
+        if (m_nextOffset >= m_endOffset) {
+            return;
+        }
+
+        chunk.offset = m_nextOffset;
+        chunk.length = 0;
+        chunk.state = State::Reading;
+        m_nextOffset += m_options.chunkSize;
+        m_inFlight++;
+        prepareRead(chunk);
+    }
+
+    auto prepareRead(Chunk& chunk) -> void
+    {
+        chunk.readOp.fd = m_fd;
+        chunk.readOp.buffer = std::span(chunk.data).subspan(chunk.length);
+        chunk.readOp.offset = chunk.offset + chunk.length;
+        m_ring.prepare_operation<Operations>(chunk.readOp);
+    }
+
+    auto complete() -> void
+    {
+        auto completion = m_ring.wait();
+        Operations::dispatch(completion.get(), [this](ReadChunk& read, ReadChunk::result_type result) {
+            onRead(*read.chunk, result);
+        });
+        m_ring.seen(completion);
+    }
+
+    auto onRead(Chunk& chunk, Result<std::size_t> result) -> void
+    {
+        if (!result.ok()) {
+            chunk.error = result.error();
+            chunk.state = State::Ready;
+            m_inFlight--;
+            return;
+        }
+
+        chunk.length += result.value();
+        if (result.value() && chunk.length < chunk.data.size()) {
+            prepareRead(chunk);
+            return;
+        }
+
+        if (!result.value()) {
+            // Chunks behind the end are dropped, even if the file grows meanwhile
+            m_endOffset = std::min(m_endOffset, chunk.offset + chunk.length);
+        }
+        chunk.state = State::Ready;
+        m_inFlight--;
+    }
+
+    auto drain() -> void
+    {
+        while (m_inFlight) {
+            m_ring.submit();
+            complete();
+        }
+    }
+
+    ReaderOptions m_options;
+    int m_fd;
+    bool m_ownsFd;
+    Ring<void> m_ring;
+    std::vector<Chunk> m_chunks;
+
+    std::size_t m_head = 0;
+    Chunk* m_handedOut = nullptr;
+    std::uint64_t m_nextOffset;
+    std::uint64_t m_endOffset = UINT64_MAX;
+    std::size_t m_inFlight = 0;
+};
+
+/*
+ * Generates the chunks of the file, with the reads of options.readAhead chunks in
+ * flight ahead of the consumer. A chunk stays valid until the consumer advances,
+ * which recycles its buffer for the next read:
+ *
+ *  for (auto chunk : readChunks(path) | std::views::filter(isRecord)) { ... }
+ *
+ * Destroying the generator early waits for the reads in flight.
+ */
+inline auto readChunks(std::filesystem::path file, ReaderOptions options = {})
+    -> Generator<std::span<const std::uint8_t>>
+{
+    AsyncFileReader reader(file, options);
+    while (auto chunk = reader.next()) {
+        co_yield *chunk;
+    }
+}
+
+/*
+ * @param[in] fd file descriptor which stays owned by the caller and needs to
+ *               outlive the generator
+ * @param[in] offset offset of the first chunk
+ */
+inline auto readChunks(int fd, ReaderOptions options = {}, std::uint64_t offset = 0)
+    -> Generator<std::span<const std::uint8_t>>
+{
+    AsyncFileReader reader(fd, options, offset);
+    while (auto chunk = reader.next()) {
+        co_yield *chunk;
+    }
+}
+
+} // namespace uringpp
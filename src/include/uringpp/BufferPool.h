@@ -1,13 +1,26 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
 #include <span>
 #include <vector>
 
 class BufferPool {
   public:
-    BufferPool(std::size_t numberOfBuffers, std::size_t sizePerBuffer, std::size_t groupId)
+    /*
+     * @param[in] numberOfBuffers number of buffers in the pool
+     * @param[in] sizePerBuffer size of each buffer
+     * @param[in] groupId buffer group id the kernel selects buffers from
+     * @param[in] firstBufferId buffer id of the first buffer, pools of the same
+     *            group need disjoint buffer id ranges
+     */
+    BufferPool(
+        std::size_t numberOfBuffers,
+        std::size_t sizePerBuffer,
+        std::size_t groupId,
+        std::size_t firstBufferId = 0)
         : m_groupId(groupId)
+        , m_firstBufferId(firstBufferId)
         , m_numberOfBuffers(numberOfBuffers)
         , m_sizePerBuffer(sizePerBuffer)
         , m_storage(m_numberOfBuffers * m_sizePerBuffer)
@@ -47,8 +60,14 @@ class BufferPool {
         return m_groupId;
     }
 
+    auto first_buffer_id() const -> std::size_t
+    {
+        return m_firstBufferId;
+    }
+
   private:
     std::size_t m_groupId;
+    std::size_t m_firstBufferId;
     std::size_t m_numberOfBuffers;
     std::size_t m_sizePerBuffer;
     std::vector<std::uint8_t> m_storage;
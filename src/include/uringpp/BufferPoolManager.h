@@ -0,0 +1,403 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "uringpp/BufferPool.h"
+#include "uringpp/Capabilities.h"
+#include "uringpp/Operation.h"
+
+namespace uringpp {
+
+struct SizeClass {
+    std::size_t bufferSize;
+    std::size_t numberOfBuffers;
+};
+
+struct SizeClassUsage {
+    std::size_t bufferSize;
+    std::size_t groupId;
+    std::size_t buffers;
+    std::size_t inUse;
+    std::size_t peakInUse;
+    std::size_t grows;
+    std::size_t noBuffers;
+    std::size_t receives;
+    std::uint64_t bytes;
+};
+
+/*
+ * Estimates the message size of a socket from its recent receives. Meant to be
+ * embedded into the per-connection state.
+ */
+class SizeClassSelector {
+  public:
+    /*
+     * @param[in] bytes bytes received
+     * @param[in] bufferFull true if the receive filled the whole buffer, the message
+     *            was probably larger and got split across receives
+     */
+    auto observe(std::size_t bytes, bool bufferFull) -> void
+    {
+        if (bufferFull) {
+            m_expectedSize = std::max(m_expectedSize, bytes * 2);
+            return;
+        }
+        m_expectedSize = m_expectedSize ? (m_expectedSize * 7 + bytes) / 8 : bytes;
+    }
+
+    auto expected_size() const -> std::size_t
+    {
+        return m_expectedSize;
+    }
+
+  private:
+    std::size_t m_expectedSize = 0;
+};
+
+/*
+ * Maintains one provided buffer group per size class, e.g. 256 B, 4 KiB and 64 KiB.
+ *
+ * Receives select their group from the expected message size of the socket, so
+ * small messages do not occupy large buffers and large messages are not split
+ * across many receives. A group which runs out of buffers (-ENOBUFS) grows by
+ * another chunk of buffers instead of failing. Chunks are separate allocations,
+ * so growing never moves buffers already handed to the kernel.
+ *
+ * The provide buffer operations of the manager complete as ProvideBuffersOp,
+ * which therefore has to be part of the OperationSet of the ring, and are handed
+ * to provided().
+ *
+ * Buffers are handed to the kernel with IORING_OP_PROVIDE_BUFFERS even if it
+ * supports ring mapped buffers (Capabilities::has_buffer_ring()): a buffer added
+ * to a buffer ring posts no completion, which ends a shortage and resumes parked
+ * receives here, and a buffer ring can not grow beyond its registered size.
+ */
+class BufferPoolManager {
+    // Buffer ids are 16 bit
+    static constexpr std::size_t maxBuffersPerGroup = 1 << 16;
+
+  public:
+    struct ProvideBuffersOp : op::ProvideBuffers {
+        std::size_t sizeClass = 0;
+        // Provides a whole chunk, false for the readd of a released buffer
+        bool chunk = false;
+    };
+
+    /*
+     * @param[in] sizeClasses size classes in ascending buffer size
+     * @param[in] firstGroupId group id of the first size class, the others follow
+     */
+    explicit BufferPoolManager(std::vector<SizeClass> sizeClasses, std::size_t firstGroupId = 0)
+    {
+        if (sizeClasses.empty()) {
+            throw std::invalid_argument("BufferPoolManager needs at least one size class");
+        }
+
+        for (std::size_t index = 0; index < sizeClasses.size(); index++) {
+            auto& group = m_groups.emplace_back();
+            group.sizeClass = sizeClasses[index];
+            group.groupId = firstGroupId + index;
+            addChunk(index);
+        }
+        logSelectedPath("buffer pool manager", "provided buffers");
+    }
+
+    BufferPoolManager(const BufferPoolManager&) = delete;
+    auto operator=(const BufferPoolManager&) -> BufferPoolManager& = delete;
+
+    /*
+     * Prepares the provide buffer operations of all chunks which were not yet
+     * handed to the kernel
+     */
+    template <class Operations, class Ring> auto provide(Ring& ring) -> void
+    {
+        for (auto& group : m_groups) {
+            for (; group.providedChunks < group.chunks.size(); group.providedChunks++) {
+                auto& provide = group.chunkOps[group.providedChunks];
+                ring.template prepare_operation<Operations>(provide);
+            }
+        }
+    }
+
+    auto size_classes() const -> std::size_t
+    {
+        return m_groups.size();
+    }
+
+    /*
+     * Returns the smallest size class which fits the message size, the largest
+     * size class for messages larger than all classes
+     */
+    auto size_class_for(std::size_t messageSize) const -> std::size_t
+    {
+        for (std::size_t index = 0; index < m_groups.size(); index++) {
+            if (m_groups[index].sizeClass.bufferSize >= messageSize) {
+                return index;
+            }
+        }
+        return m_groups.size() - 1;
+    }
+
+    auto size_class_for(const SizeClassSelector& selector) const -> std::size_t
+    {
+        return size_class_for(selector.expected_size());
+    }
+
+    /*
+     * Returns a pool of the size class to receive from e.g. with op::RecvBp
+     */
+    auto pool(std::size_t sizeClass) -> BufferPool&
+    {
+        return m_groups[sizeClass].chunks.front();
+    }
+
+    auto buffer_size(std::size_t sizeClass) const -> std::size_t
+    {
+        return m_groups[sizeClass].sizeClass.bufferSize;
+    }
+
+    /*
+     * Returns the buffer the kernel selected for a receive
+     *
+     * @param[in] sizeClass size class the receive selected from
+     * @param[in] bufferId buffer id of the completion
+     */
+    auto buffer(std::size_t sizeClass, std::size_t bufferId) -> std::span<std::uint8_t>
+    {
+        auto& group = m_groups[sizeClass];
+        const auto chunkSize = group.sizeClass.numberOfBuffers;
+        return group.chunks[bufferId / chunkSize].at(bufferId % chunkSize);
+    }
+
+    /*
+     * Records that a receive completed into a buffer of the size class
+     */
+    auto acquired(std::size_t sizeClass, std::size_t bytes) -> void
+    {
+        auto& group = m_groups[sizeClass];
+        group.inUse++;
+        group.peakInUse = std::max(group.peakInUse, group.inUse);
+        group.receives++;
+        group.bytes += bytes;
+    }
+
+    /*
+     * Hands a buffer back to the kernel
+     */
+    template <class Operations, class Ring>
+    auto release(Ring& ring, std::size_t sizeClass, std::size_t bufferId) -> bool
+    {
+        auto& group = m_groups[sizeClass];
+        group.inUse--;
+        return ring.template prepare_operation<Operations>(group.readdOps[bufferId]);
+    }
+
+    /*
+     * Grows the size class by another chunk after a receive failed with -ENOBUFS.
+     * A shortage grows the size class once: receives which fail while the grown
+     * chunk is still being provided add no further chunks.
+     *
+     * @return false if the group reached the maximum number of buffers, only a
+     *         released buffer serves the next receive then
+     */
+    template <class Operations, class Ring> auto grow(Ring& ring, std::size_t sizeClass) -> bool
+    {
+        auto& group = m_groups[sizeClass];
+        group.noBuffers++;
+        if (group.growing) {
+            return true;
+        }
+        if ((group.chunks.size() + 1) * group.sizeClass.numberOfBuffers > maxBuffersPerGroup) {
+            return false;
+        }
+
+        addChunk(sizeClass);
+        group.grows++;
+        group.growing = true;
+        provide<Operations>(ring);
+        return true;
+    }
+
+    /*
+     * Records the completion of a provide buffers operation of the manager, which
+     * ends the shortage of a grown size class
+     */
+    auto provided(const ProvideBuffersOp& provide) -> void
+    {
+        if (provide.chunk) {
+            m_groups[provide.sizeClass].growing = false;
+        }
+    }
+
+    auto usage() const -> std::vector<SizeClassUsage>
+    {
+        std::vector<SizeClassUsage> usage;
+        for (const auto& group : m_groups) {
+            usage.push_back(SizeClassUsage { group.sizeClass.bufferSize,
+                                             group.groupId,
+                                             group.chunks.size() * group.sizeClass.numberOfBuffers,
+                                             group.inUse,
+                                             group.peakInUse,
+                                             group.grows,
+                                             group.noBuffers,
+                                             group.receives,
+                                             group.bytes });
+        }
+        return usage;
+    }
+
+    auto report(std::ostream& stream) const -> void
+    {
+        for (const auto& usage : this->usage()) {
+            stream << "size class " << usage.bufferSize << " B (group " << usage.groupId
+                   << "): " << usage.buffers << " buffers ("
+                   << usage.buffers * usage.bufferSize / 1024 << " KiB), " << usage.inUse
+                   << " in use, peak " << usage.peakInUse << ", " << usage.grows << " grows, "
+                   << usage.noBuffers << " out of buffers, " << usage.receives << " receives, "
+                   << usage.bytes << " bytes" << std::endl;
+        }
+    }
+
+  private:
+    struct Group {
+        SizeClass sizeClass;
+        std::size_t groupId = 0;
+        std::deque<BufferPool> chunks;
+        std::deque<ProvideBuffersOp> chunkOps;
+        std::deque<ProvideBuffersOp> readdOps;
+        std::size_t providedChunks = 0;
+        // A grown chunk is being provided
+        bool growing = false;
+        std::size_t inUse = 0;
+        std::size_t peakInUse = 0;
+        std::size_t grows = 0;
+        std::size_t noBuffers = 0;
+        std::size_t receives = 0;
+        std::uint64_t bytes = 0;
+    };
+
+    auto addChunk(std::size_t sizeClass) -> void
+    {
+        auto& group = m_groups[sizeClass];
+        const auto numberOfBuffers = group.sizeClass.numberOfBuffers;
+        auto& chunk = group.chunks.emplace_back(
+            numberOfBuffers,
+            group.sizeClass.bufferSize,
+            group.groupId,
+            (group.chunks.size()) * numberOfBuffers);
+
+        auto& provide = group.chunkOps.emplace_back();
+        provide.bufferPool = &chunk;
+        provide.bufferIdx = 0;
+        provide.numberOfBuffers = numberOfBuffers;
+        provide.sizeClass = sizeClass;
+        provide.chunk = true;
+
+        for (std::size_t bufferIdx = 0; bufferIdx < numberOfBuffers; bufferIdx++) {
+            auto& readd = group.readdOps.emplace_back();
+            readd.bufferPool = &chunk;
+            readd.bufferIdx = bufferIdx;
+            readd.sizeClass = sizeClass;
+        }
+    }
+
+    std::deque<Group> m_groups;
+};
+
+/*
+ * Receivers, e.g. connections, whose receive failed with -ENOBUFS.
+ *
+ * Re-arming such a receive right away fails again until a buffer is back in the
+ * kernel, so the receiver is parked instead. park() grows the size class and
+ * provided() resumes as many parked receivers, in the order they were parked, as a
+ * completed provide buffers operation handed buffers to the kernel, be it a grown
+ * chunk or a released buffer. Receivers of a single BufferPool are parked and
+ * resumed without the manager.
+ */
+template <class Receiver> class ParkedReceives {
+  public:
+    explicit ParkedReceives(std::size_t sizeClasses = 1)
+        : m_parked(sizeClasses)
+    {
+    }
+
+    template <class Operations, class Ring>
+    auto park(Ring& ring, BufferPoolManager& buffers, std::size_t sizeClass, Receiver receiver)
+        -> void
+    {
+        buffers.template grow<Operations>(ring, sizeClass);
+        park(receiver, sizeClass);
+    }
+
+    auto park(Receiver receiver, std::size_t sizeClass = 0) -> void
+    {
+        m_parked[sizeClass].push_back(receiver);
+    }
+
+    /*
+     * Call on each completion of a ProvideBuffersOp
+     *
+     * @param[in] resume called with each resumed receiver, re-arms its receive
+     */
+    template <class Resume>
+    auto provided(
+        BufferPoolManager& buffers,
+        const BufferPoolManager::ProvideBuffersOp& provide,
+        Resume&& resume) -> void
+    {
+        buffers.provided(provide);
+        this->resume(provide.sizeClass, provide.numberOfBuffers, std::forward<Resume>(resume));
+    }
+
+    /*
+     * Resumes up to count receivers of the size class, e.g. when count buffers were
+     * handed back to the kernel
+     */
+    template <class Resume>
+    auto resume(std::size_t sizeClass, std::size_t count, Resume&& resume) -> void
+    {
+        auto& parked = m_parked[sizeClass];
+        for (std::size_t i = 0; i < count && !parked.empty(); i++) {
+            auto receiver = parked.front();
+            parked.pop_front();
+            resume(receiver);
+        }
+    }
+
+    /*
+     * Forgets a receiver which is closed while parked
+     *
+     * @return true if the receiver was parked
+     */
+    auto remove(const Receiver& receiver) -> bool
+    {
+        for (auto& parked : m_parked) {
+            if (auto it = std::find(parked.begin(), parked.end(), receiver); it != parked.end()) {
+                parked.erase(it);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    auto size() const -> std::size_t
+    {
+        std::size_t size = 0;
+        for (const auto& parked : m_parked) {
+            size += parked.size();
+        }
+        return size;
+    }
+
+  private:
+    std::vector<std::deque<Receiver>> m_parked;
+};
+
+} // namespace uringpp
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <atomic>
+#include <bitset>
+#include <iostream>
+#include <string>
+
+#include "liburing.h"
+
+namespace uringpp {
+
+/*
+ * Opcodes and derived features supported by the running kernel.
+ *
+ * The opcodes are probed with io_uring_get_probe once per process, get() returns
+ * the cached result. Features which have no opcode of their own, e.g. multishot
+ * accept, are derived from an opcode which was introduced with the same kernel
+ * release.
+ */
+class Capabilities {
+  public:
+    static auto get() -> const Capabilities&
+    {
+        static const Capabilities capabilities { true };
+        return capabilities;
+    }
+
+    /*
+     * Capabilities without any supported opcode, e.g. to exercise fallback paths
+     */
+    static auto none() -> const Capabilities&
+    {
+        static const Capabilities capabilities { false };
+        return capabilities;
+    }
+
+    /*
+     * @param[in] opcode IORING_OP_* opcode
+     */
+    auto supports(int opcode) const -> bool
+    {
+        return opcode >= 0 && static_cast<std::size_t>(opcode) < m_opcodes.size()
+            && m_opcodes.test(opcode);
+    }
+
+    /*
+     * Returns false if the kernel is too old to be probed (< 5.6), in which case no
+     * opcode is reported as supported
+     */
+    auto probed() const -> bool
+    {
+        return m_probed;
+    }
+
+    /*
+     * Non vectored read and write (5.6)
+     */
+    auto has_read_write() const -> bool
+    {
+        return supports(IORING_OP_READ) && supports(IORING_OP_WRITE);
+    }
+
+    auto has_provide_buffers() const -> bool
+    {
+        return supports(IORING_OP_PROVIDE_BUFFERS);
+    }
+
+    /*
+     * Splice between a pipe and a file or socket (5.7)
+     */
+    auto has_splice() const -> bool
+    {
+        return supports(IORING_OP_SPLICE);
+    }
+
+    /*
+     * Socket shutdown (5.11)
+     */
+    auto has_shutdown() const -> bool
+    {
+        return supports(IORING_OP_SHUTDOWN);
+    }
+
+    /*
+     * Updating the expiry of an armed timeout (5.11)
+     */
+    auto has_timeout_update() const -> bool
+    {
+        return supports(IORING_OP_SHUTDOWN);
+    }
+
+    /*
+     * Multishot accept and kernel allocated direct descriptors (5.19)
+     */
+    auto has_multishot_accept() const -> bool
+    {
+        return supports(IORING_OP_SOCKET);
+    }
+
+    /*
+     * Ring mapped provided buffers (5.19)
+     */
+    auto has_buffer_ring() const -> bool
+    {
+        return supports(IORING_OP_SOCKET);
+    }
+
+    /*
+     * Multishot recv and recvmsg (6.0)
+     */
+    auto has_multishot_recv() const -> bool
+    {
+        return supports(IORING_OP_SEND_ZC);
+    }
+
+    /*
+     * Zero copy send (6.0)
+     */
+    auto has_send_zc() const -> bool
+    {
+        return supports(IORING_OP_SEND_ZC);
+    }
+
+    /*
+     * Futex wait and wake (6.7)
+     */
+    auto has_futex() const -> bool
+    {
+        return supports(IORING_OP_FUTEX_WAIT);
+    }
+
+    auto report(std::ostream& stream) const -> void
+    {
+        stream << "io_uring capabilities: " << (m_probed ? "" : "probe unsupported, ")
+               << "read/write " << has_read_write() << ", provide buffers "
+               << has_provide_buffers() << ", splice " << has_splice() << ", shutdown "
+               << has_shutdown() << ", timeout update " << has_timeout_update()
+               << ", multishot accept " << has_multishot_accept()
+               << ", buffer ring " << has_buffer_ring() << ", multishot recv "
+               << has_multishot_recv() << ", send zc " << has_send_zc() << ", futex "
+               << has_futex() << std::endl;
+    }
+
+  private:
+    explicit Capabilities(bool probeKernel)
+    {
+        if (!probeKernel) {
+            return;
+        }
+
+        auto probe = io_uring_get_probe();
+        if (!probe) {
+            return;
+        }
+
+        for (int opcode = 0; opcode < static_cast<int>(m_opcodes.size()); opcode++) {
+            m_opcodes[opcode] = io_uring_opcode_supported(probe, opcode);
+        }
+        m_probed = true;
+        io_uring_free_probe(probe);
+    }
+
+    std::bitset<256> m_opcodes;
+    bool m_probed = false;
+};
+
+/*
+ * Switch of logSelectedPath, off by default so components do not write to
+ * std::clog unless asked to
+ */
+inline auto pathLogging() -> std::atomic<bool>&
+{
+    static std::atomic<bool> enabled { false };
+    return enabled;
+}
+
+inline auto enablePathLogging(bool enabled = true) -> void
+{
+    pathLogging().store(enabled, std::memory_order_relaxed);
+}
+
+/*
+ * Logs the mechanism a component selected from the capabilities, so it can be
+ * confirmed that the fast path is active. Logs only after enablePathLogging().
+ */
+inline auto logSelectedPath(const std::string& component, const std::string& path) -> void
+{
+    if (pathLogging().load(std::memory_order_relaxed)) {
+        std::clog << "uringpp: " << component << " uses " << path << std::endl;
+    }
+}
+
+} // namespace uringpp
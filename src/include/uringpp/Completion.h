@@ -1,6 +1,7 @@
 #pragma once
 
-#include <exception>
+#include <cassert>
+#include <cstdint>
 
 #include "liburing.h"
 
@@ -8,10 +9,10 @@ template <class UserData>
 class Completion
 {
 public:    
-    Completion(io_uring_cqe *cqe) : m_cqe(cqe){
-        if(!m_cqe){
-            throw std::runtime_error("Completion queue entry is null");
-        }
+    // The ring only creates completions of valid completion queue entries,
+    // so the hot path does not pay for a null check in release builds.
+    Completion(io_uring_cqe *cqe) noexcept : m_cqe(cqe){
+        assert(m_cqe);
     }
 
     auto get() const -> io_uring_cqe * {
@@ -27,6 +28,16 @@ public:
     {
         return m_cqe->flags;
     }
+
+    /*
+     * Returns true if the multishot command which posted this completion stays
+     * armed and will post further completions
+     */
+    auto has_more() const -> bool
+    {
+        return m_cqe->flags & IORING_CQE_F_MORE;
+    }
+
     auto userData() const -> UserData*
     {
         return reinterpret_cast<UserData*>(m_cqe->user_data);
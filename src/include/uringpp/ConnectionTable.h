@@ -0,0 +1,209 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace uringpp {
+
+/*
+ * Contiguous slab of per-connection state indexed by file descriptor or by
+ * direct descriptor slot.
+ *
+ * Each slot sits on its own cache line, so connections served from different
+ * completions do not share lines. The capacity is fixed at construction, which
+ * keeps the address of a slot stable while operations embedded in its state are
+ * in flight. Unused slots are linked in an intrusive free list, so opening and
+ * closing a connection neither allocates nor hashes.
+ *
+ * A connection is only released once it was closed and all its pending
+ * operations completed, see acquire()/release()/close().
+ */
+template <class State> class ConnectionTable {
+    static constexpr std::int32_t none = -1;
+
+    struct alignas(64) Slot {
+        State state {};
+        std::uint32_t pendingOps = 0;
+        std::int32_t previousFree = none;
+        std::int32_t nextFree = none;
+        bool used = false;
+        bool closing = false;
+    };
+
+  public:
+    /*
+     * @param[in] capacity maximum number of connections, for fd indexing the
+     *            largest expected file descriptor + 1
+     */
+    explicit ConnectionTable(std::size_t capacity)
+        : m_slots(capacity)
+    {
+        for (std::size_t index = capacity; index-- > 0;) {
+            pushFree(static_cast<std::int32_t>(index));
+        }
+    }
+
+    ConnectionTable(const ConnectionTable&) = delete;
+    auto operator=(const ConnectionTable&) -> ConnectionTable& = delete;
+
+    /*
+     * Claims the slot of a connection whose index was chosen outside of the
+     * table e.g. the file descriptor returned by accept
+     *
+     * @param[in] index file descriptor or direct descriptor slot
+     * @return state of the connection
+     */
+    auto open(std::size_t index) -> State&
+    {
+        if (index >= m_slots.size()) {
+            throw std::out_of_range("Connection index exceeds connection table capacity");
+        }
+
+        auto& slot = m_slots[index];
+        if (slot.used) {
+            throw std::logic_error("Connection is already open");
+        }
+
+        unlinkFree(static_cast<std::int32_t>(index));
+        slot.used = true;
+        m_size++;
+        return slot.state;
+    }
+
+    /*
+     * Claims any free slot e.g. for a direct descriptor
+     *
+     * @return index of the slot or -1 if the table is full
+     */
+    auto allocate() -> std::int32_t
+    {
+        const auto index = m_freeHead;
+        if (index != none) {
+            open(index);
+        }
+        return index;
+    }
+
+    auto at(std::size_t index) -> State&
+    {
+        return m_slots[index].state;
+    }
+
+    auto contains(std::size_t index) const -> bool
+    {
+        return index < m_slots.size() && m_slots[index].used;
+    }
+
+    /*
+     * Counts an operation of the connection which is in flight
+     */
+    auto acquire(std::size_t index) -> void
+    {
+        m_slots[index].pendingOps++;
+    }
+
+    /*
+     * Marks an operation of the connection as completed
+     *
+     * @return true if the connection was closed and its slot is released
+     */
+    auto release(std::size_t index) -> bool
+    {
+        auto& slot = m_slots[index];
+        if (!slot.used || slot.pendingOps == 0) {
+            throw std::logic_error("Connection has no pending operation");
+        }
+
+        slot.pendingOps--;
+        if (slot.closing && slot.pendingOps == 0) {
+            freeSlot(index);
+            return true;
+        }
+        return false;
+    }
+
+    /*
+     * Closes the connection. The slot is released as soon as no operations are pending.
+     *
+     * @return true if the slot was released right away
+     */
+    auto close(std::size_t index) -> bool
+    {
+        auto& slot = m_slots[index];
+        if (!slot.used || slot.closing) {
+            throw std::logic_error("Connection is not open");
+        }
+
+        slot.closing = true;
+        if (slot.pendingOps == 0) {
+            freeSlot(index);
+            return true;
+        }
+        return false;
+    }
+
+    auto closing(std::size_t index) const -> bool
+    {
+        return m_slots[index].closing;
+    }
+
+    auto pending_ops(std::size_t index) const -> std::uint32_t
+    {
+        return m_slots[index].pendingOps;
+    }
+
+    auto size() const -> std::size_t
+    {
+        return m_size;
+    }
+
+    auto capacity() const -> std::size_t
+    {
+        return m_slots.size();
+    }
+
+  private:
+    auto freeSlot(std::size_t index) -> void
+    {
+        auto& slot = m_slots[index];
+        slot.state = State {};
+        slot.used = false;
+        slot.closing = false;
+        slot.pendingOps = 0;
+        pushFree(static_cast<std::int32_t>(index));
+        m_size--;
+    }
+
+    auto pushFree(std::int32_t index) -> void
+    {
+        auto& slot = m_slots[index];
+        slot.previousFree = none;
+        slot.nextFree = m_freeHead;
+        if (m_freeHead != none) {
+            m_slots[m_freeHead].previousFree = index;
+        }
+        m_freeHead = index;
+    }
+
+    auto unlinkFree(std::int32_t index) -> void
+    {
+        auto& slot = m_slots[index];
+        if (slot.previousFree != none) {
+            m_slots[slot.previousFree].nextFree = slot.nextFree;
+        } else {
+            m_freeHead = slot.nextFree;
+        }
+        if (slot.nextFree != none) {
+            m_slots[slot.nextFree].previousFree = slot.previousFree;
+        }
+        slot.previousFree = none;
+        slot.nextFree = none;
+    }
+
+    std::vector<Slot> m_slots;
+    std::int32_t m_freeHead = none;
+    std::size_t m_size = 0;
+};
+
+} // namespace uringpp
@@ -0,0 +1,794 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "uringpp/Capabilities.h"
+#include "uringpp/Crc32c.h"
+#include "uringpp/Operation.h"
+#include "uringpp/Ring.h"
+
+namespace uringpp {
+
+enum class CopyPath {
+    ReadWrite,
+    ReadvWritev,
+};
+
+inline auto toString(CopyPath path) -> const char*
+{
+    switch (path) {
+    case CopyPath::ReadWrite:
+        return "read/write";
+    case CopyPath::ReadvWritev:
+        return "readv/writev";
+    }
+    return "unknown";
+}
+
+struct CopyOptions {
+    // Number of blocks in flight
+    std::size_t queueDepth = 64;
+    std::size_t blockSize = 32 * 1024;
+    // Only copy the data extents of the input and keep its holes in the output
+    bool sparse = true;
+    // Compute the CRC32C digest of the copied range, see CopyEngine::digest()
+    bool checksum = false;
+    // Threads which checksum the blocks, 0 checksums on the completion thread
+    std::size_t checksumThreads = 0;
+    // Measure the first part of a copy to choose queueDepth and blockSize
+    bool autoTune = false;
+    // Limit of queueDepth * blockSize while tuning
+    std::size_t memoryLimit = 64 * 1024 * 1024;
+};
+
+/*
+ * Throughput of one queue depth and block size measured while tuning
+ */
+struct CopyProbe {
+    std::size_t queueDepth;
+    std::size_t blockSize;
+    double bytesPerSecond;
+};
+
+/*
+ * Copies files through a ring with a fixed number of blocks in flight.
+ *
+ * Each block cycles through the read and write of consecutive chunks of the file,
+ * so the memory of a copy is bounded by queueDepth * blockSize independent of the
+ * file size. Short reads and writes are continued. The engine uses read/write if
+ * the kernel supports them and falls back to readv/writev otherwise.
+ *
+ * Sparse copies discover the data extents of the input with SEEK_DATA/SEEK_HOLE
+ * and only read and write these, so the copy time scales with the allocated
+ * instead of the logical size. The holes are left unwritten in a new output and
+ * punched into an existing one.
+ *
+ * A checksumming copy computes the CRC32C of each block between its read and its
+ * write, so the digest of the copy needs no second pass over the data. The
+ * checksum threads signal finished blocks through an eventfd which is read by
+ * the ring, so the ring keeps running while blocks are checksummed.
+ *
+ * An auto tuning copy hill climbs from the configured queue depth and block size
+ * (clamped to the tuning limits): it copies a probe
+ * of the range with each neighbour configuration (queue depth or block size
+ * halved or doubled, within the memory limit), moves to the fastest one and stops
+ * once no neighbour is more than 5% faster or a quarter of the range is copied.
+ * The remaining range is copied with the chosen configuration. Later copies keep
+ * it once the climb converged and continue the climb otherwise.
+ */
+class CopyEngine {
+    struct Block;
+
+    struct ReadBlock : op::Read {
+        Block* block;
+    };
+
+    struct WriteBlock : op::Write {
+        Block* block;
+    };
+
+    struct ReadvBlock : op::Readv {
+        Block* block;
+    };
+
+    struct WritevBlock : op::Writev {
+        Block* block;
+    };
+
+    struct WakeOp : op::Read {
+    };
+
+    using Operations = OperationSet<ReadBlock, WriteBlock, ReadvBlock, WritevBlock, WakeOp>;
+
+    struct Extent {
+        std::uint64_t offset;
+        std::uint64_t length;
+    };
+
+    struct BlockDigest {
+        std::uint64_t offset;
+        std::uint64_t length;
+        std::uint32_t crc;
+    };
+
+    struct Block {
+        std::vector<std::uint8_t> data;
+        iovec vec;
+        std::uint64_t offset = 0;
+        std::size_t length = 0;
+        std::size_t read = 0;
+        std::size_t written = 0;
+        std::uint32_t crc = 0;
+        ReadBlock readOp;
+        WriteBlock writeOp;
+        ReadvBlock readvOp;
+        WritevBlock writevOp;
+    };
+
+    class FileDescriptor {
+      public:
+        FileDescriptor(const std::filesystem::path& file, int flags, mode_t mode = 0)
+            : m_fd(::open(file.c_str(), flags, mode))
+        {
+            if (m_fd < 0) {
+                throw std::runtime_error(
+                    std::string("Failed to open file ") + file.c_str() + ": " + strerror(errno));
+            }
+        }
+
+        FileDescriptor(const FileDescriptor&) = delete;
+        auto operator=(const FileDescriptor&) -> FileDescriptor& = delete;
+
+        ~FileDescriptor()
+        {
+            ::close(m_fd);
+        }
+
+        auto get() const -> int
+        {
+            return m_fd;
+        }
+
+      private:
+        int m_fd;
+    };
+
+    class ChecksumWorkers {
+      public:
+        explicit ChecksumWorkers(std::size_t numberOfThreads)
+            : m_eventFd(eventfd(0, EFD_CLOEXEC))
+        {
+            if (m_eventFd < 0) {
+                throw std::runtime_error(std::string("Failed to create eventfd: ") + strerror(errno));
+            }
+            for (std::size_t i = 0; i < numberOfThreads; i++) {
+                m_threads.emplace_back([this] { run(); });
+            }
+        }
+
+        ~ChecksumWorkers()
+        {
+            {
+                std::lock_guard lock(m_mutex);
+                m_stop = true;
+            }
+            m_wake.notify_all();
+            for (auto& thread : m_threads) {
+                thread.join();
+            }
+            ::close(m_eventFd);
+        }
+
+        auto push(Block& block) -> void
+        {
+            {
+                std::lock_guard lock(m_mutex);
+                m_jobs.push_back(&block);
+            }
+            m_wake.notify_one();
+        }
+
+        auto take_done() -> std::vector<Block*>
+        {
+            std::lock_guard lock(m_mutex);
+            return std::exchange(m_done, {});
+        }
+
+        auto event_fd() const -> int
+        {
+            return m_eventFd;
+        }
+
+      private:
+        auto run() -> void
+        {
+            std::unique_lock lock(m_mutex);
+            while (true) {
+                m_wake.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+                if (m_stop) {
+                    return;
+                }
+
+                auto block = m_jobs.front();
+                m_jobs.pop_front();
+                lock.unlock();
+                block->crc = crc32c(std::span(block->data.data(), block->read));
+                lock.lock();
+                m_done.push_back(block);
+
+                const std::uint64_t one = 1;
+                [[maybe_unused]] auto written = ::write(m_eventFd, &one, sizeof(one));
+            }
+        }
+
+        int m_eventFd;
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::deque<Block*> m_jobs;
+        std::vector<Block*> m_done;
+        bool m_stop = false;
+        std::vector<std::thread> m_threads;
+    };
+
+  public:
+    explicit CopyEngine(
+        CopyOptions options = {}, const Capabilities& capabilities = Capabilities::get())
+        : m_options(options)
+        , m_path(capabilities.has_read_write() ? CopyPath::ReadWrite : CopyPath::ReadvWritev)
+        , m_ring(std::max(options.queueDepth, options.autoTune ? maxTuneQueueDepth : 0) + 1)
+    {
+        if (m_options.checksum && m_options.checksumThreads) {
+            m_checksumWorkers = std::make_unique<ChecksumWorkers>(m_options.checksumThreads);
+        }
+
+        resizeBlocks(m_options.queueDepth, m_options.blockSize);
+        logSelectedPath("copy engine", toString(m_path));
+    }
+
+    CopyEngine(const CopyEngine&) = delete;
+    auto operator=(const CopyEngine&) -> CopyEngine& = delete;
+
+    /*
+     * Copies the input file to the output file, which is created or truncated
+     *
+     * @return number of copied bytes, without the holes of a sparse copy
+     */
+    auto copy(const std::filesystem::path& input, const std::filesystem::path& output)
+        -> std::uint64_t
+    {
+        struct stat inputStat;
+        FileDescriptor inputFd(input, O_RDONLY);
+        if (fstat(inputFd.get(), &inputStat) < 0) {
+            throw std::runtime_error(std::string("Failed to stat file ") + input.c_str());
+        }
+        FileDescriptor outputFd(output, O_WRONLY | O_CREAT | O_TRUNC, inputStat.st_mode & 0777);
+
+        // Copies of ranges punch holes again, also after a failed copy
+        struct RestorePunchHoles {
+            bool& punchHoles;
+
+            ~RestorePunchHoles()
+            {
+                punchHoles = true;
+            }
+        } restorePunchHoles { m_punchHoles };
+
+        if (m_options.sparse) {
+            // The truncated output is one hole, which only the data extents fill
+            if (ftruncate(outputFd.get(), inputStat.st_size) < 0) {
+                throw std::runtime_error(std::string("Failed to truncate file ") + output.c_str());
+            }
+            m_punchHoles = false;
+        }
+        return copy(inputFd.get(), outputFd.get(), 0, inputStat.st_size);
+    }
+
+    /*
+     * Copies a range of the input file to the same range of the output file
+     *
+     * @param[in] offset offset of the range in both files
+     * @param[in] length length of the range, the copy ends early at the end of the input
+     * @return number of copied bytes, without the holes of a sparse copy
+     */
+    auto copy(int inputFd, int outputFd, std::uint64_t offset, std::uint64_t length)
+        -> std::uint64_t
+    {
+        m_inputFd = inputFd;
+        m_outputFd = outputFd;
+
+        // The input ends early, the digest covers the copied range only
+        struct stat inputStat;
+        if (fstat(inputFd, &inputStat) == 0 && S_ISREG(inputStat.st_mode)) {
+            const std::uint64_t inputSize = inputStat.st_size;
+            length = std::min(length, inputSize > offset ? inputSize - offset : 0);
+        }
+
+        m_extents = m_options.sparse ? dataExtents(offset, offset + length)
+                                     : std::vector<Extent> { { offset, length } };
+        m_extent = 0;
+        m_next = m_extents.empty() ? 0 : m_extents.front().offset;
+        m_end = offset + length;
+        m_scheduled = 0;
+        m_copied = 0;
+        m_inFlight = 0;
+        m_checksumming = 0;
+        m_error = 0;
+        m_blockDigests.clear();
+        m_digest.reset();
+
+        if (m_options.autoTune && !m_tuned) {
+            tune(length);
+        }
+        runPhase(UINT64_MAX);
+
+        if (m_error) {
+            throw std::runtime_error(std::string("Failed to copy: ") + strerror(m_error));
+        }
+
+        if (m_options.checksum) {
+            m_digest = combineDigests(offset, m_end);
+        }
+        return m_copied;
+    }
+
+    /*
+     * CRC32C of the range copied last, including the zeros of holes, if the
+     * engine checksums
+     */
+    auto digest() const -> std::optional<std::uint32_t>
+    {
+        return m_digest;
+    }
+
+    auto path() const -> CopyPath
+    {
+        return m_path;
+    }
+
+    /*
+     * Options of the engine, with the tuned queue depth and block size after an
+     * auto tuning copy
+     */
+    auto options() const -> const CopyOptions&
+    {
+        return m_options;
+    }
+
+    /*
+     * Configurations measured by the last auto tuning, in measurement order
+     */
+    auto probes() const -> const std::vector<CopyProbe>&
+    {
+        return m_probes;
+    }
+
+  private:
+    static constexpr std::size_t minTuneQueueDepth = 2;
+    static constexpr std::size_t maxTuneQueueDepth = 256;
+    static constexpr std::size_t minTuneBlockSize = 4 * 1024;
+    static constexpr std::size_t maxTuneBlockSize = 4 * 1024 * 1024;
+
+    auto resizeBlocks(std::size_t queueDepth, std::size_t blockSize) -> void
+    {
+        m_blocks.clear();
+        m_blocks.resize(queueDepth);
+        for (auto& block : m_blocks) {
+            block.data.resize(blockSize);
+            block.readOp.block = &block;
+            block.writeOp.block = &block;
+            block.readvOp.block = &block;
+            block.writevOp.block = &block;
+        }
+        m_options.queueDepth = queueDepth;
+        m_options.blockSize = blockSize;
+    }
+
+    auto fitsTuneLimits(std::size_t queueDepth, std::size_t blockSize) const -> bool
+    {
+        return queueDepth >= minTuneQueueDepth && queueDepth <= maxTuneQueueDepth
+            && blockSize >= minTuneBlockSize && blockSize <= maxTuneBlockSize
+            && queueDepth * blockSize <= m_options.memoryLimit;
+    }
+
+    /*
+     * Copies a probe of the range with the configuration
+     *
+     * @return bytes per second of the probe
+     */
+    auto measure(std::size_t queueDepth, std::size_t blockSize) -> double
+    {
+        resizeBlocks(queueDepth, blockSize);
+        const auto probeBytes = std::max<std::uint64_t>(8 * 1024 * 1024, 4 * queueDepth * blockSize);
+
+        const auto copied = m_copied;
+        const auto start = std::chrono::steady_clock::now();
+        runPhase(probeBytes);
+        const auto seconds
+            = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        const auto bytesPerSecond = (m_copied - copied) / std::max(seconds, 1e-9);
+        m_probes.push_back({ queueDepth, blockSize, bytesPerSecond });
+        return bytesPerSecond;
+    }
+
+    auto tune(std::uint64_t length) -> void
+    {
+        m_probes.clear();
+        const auto tuneBytes = length / 4;
+
+        auto queueDepth = std::clamp(m_options.queueDepth, minTuneQueueDepth, maxTuneQueueDepth);
+        auto blockSize = std::clamp(m_options.blockSize, minTuneBlockSize, maxTuneBlockSize);
+        while (!fitsTuneLimits(queueDepth, blockSize) && queueDepth > minTuneQueueDepth) {
+            queueDepth /= 2;
+        }
+        while (!fitsTuneLimits(queueDepth, blockSize) && blockSize > minTuneBlockSize) {
+            blockSize /= 2;
+        }
+        if (!fitsTuneLimits(queueDepth, blockSize)) {
+            return;
+        }
+
+        auto best = measure(queueDepth, blockSize);
+        auto measured = [this](std::size_t queueDepth, std::size_t blockSize) {
+            return std::any_of(m_probes.begin(), m_probes.end(), [&](const auto& probe) {
+                return probe.queueDepth == queueDepth && probe.blockSize == blockSize;
+            });
+        };
+
+        bool improved = true;
+        bool converged = false;
+        while (improved && !m_error && m_scheduled < tuneBytes) {
+            improved = false;
+            const std::pair<std::size_t, std::size_t> neighbours[] = {
+                { queueDepth * 2, blockSize },
+                { queueDepth, blockSize * 2 },
+                { queueDepth / 2, blockSize },
+                { queueDepth, blockSize / 2 },
+            };
+
+            auto next = std::pair { queueDepth, blockSize };
+            auto nextThroughput = best * 1.05;
+            for (auto [depth, size] : neighbours) {
+                if (m_error || m_scheduled >= tuneBytes || !fitsTuneLimits(depth, size)
+                    || measured(depth, size)) {
+                    continue;
+                }
+                const auto throughput = measure(depth, size);
+                if (throughput > nextThroughput) {
+                    next = { depth, size };
+                    nextThroughput = throughput;
+                }
+            }
+
+            if (next != std::pair { queueDepth, blockSize }) {
+                std::tie(queueDepth, blockSize) = next;
+                best = nextThroughput;
+                improved = true;
+            } else {
+                converged = m_scheduled < tuneBytes && !m_error;
+            }
+        }
+
+        resizeBlocks(queueDepth, blockSize);
+        m_tuned = converged;
+        logSelectedPath(
+            "copy engine",
+            "queue depth " + std::to_string(queueDepth) + ", block size "
+                + std::to_string(blockSize / 1024) + " KiB");
+    }
+
+    /*
+     * Copies up to limit bytes more of the range and waits until they are written
+     */
+    auto runPhase(std::uint64_t limit) -> void
+    {
+        m_scheduleLimit = limit == UINT64_MAX ? UINT64_MAX : m_scheduled + limit;
+        for (auto& block : m_blocks) {
+            if (!startChunk(block)) {
+                break;
+            }
+        }
+
+        auto handler = Overloaded {
+            [this](ReadBlock& read, ReadBlock::result_type result) {
+                onRead(*read.block, result);
+            },
+            [this](ReadvBlock& read, ReadvBlock::result_type result) {
+                onRead(*read.block, result);
+            },
+            [this](WriteBlock& write, WriteBlock::result_type result) {
+                onWrite(*write.block, result);
+            },
+            [this](WritevBlock& write, WritevBlock::result_type result) {
+                onWrite(*write.block, result);
+            },
+            [this](WakeOp&, WakeOp::result_type) { onChecksummed(); }
+        };
+
+        // In flight blocks are drained on failure, so the ring can be reused
+        while (m_inFlight) {
+            m_ring.submit();
+            auto completion = m_ring.wait();
+            Operations::dispatch(completion.get(), handler);
+            m_ring.seen(completion);
+        }
+    }
+
+    /*
+     * Returns the data extents of the input in [begin, end) and punches the holes
+     * between them into the output. Extents which cannot be discovered or holes
+     * which cannot be punched are copied as data.
+     */
+    auto dataExtents(std::uint64_t begin, std::uint64_t end) -> std::vector<Extent>
+    {
+        std::vector<Extent> extents;
+        auto position = begin;
+
+        while (position < end) {
+            auto data = lseek(m_inputFd, position, SEEK_DATA);
+            if (data < 0 && errno == ENXIO) {
+                // Only a hole is left up to the end of the file
+                data = end;
+            } else if (data < 0) {
+                extents.push_back({ position, end - position });
+                break;
+            }
+            const auto dataBegin = std::min<std::uint64_t>(data, end);
+
+            if (dataBegin > position && !punchHole(position, dataBegin - position)) {
+                extents.push_back({ position, dataBegin - position });
+            }
+            if (dataBegin == end) {
+                break;
+            }
+
+            auto hole = lseek(m_inputFd, dataBegin, SEEK_HOLE);
+            const auto dataEnd = hole < 0 ? end : std::min<std::uint64_t>(hole, end);
+            extents.push_back({ dataBegin, dataEnd - dataBegin });
+            position = dataEnd;
+        }
+
+        return extents;
+    }
+
+    auto punchHole(std::uint64_t offset, std::uint64_t length) -> bool
+    {
+        if (!m_punchHoles) {
+            return true;
+        }
+
+        struct stat outputStat;
+        if (fstat(m_outputFd, &outputStat) < 0
+            || fallocate(m_outputFd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset, length) < 0) {
+            return false;
+        }
+
+        // A hole at the end of the range extends the output like the written zeros would
+        if (static_cast<std::uint64_t>(outputStat.st_size) < offset + length) {
+            return ftruncate(m_outputFd, offset + length) == 0;
+        }
+        return true;
+    }
+
+    auto startChunk(Block& block) -> bool
+    {
+        while (m_extent < m_extents.size()
+               && m_next >= m_extents[m_extent].offset + m_extents[m_extent].length) {
+            if (++m_extent < m_extents.size()) {
+                m_next = m_extents[m_extent].offset;
+            }
+        }
+
+        if (m_error || m_extent == m_extents.size() || m_next >= m_end
+            || m_scheduled >= m_scheduleLimit) {
+            return false;
+        }
+
+        const auto& extent = m_extents[m_extent];
+        block.offset = m_next;
+        block.length = static_cast<std::size_t>(std::min<std::uint64_t>(
+            m_options.blockSize, extent.offset + extent.length - m_next));
+        block.read = 0;
+        block.written = 0;
+        m_next += block.length;
+        m_scheduled += block.length;
+        m_inFlight++;
+        prepareRead(block);
+        return true;
+    }
+
+    auto finishChunk(Block& block) -> void
+    {
+        if (m_options.checksum && block.written) {
+            m_blockDigests.push_back({ block.offset, block.written, block.crc });
+        }
+        m_copied += block.written;
+        m_inFlight--;
+        startChunk(block);
+    }
+
+    auto prepareRead(Block& block) -> void
+    {
+        const auto buffer = std::span(block.data).subspan(block.read, block.length - block.read);
+        const auto offset = block.offset + block.read;
+
+        if (m_path == CopyPath::ReadWrite) {
+            block.readOp.fd = m_inputFd;
+            block.readOp.buffer = buffer;
+            block.readOp.offset = offset;
+            m_ring.prepare_operation<Operations>(block.readOp);
+        } else {
+            block.vec = { buffer.data(), buffer.size() };
+            block.readvOp.fd = m_inputFd;
+            block.readvOp.vecs = &block.vec;
+            block.readvOp.offset = offset;
+            m_ring.prepare_operation<Operations>(block.readvOp);
+        }
+    }
+
+    auto prepareWrite(Block& block) -> void
+    {
+        const auto buffer = std::span(block.data).subspan(block.written, block.read - block.written);
+        const auto offset = block.offset + block.written;
+
+        if (m_path == CopyPath::ReadWrite) {
+            block.writeOp.fd = m_outputFd;
+            block.writeOp.buffer = buffer;
+            block.writeOp.offset = offset;
+            m_ring.prepare_operation<Operations>(block.writeOp);
+        } else {
+            block.vec = { buffer.data(), buffer.size() };
+            block.writevOp.fd = m_outputFd;
+            block.writevOp.vecs = &block.vec;
+            block.writevOp.offset = offset;
+            m_ring.prepare_operation<Operations>(block.writevOp);
+        }
+    }
+
+    auto onRead(Block& block, Result<std::size_t> result) -> void
+    {
+        if (!result.ok()) {
+            m_error = result.error();
+            m_inFlight--;
+            return;
+        }
+
+        if (result.value() == 0) {
+            // The input ended before the range, write what was read so far
+            block.length = block.read;
+            m_end = std::min(m_end, block.offset + block.read);
+        }
+        block.read += result.value();
+
+        if (block.read < block.length) {
+            prepareRead(block);
+        } else if (block.read) {
+            checksumAndWrite(block);
+        } else {
+            finishChunk(block);
+        }
+    }
+
+    auto checksumAndWrite(Block& block) -> void
+    {
+        if (!m_options.checksum) {
+            prepareWrite(block);
+        } else if (m_checksumWorkers) {
+            m_checksumWorkers->push(block);
+            if (!m_checksumming++) {
+                prepareWake();
+            }
+        } else {
+            block.crc = crc32c(std::span(block.data.data(), block.read));
+            prepareWrite(block);
+        }
+    }
+
+    auto prepareWake() -> void
+    {
+        m_wakeOp.fd = m_checksumWorkers->event_fd();
+        m_wakeOp.buffer = std::span(reinterpret_cast<std::uint8_t*>(&m_wakeCount), sizeof(m_wakeCount));
+        m_ring.prepare_operation<Operations>(m_wakeOp);
+    }
+
+    auto onChecksummed() -> void
+    {
+        for (auto block : m_checksumWorkers->take_done()) {
+            m_checksumming--;
+            if (m_error) {
+                m_inFlight--;
+            } else {
+                prepareWrite(*block);
+            }
+        }
+
+        if (m_checksumming) {
+            prepareWake();
+        }
+    }
+
+    /*
+     * Combines the digests of the blocks in file order, the gaps between them are
+     * holes which read as zeros
+     */
+    auto combineDigests(std::uint64_t begin, std::uint64_t end) -> std::uint32_t
+    {
+        std::sort(m_blockDigests.begin(), m_blockDigests.end(), [](const auto& a, const auto& b) {
+            return a.offset < b.offset;
+        });
+
+        std::uint32_t digest = 0;
+        auto position = begin;
+        for (const auto& block : m_blockDigests) {
+            digest = crc32cAppendZeros(digest, block.offset - position);
+            digest = crc32cCombine(digest, block.crc, block.length);
+            position = block.offset + block.length;
+        }
+        return crc32cAppendZeros(digest, end > position ? end - position : 0);
+    }
+
+    auto onWrite(Block& block, Result<std::size_t> result) -> void
+    {
+        if (!result.ok() || result.value() == 0) {
+            m_error = result.ok() ? EIO : result.error();
+            m_inFlight--;
+            return;
+        }
+
+        block.written += result.value();
+        if (block.written < block.read) {
+            prepareWrite(block);
+        } else {
+            finishChunk(block);
+        }
+    }
+
+    CopyOptions m_options;
+    CopyPath m_path;
+    Ring<void> m_ring;
+    std::vector<Block> m_blocks;
+
+    int m_inputFd = -1;
+    int m_outputFd = -1;
+    bool m_punchHoles = true;
+    bool m_tuned = false;
+    std::vector<CopyProbe> m_probes;
+    std::uint64_t m_scheduled = 0;
+    std::uint64_t m_scheduleLimit = UINT64_MAX;
+    std::unique_ptr<ChecksumWorkers> m_checksumWorkers;
+    WakeOp m_wakeOp {};
+    std::uint64_t m_wakeCount = 0;
+    std::size_t m_checksumming = 0;
+    std::vector<BlockDigest> m_blockDigests;
+    std::optional<std::uint32_t> m_digest;
+    std::vector<Extent> m_extents;
+    std::size_t m_extent = 0;
+    std::uint64_t m_next = 0;
+    std::uint64_t m_end = 0;
+    std::uint64_t m_copied = 0;
+    std::size_t m_inFlight = 0;
+    int m_error = 0;
+};
+
+} // namespace uringpp
@@ -0,0 +1,20 @@
+#pragma once
+
+namespace uringpp {
+
+/*
+ * Hints the cpu that the caller is in a busy wait loop. Reduces power
+ * consumption and the penalty of leaving the loop on a memory order violation.
+ */
+inline auto cpuRelax() -> void
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#else
+    asm volatile("" ::: "memory");
+#endif
+}
+
+} // namespace uringpp
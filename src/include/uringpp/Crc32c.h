@@ -0,0 +1,170 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+namespace uringpp {
+
+namespace detail {
+
+// Reflected Castagnoli polynomial
+constexpr std::uint32_t crc32cPolynomial = 0x82F63B78;
+
+inline auto crc32cTable() -> const std::array<std::uint32_t, 256>&
+{
+    static const auto table = [] {
+        std::array<std::uint32_t, 256> table {};
+        for (std::uint32_t byte = 0; byte < table.size(); byte++) {
+            auto crc = byte;
+            for (int bit = 0; bit < 8; bit++) {
+                crc = crc & 1 ? (crc >> 1) ^ crc32cPolynomial : crc >> 1;
+            }
+            table[byte] = crc;
+        }
+        return table;
+    }();
+    return table;
+}
+
+inline auto crc32cSoftware(std::uint32_t crc, const std::uint8_t* data, std::size_t size)
+    -> std::uint32_t
+{
+    const auto& table = crc32cTable();
+    for (std::size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+
+/*
+ * Multiplies two polynomials modulo the CRC polynomial
+ */
+inline auto crc32cMultiply(std::uint32_t a, std::uint32_t b) -> std::uint32_t
+{
+    std::uint32_t product = 0;
+    for (std::uint32_t mask = 1u << 31; mask; mask >>= 1) {
+        if (a & mask) {
+            product ^= b;
+        }
+        b = b & 1 ? (b >> 1) ^ crc32cPolynomial : b >> 1;
+    }
+    return product;
+}
+
+/*
+ * Returns x^(8 * length) modulo the CRC polynomial, the operator which appends
+ * length zero bytes to a CRC register
+ */
+inline auto crc32cZerosOperator(std::uint64_t length) -> std::uint32_t
+{
+    // x^(2^n), the bits of the length in bytes start at n = 3
+    static const auto powers = [] {
+        std::array<std::uint32_t, 64 + 3> powers {};
+        std::uint32_t power = 1u << 30;
+        for (auto& entry : powers) {
+            entry = power;
+            power = crc32cMultiply(power, power);
+        }
+        return powers;
+    }();
+
+    std::uint32_t result = 1u << 31;
+    for (std::size_t n = 3; length; length >>= 1, n++) {
+        if (length & 1) {
+            result = crc32cMultiply(powers[n], result);
+        }
+    }
+    return result;
+}
+
+#if defined(__x86_64__)
+/*
+ * Runs three independent crc32 instruction streams over consecutive stripes to
+ * hide the latency of the instruction and merges them with the zeros operator
+ */
+__attribute__((target("sse4.2"))) inline auto
+crc32cSse42(std::uint32_t crc, const std::uint8_t* data, std::size_t size) -> std::uint32_t
+{
+    constexpr std::size_t stripe = 4096;
+    static const auto shiftOneStripe = crc32cZerosOperator(stripe);
+    static const auto shiftTwoStripes = crc32cZerosOperator(2 * stripe);
+
+    auto load = [](const std::uint8_t* data) {
+        std::uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        return word;
+    };
+
+    for (; size >= 3 * stripe; data += 3 * stripe, size -= 3 * stripe) {
+        std::uint64_t first = crc;
+        std::uint64_t second = 0;
+        std::uint64_t third = 0;
+        for (std::size_t offset = 0; offset < stripe; offset += 8) {
+            first = _mm_crc32_u64(first, load(data + offset));
+            second = _mm_crc32_u64(second, load(data + stripe + offset));
+            third = _mm_crc32_u64(third, load(data + 2 * stripe + offset));
+        }
+        crc = crc32cMultiply(shiftTwoStripes, static_cast<std::uint32_t>(first))
+            ^ crc32cMultiply(shiftOneStripe, static_cast<std::uint32_t>(second))
+            ^ static_cast<std::uint32_t>(third);
+    }
+
+    std::uint64_t crc64 = crc;
+    for (; size >= 8; data += 8, size -= 8) {
+        crc64 = _mm_crc32_u64(crc64, load(data));
+    }
+    crc = static_cast<std::uint32_t>(crc64);
+    for (; size; data++, size--) {
+        crc = _mm_crc32_u8(crc, *data);
+    }
+    return crc;
+}
+#endif
+
+} // namespace detail
+
+/*
+ * CRC32C (Castagnoli) of the data, continued from the CRC of the preceding data.
+ *
+ * Uses the SSE4.2 crc32 instruction if the CPU has it and a lookup table
+ * otherwise.
+ */
+inline auto crc32c(std::span<const std::uint8_t> data, std::uint32_t crc = 0) -> std::uint32_t
+{
+    crc = ~crc;
+#if defined(__x86_64__)
+    static const bool sse42 = __builtin_cpu_supports("sse4.2");
+    if (sse42) {
+        return ~detail::crc32cSse42(crc, data.data(), data.size());
+    }
+#endif
+    return ~detail::crc32cSoftware(crc, data.data(), data.size());
+}
+
+/*
+ * CRC32C of the concatenation of two data blocks from their CRCs
+ *
+ * @param[in] lengthSecond length of the second block
+ */
+inline auto crc32cCombine(std::uint32_t crcFirst, std::uint32_t crcSecond, std::uint64_t lengthSecond)
+    -> std::uint32_t
+{
+    return detail::crc32cMultiply(detail::crc32cZerosOperator(lengthSecond), crcFirst) ^ crcSecond;
+}
+
+/*
+ * CRC32C of the data followed by length zero bytes, e.g. a hole of a sparse file
+ */
+inline auto crc32cAppendZeros(std::uint32_t crc, std::uint64_t length) -> std::uint32_t
+{
+    return ~detail::crc32cMultiply(detail::crc32cZerosOperator(length), ~crc);
+}
+
+} // namespace uringpp
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "liburing.h"
+
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+
+namespace uringpp {
+
+/*
+ * View on a datagram received by a multishot recvmsg into a provided buffer.
+ *
+ * The kernel writes an io_uring_recvmsg_out header, the source address, the control
+ * messages and the payload into the selected buffer. The msghdr of the receive
+ * command tells where each part starts.
+ */
+class RecvMsgOut {
+  public:
+    /*
+     * @param[in] buffer buffer selected by the kernel
+     * @param[in] received completion result, the number of bytes written into the buffer
+     * @param[in] msg msghdr the receive command was prepared with
+     */
+    RecvMsgOut(std::span<std::uint8_t> buffer, std::size_t received, msghdr& msg)
+        : m_msg(&msg)
+        , m_received(static_cast<int>(std::min(received, buffer.size())))
+        , m_out(io_uring_recvmsg_validate(buffer.data(), m_received, m_msg))
+    {
+    }
+
+    /*
+     * Returns false if the buffer is too short for the header, address and control
+     * messages announced by the msghdr
+     */
+    auto valid() const -> bool
+    {
+        return m_out != nullptr;
+    }
+
+    auto name() const -> const sockaddr*
+    {
+        return static_cast<const sockaddr*>(io_uring_recvmsg_name(m_out));
+    }
+
+    auto name_length() const -> socklen_t
+    {
+        return std::min<socklen_t>(m_out->namelen, m_msg->msg_namelen);
+    }
+
+    auto payload() const -> std::span<std::uint8_t>
+    {
+        return { static_cast<std::uint8_t*>(io_uring_recvmsg_payload(m_out, m_msg)),
+                 io_uring_recvmsg_payload_length(m_out, m_received, m_msg) };
+    }
+
+    /*
+     * Returns true if the datagram was larger than the buffer, the remainder is lost
+     */
+    auto payload_truncated() const -> bool
+    {
+        return m_out->flags & MSG_TRUNC;
+    }
+
+    auto control_truncated() const -> bool
+    {
+        return m_out->flags & MSG_CTRUNC;
+    }
+
+    auto first_cmsg() const -> cmsghdr*
+    {
+        return io_uring_recvmsg_cmsg_firsthdr(m_out, m_msg);
+    }
+
+    auto next_cmsg(cmsghdr* cmsg) const -> cmsghdr*
+    {
+        return io_uring_recvmsg_cmsg_nexthdr(m_out, m_msg, cmsg);
+    }
+
+  private:
+    msghdr* m_msg;
+    int m_received;
+    io_uring_recvmsg_out* m_out;
+};
+
+/*
+ * Batches datagrams of equal size to one destination into a single sendmsg with
+ * UDP generic segmentation offload. The kernel splits the batch into datagrams of
+ * the segment size, so a batch costs one command and one trip through the stack.
+ *
+ * All datagrams but the last must have the segment size. The batch must stay at
+ * its address until the sendmsg completed.
+ */
+class GsoBatch {
+    // Maximum payload of a single UDP send
+    static constexpr std::size_t maxPayload = 65507;
+
+  public:
+    // Maximum number of segments the kernel accepts per send
+    static constexpr std::size_t maxSegments = 64;
+
+    /*
+     * @param[in] segmentSize payload size of each datagram
+     * @param[in] segments maximum number of datagrams in the batch
+     */
+    explicit GsoBatch(std::size_t segmentSize, std::size_t segments = maxSegments)
+        : m_segmentSize(checkSegmentSize(segmentSize))
+        , m_maxSegments(std::min({ segments, maxSegments, maxPayload / segmentSize }))
+        , m_data(m_maxSegments * m_segmentSize)
+    {
+        std::memset(&m_destination, 0, sizeof(m_destination));
+        std::memset(&m_msg, 0, sizeof(m_msg));
+    }
+
+    GsoBatch(const GsoBatch&) = delete;
+    auto operator=(const GsoBatch&) -> GsoBatch& = delete;
+
+    auto set_destination(const sockaddr* address, socklen_t length) -> void
+    {
+        std::memcpy(&m_destination, address, std::min<std::size_t>(length, sizeof(m_destination)));
+        m_destinationLength = length;
+    }
+
+    /*
+     * Copies a datagram into the batch
+     *
+     * @return false if the batch is full, the datagram exceeds the segment size or
+     *         the previous datagram was shorter than the segment size
+     */
+    auto append(std::span<const std::uint8_t> datagram) -> bool
+    {
+        if (full() || datagram.size() > m_segmentSize) {
+            return false;
+        }
+
+        std::memcpy(m_data.data() + m_bytes, datagram.data(), datagram.size());
+        m_bytes += datagram.size();
+        m_segments++;
+        m_closed = datagram.size() < m_segmentSize;
+        return true;
+    }
+
+    auto full() const -> bool
+    {
+        return m_closed || m_segments == m_maxSegments;
+    }
+
+    auto empty() const -> bool
+    {
+        return m_segments == 0;
+    }
+
+    auto segments() const -> std::size_t
+    {
+        return m_segments;
+    }
+
+    auto bytes() const -> std::size_t
+    {
+        return m_bytes;
+    }
+
+    /*
+     * Returns the message for op::SendMsg or Ring::prepare_sendmsg. A single
+     * datagram is sent without segmentation.
+     */
+    auto message() -> const msghdr*
+    {
+        m_iovec.iov_base = m_data.data();
+        m_iovec.iov_len = m_bytes;
+
+        m_msg.msg_name = &m_destination;
+        m_msg.msg_namelen = m_destinationLength;
+        m_msg.msg_iov = &m_iovec;
+        m_msg.msg_iovlen = 1;
+        m_msg.msg_control = nullptr;
+        m_msg.msg_controllen = 0;
+
+        if (m_segments > 1) {
+            m_msg.msg_control = m_control;
+            m_msg.msg_controllen = sizeof(m_control);
+            auto cmsg = CMSG_FIRSTHDR(&m_msg);
+            cmsg->cmsg_level = SOL_UDP;
+            cmsg->cmsg_type = UDP_SEGMENT;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(std::uint16_t));
+            const auto segmentSize = static_cast<std::uint16_t>(m_segmentSize);
+            std::memcpy(CMSG_DATA(cmsg), &segmentSize, sizeof(segmentSize));
+        }
+
+        return &m_msg;
+    }
+
+    auto clear() -> void
+    {
+        m_bytes = 0;
+        m_segments = 0;
+        m_closed = false;
+    }
+
+  private:
+    static auto checkSegmentSize(std::size_t segmentSize) -> std::size_t
+    {
+        if (segmentSize == 0 || segmentSize > maxPayload) {
+            throw std::invalid_argument("Invalid gso segment size");
+        }
+        return segmentSize;
+    }
+
+    std::size_t m_segmentSize;
+    std::size_t m_maxSegments;
+    std::vector<std::uint8_t> m_data;
+    std::size_t m_bytes = 0;
+    std::size_t m_segments = 0;
+    bool m_closed = false;
+    sockaddr_storage m_destination;
+    socklen_t m_destinationLength = 0;
+    iovec m_iovec {};
+    msghdr m_msg;
+    alignas(cmsghdr) std::uint8_t m_control[CMSG_SPACE(sizeof(std::uint16_t))] {};
+};
+
+} // namespace uringpp
@@ -0,0 +1,375 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "uringpp/BufferPool.h"
+#include "uringpp/Operation.h"
+#include "uringpp/Ring.h"
+
+namespace uringpp {
+
+struct LoaderOptions {
+    // Number of files loaded at once, each holds a direct descriptor slot and a
+    // staging buffer
+    std::size_t batchSize = 256;
+    // Size of the staging buffers, larger files need a second read
+    std::size_t readSize = 64 * 1024;
+    // Size of the blocks of the arena, larger files get a block of their own
+    std::size_t blockSize = 4 * 1024 * 1024;
+};
+
+struct LoadedFile {
+    std::span<const std::uint8_t> data;
+    // errno of the failed open, statx or read, 0 if the file was loaded
+    int error = 0;
+
+    auto ok() const -> bool
+    {
+        return error == 0;
+    }
+};
+
+/*
+ * Contents of the files of one FileLoader::load_all, in the order of their paths.
+ * All contents live in the blocks of an arena which is owned by the result.
+ */
+class LoadedFiles {
+  public:
+    auto operator[](std::size_t index) const -> const LoadedFile&
+    {
+        return m_files[index];
+    }
+
+    auto size() const -> std::size_t
+    {
+        return m_files.size();
+    }
+
+    auto begin() const
+    {
+        return m_files.begin();
+    }
+
+    auto end() const
+    {
+        return m_files.end();
+    }
+
+    /*
+     * Total size of the loaded contents
+     */
+    auto bytes() const -> std::size_t
+    {
+        return m_bytes;
+    }
+
+  private:
+    friend class FileLoader;
+
+    LoadedFiles(std::size_t files, std::size_t blockSize)
+        : m_files(files)
+        , m_blockSize(blockSize)
+    {
+    }
+
+    auto allocate(std::size_t size) -> std::span<std::uint8_t>
+    {
+        if (size > m_blockSize / 4) {
+            m_blocks.push_back(std::make_unique_for_overwrite<std::uint8_t[]>(size));
+            return { m_blocks.back().get(), size };
+        }
+        if (m_blocks.empty() || m_blockUsed + size > m_blockSize) {
+            m_blocks.push_back(std::make_unique_for_overwrite<std::uint8_t[]>(m_blockSize));
+            m_block = m_blocks.back().get();
+            m_blockUsed = 0;
+        }
+        auto data = m_block + m_blockUsed;
+        m_blockUsed += size;
+        return { data, size };
+    }
+
+    std::vector<LoadedFile> m_files;
+    std::vector<std::unique_ptr<std::uint8_t[]>> m_blocks;
+    std::size_t m_blockSize;
+    std::uint8_t* m_block = nullptr;
+    std::size_t m_blockUsed = 0;
+    std::size_t m_bytes = 0;
+};
+
+/*
+ * Loads many small files, e.g. the configuration or assets of a service at startup.
+ *
+ * Each file is loaded by one chain of linked operations: an openat into a direct
+ * descriptor slot, a statx, a read into the staging buffer of the slot and a close
+ * of the slot. The links are hard links, so the close runs even if the open
+ * failed or the read was short, and batchSize chains are in flight at once. Once
+ * a chain completed the contents are copied into the arena. A file larger than
+ * the staging buffer, according to its statx, is completed by a second chain
+ * which reads the remainder straight into the arena.
+ *
+ * Direct descriptors need Linux 5.15.
+ */
+class FileLoader {
+    struct Slot;
+
+    struct OpenOp : op::OpenAtDirect {
+        Slot* slot;
+    };
+
+    struct StatxOp : op::Statx {
+        Slot* slot;
+    };
+
+    struct ReadOp : op::Read {
+        Slot* slot;
+    };
+
+    struct CloseOp : op::CloseDirect {
+        Slot* slot;
+    };
+
+    using Operations = OperationSet<OpenOp, StatxOp, ReadOp, CloseOp>;
+
+    struct Slot {
+        std::size_t file = 0;
+        unsigned index = 0;
+        std::size_t pending = 0;
+        int error = 0;
+        std::size_t length = 0;
+        // Arena region of a file larger than the staging buffer
+        std::span<std::uint8_t> large;
+        struct statx attributes {};
+        OpenOp openOp;
+        StatxOp statxOp;
+        ReadOp readOp;
+        CloseOp closeOp;
+    };
+
+  public:
+    explicit FileLoader(LoaderOptions options = {})
+        : m_options(checkOptions(options))
+        , m_staging(options.batchSize, options.readSize, 0)
+        , m_slots(options.batchSize)
+        , m_ring(4 * m_options.batchSize)
+    {
+        m_ring.register_files_sparse(options.batchSize);
+        for (std::size_t i = 0; i < m_slots.size(); i++) {
+            auto& slot = m_slots[i];
+            slot.index = static_cast<unsigned>(i);
+            slot.openOp.slot = &slot;
+            slot.statxOp.slot = &slot;
+            slot.readOp.slot = &slot;
+            slot.closeOp.slot = &slot;
+        }
+    }
+
+    FileLoader(const FileLoader&) = delete;
+    auto operator=(const FileLoader&) -> FileLoader& = delete;
+
+    /*
+     * Loads the files, a file which fails to load reports its error instead of
+     * failing the others
+     *
+     * A loader whose load_all threw, e.g. on a failed submit, still has reads into
+     * its buffers in flight and can not load again.
+     */
+    auto load_all(std::span<const std::filesystem::path> paths) -> LoadedFiles
+    {
+        if (m_inFlight) {
+            throw std::logic_error("FileLoader can not be reused after a failed load");
+        }
+
+        // Owned by the loader while loading, so the arena outlives the reads into it
+        m_files = LoadedFiles(paths.size(), m_options.blockSize);
+        m_paths = paths;
+        m_next = 0;
+
+        m_free.clear();
+        for (auto& slot : m_slots) {
+            m_free.push_back(&slot);
+        }
+        m_inFlight = startChains();
+
+        while (m_inFlight) {
+            m_ring.submit();
+            auto completion = m_ring.wait();
+            m_inFlight -= complete(completion.get());
+            m_ring.seen(completion);
+            while (auto next = m_ring.peek()) {
+                m_inFlight -= complete(next->get());
+                m_ring.seen(*next);
+            }
+            m_inFlight += startChains();
+        }
+
+        auto files = std::move(*m_files);
+        m_files.reset();
+        return files;
+    }
+
+    auto options() const -> const LoaderOptions&
+    {
+        return m_options;
+    }
+
+  private:
+    static auto checkOptions(LoaderOptions options) -> LoaderOptions
+    {
+        if (!options.batchSize || !options.readSize || !options.blockSize) {
+            throw std::invalid_argument("Batch, read and block size need to be positive");
+        }
+        return options;
+    }
+
+    /*
+     * Starts the chains of the next files on the free slots
+     *
+     * @return number of started chains
+     */
+    auto startChains() -> std::size_t
+    {
+        std::size_t started = 0;
+        while (!m_free.empty() && m_next < m_paths.size()) {
+            auto& slot = *m_free.back();
+            m_free.pop_back();
+            slot.file = m_next++;
+            slot.error = 0;
+            slot.length = 0;
+            slot.large = {};
+            prepareChain(slot, m_staging.at(slot.index), 0, true);
+            started++;
+        }
+        return started;
+    }
+
+    /*
+     * Prepares open, statx if withStatx, read of buffer at offset and close
+     */
+    auto prepareChain(
+        Slot& slot, std::span<std::uint8_t> buffer, std::uint64_t offset, bool withStatx) -> void
+    {
+        const auto path = m_paths[slot.file].c_str();
+
+        slot.openOp.path = path;
+        // A direct descriptor is not in the file table, O_CLOEXEC fails with EINVAL
+        slot.openOp.flags = O_RDONLY;
+        slot.openOp.fileIndex = slot.index;
+        slot.openOp.hardLink = true;
+        m_ring.prepare_operation<Operations>(slot.openOp);
+
+        if (withStatx) {
+            slot.statxOp.path = path;
+            slot.statxOp.buffer = &slot.attributes;
+            slot.statxOp.hardLink = true;
+            m_ring.prepare_operation<Operations>(slot.statxOp);
+        }
+
+        slot.readOp.fd = static_cast<int>(slot.index);
+        slot.readOp.fixedFile = true;
+        slot.readOp.buffer = buffer;
+        slot.readOp.offset = offset;
+        slot.readOp.hardLink = true;
+        m_ring.prepare_operation<Operations>(slot.readOp);
+
+        slot.closeOp.fileIndex = slot.index;
+        m_ring.prepare_operation<Operations>(slot.closeOp);
+
+        slot.pending = withStatx ? 4 : 3;
+    }
+
+    /*
+     * @return 1 if the completion finished the file
+     */
+    auto complete(const io_uring_cqe* cqe) -> std::size_t
+    {
+        Slot* completed = nullptr;
+        const auto onResult = [&](Slot& slot, int error) {
+            if (error && !slot.error) {
+                slot.error = error;
+            }
+            if (--slot.pending == 0) {
+                completed = &slot;
+            }
+        };
+
+        Operations::dispatch(
+            cqe,
+            Overloaded {
+                [&](OpenOp& open, OpenOp::result_type result) {
+                    onResult(*open.slot, result.error());
+                },
+                [&](StatxOp& statx, StatxOp::result_type result) {
+                    onResult(*statx.slot, result.error());
+                },
+                [&](ReadOp& read, ReadOp::result_type result) {
+                    if (result.ok()) {
+                        read.slot->length = result.value();
+                    }
+                    onResult(*read.slot, result.error());
+                },
+                // A failed close of a read only file loses no data
+                [&](CloseOp& close, CloseOp::result_type) { onResult(*close.slot, 0); } });
+
+        return completed ? finish(*completed) : 0;
+    }
+
+    auto finish(Slot& slot) -> std::size_t
+    {
+        auto& file = m_files->m_files[slot.file];
+        if (slot.error) {
+            file.error = slot.error;
+        } else if (!slot.large.empty()) {
+            file.data = slot.large.first(m_options.readSize + slot.length);
+        } else if (slot.length == m_options.readSize && slot.attributes.stx_size > slot.length) {
+            // Keep the staged head and read the rest behind it
+            slot.large = m_files->allocate(slot.attributes.stx_size);
+            std::memcpy(slot.large.data(), m_staging.at(slot.index).data(), slot.length);
+            prepareChain(slot, slot.large.subspan(slot.length), slot.length, false);
+            return 0;
+        } else {
+            auto data = m_files->allocate(slot.length);
+            std::memcpy(data.data(), m_staging.at(slot.index).data(), slot.length);
+            file.data = data;
+        }
+
+        m_files->m_bytes += file.data.size();
+        m_free.push_back(&slot);
+        return 1;
+    }
+
+    LoaderOptions m_options;
+    BufferPool m_staging;
+    std::vector<Slot> m_slots;
+    std::vector<Slot*> m_free;
+
+    std::span<const std::filesystem::path> m_paths;
+    std::optional<LoadedFiles> m_files;
+    std::size_t m_next = 0;
+    // Chains in flight
+    std::size_t m_inFlight = 0;
+    // Declared last, so it is destroyed first and cancels the reads into the staging
+    // buffers and the arena
+    Ring<void> m_ring;
+};
+
+/*
+ * Loads the files with a FileLoader which lives for this call only
+ */
+inline auto load_all(std::span<const std::filesystem::path> paths, LoaderOptions options = {})
+    -> LoadedFiles
+{
+    return FileLoader(options).load_all(paths);
+}
+
+} // namespace uringpp
@@ -0,0 +1,387 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <vector>
+
+#include "uringpp/LineSplitter.h"
+
+namespace uringpp {
+
+/*
+ * Part of a SegmentedBuffer: the unconsumed bytes of a provided buffer
+ */
+struct BufferSegment {
+    // Buffer id of the provided buffer, ownedSegment for bytes owned by the
+    // SegmentedBuffer
+    std::size_t bufferId;
+    std::span<const std::uint8_t> data;
+};
+
+inline constexpr std::size_t ownedSegment = static_cast<std::size_t>(-1);
+
+/*
+ * Byte stream chained from the provided buffers a connection received into.
+ *
+ * The buffers are referenced, not copied. Consuming bytes hands each buffer
+ * whose bytes were all consumed back to the caller, who returns it to its pool.
+ * compact() moves the remaining bytes into owned storage so that a long partial
+ * message does not pin many buffers of the pool.
+ */
+class SegmentedBuffer {
+  public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    auto append(std::size_t bufferId, std::span<const std::uint8_t> data) -> void
+    {
+        m_segments.push_back({ bufferId, data });
+        m_size += data.size();
+    }
+
+    auto size() const -> std::size_t
+    {
+        return m_size;
+    }
+
+    auto empty() const -> bool
+    {
+        return m_size == 0;
+    }
+
+    auto segments() const -> const std::deque<BufferSegment>&
+    {
+        return m_segments;
+    }
+
+    /*
+     * Contiguous bytes at the front of the stream
+     */
+    auto front() const -> std::span<const std::uint8_t>
+    {
+        return m_segments.empty() ? std::span<const std::uint8_t> {} : m_segments.front().data;
+    }
+
+    /*
+     * Copies destination.size() bytes starting at offset, which must be available
+     */
+    auto copy(std::size_t offset, std::span<std::uint8_t> destination) const -> void
+    {
+        auto out = destination.data();
+        auto remaining = destination.size();
+        for (const auto& segment : m_segments) {
+            if (!remaining) {
+                break;
+            }
+            if (offset >= segment.data.size()) {
+                offset -= segment.data.size();
+                continue;
+            }
+            const auto count = std::min(remaining, segment.data.size() - offset);
+            out = std::copy_n(segment.data.data() + offset, count, out);
+            remaining -= count;
+            offset = 0;
+        }
+    }
+
+    /*
+     * Returns the offset of the first occurrence of byte at or after from, or npos
+     */
+    auto find(std::uint8_t byte, std::size_t from = 0) const -> std::size_t
+    {
+        std::size_t base = 0;
+        for (const auto& segment : m_segments) {
+            const auto size = segment.data.size();
+            if (from < base + size) {
+                const auto begin = segment.data.data() + (from > base ? from - base : 0);
+                const auto end = segment.data.data() + size;
+                const auto found = findByte(begin, end, byte);
+                if (found != end) {
+                    return base + (found - segment.data.data());
+                }
+            }
+            base += size;
+        }
+        return npos;
+    }
+
+    /*
+     * Drops count bytes from the front and calls onRelease(std::size_t bufferId)
+     * for each provided buffer which has no bytes left
+     */
+    template <class OnRelease> auto consume(std::size_t count, OnRelease&& onRelease) -> void
+    {
+        m_size -= count;
+        while (count) {
+            auto& segment = m_segments.front();
+            if (count < segment.data.size()) {
+                segment.data = segment.data.subspan(count);
+                return;
+            }
+            count -= segment.data.size();
+            release(onRelease);
+        }
+    }
+
+    /*
+     * Moves all bytes into owned storage and calls onRelease for every provided
+     * buffer
+     */
+    template <class OnRelease> auto compact(OnRelease&& onRelease) -> void
+    {
+        if (m_segments.empty()
+            || (m_segments.size() == 1 && m_segments.front().bufferId == ownedSegment)) {
+            return;
+        }
+
+        // Owned bytes are always the first segment, drop what was consumed of them
+        if (m_segments.front().bufferId == ownedSegment) {
+            const auto consumed = m_segments.front().data.data() - m_storage.data();
+            m_storage.erase(m_storage.begin(), m_storage.begin() + consumed);
+            m_segments.pop_front();
+        } else {
+            m_storage.clear();
+        }
+
+        while (!m_segments.empty()) {
+            const auto data = m_segments.front().data;
+            m_storage.insert(m_storage.end(), data.begin(), data.end());
+            release(onRelease);
+        }
+        m_segments.push_front({ ownedSegment, m_storage });
+    }
+
+  private:
+    template <class OnRelease> auto release(OnRelease& onRelease) -> void
+    {
+        const auto bufferId = m_segments.front().bufferId;
+        m_segments.pop_front();
+        if (bufferId != ownedSegment) {
+            onRelease(bufferId);
+        }
+    }
+
+    std::deque<BufferSegment> m_segments;
+    std::size_t m_size = 0;
+    std::vector<std::uint8_t> m_storage;
+};
+
+//***************************************************************************
+// FRAMINGS
+//***************************************************************************
+
+enum class FrameStatus {
+    Complete,
+    Incomplete,
+    TooLarge
+};
+
+/*
+ * Position of a frame at the front of a SegmentedBuffer
+ */
+struct FrameExtent {
+    // Bytes before the payload, e.g. a length prefix
+    std::size_t header = 0;
+    std::size_t payload = 0;
+    // Bytes after the payload, e.g. a delimiter
+    std::size_t trailer = 0;
+
+    auto size() const -> std::size_t
+    {
+        return header + payload + trailer;
+    }
+};
+
+/*
+ * Frames with a big endian length prefix of prefixSize bytes (1, 2, 4 or 8) which
+ * counts the payload only
+ */
+struct LengthPrefixFraming {
+    std::size_t prefixSize = 4;
+    std::size_t maxFrameSize = 16 * 1024 * 1024;
+
+    /*
+     * @param[in] scanned unused, frames are located from their prefix
+     */
+    auto extent(const SegmentedBuffer& buffer, std::size_t& scanned, FrameExtent& extent) const
+        -> FrameStatus
+    {
+        static_cast<void>(scanned);
+        if (buffer.size() < prefixSize) {
+            return FrameStatus::Incomplete;
+        }
+
+        std::uint8_t prefix[8];
+        const auto front = buffer.front();
+        const auto bytes = front.size() >= prefixSize ? front.data() : prefix;
+        if (bytes == prefix) {
+            buffer.copy(0, std::span(prefix, prefixSize));
+        }
+
+        std::uint64_t length = 0;
+        for (std::size_t i = 0; i < prefixSize; i++) {
+            length = (length << 8) | bytes[i];
+        }
+        if (length > maxFrameSize) {
+            return FrameStatus::TooLarge;
+        }
+
+        extent = { prefixSize, static_cast<std::size_t>(length), 0 };
+        return buffer.size() >= extent.size() ? FrameStatus::Complete : FrameStatus::Incomplete;
+    }
+
+    /*
+     * Writes the prefix for a payload of length bytes
+     *
+     * @return number of bytes written, prefixSize
+     */
+    auto encode(std::uint64_t length, std::uint8_t* out) const -> std::size_t
+    {
+        for (std::size_t i = 0; i < prefixSize; i++) {
+            out[prefixSize - 1 - i] = static_cast<std::uint8_t>(length >> (8 * i));
+        }
+        return prefixSize;
+    }
+};
+
+/*
+ * Frames terminated by a delimiter byte, which is not part of the payload
+ */
+struct DelimiterFraming {
+    std::uint8_t delimiter = '\n';
+    std::size_t maxFrameSize = 64 * 1024;
+
+    /*
+     * @param[in,out] scanned bytes known to contain no delimiter, so a frame which
+     *                arrives in many buffers is searched once
+     */
+    auto extent(const SegmentedBuffer& buffer, std::size_t& scanned, FrameExtent& extent) const
+        -> FrameStatus
+    {
+        const auto position = buffer.find(delimiter, scanned);
+        if (position == SegmentedBuffer::npos) {
+            scanned = buffer.size();
+            return scanned > maxFrameSize ? FrameStatus::TooLarge : FrameStatus::Incomplete;
+        }
+        if (position > maxFrameSize) {
+            return FrameStatus::TooLarge;
+        }
+
+        extent = { 0, position, 1 };
+        return FrameStatus::Complete;
+    }
+};
+
+//***************************************************************************
+// DECODER
+//***************************************************************************
+
+/*
+ * Splits the data received into provided buffers into frames.
+ *
+ * A frame which lies within one buffer is handed out as a view into the buffer.
+ * Only a frame which straddles buffers is gathered into a scratch buffer. Every
+ * buffer is handed back as soon as all its bytes were consumed, and a partial
+ * frame which would hold more than maxHeldBuffers buffers is moved into owned
+ * storage, so large frames do not exhaust the pool.
+ *
+ * Framing is LengthPrefixFraming, DelimiterFraming or any type with an equal
+ * extent() member.
+ */
+template <class Framing> class FrameDecoder {
+  public:
+    explicit FrameDecoder(Framing framing = {}, std::size_t maxHeldBuffers = 4)
+        : m_framing(framing)
+        , m_maxHeldBuffers(maxHeldBuffers)
+    {
+    }
+
+    /*
+     * Adds the bytes received into a provided buffer, calls
+     * onFrame(std::span<const std::uint8_t> payload) for each completed frame and
+     * onRelease(std::size_t bufferId) for each buffer which may be provided again.
+     * A payload is valid during the call only.
+     *
+     * @return false if a frame exceeds the maximum frame size, the stream can not
+     *         be decoded further
+     */
+    template <class OnFrame, class OnRelease>
+    auto feed(
+        std::size_t bufferId,
+        std::span<const std::uint8_t> data,
+        OnFrame&& onFrame,
+        OnRelease&& onRelease) -> bool
+    {
+        if (data.empty()) {
+            // e.g. a recv which saw the end of the stream
+            onRelease(bufferId);
+            return true;
+        }
+        m_buffer.append(bufferId, data);
+
+        FrameExtent extent;
+        while (!m_buffer.empty()) {
+            const auto status = m_framing.extent(m_buffer, m_scanned, extent);
+            if (status == FrameStatus::TooLarge) {
+                return false;
+            }
+            if (status == FrameStatus::Incomplete) {
+                break;
+            }
+
+            const auto front = m_buffer.front();
+            if (front.size() >= extent.size()) {
+                onFrame(front.subspan(extent.header, extent.payload));
+            } else {
+                m_frame.resize(extent.payload);
+                m_buffer.copy(extent.header, m_frame);
+                m_gathered++;
+                onFrame(std::span<const std::uint8_t>(m_frame));
+            }
+            m_buffer.consume(extent.size(), onRelease);
+            m_scanned = 0;
+        }
+
+        if (m_buffer.segments().size() > m_maxHeldBuffers) {
+            m_buffer.compact(onRelease);
+        }
+        return true;
+    }
+
+    /*
+     * Bytes of the incomplete frame
+     */
+    auto buffered() const -> std::size_t
+    {
+        return m_buffer.size();
+    }
+
+    /*
+     * Provided buffers held by the incomplete frame
+     */
+    auto held_buffers() const -> std::size_t
+    {
+        return std::count_if(m_buffer.segments().begin(), m_buffer.segments().end(), [](auto& s) {
+            return s.bufferId != ownedSegment;
+        });
+    }
+
+    /*
+     * Number of frames which straddled buffers and were copied
+     */
+    auto gathered() const -> std::uint64_t
+    {
+        return m_gathered;
+    }
+
+  private:
+    Framing m_framing;
+    std::size_t m_maxHeldBuffers;
+    SegmentedBuffer m_buffer;
+    std::size_t m_scanned = 0;
+    std::vector<std::uint8_t> m_frame;
+    std::uint64_t m_gathered = 0;
+};
+
+} // namespace uringpp
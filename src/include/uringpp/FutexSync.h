@@ -0,0 +1,337 @@
+#pragma once
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+#include "uringpp/Operation.h"
+
+namespace uringpp {
+
+inline auto futexWord(std::atomic<std::uint32_t>& word) -> std::uint32_t*
+{
+    static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t));
+    return reinterpret_cast<std::uint32_t*>(&word);
+}
+
+/*
+ * Blocks the calling thread while word holds expected, or until it is woken
+ */
+inline auto futexWait(std::atomic<std::uint32_t>& word, std::uint32_t expected) -> void
+{
+    syscall(SYS_futex, futexWord(word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+}
+
+inline auto futexWake(std::atomic<std::uint32_t>& word, std::uint32_t count) -> void
+{
+    syscall(SYS_futex, futexWord(word), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+}
+
+/*
+ * Outcome of acquiring an AsyncMutex, AsyncSemaphore or AsyncQueue on a ring
+ */
+enum class AcquireStatus {
+    Acquired,
+    // The futex wait was prepared, complete() is to be called once it completed
+    Waiting,
+    // The submission queue was full, the acquire is to be repeated with complete()
+    QueueFull
+};
+
+/*
+ * Mutex which a thread which owns a ring locks without blocking: a contended
+ * lock prepares an op::FutexWait, so the thread keeps completing its I/O while it
+ * waits and is woken by the completion of the wait. Threads without a ring lock
+ * it with the blocking lock().
+ *
+ * The state is 0 when unlocked, 1 when locked and 2 when locked with waiters, so
+ * an uncontended lock and unlock are one atomic operation each and unlock only
+ * wakes if someone waits.
+ *
+ *  switch (mutex.lock<Operations>(ring, wait)) { ... }
+ *  // on completion of the op::FutexWait
+ *  if (mutex.complete<Operations>(ring, wait) == AcquireStatus::Acquired) { ... }
+ *
+ * Waiting on a ring needs futex support of io_uring (Capabilities::has_futex()).
+ */
+class AsyncMutex {
+  public:
+    auto try_lock() -> bool
+    {
+        std::uint32_t unlocked = 0;
+        return m_state.compare_exchange_strong(
+            unlocked, 1, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    /*
+     * Blocks the calling thread until the mutex is locked
+     */
+    auto lock() -> void
+    {
+        if (try_lock()) {
+            return;
+        }
+        while (m_state.exchange(2, std::memory_order_acquire) != 0) {
+            futexWait(m_state, 2);
+        }
+    }
+
+    /*
+     * Locks the mutex or prepares the wait for its unlock
+     *
+     * @param[in] wait operation which must stay valid until its completion
+     */
+    template <class Operations, class Ring>
+    auto lock(Ring& ring, op::FutexWait& wait) -> AcquireStatus
+    {
+        if (try_lock()) {
+            return AcquireStatus::Acquired;
+        }
+        return complete<Operations>(ring, wait);
+    }
+
+    /*
+     * Locks the mutex after the wait completed or waits again
+     */
+    template <class Operations, class Ring>
+    auto complete(Ring& ring, op::FutexWait& wait) -> AcquireStatus
+    {
+        // A woken waiter can not tell whether others wait, so it keeps the state
+        // contended and its unlock wakes the next one
+        if (m_state.exchange(2, std::memory_order_acquire) == 0) {
+            return AcquireStatus::Acquired;
+        }
+        wait.futex = futexWord(m_state);
+        wait.expected = 2;
+        return ring.template prepare_operation<Operations>(wait) ? AcquireStatus::Waiting
+                                                                   : AcquireStatus::QueueFull;
+    }
+
+    auto unlock() -> void
+    {
+        if (m_state.exchange(0, std::memory_order_release) == 2) {
+            futexWake(m_state, 1);
+        }
+    }
+
+    /*
+     * Unlocks the mutex and wakes a waiter with the next submit of the ring instead
+     * of a system call
+     */
+    template <class Operations, class Ring> auto unlock(Ring& ring, op::FutexWake& wake) -> void
+    {
+        if (m_state.exchange(0, std::memory_order_release) == 2) {
+            wake.futex = futexWord(m_state);
+            wake.count = 1;
+            if (!ring.template prepare_operation<Operations>(wake)) {
+                futexWake(m_state, 1);
+            }
+        }
+    }
+
+  private:
+    std::atomic<std::uint32_t> m_state = 0;
+};
+
+/*
+ * Counting semaphore with the same ring and blocking interface as AsyncMutex.
+ * The count is the futex, waiters sleep while it is 0 and a release only wakes if
+ * waiters registered.
+ */
+class AsyncSemaphore {
+  public:
+    explicit AsyncSemaphore(std::uint32_t count = 0)
+        : m_count(count)
+    {
+    }
+
+    auto try_acquire() -> bool
+    {
+        auto count = m_count.load(std::memory_order_relaxed);
+        while (count) {
+            if (m_count.compare_exchange_weak(
+                    count, count - 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /*
+     * Blocks the calling thread until a unit was acquired
+     */
+    auto acquire() -> void
+    {
+        while (!try_acquire()) {
+            m_waiters.fetch_add(1);
+            futexWait(m_count, 0);
+            m_waiters.fetch_sub(1);
+        }
+    }
+
+    /*
+     * Acquires a unit or prepares the wait for a release
+     *
+     * @param[in] wait operation which must stay valid until its completion
+     */
+    template <class Operations, class Ring>
+    auto acquire(Ring& ring, op::FutexWait& wait) -> AcquireStatus
+    {
+        if (try_acquire()) {
+            return AcquireStatus::Acquired;
+        }
+
+        // A release between the registration and the submission of the wait
+        // changes the count, the wait then completes with -EAGAIN and is retried
+        m_waiters.fetch_add(1);
+        wait.futex = futexWord(m_count);
+        wait.expected = 0;
+        return ring.template prepare_operation<Operations>(wait) ? AcquireStatus::Waiting
+                                                                   : AcquireStatus::QueueFull;
+    }
+
+    /*
+     * Acquires a unit after the wait completed or waits again
+     */
+    template <class Operations, class Ring>
+    auto complete(Ring& ring, op::FutexWait& wait) -> AcquireStatus
+    {
+        m_waiters.fetch_sub(1);
+        return acquire<Operations>(ring, wait);
+    }
+
+    auto release(std::uint32_t count = 1) -> void
+    {
+        m_count.fetch_add(count);
+        if (m_waiters.load()) {
+            futexWake(m_count, count);
+        }
+    }
+
+    /*
+     * Releases count units and wakes waiters with the next submit of the ring
+     * instead of a system call
+     */
+    template <class Operations, class Ring>
+    auto release(Ring& ring, op::FutexWake& wake, std::uint32_t count = 1) -> void
+    {
+        m_count.fetch_add(count);
+        if (m_waiters.load()) {
+            wake.futex = futexWord(m_count);
+            wake.count = count;
+            if (!ring.template prepare_operation<Operations>(wake)) {
+                futexWake(m_count, count);
+            }
+        }
+    }
+
+    auto available() const -> std::uint32_t
+    {
+        return m_count.load(std::memory_order_relaxed);
+    }
+
+  private:
+    std::atomic<std::uint32_t> m_count;
+    std::atomic<std::uint32_t> m_waiters = 0;
+};
+
+/*
+ * Unbounded multi producer, multi consumer queue whose consumers wait on a ring.
+ * The items are counted by an AsyncSemaphore, a consumer which acquired a unit
+ * takes an item under an AsyncMutex.
+ */
+template <class T> class AsyncQueue {
+  public:
+    auto push(T value) -> void
+    {
+        store(std::move(value));
+        m_available.release();
+    }
+
+    /*
+     * Pushes the value and wakes a consumer with the next submit of the ring
+     */
+    template <class Operations, class Ring>
+    auto push(Ring& ring, op::FutexWake& wake, T value) -> void
+    {
+        store(std::move(value));
+        m_available.template release<Operations>(ring, wake);
+    }
+
+    auto try_pop() -> std::optional<T>
+    {
+        if (!m_available.try_acquire()) {
+            return std::nullopt;
+        }
+        return take();
+    }
+
+    /*
+     * Blocks the calling thread until an item was taken
+     */
+    auto pop() -> T
+    {
+        m_available.acquire();
+        return take();
+    }
+
+    /*
+     * Takes an item into value or prepares the wait for a push
+     *
+     * @param[in] wait operation which must stay valid until its completion
+     */
+    template <class Operations, class Ring>
+    auto pop(Ring& ring, op::FutexWait& wait, T& value) -> AcquireStatus
+    {
+        return taken(m_available.template acquire<Operations>(ring, wait), value);
+    }
+
+    /*
+     * Takes an item after the wait completed or waits again
+     */
+    template <class Operations, class Ring>
+    auto complete(Ring& ring, op::FutexWait& wait, T& value) -> AcquireStatus
+    {
+        return taken(m_available.template complete<Operations>(ring, wait), value);
+    }
+
+    auto size() const -> std::size_t
+    {
+        return m_available.available();
+    }
+
+  private:
+    auto store(T&& value) -> void
+    {
+        std::lock_guard lock(m_mutex);
+        m_items.push_back(std::move(value));
+    }
+
+    auto take() -> T
+    {
+        std::lock_guard lock(m_mutex);
+        auto value = std::move(m_items.front());
+        m_items.pop_front();
+        return value;
+    }
+
+    auto taken(AcquireStatus status, T& value) -> AcquireStatus
+    {
+        if (status == AcquireStatus::Acquired) {
+            value = take();
+        }
+        return status;
+    }
+
+    AsyncMutex m_mutex;
+    AsyncSemaphore m_available;
+    std::deque<T> m_items;
+};
+
+} // namespace uringpp
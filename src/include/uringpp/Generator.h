@@ -0,0 +1,168 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+
+namespace uringpp {
+
+/*
+ * Lazily evaluated sequence of the values a coroutine yields:
+ *
+ *  auto numbers() -> Generator<int> { for (int i = 0;; i++) co_yield i; }
+ *
+ * The coroutine runs until its next co_yield whenever the consumer advances,
+ * so a yielded value, e.g. a view into a buffer, stays valid until the consumer
+ * moves on. An exception of the coroutine is rethrown to the consumer.
+ *
+ * The generator is a move only input view, so it composes with the range
+ * adapters, e.g. std::move(generator) | std::views::transform(parse).
+ */
+template <class T> class Generator : public std::ranges::view_interface<Generator<T>> {
+  public:
+    using value_type = std::remove_cvref_t<T>;
+    using reference = const value_type&;
+
+    struct promise_type {
+        const value_type* value = nullptr;
+        std::exception_ptr exception;
+
+        auto get_return_object() -> Generator
+        {
+            return Generator(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        auto initial_suspend() noexcept -> std::suspend_always
+        {
+            return {};
+        }
+
+        auto final_suspend() noexcept -> std::suspend_always
+        {
+            return {};
+        }
+
+        // A yielded temporary lives until the coroutine resumes
+        auto yield_value(const value_type& yielded) noexcept -> std::suspend_always
+        {
+            value = std::addressof(yielded);
+            return {};
+        }
+
+        auto return_void() -> void
+        {
+        }
+
+        auto unhandled_exception() -> void
+        {
+            exception = std::current_exception();
+        }
+
+        // The coroutine is resumed by its consumer only
+        template <class Awaitable> auto await_transform(Awaitable&&) = delete;
+    };
+
+    using Handle = std::coroutine_handle<promise_type>;
+
+    class iterator {
+      public:
+        using value_type = Generator::value_type;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+
+        auto operator*() const -> reference
+        {
+            return *m_coroutine.promise().value;
+        }
+
+        auto operator++() -> iterator&
+        {
+            resume(m_coroutine);
+            return *this;
+        }
+
+        auto operator++(int) -> void
+        {
+            ++*this;
+        }
+
+        friend auto operator==(const iterator& it, std::default_sentinel_t) -> bool
+        {
+            return !it.m_coroutine || it.m_coroutine.done();
+        }
+
+      private:
+        friend class Generator;
+
+        explicit iterator(Handle coroutine)
+            : m_coroutine(coroutine)
+        {
+        }
+
+        Handle m_coroutine;
+    };
+
+    Generator() = default;
+
+    Generator(Generator&& other) noexcept
+        : m_coroutine(std::exchange(other.m_coroutine, {}))
+        , m_started(std::exchange(other.m_started, false))
+    {
+    }
+
+    auto operator=(Generator&& other) noexcept -> Generator&
+    {
+        std::swap(m_coroutine, other.m_coroutine);
+        std::swap(m_started, other.m_started);
+        return *this;
+    }
+
+    ~Generator()
+    {
+        if (m_coroutine) {
+            m_coroutine.destroy();
+        }
+    }
+
+    /*
+     * Runs the coroutine to its first co_yield, a generator is iterated once
+     */
+    auto begin() -> iterator
+    {
+        if (m_coroutine && !m_started) {
+            m_started = true;
+            resume(m_coroutine);
+        }
+        return iterator(m_coroutine);
+    }
+
+    auto end() const -> std::default_sentinel_t
+    {
+        return {};
+    }
+
+  private:
+    explicit Generator(Handle coroutine)
+        : m_coroutine(coroutine)
+    {
+    }
+
+    static auto resume(Handle coroutine) -> void
+    {
+        coroutine.resume();
+        if (auto exception = std::exchange(coroutine.promise().exception, nullptr)) {
+            std::rethrow_exception(exception);
+        }
+    }
+
+    Handle m_coroutine;
+    bool m_started = false;
+};
+
+} // namespace uringpp
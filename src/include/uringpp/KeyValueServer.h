@@ -0,0 +1,562 @@
+#pragma once
+
+#include <limits.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "uringpp/BufferPoolManager.h"
+#include "uringpp/Capabilities.h"
+#include "uringpp/KeyValueStore.h"
+#include "uringpp/MemcacheParser.h"
+#include "uringpp/Operation.h"
+#include "uringpp/Ring.h"
+
+namespace uringpp {
+
+struct KeyValueServerOptions {
+    std::size_t queueDepth = 256;
+    std::size_t bufferSize = 16 * 1024;
+    std::size_t numberOfBuffers = 256;
+    std::size_t maxValueSize = 1024 * 1024;
+    // Initial number of slots of the store
+    std::size_t capacity = 64 * 1024;
+};
+
+struct KeyValueServerStatistics {
+    std::uint64_t connections = 0;
+    std::uint64_t activeConnections = 0;
+    std::uint64_t gets = 0;
+    std::uint64_t getHits = 0;
+    std::uint64_t sets = 0;
+    std::uint64_t deletes = 0;
+    // sendmsg calls, each sends the responses to all requests parsed since the last one
+    std::uint64_t sends = 0;
+};
+
+/*
+ * In-memory key-value server speaking the get, set and delete subset of the
+ * memcached text protocol.
+ *
+ * Connections receive into provided buffers and the MemcacheParser parses the
+ * pipelined requests in place from them, so a buffer goes back to the kernel as
+ * soon as it was parsed. The responses are collected as iovecs, constant replies
+ * point to static strings and get hits to the stored item. They are sent with one
+ * sendmsg, the responses parsed while a send is in flight go with the next one.
+ *
+ * run() serves until stop() is called from any thread.
+ */
+class KeyValueServer {
+  public:
+    /*
+     * @param[in] listenFd listening socket, owned by the caller
+     */
+    KeyValueServer(
+        int listenFd,
+        KeyValueServerOptions options = {},
+        const Capabilities& capabilities = Capabilities::get())
+        : m_listenFd(listenFd)
+        , m_options(options)
+        , m_store(options.capacity)
+        , m_ring(options.queueDepth)
+    {
+        if (!capabilities.has_provide_buffers()) {
+            throw std::runtime_error("KeyValueServer needs provided buffers");
+        }
+        m_buffers.emplace(
+            std::vector<SizeClass> { { options.bufferSize, options.numberOfBuffers } });
+
+        m_eventFd = eventfd(0, EFD_CLOEXEC);
+        if (m_eventFd < 0) {
+            throw std::runtime_error(std::string("Failed to create eventfd: ") + strerror(errno));
+        }
+    }
+
+    KeyValueServer(const KeyValueServer&) = delete;
+    auto operator=(const KeyValueServer&) -> KeyValueServer& = delete;
+
+    ~KeyValueServer()
+    {
+        // Closes the sockets while receives and sends may still be in flight, the
+        // members, m_ring included, are only destroyed after this body. The kernel
+        // keeps each socket alive until the ring cancelled its last operation.
+        for (auto& connection : m_connections) {
+            close(connection->fd);
+        }
+        close(m_eventFd);
+    }
+
+    /*
+     * Accepts and serves connections until stop() is called. Returns once all
+     * connections were closed.
+     */
+    auto run() -> void
+    {
+        m_stopping = false;
+        if (!m_acceptArmed) {
+            m_acceptOp.fd = m_listenFd;
+            prepare(m_acceptOp);
+            m_acceptArmed = true;
+        }
+        prepareWake();
+        if (!m_buffersProvided) {
+            m_buffers->provide<Operations>(m_ring);
+            m_buffersProvided = true;
+        }
+
+        auto handler = Overloaded {
+            [this](AcceptOp&, AcceptOp::result_type result) { onAccepted(result); },
+            [this](RecvOp& recv, RecvOp::result_type result) {
+                onReceived(*recv.connection, result);
+            },
+            [this](SendOp& send, SendOp::result_type result) {
+                onSent(*send.connection, result);
+            },
+            [this](WakeOp&, WakeOp::result_type) { onStop(); },
+            [this](ProvideBuffersOp& provide, ProvideBuffersOp::result_type result) {
+                if (!result.ok()) {
+                    throw std::runtime_error(
+                        std::string("Failed to provide buffers: ") + strerror(result.error()));
+                }
+                m_parked.provided(*m_buffers, provide, [this](Connection* connection) {
+                    onResumed(*connection);
+                });
+            }
+        };
+
+        while (!m_stopping || !m_connections.empty()) {
+            m_ring.submit();
+            auto completion = m_ring.wait();
+            Operations::dispatch(completion.get(), handler);
+            m_ring.seen(completion);
+        }
+    }
+
+    /*
+     * Makes run() close all connections and return, may be called from any thread
+     */
+    auto stop() -> void
+    {
+        const std::uint64_t one = 1;
+        if (write(m_eventFd, &one, sizeof(one)) != sizeof(one)) {
+            throw std::runtime_error(std::string("Failed to stop server: ") + strerror(errno));
+        }
+    }
+
+    /*
+     * The store, e.g. to preload it. Must not be used while run() is running.
+     */
+    auto store() -> KeyValueStore&
+    {
+        return m_store;
+    }
+
+    /*
+     * Returns the statistics, consistent while run() is not running
+     */
+    auto statistics() const -> KeyValueServerStatistics
+    {
+        return m_statistics;
+    }
+
+  private:
+    struct Connection;
+
+    struct AcceptOp : op::Accept {
+    };
+
+    struct RecvOp : op::RecvBp {
+        Connection* connection;
+    };
+
+    struct SendOp : op::SendMsg {
+        Connection* connection;
+    };
+
+    struct WakeOp : op::Read {
+    };
+
+    using ProvideBuffersOp = BufferPoolManager::ProvideBuffersOp;
+    using Operations = OperationSet<AcceptOp, RecvOp, SendOp, WakeOp, ProvideBuffersOp>;
+
+    /*
+     * Responses gathered for one sendmsg. The items keep the hits alive until
+     * they were sent.
+     */
+    struct Batch {
+        std::vector<iovec> vecs;
+        std::vector<ItemRef> items;
+        // Number of completely sent vecs
+        std::size_t sent = 0;
+
+        auto append(std::string_view data) -> void
+        {
+            vecs.push_back({ const_cast<char*>(data.data()), data.size() });
+        }
+
+        auto clear() -> void
+        {
+            vecs.clear();
+            items.clear();
+            sent = 0;
+        }
+    };
+
+    struct Connection {
+        explicit Connection(std::size_t maxValueSize)
+            : parser(maxValueSize)
+        {
+        }
+
+        int fd = -1;
+        std::size_t index = 0;
+        // Operations in flight, the connection is freed once it is closing and none is left
+        std::size_t pending = 0;
+        bool receiving = false;
+        bool sending = false;
+        // The client shut its sending side down or sent garbage, close after the responses
+        bool draining = false;
+        bool closing = false;
+        MemcacheParser parser;
+        RecvOp recv {};
+        SendOp send {};
+        msghdr message {};
+        Batch inFlight;
+        Batch next;
+    };
+
+    // Responses which are queued beyond this number of iovecs stop the receiving
+    // until the send caught up
+    static constexpr std::size_t maxQueuedVecs = IOV_MAX;
+
+    static constexpr std::string_view stored = "STORED\r\n";
+    static constexpr std::string_view deleted = "DELETED\r\n";
+    static constexpr std::string_view notFound = "NOT_FOUND\r\n";
+    static constexpr std::string_view end = "END\r\n";
+    static constexpr std::string_view error = "ERROR\r\n";
+    static constexpr std::string_view clientError = "CLIENT_ERROR bad data chunk\r\n";
+
+    //***************************************************************************
+    // CONNECTIONS
+    //***************************************************************************
+
+    auto onAccepted(AcceptOp::result_type result) -> void
+    {
+        m_acceptArmed = false;
+        if (m_stopping) {
+            if (result.ok()) {
+                close(result.value());
+            }
+            return;
+        }
+        prepare(m_acceptOp);
+        m_acceptArmed = true;
+
+        if (!result.ok()) {
+            // e.g. EMFILE, the next accept tries again
+            return;
+        }
+
+        const int one = 1;
+        setsockopt(result.value(), IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        auto& connection
+            = *m_connections.emplace_back(std::make_unique<Connection>(m_options.maxValueSize));
+        connection.index = m_connections.size() - 1;
+        connection.fd = result.value();
+        connection.recv.connection = &connection;
+        connection.send.connection = &connection;
+        m_statistics.connections++;
+        m_statistics.activeConnections++;
+        receive(connection);
+    }
+
+    /*
+     * Shuts the socket down, which completes the receive in flight
+     */
+    auto closeConnection(Connection& connection) -> void
+    {
+        if (!connection.closing) {
+            connection.closing = true;
+            shutdown(connection.fd, SHUT_RDWR);
+        }
+        finishIfIdle(connection);
+    }
+
+    auto finishIfIdle(Connection& connection) -> void
+    {
+        if (!connection.closing || connection.pending) {
+            return;
+        }
+
+        m_parked.remove(&connection);
+        close(connection.fd);
+        m_statistics.activeConnections--;
+
+        const auto index = connection.index;
+        std::swap(m_connections[index], m_connections.back());
+        m_connections[index]->index = index;
+        m_connections.pop_back();
+    }
+
+    auto onStop() -> void
+    {
+        m_stopping = true;
+        for (std::size_t index = m_connections.size(); index > 0; index--) {
+            closeConnection(*m_connections[index - 1]);
+        }
+    }
+
+    //***************************************************************************
+    // REQUESTS
+    //***************************************************************************
+
+    auto receive(Connection& connection) -> void
+    {
+        connection.recv.fd = connection.fd;
+        connection.recv.bufferPool = &m_buffers->pool(0);
+        connection.receiving = true;
+        prepare(connection, connection.recv);
+    }
+
+    auto onReceived(Connection& connection, RecvOp::result_type result) -> void
+    {
+        connection.pending--;
+        connection.receiving = false;
+
+        if (connection.closing) {
+            if (result.ok() && result.value() > 0) {
+                m_buffers->acquired(0, result.value());
+                releaseBuffer(result.buffer_idx());
+            }
+            finishIfIdle(connection);
+            return;
+        }
+
+        if (result.error() == ENOBUFS) {
+            // All buffers are in flight, the connection stays receiving until buffers
+            // are provided
+            connection.receiving = true;
+            reserve(1);
+            m_parked.park<Operations>(m_ring, *m_buffers, 0, &connection);
+            return;
+        }
+
+        if (!result.ok()) {
+            closeConnection(connection);
+            return;
+        }
+
+        if (result.value() == 0) {
+            connection.draining = true;
+        } else {
+            m_buffers->acquired(0, result.value());
+            const auto buffer = m_buffers->buffer(0, result.buffer_idx()).first(result.value());
+            const auto ok = connection.parser.feed(
+                buffer, [&](const MemcacheRequest& request) { handle(connection, request); });
+            // Nothing refers to the buffer after parsing, responses point into the store
+            releaseBuffer(result.buffer_idx());
+
+            if (!ok) {
+                connection.next.append(clientError);
+                connection.draining = true;
+            }
+        }
+
+        flush(connection);
+        if (!connection.draining && connection.next.vecs.size() < maxQueuedVecs) {
+            receive(connection);
+        }
+        closeIfDrained(connection);
+    }
+
+    /*
+     * Re-arms the receive of a parked connection after buffers were provided
+     */
+    auto onResumed(Connection& connection) -> void
+    {
+        if (connection.closing) {
+            connection.receiving = false;
+            finishIfIdle(connection);
+            return;
+        }
+        receive(connection);
+    }
+
+    auto handle(Connection& connection, const MemcacheRequest& request) -> void
+    {
+        auto& batch = connection.next;
+        switch (request.command) {
+        case MemcacheCommand::Get:
+            request.for_each_key([&](std::string_view key) {
+                m_statistics.gets++;
+                if (auto item = m_store.get(key)) {
+                    m_statistics.getHits++;
+                    batch.append(item->response());
+                    batch.items.push_back(std::move(item));
+                }
+            });
+            batch.append(end);
+            break;
+        case MemcacheCommand::Set:
+            m_statistics.sets++;
+            m_store.set(request.key, request.flags, request.data);
+            if (!request.noreply) {
+                batch.append(stored);
+            }
+            break;
+        case MemcacheCommand::Delete:
+            m_statistics.deletes++;
+            if (const auto found = m_store.erase(request.key); !request.noreply) {
+                batch.append(found ? deleted : notFound);
+            }
+            break;
+        case MemcacheCommand::Invalid:
+            batch.append(error);
+            break;
+        }
+    }
+
+    auto closeIfDrained(Connection& connection) -> void
+    {
+        if (connection.draining && !connection.sending && !connection.receiving) {
+            closeConnection(connection);
+        }
+    }
+
+    //***************************************************************************
+    // RESPONSES
+    //***************************************************************************
+
+    /*
+     * Starts sending the gathered responses unless a send is in flight
+     */
+    auto flush(Connection& connection) -> void
+    {
+        if (connection.sending || connection.next.vecs.empty()) {
+            return;
+        }
+        std::swap(connection.inFlight, connection.next);
+        m_statistics.sends++;
+        sendRemaining(connection);
+    }
+
+    auto sendRemaining(Connection& connection) -> void
+    {
+        auto& batch = connection.inFlight;
+        connection.message.msg_iov = batch.vecs.data() + batch.sent;
+        connection.message.msg_iovlen = std::min(batch.vecs.size() - batch.sent, maxQueuedVecs);
+        connection.send.fd = connection.fd;
+        connection.send.msg = &connection.message;
+        connection.sending = true;
+        prepare(connection, connection.send);
+    }
+
+    auto onSent(Connection& connection, SendOp::result_type result) -> void
+    {
+        connection.pending--;
+        connection.sending = false;
+
+        if (!result.ok() || connection.closing) {
+            connection.inFlight.clear();
+            closeConnection(connection);
+            return;
+        }
+
+        // Skip what was sent, a short send continues within a vec
+        auto& batch = connection.inFlight;
+        auto sent = result.value();
+        while (batch.sent < batch.vecs.size() && sent >= batch.vecs[batch.sent].iov_len) {
+            sent -= batch.vecs[batch.sent].iov_len;
+            batch.sent++;
+        }
+        if (batch.sent < batch.vecs.size()) {
+            auto& vec = batch.vecs[batch.sent];
+            vec.iov_base = static_cast<char*>(vec.iov_base) + sent;
+            vec.iov_len -= sent;
+            sendRemaining(connection);
+            return;
+        }
+
+        batch.clear();
+        flush(connection);
+        if (!connection.draining && !connection.receiving
+            && connection.next.vecs.size() < maxQueuedVecs) {
+            receive(connection);
+        }
+        closeIfDrained(connection);
+    }
+
+    //***************************************************************************
+    // SUBMISSION
+    //***************************************************************************
+
+    auto releaseBuffer(std::size_t bufferId) -> void
+    {
+        reserve(1);
+        m_buffers->release<Operations>(m_ring, 0, bufferId);
+    }
+
+    /*
+     * Submits the prepared entries if less than count entries are free
+     */
+    auto reserve(unsigned count) -> void
+    {
+        if (m_ring.capacity() < count) {
+            m_ring.submit();
+        }
+    }
+
+    template <class Operation> auto prepare(Operation& operation) -> void
+    {
+        reserve(1);
+        m_ring.prepare_operation<Operations>(operation);
+    }
+
+    template <class Operation> auto prepare(Connection& connection, Operation& operation) -> void
+    {
+        prepare(operation);
+        connection.pending++;
+    }
+
+    auto prepareWake() -> void
+    {
+        m_wakeOp.fd = m_eventFd;
+        m_wakeOp.buffer
+            = std::span(reinterpret_cast<std::uint8_t*>(&m_wakeCount), sizeof(m_wakeCount));
+        prepare(m_wakeOp);
+    }
+
+    int m_listenFd;
+    KeyValueServerOptions m_options;
+    int m_eventFd = -1;
+    bool m_stopping = false;
+    bool m_acceptArmed = false;
+    bool m_buffersProvided = false;
+    AcceptOp m_acceptOp {};
+    WakeOp m_wakeOp {};
+    std::uint64_t m_wakeCount = 0;
+    KeyValueStore m_store;
+    std::optional<BufferPoolManager> m_buffers;
+    // Connections whose receive ran out of buffers
+    ParkedReceives<Connection*> m_parked;
+    std::vector<std::unique_ptr<Connection>> m_connections;
+    KeyValueServerStatistics m_statistics;
+    // Declared last, so it is destroyed first and cancels the operations in flight
+    Ring<void> m_ring;
+};
+
+} // namespace uringpp
@@ -0,0 +1,308 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace uringpp {
+
+/*
+ * Value of a KeyValueStore. The item is stored in the form a memcached get
+ * answers with, "VALUE <key> <flags> <bytes>\r\n<data>\r\n", so a hit is sent
+ * straight out of the item.
+ *
+ * Items are reference counted without atomics and shared between the store and
+ * the sends in flight, a replaced or erased item lives until its last send
+ * completed.
+ */
+class Item {
+  public:
+    static auto create(std::string_view key, std::uint32_t flags, std::string_view data) -> Item*
+    {
+        char numbers[32];
+        auto end = std::to_chars(numbers, numbers + sizeof(numbers), flags).ptr;
+        *end++ = ' ';
+        end = std::to_chars(end, numbers + sizeof(numbers), data.size()).ptr;
+
+        const auto headerSize = prefix.size() + key.size() + 1 + (end - numbers) + 2;
+        const auto size = headerSize + data.size() + 2;
+        auto item
+            = new (::operator new(sizeof(Item) + size)) Item(key.size(), headerSize, size, flags);
+
+        auto bytes = item->bytes();
+        bytes = std::copy(prefix.begin(), prefix.end(), bytes);
+        bytes = std::copy(key.begin(), key.end(), bytes);
+        *bytes++ = ' ';
+        bytes = std::copy(numbers, end, bytes);
+        bytes = std::copy_n("\r\n", 2, bytes);
+        bytes = std::copy(data.begin(), data.end(), bytes);
+        std::copy_n("\r\n", 2, bytes);
+        return item;
+    }
+
+    auto acquire() -> void
+    {
+        m_references++;
+    }
+
+    auto release() -> void
+    {
+        if (--m_references == 0) {
+            this->~Item();
+            ::operator delete(this);
+        }
+    }
+
+    auto key() const -> std::string_view
+    {
+        return { bytes() + prefix.size(), m_keySize };
+    }
+
+    auto data() const -> std::string_view
+    {
+        return { bytes() + m_headerSize, m_size - m_headerSize - 2 };
+    }
+
+    auto flags() const -> std::uint32_t
+    {
+        return m_flags;
+    }
+
+    /*
+     * The VALUE line followed by the data block
+     */
+    auto response() const -> std::string_view
+    {
+        return { bytes(), m_size };
+    }
+
+  private:
+    static constexpr std::string_view prefix = "VALUE ";
+
+    Item(std::size_t keySize, std::size_t headerSize, std::size_t size, std::uint32_t flags)
+        : m_keySize(static_cast<std::uint32_t>(keySize))
+        , m_headerSize(static_cast<std::uint32_t>(headerSize))
+        , m_flags(flags)
+        , m_size(size)
+    {
+    }
+
+    auto bytes() -> char*
+    {
+        return reinterpret_cast<char*>(this + 1);
+    }
+
+    auto bytes() const -> const char*
+    {
+        return reinterpret_cast<const char*>(this + 1);
+    }
+
+    std::uint32_t m_references = 1;
+    std::uint32_t m_keySize;
+    std::uint32_t m_headerSize;
+    std::uint32_t m_flags;
+    std::size_t m_size;
+};
+
+/*
+ * Owning reference to an Item, empty for a miss
+ */
+class ItemRef {
+  public:
+    ItemRef() = default;
+
+    explicit ItemRef(Item* item)
+        : m_item(item)
+    {
+        if (m_item) {
+            m_item->acquire();
+        }
+    }
+
+    ItemRef(ItemRef&& other) noexcept
+        : m_item(std::exchange(other.m_item, nullptr))
+    {
+    }
+
+    auto operator=(ItemRef&& other) noexcept -> ItemRef&
+    {
+        std::swap(m_item, other.m_item);
+        return *this;
+    }
+
+    ItemRef(const ItemRef&) = delete;
+    auto operator=(const ItemRef&) -> ItemRef& = delete;
+
+    ~ItemRef()
+    {
+        if (m_item) {
+            m_item->release();
+        }
+    }
+
+    explicit operator bool() const
+    {
+        return m_item;
+    }
+
+    auto operator->() const -> const Item*
+    {
+        return m_item;
+    }
+
+  private:
+    Item* m_item = nullptr;
+};
+
+/*
+ * Single threaded hash table from keys to items.
+ *
+ * Open addressing with linear probing: a slot is the hash and a pointer to the
+ * item, four slots share a cache line and a lookup compares the hashes before
+ * it touches an item. Erasing shifts the following slots of the probe sequence
+ * back instead of leaving tombstones, so lookups never scan deleted slots.
+ */
+class KeyValueStore {
+  public:
+    /*
+     * @param[in] capacity number of slots, rounded up to a power of two. The table
+     *            doubles once it is three quarters full.
+     */
+    explicit KeyValueStore(std::size_t capacity = 1024)
+        : m_slots(std::bit_ceil(std::max<std::size_t>(capacity, 8)))
+    {
+    }
+
+    KeyValueStore(const KeyValueStore&) = delete;
+    auto operator=(const KeyValueStore&) -> KeyValueStore& = delete;
+
+    ~KeyValueStore()
+    {
+        for (auto& slot : m_slots) {
+            if (slot.item) {
+                slot.item->release();
+            }
+        }
+    }
+
+    auto get(std::string_view key) const -> ItemRef
+    {
+        const auto index = find(key, hashOf(key));
+        return ItemRef(index != npos ? m_slots[index].item : nullptr);
+    }
+
+    /*
+     * Inserts the item or replaces the item of the key
+     */
+    auto set(std::string_view key, std::uint32_t flags, std::string_view data) -> void
+    {
+        const auto hash = hashOf(key);
+        auto item = Item::create(key, flags, data);
+
+        const auto index = find(key, hash);
+        if (index != npos) {
+            m_slots[index].item->release();
+            m_slots[index].item = item;
+            return;
+        }
+
+        if ((m_size + 1) * 4 > m_slots.size() * 3) {
+            grow();
+        }
+        insert({ hash, item });
+        m_size++;
+    }
+
+    /*
+     * @return false if the key was not present
+     */
+    auto erase(std::string_view key) -> bool
+    {
+        auto index = find(key, hashOf(key));
+        if (index == npos) {
+            return false;
+        }
+        m_slots[index].item->release();
+        m_slots[index].item = nullptr;
+        m_size--;
+
+        // Move the following entries of the probe sequence into the gap unless
+        // their ideal slot lies behind the gap
+        const auto mask = m_slots.size() - 1;
+        for (auto next = (index + 1) & mask; m_slots[next].item; next = (next + 1) & mask) {
+            const auto ideal = m_slots[next].hash & mask;
+            if (((next - ideal) & mask) >= ((next - index) & mask)) {
+                m_slots[index] = m_slots[next];
+                m_slots[next].item = nullptr;
+                index = next;
+            }
+        }
+        return true;
+    }
+
+    auto size() const -> std::size_t
+    {
+        return m_size;
+    }
+
+    auto capacity() const -> std::size_t
+    {
+        return m_slots.size();
+    }
+
+  private:
+    struct Slot {
+        std::size_t hash = 0;
+        Item* item = nullptr;
+    };
+
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    static auto hashOf(std::string_view key) -> std::size_t
+    {
+        return std::hash<std::string_view> {}(key);
+    }
+
+    auto find(std::string_view key, std::size_t hash) const -> std::size_t
+    {
+        const auto mask = m_slots.size() - 1;
+        for (auto index = hash & mask; m_slots[index].item; index = (index + 1) & mask) {
+            if (m_slots[index].hash == hash && m_slots[index].item->key() == key) {
+                return index;
+            }
+        }
+        return npos;
+    }
+
+    auto insert(Slot slot) -> void
+    {
+        const auto mask = m_slots.size() - 1;
+        auto index = slot.hash & mask;
+        while (m_slots[index].item) {
+            index = (index + 1) & mask;
+        }
+        m_slots[index] = slot;
+    }
+
+    auto grow() -> void
+    {
+        auto slots = std::exchange(m_slots, std::vector<Slot>(m_slots.size() * 2));
+        for (const auto& slot : slots) {
+            if (slot.item) {
+                insert(slot);
+            }
+        }
+    }
+
+    std::vector<Slot> m_slots;
+    std::size_t m_size = 0;
+};
+
+} // namespace uringpp
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <limits>
+
+namespace uringpp {
+
+/*
+ * Log-linear histogram of latencies in nanoseconds with a relative error below
+ * 1/64 (~1.6%) over the whole 64 bit range.
+ *
+ * Values below 64 are counted exactly, larger values in 64 linear sub buckets per
+ * power of two. Recording is a few instructions and never allocates.
+ *
+ * Load generators which wait for a response before they send the next request
+ * (closed loop) do not send the requests they should have sent while a response
+ * was late, so the latency of those requests is never measured (coordinated
+ * omission). record_corrected and corrected() add the missing samples for an
+ * expected interval between requests.
+ */
+class LatencyHistogram {
+  public:
+    static constexpr unsigned subBucketBits = 6;
+    static constexpr std::uint64_t subBuckets = 1u << subBucketBits;
+    static constexpr std::size_t buckets = (64 - subBucketBits + 1) * subBuckets;
+
+    auto record(std::uint64_t value, std::uint64_t count = 1) -> void
+    {
+        m_counts[index(value)] += count;
+        m_count += count;
+        m_sum += static_cast<double>(value) * count;
+        m_min = std::min(m_min, value);
+        m_max = std::max(m_max, value);
+    }
+
+    /*
+     * Records the value and the values of the requests which would have been sent
+     * every expectedInterval while waiting for it
+     *
+     * @param[in] expectedInterval interval between requests, 0 disables the correction
+     */
+    auto record_corrected(std::uint64_t value, std::uint64_t expectedInterval) -> void
+    {
+        recordCorrected(value, expectedInterval, 1);
+    }
+
+    /*
+     * Returns a copy of the histogram as if all its values had been recorded with
+     * record_corrected
+     */
+    auto corrected(std::uint64_t expectedInterval) const -> LatencyHistogram
+    {
+        LatencyHistogram histogram;
+        for (std::size_t bucket = 0; bucket < buckets; bucket++) {
+            if (m_counts[bucket]) {
+                histogram.recordCorrected(value(bucket), expectedInterval, m_counts[bucket]);
+            }
+        }
+        // The corrections are smaller than the value they were derived from
+        histogram.m_min = std::min(histogram.m_min, m_min);
+        histogram.m_max = m_max;
+        return histogram;
+    }
+
+    auto merge(const LatencyHistogram& other) -> void
+    {
+        for (std::size_t bucket = 0; bucket < buckets; bucket++) {
+            m_counts[bucket] += other.m_counts[bucket];
+        }
+        m_count += other.m_count;
+        m_sum += other.m_sum;
+        m_min = std::min(m_min, other.m_min);
+        m_max = std::max(m_max, other.m_max);
+    }
+
+    /*
+     * Returns the value at the percentile, exact for the minimum and maximum
+     *
+     * @param[in] percentile in [0, 100]
+     */
+    auto percentile(double percentile) const -> std::uint64_t
+    {
+        if (!m_count) {
+            return 0;
+        }
+
+        const auto rank = std::max<std::uint64_t>(
+            1, static_cast<std::uint64_t>(percentile / 100.0 * static_cast<double>(m_count) + 0.5));
+        std::uint64_t seen = 0;
+        for (std::size_t bucket = 0; bucket < buckets; bucket++) {
+            seen += m_counts[bucket];
+            if (seen >= rank) {
+                return std::clamp(value(bucket), m_min, m_max);
+            }
+        }
+        return m_max;
+    }
+
+    auto count() const -> std::uint64_t
+    {
+        return m_count;
+    }
+
+    auto min() const -> std::uint64_t
+    {
+        return m_count ? m_min : 0;
+    }
+
+    auto max() const -> std::uint64_t
+    {
+        return m_max;
+    }
+
+    auto mean() const -> double
+    {
+        return m_count ? m_sum / static_cast<double>(m_count) : 0.0;
+    }
+
+    auto reset() -> void
+    {
+        *this = LatencyHistogram {};
+    }
+
+  private:
+    auto recordCorrected(std::uint64_t value, std::uint64_t expectedInterval, std::uint64_t count)
+        -> void
+    {
+        record(value, count);
+        if (!expectedInterval) {
+            return;
+        }
+        for (auto missing = value - std::min(value, expectedInterval); missing >= expectedInterval;
+             missing -= expectedInterval) {
+            record(missing, count);
+        }
+    }
+
+    static auto index(std::uint64_t value) -> std::size_t
+    {
+        if (value < subBuckets) {
+            return value;
+        }
+        const unsigned exponent = std::bit_width(value) - 1;
+        const auto subBucket = (value >> (exponent - subBucketBits)) & (subBuckets - 1);
+        return (exponent - subBucketBits + 1) * subBuckets + subBucket;
+    }
+
+    /*
+     * Returns the middle of the values counted in the bucket
+     */
+    static auto value(std::size_t bucket) -> std::uint64_t
+    {
+        if (bucket < subBuckets) {
+            return bucket;
+        }
+        const unsigned shift = bucket / subBuckets - 1;
+        const auto lowest = (subBuckets + bucket % subBuckets) << shift;
+        return lowest + ((std::uint64_t { 1 } << shift) >> 1);
+    }
+
+    std::array<std::uint64_t, buckets> m_counts {};
+    std::uint64_t m_count = 0;
+    double m_sum = 0;
+    std::uint64_t m_min = std::numeric_limits<std::uint64_t>::max();
+    std::uint64_t m_max = 0;
+};
+
+} // namespace uringpp
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace uringpp {
+
+/*
+ * Returns the first occurrence of byte in [begin, end) or end.
+ *
+ * Compares 16 bytes per step with SSE2 if available and falls back to memchr
+ * otherwise.
+ */
+inline auto findByte(const std::uint8_t* begin, const std::uint8_t* end, std::uint8_t byte)
+    -> const std::uint8_t*
+{
+#if defined(__SSE2__)
+    const auto pattern = _mm_set1_epi8(static_cast<char>(byte));
+    for (; end - begin >= 16; begin += 16) {
+        const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        const auto mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, pattern));
+        if (mask) {
+            return begin + __builtin_ctz(mask);
+        }
+    }
+    for (; begin != end; begin++) {
+        if (*begin == byte) {
+            return begin;
+        }
+    }
+    return end;
+#else
+    auto found = std::memchr(begin, byte, end - begin);
+    return found ? static_cast<const std::uint8_t*>(found) : end;
+#endif
+}
+
+/*
+ * Splits a stream of chunks into newline terminated records.
+ *
+ * Records which lie within a chunk are handed out as views into the chunk. Only
+ * a record which crosses a chunk boundary is copied into an internal carry
+ * buffer, until its newline arrives with a later chunk.
+ */
+class LineSplitter {
+  public:
+    /*
+     * Calls onLine(std::string_view) for each record completed by the chunk, without
+     * the newline
+     *
+     * @return number of completed records
+     */
+    template <class OnLine> auto feed(std::span<const std::uint8_t> chunk, OnLine&& onLine) -> std::size_t
+    {
+        auto begin = chunk.data();
+        const auto end = chunk.data() + chunk.size();
+        std::size_t lines = 0;
+
+        while (begin != end) {
+            const auto newline = findByte(begin, end, '\n');
+            if (newline == end) {
+                m_carry.append(reinterpret_cast<const char*>(begin), end - begin);
+                break;
+            }
+
+            const auto record = std::string_view(reinterpret_cast<const char*>(begin), newline - begin);
+            if (m_carry.empty()) {
+                onLine(record);
+            } else {
+                m_carry.append(record);
+                onLine(std::string_view(m_carry));
+                m_carry.clear();
+            }
+            lines++;
+            begin = newline + 1;
+        }
+
+        return lines;
+    }
+
+    /*
+     * Calls onLine for the last record if the stream did not end with a newline
+     *
+     * @return number of completed records
+     */
+    template <class OnLine> auto finish(OnLine&& onLine) -> std::size_t
+    {
+        if (m_carry.empty()) {
+            return 0;
+        }
+
+        onLine(std::string_view(m_carry));
+        m_carry.clear();
+        return 1;
+    }
+
+    /*
+     * Bytes of the incomplete record carried to the next chunk
+     */
+    auto carried() const -> std::size_t
+    {
+        return m_carry.size();
+    }
+
+  private:
+    std::string m_carry;
+};
+
+} // namespace uringpp
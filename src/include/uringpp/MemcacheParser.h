@@ -0,0 +1,241 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "uringpp/LineSplitter.h"
+
+namespace uringpp {
+
+enum class MemcacheCommand {
+    Get,
+    Set,
+    Delete,
+    // Unknown command or malformed command line, answered with ERROR
+    Invalid
+};
+
+struct MemcacheRequest {
+    MemcacheCommand command = MemcacheCommand::Invalid;
+    // The key, or all space separated keys of a get
+    std::string_view key;
+    std::uint32_t flags = 0;
+    // Data block of a set without the trailing "\r\n"
+    std::string_view data;
+    bool noreply = false;
+
+    /*
+     * Calls onKey(std::string_view) for each key of a get
+     */
+    template <class OnKey> auto for_each_key(OnKey&& onKey) const -> void
+    {
+        auto keys = key;
+        while (true) {
+            const auto begin = keys.find_first_not_of(' ');
+            if (begin == std::string_view::npos) {
+                return;
+            }
+            keys.remove_prefix(begin);
+            const auto end = std::min(keys.find(' '), keys.size());
+            onKey(keys.substr(0, end));
+            keys.remove_prefix(end);
+        }
+    }
+};
+
+/*
+ * Parses the get, set and delete commands of the memcached text protocol from a
+ * stream of chunks, e.g. the provided buffers of a connection.
+ *
+ * Requests are parsed in place: the keys and data of a request which lies within
+ * a chunk are views into the chunk, so pipelined requests are handled without
+ * copies. Only a request which crosses a chunk boundary is collected in a carry
+ * buffer until it is complete.
+ */
+class MemcacheParser {
+  public:
+    static constexpr std::size_t maxKeySize = 250;
+    static constexpr std::size_t maxLineSize = 2048;
+
+    /*
+     * @param[in] maxValueSize largest data block a set may carry
+     */
+    explicit MemcacheParser(std::size_t maxValueSize = 1024 * 1024)
+        : m_maxValueSize(maxValueSize)
+    {
+    }
+
+    /*
+     * Calls onRequest(const MemcacheRequest&) for each request completed by the
+     * chunk. The views of the request are valid during the call only.
+     *
+     * @return false on an error the stream can not recover from, an over long
+     *         line, a malformed set or a data block without terminator
+     */
+    template <class OnRequest>
+    auto feed(std::span<const std::uint8_t> chunk, OnRequest&& onRequest) -> bool
+    {
+        auto input = std::string_view(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+        MemcacheRequest request;
+
+        // Complete the request which crossed the previous boundary, taking no more
+        // than it needs so the following requests are parsed in place
+        while (!m_carry.empty() && !input.empty()) {
+            auto take = input.size();
+            if (m_required) {
+                take = std::min(take, m_required - m_carry.size());
+            } else if (const auto newline = input.find('\n'); newline != std::string_view::npos) {
+                take = newline + 1;
+            }
+            m_carry.append(input.substr(0, take));
+            input.remove_prefix(take);
+
+            const auto parsed = parse(m_carry, request);
+            if (parsed.error) {
+                return false;
+            }
+            m_required = parsed.required;
+            if (parsed.consumed) {
+                onRequest(request);
+                m_carry.clear();
+            }
+        }
+
+        while (!input.empty()) {
+            const auto parsed = parse(input, request);
+            if (parsed.error) {
+                return false;
+            }
+            if (!parsed.consumed) {
+                m_carry.assign(input);
+                m_required = parsed.required;
+                break;
+            }
+            onRequest(request);
+            input.remove_prefix(parsed.consumed);
+        }
+        return true;
+    }
+
+    /*
+     * Bytes of the incomplete request carried to the next chunk
+     */
+    auto carried() const -> std::size_t
+    {
+        return m_carry.size();
+    }
+
+  private:
+    struct Parsed {
+        // Length of the complete request, 0 if incomplete
+        std::size_t consumed = 0;
+        // Length of the incomplete request if known
+        std::size_t required = 0;
+        bool error = false;
+    };
+
+    auto parse(std::string_view input, MemcacheRequest& request) const -> Parsed
+    {
+        const auto newline = findByte(
+            reinterpret_cast<const std::uint8_t*>(input.data()),
+            reinterpret_cast<const std::uint8_t*>(input.data() + input.size()),
+            '\n');
+        const auto lineEnd = reinterpret_cast<const char*>(newline) - input.data();
+        if (static_cast<std::size_t>(lineEnd) == input.size()) {
+            return { .error = input.size() > maxLineSize };
+        }
+        if (static_cast<std::size_t>(lineEnd) > maxLineSize) {
+            return { .error = true };
+        }
+
+        auto line = input.substr(0, lineEnd);
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        const std::size_t lineSize = lineEnd + 1;
+
+        request = MemcacheRequest {};
+        const auto command = nextToken(line);
+
+        if (command == "get") {
+            const auto begin = line.find_first_not_of(' ');
+            if (begin != std::string_view::npos) {
+                request.command = MemcacheCommand::Get;
+                request.key = line.substr(begin);
+                request.for_each_key([&](std::string_view key) {
+                    if (key.size() > maxKeySize) {
+                        request.command = MemcacheCommand::Invalid;
+                    }
+                });
+            }
+            return { .consumed = lineSize };
+        }
+
+        if (command == "delete") {
+            request.key = nextToken(line);
+            request.noreply = nextToken(line) == "noreply";
+            if (!request.key.empty() && request.key.size() <= maxKeySize) {
+                request.command = MemcacheCommand::Delete;
+            }
+            return { .consumed = lineSize };
+        }
+
+        if (command == "set") {
+            // set <key> <flags> <exptime> <bytes> [noreply]
+            std::uint32_t flags;
+            std::int64_t exptime;
+            std::size_t bytes;
+            request.key = nextToken(line);
+            if (request.key.empty() || !parseNumber(nextToken(line), flags)
+                || !parseNumber(nextToken(line), exptime) || !parseNumber(nextToken(line), bytes)
+                || bytes > m_maxValueSize) {
+                return { .error = true };
+            }
+            request.noreply = nextToken(line) == "noreply";
+
+            const auto size = lineSize + bytes + 2;
+            if (input.size() < size) {
+                return { .required = size };
+            }
+            if (input.substr(lineSize + bytes, 2) != "\r\n") {
+                return { .error = true };
+            }
+            // Expiry is not supported, items live until they are replaced or deleted
+            if (request.key.size() <= maxKeySize) {
+                request.command = MemcacheCommand::Set;
+            }
+            request.flags = flags;
+            request.data = input.substr(lineSize, bytes);
+            return { .consumed = size };
+        }
+
+        return { .consumed = lineSize };
+    }
+
+    static auto nextToken(std::string_view& line) -> std::string_view
+    {
+        const auto begin = std::min(line.find_first_not_of(' '), line.size());
+        const auto end = std::min(line.find(' ', begin), line.size());
+        const auto token = line.substr(begin, end - begin);
+        line.remove_prefix(end);
+        return token;
+    }
+
+    template <class Number> static auto parseNumber(std::string_view token, Number& number) -> bool
+    {
+        const auto result = std::from_chars(token.data(), token.data() + token.size(), number);
+        return !token.empty() && result.ec == std::errc()
+            && result.ptr == token.data() + token.size();
+    }
+
+    std::size_t m_maxValueSize;
+    std::string m_carry;
+    // Length of the carried request once its command line is complete
+    std::size_t m_required = 0;
+};
+
+} // namespace uringpp
@@ -0,0 +1,949 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+#include "liburing.h"
+
+#include "uringpp/BufferPool.h"
+
+namespace uringpp {
+
+/*
+ * Typed view on the result of a completed operation. Negative kernel results
+ * are reported as errno values, non negative results as the value of the operation.
+ */
+template <class Value> class Result {
+  public:
+    explicit Result(std::int32_t result)
+        : m_result(result)
+    {
+    }
+
+    auto ok() const -> bool
+    {
+        return m_result >= 0;
+    }
+
+    auto error() const -> int
+    {
+        return ok() ? 0 : -m_result;
+    }
+
+    auto value() const -> Value
+    {
+        return static_cast<Value>(m_result);
+    }
+
+  private:
+    std::int32_t m_result;
+};
+
+/*
+ * Result of a receive into a buffer selected by the kernel from a BufferPool
+ */
+class BufferResult : public Result<std::size_t> {
+  public:
+    BufferResult(std::int32_t result, std::uint32_t flags)
+        : Result<std::size_t>(result)
+        , m_bufferIdx(flags >> IORING_CQE_BUFFER_SHIFT)
+    {
+    }
+
+    auto buffer_idx() const -> std::size_t
+    {
+        return m_bufferIdx;
+    }
+
+  private:
+    std::size_t m_bufferIdx;
+};
+
+/*
+ * Result of an operation which may post several completions e.g. a multishot
+ * accept. The operation stays armed as long as has_more() is true.
+ */
+template <class Value> class MultishotResult : public Result<Value> {
+  public:
+    MultishotResult(std::int32_t result, std::uint32_t flags)
+        : Result<Value>(result)
+        , m_more(flags & IORING_CQE_F_MORE)
+    {
+    }
+
+    auto has_more() const -> bool
+    {
+        return m_more;
+    }
+
+  private:
+    bool m_more;
+};
+
+/*
+ * Result of a multishot receive into buffers selected from a BufferPool
+ */
+class MultishotBufferResult : public BufferResult {
+  public:
+    MultishotBufferResult(std::int32_t result, std::uint32_t flags)
+        : BufferResult(result, flags)
+        , m_more(flags & IORING_CQE_F_MORE)
+    {
+    }
+
+    auto has_more() const -> bool
+    {
+        return m_more;
+    }
+
+  private:
+    bool m_more;
+};
+
+//***************************************************************************
+// OPERATIONS
+//***************************************************************************
+
+/*
+ * Operation descriptors. Each descriptor knows how to prepare its submission
+ * queue entry and how to translate its completion queue entry into a typed
+ * result. Applications attach their own state by deriving from a descriptor:
+ *
+ *  struct ReadBlock : uringpp::op::Read {
+ *      std::size_t blockIndex;
+ *  };
+ *
+ * Descriptors must stay at a fixed address until their completion was dispatched.
+ *
+ * Descriptors with a fixedFile flag address the file by its direct descriptor,
+ * the slot in the registered file table, instead of by its file descriptor.
+ * Descriptors with a link flag start the next prepared descriptor only after they
+ * completed successfully, a failed or short one cancels it.
+ */
+namespace op {
+
+inline auto setFixedFile(io_uring_sqe* sqe, bool fixedFile) -> void
+{
+    if (fixedFile) {
+        sqe->flags |= IOSQE_FIXED_FILE;
+    }
+}
+
+inline auto setLink(io_uring_sqe* sqe, bool link) -> void
+{
+    if (link) {
+        sqe->flags |= IOSQE_IO_LINK;
+    }
+}
+
+/*
+ * Starts the next operation also after this one failed or was short
+ */
+inline auto setHardLink(io_uring_sqe* sqe, bool hardLink) -> void
+{
+    if (hardLink) {
+        sqe->flags |= IOSQE_IO_HARDLINK;
+    }
+}
+
+struct alignas(8) Nop {
+    using result_type = Result<std::int32_t>;
+
+    auto prepare(io_uring_sqe* sqe) const -> void
+    {
+        io_uring_prep_nop(sqe);
+    }
+
+    static auto result(const io_uring_cqe* cqe) -> result_type
+    {
+        return result_type { cqe->res };
+    }
+};
+
+struct Read {
+    using result_type = Result<std::size_t>;
+
+    int fd;
+    std::span<std::uint8_t> buffer;
+    std::uint64_t offset = 0;
+    bool fixedFile = false;
+    // A read is short at the end of the file, which breaks a normal link
+    bool hardLink = false;
+
+    auto prepare(io_uring_sqe* sqe) const -> void
+    {
+        io_uring_prep_read(sqe, fd, buffer.data(), buffer.size(), offset);
+        setFixedFile(sqe, fixedFile);
+        setHardLink(sqe, hardLink);
+    }
+
+    static auto result(const io_uring_cqe* cqe) -> result_type
+    {
+        return result_type { cqe->res };
+    }
+};
+
+struct Write {
+    using result_type = Result<std::size_t>;
+
+    int fd;
+    std::span<const std::uint8_t> buffer;
+    std::uint64_t offset = 0;
+    bool fixedFile = false;
+    bool link = false;
+
+    auto prepare(io_uring_sqe* sqe) const -> void
+    {
+        io_uring_prep_write(sqe, fd, buffer.data(), buffer.size(), offset);
+        setFixedFile(sqe, fixedFile);
+        setLink(sqe, link);
+    }
+
+    static auto result(const io_uring_cqe* cqe) -> result_type
+    {
+        return result_type { cqe->res };
+    }
+};
+
+/*
+ * Reads into a buffer registered with register_buffers, the buffer must lie within
+ * the registered buffer bufferIndex
+ */
+struct ReadFixed {
+    using result_type = Result<std::size_t>;
+
+    int fd;
+    std::span<std::uint8_t> buffer;
+    std::uint64_t offset = 0;
+    int bufferIndex = 0;
+    bool fixedFile = false;
+
+    auto prepare(io_uring_sqe* sqe) const -> void
+    {
+        io_uring_prep_read_fixed(sqe, fd, buffer.data(), buffer.size(), offset, bufferIndex);
+        setFixedFile(sqe, fixedFile);
+    }
+
+    static auto result(const io_uring_cqe* cqe) -> result_type
+    {
+        return result_type { cqe->res };
+    }
+};
+
+struct WriteFixed {
+    using result_type = Result<std::size_t>;
+
+    int fd;
+    std::span<const std::uint8_t> buffer;
+    std::uint64_t offset = 0;
+    int bufferIndex = 0;
+    bool fixedFile = false;
+    bool link = false;
+
+    auto prepare(io_uring_sqe* sqe) const -> void
+    {
+        io_uring_prep_write_fixed(sqe, fd, buffer.data(), buffer.size(), offset, bufferIndex);
+        setFixedFile(sqe, fixedFile);
+        setLink(sqe, link);
+    }
+
+    static auto result(const io_uring_cqe* cqe) -> result_type
+    {
+        return result_type { cqe->res };
+    }
+};
+
+/*
+ * Vectored read for kernels without IORING_OP_READ. The iovecs must stay valid
+ * until the command was submitted.
+ */
+struct Readv {
+    using result_type = Result<std::size_t>;
+
+    int fd;
+    const iovec* vecs;
+    unsigned numberOfVecs = 1;
+    std::uint64_t offset = 0;
+    bool fixedFile = false;
+
+    auto prepare(io_uring_sqe* sqe) const -> void
+    {
+        io_uring_prep_readv(sqe, fd, vecs, numberOfVecs, offset);
+        setFixedFile(sqe, fixedFile);
+    }
+
+    static auto result(const io_uring_cqe* cqe) -> result_type
+    {
+        return result_type { cqe->res };
+    }
+};
+
+struct Writev {
+    using result_type = Result<std::size_t>;
+
+    int fd;
+    const iovec* vecs;
+    unsigned numberOfVecs = 1;
+    std::uint64_t offset = 0;
+    bool fixedFile = false;
+    bool link = false;
+
+    auto prepare(io_uring_sqe* sqe) const -> void
+    {
+        io_uring_prep_writev(sqe, fd, vecs, numberOfVecs, offset);
+        setFixedFile(sqe, fixedFile);
+        setLink(sqe, link);
+    }
+
+    static auto result(const io_uring_cqe* cqe) -> result_type
+    {
+        return result_type { cqe->res };
+    }
+};
+
+/*
+ * Flushes the file to the storage device like fsync(2), or like fdatasync(2)
+ * with dataSync. Linked behind a write it covers the data of the write.
+ */
+struct Fsync {
+    using result_type = Result<std::int32_t>;
+
+    int fd;
+    bool dataSync = false;
+    bool fixedFile = false;
+
+    auto prepare(io_uring_sqe* sqe) const -> void
+    {
+        io_uring_prep_fsync(sqe, fd, dataSync ? IORING_FSYNC_DATASYNC : 0);
+        setFixedFile(sqe, fixedFile);
+    }
+
+    static auto result(const io_uring_cqe* cqe) -> result_type
+    {
+        return result_type { cqe->res };
+    }
+};
+
+/*
+ * Writes back a range of the file like sync_file_range(2). A length of 0 covers
+ * the file from offset to its end. Neither metadata nor the device cache are
+ * flushed.
+ */
+struct SyncFileRange {
+    using result_type = Result<std::int32_t>;
+
+    int fd;
+    std::uint64_t offset = 0;
+    unsigned length = 0;
+    int flags = SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER;
+    bool fixedFile = false;
+
+    auto prepare(io_uring_sqe* sqe) const -> void
+    {
+        io_uring_prep_sync_file_range(sqe, fd, length, offset, flags);
+        setFixedFile(sqe, fixedFile);
+    }
+
+    static auto result(const io_uring_cqe* cqe) -> result_type
+    {
+        return result_type { cqe->res };
+    }
+};
+
+struct Accept {
+    using result_type = Result<int>;
+
+    int fd;
+    sockaddr* addr = nullptr;
+    socklen_t* addrlen = nullptr;
+
+    auto prepare(io_uring_sqe* sqe) const -> void
+    {
+        const int flags = 0;
+        io_uring_prep_accept(sqe, fd, addr, addrlen, flags);
+    }
+
+    static auto result(const io_uring_cqe* cqe) -> result_type
+    {
+        return result_type { cqe->res };
+    }
+};
+
+/*
+ * Connects the socket to the address, which must stay valid until the completion
+ */
+struct Connect {
+    using result_type = Result<int>;
+
+    int fd;
+    const sockaddr* addr = nullptr;
+    socklen_t addrlen = 0;
+    bool fixedFile = false;
+
+    auto prepare(io_uring_sqe* sqe) const -> void
+    {
+        io_uring_prep_connect(sqe, fd, addr, addrlen);
+        setFixedFile(sqe, fixedFile);
+    }
+
+    static auto result(const io_uring_cqe* cqe) -> result_type
+    {
+        return result_type { cqe->res };
+    }
+};
+
+/*
+ * Completes after the relative timeout expired with -ETIME, or earlier once count
+ * other completions were posted. With absolute ts is a CLOCK_MONOTONIC time.
+ */
+struct Timeout {
+    using result_type = Result<int>;
+
+    __kernel_timespec ts {};
+    unsigned count = 0;
+    bool absolute = false;
+
+    auto prepare(io_uring_sqe* sqe) const -> void
+    {
+        const unsigned flags = absolute ? IORING_TIMEOUT_ABS : 0;
+        io_uring_prep_timeout(sqe, const_cast<__kernel_timespec*>(&ts), count, flags);
+    }
+
+    static auto result(const io_uring_cqe* cqe) -> result_type
+    {
+        return result_type { cqe->res };
+    }
+};
+
+/*
+ * Moves the expiry of the armed timeout with the given user data, e.g. from
+ * OperationSet::encode, to ts (5.11). Fails with -ENOENT if the timeout already
+ * completed.
+ */
+struct TimeoutUpdate {
+    using result_type = Result<int>;
+
+    __kernel_timespec ts {};
+    std::uint64_t userData = 0;
+    bool absolute = false;
+
+    auto prepare(io_uring_sqe* sqe) const -> void
+    {
+        const unsigned flags = absolute ? IORING_TIMEOUT_ABS : 0;
+        io_uring_prep_timeout_update(sqe, const_cast<__kernel_timespec*>(&ts), userData, flags);
+    }
+
+    static auto result(const io_uring_cqe* cqe) -> result_type
+    {
+        return result_type { cqe->res };
+    }
+};
+
+/*
+ * Cancels the armed timeout with the given user data, which completes with
+ * -ECANCELED. Fails with -ENOENT if the timeout already completed.
+ */
+struct alignas(8) TimeoutRemove {
+    using result_type = Result<int>;
+
+    std::uint64_t userData = 0;
+
+    auto prepare(io_uring_sqe* sqe) const -> void
+    {
+        const unsigned flags = 0;
+        io_uring_prep_timeout_remove(sqe, userData, flags);
+    }
+
+    static auto result(const io_uring_cqe* cqe) -> result_type
+    {
+        return result_type { cqe->res };
+    }
+};
+
+/*
+ * Waits until the 32 bit futex is woken, completes with 0 then, or with -EAGAIN
+ * if it did not hold expected when the wait was queued (6.7). Compatible with
+ * FUTEX_WAKE_PRIVATE of the futex system call.
+ */
+struct FutexWait {
+    using result_type = Result<int>;
+
+    std::uint32_t* futex = nullptr;
+    std::uint32_t expected = 0;
+    std::uint32_t mask = FUTEX_BITSET_MATCH_ANY;
+
+    auto prepare(io_uring_sqe* sqe) const -> void
+    {
+        const unsigned flags = 0;
+        io_uring_prep_futex_wait(
+            sqe, futex, expected, mask, FUTEX2_SIZE_U32 | FUTEX2_PRIVATE, flags);
+    }
+
+    static auto result(const io_uring_cqe* cqe) -> result_type
+    {
+        return result_type { cqe->res };
+    }
+};
+
+/*
+ * Wakes up to count waiters of the futex, completes with the number woken (6.7)
+ */
+struct FutexWake {
+    using result_type = Result<int>;
+
+    std::uint32_t* futex = nullptr;
+    std::uint32_t count = 1;
+    std::uint32_t mask = FUTEX_BITSET_MATCH_ANY;
+
+    auto prepare(io_uring_sqe* sqe) const -> void
+    {
+        const unsigned flags = 0;
+        io_uring_prep_futex_wake(sqe, futex, count, mask, FUTEX2_SIZE_U32 | FUTEX2_PRIVATE, flags);
+    }
+
+    static auto result(const io_uring_cqe* cqe) -> result_type
+    {
+        return result_type { cqe->res };
+    }
+};
+
+/*
+ * Waits on several futexes at once, completes with the index of the woken futex
+ * (6.7). Each futex_waitv holds the address, the expected value and the flags,
+ * e.g. FUTEX2_SIZE_U32 | FUTEX2_PRIVATE.
+ */
+struct FutexWaitv {
+    using result_type = Result<std::size_t>;
+
+    futex_waitv* futexes = nullptr;
+    std::uint32_t count = 0;
+
+    auto prepare(io_uring_sqe* sqe) const -> void
+    {
+        const unsigned flags = 0;
+        io_uring_prep_futex_waitv(sqe, futexes, count, flags);
+    }
+
+    static auto result(const io_uring_cqe* cqe) -> result_type
+    {
+        return result_type { cqe->res };
+    }
+};
+
+struct Recv {
+    using result_type = Result<std::size_t>;
+
+    int fd;
+    std::span<std::uint8_t> buffer;
+    bool fixedFile = false;
+
+    auto prepare(io_uring_sqe* sqe) const -> void
+    {
+        const int flags = 0;
+        io_uring_prep_recv(sqe, fd, buffer.data(), buffer.size(), flags);
+        setFixedFile(sqe, fixedFile);
+    }
+
+    static auto result(const io_uring_cqe* cqe) -> result_type
+    {
+        return result_type { cqe->res };
+    }
+};
+
+struct RecvBp {
+    using result_type = BufferResult;
+
+    int fd;
+    BufferPool* bufferPool;
+    bool fixedFile = false;
+
+    auto prepare(io_uring_sqe* sqe) const -> void
+    {
+        const int flags = 0;
+        io_uring_prep_recv(sqe, fd, nullptr, bufferPool->buffer_size(), flags);
+        sqe->buf_group = bufferPool->group_id();
+        io_uring_sqe_set_flags(sqe, IOSQE_BUFFER_SELECT);
+        setFixedFile(sqe, fixedFile);
+    }
+
+    static auto result(const io_uring_cqe* cqe) -> result_type
+    {
+        return result_type { cqe->res, cqe->flags };
+    }
+};
+
+struct Send {
+    using result_type = Result<std::size_t>;
+
+    int fd;
+    std::span<const std::uint8_t> buffer;
+    bool fixedFile = false;
+
+    auto prepare(io_uring_sqe* sqe) const -> void
+    {
+        const int flags = 0;
+        io_uring_prep_send(sqe, fd, buffer.data(), buffer.size(), flags);
+        setFixedFile(sqe, fixedFile);
+    }
+
+    static auto result(const io_uring_cqe* cqe) -> result_type
+    {
+        return result_type { cqe->res };
+    }
+};
+
+/*
+ * Moves up to length bytes between two file descriptors without copying them to
+ * user space, one of them must be a pipe. An offset of -1 uses the file position,
+ * which is required for pipes and sockets.
+ *
+ * A splice is short whenever less data was available, which breaks a normal link.
+ * hardLink starts the next operation anyway.
+ */
+struct Splice {
+    using result_type = Result<std::size_t>;
+
+    int fdIn;
+    std::int64_t offsetIn = -1;
+    int fdOut;
+    std::int64_t offsetOut = -1;
+    unsigned length = 0;
+    unsigned flags = SPLICE_F_MOVE;
+    bool link = false;
+    bool hardLink = false;
+
+    auto prepare(io_uring_sqe* sqe) const -> void
+    {
+        io_uring_prep_splice(sqe, fdIn, offsetIn, fdOut, offsetOut, length, flags);
+        setLink(sqe, link);
+        setHardLink(sqe, hardLink);
+    }
+
+    static auto result(const io_uring_cqe* cqe) -> result_type
+    {
+        return result_type { cqe->res };
+    }
+};
+
+/*
+ * Shuts down the sending and/or receiving side of a socket like shutdown(2)
+ */
+struct alignas(8) Shutdown {
+    using result_type = Result<int>;
+
+    int fd;
+    int how = SHUT_WR;
+    bool fixedFile = false;
+
+    auto prepare(io_uring_sqe* sqe) const -> void
+    {
+        io_uring_prep_shutdown(sqe, fd, how);
+        setFixedFile(sqe, fixedFile);
+    }
+
+    static auto result(const io_uring_cqe* cqe) -> result_type
+    {
+        return result_type { cqe->res };
+    }
+};
+
+/*
+ * Receives a datagram including its source address and control messages into
+ * the buffers described by msg
+ */
+struct RecvMsg {
+    using result_type = Result<std::size_t>;
+
+    int fd;
+    msghdr* msg;
+    bool fixedFile = false;
+
+    auto prepare(io_uring_sqe* sqe) const -> void
+    {
+        const unsigned flags = 0;
+        io_uring_prep_recvmsg(sqe, fd, msg, flags);
+        setFixedFile(sqe, fixedFile);
+    }
+
+    static auto result(const io_uring_cqe* cqe) -> result_type
+    {
+        return result_type { cqe->res };
+    }
+};
+
+/*
+ * Receives datagrams into buffers selected by the kernel from a BufferPool until
+ * the command is cancelled, fails or runs out of buffers. Each buffer starts with
+ * an io_uring_recvmsg_out header followed by the source address, the control
+ * messages and the payload, see RecvMsgOut. Only msg_namelen and msg_controllen
+ * of msg are used, they reserve the space for address and control messages in
+ * each buffer.
+ */
+struct RecvMsgMultishot {
+    using result_type = MultishotBufferResult;
+
+    int fd;
+    msghdr* msg;
+    BufferPool* bufferPool;
+    bool fixedFile = false;
+
+    auto prepare(io_uring_sqe* sqe) const -> void
+    {
+        const unsigned flags = 0;
+        io_uring_prep_recvmsg_multishot(sqe, fd, msg, flags);
+        sqe->buf_group = bufferPool->group_id();
+        sqe->flags |= IOSQE_BUFFER_SELECT;
+        setFixedFile(sqe, fixedFile);
+    }
+
+    static auto result(const io_uring_cqe* cqe) -> result_type
+    {
+        return result_type { cqe->res, cqe->flags };
+    }
+};
+
+/*
+ * Sends the buffers described by msg to the destination address of msg, e.g. a
+ * GsoBatch of several datagrams
+ */
+struct SendMsg {
+    using result_type = Result<std::size_t>;
+
+    int fd;
+    const msghdr* msg;
+    bool fixedFile = false;
+
+    auto prepare(io_uring_sqe* sqe) const -> void
+    {
+        const unsigned flags = 0;
+        io_uring_prep_sendmsg(sqe, fd, msg, flags);
+        setFixedFile(sqe, fixedFile);
+    }
+
+    static auto result(const io_uring_cqe* cqe) -> result_type
+    {
+        return result_type { cqe->res };
+    }
+};
+
+/*
+ * Accepts a connection into a slot of the registered file table. The result
+ * is the direct descriptor of the connection.
+ */
+struct alignas(8) AcceptDirect {
+    using result_type = MultishotResult<int>;
+
+    int fd;
+    unsigned fileIndex = IORING_FILE_INDEX_ALLOC;
+    bool multishot = false;
+
+    auto prepare(io_uring_sqe* sqe) const -> void
+    {
+        const int flags = 0;
+        if (multishot) {
+            io_uring_prep_multishot_accept_direct(sqe, fd, nullptr, nullptr, flags);
+        } else {
+            io_uring_prep_accept_direct(sqe, fd, nullptr, nullptr, flags, fileIndex);
+        }
+    }
+
+    static auto result(const io_uring_cqe* cqe) -> result_type
+    {
+        return result_type { cqe->res, cqe->flags };
+    }
+};
+
+/*
+ * Opens a file into a slot of the registered file table. The result is the
+ * direct descriptor of the file if the kernel allocated the slot.
+ */
+struct OpenAtDirect {
+    using result_type = Result<int>;
+
+    const char* path;
+    int flags = O_RDONLY;
+    mode_t mode = 0;
+    int directoryFd = AT_FDCWD;
+    unsigned fileIndex = IORING_FILE_INDEX_ALLOC;
+    bool hardLink = false;
+
+    auto prepare(io_uring_sqe* sqe) const -> void
+    {
+        io_uring_prep_openat_direct(sqe, directoryFd, path, flags, mode, fileIndex);
+        setHardLink(sqe, hardLink);
+    }
+
+    static auto result(const io_uring_cqe* cqe) -> result_type
+    {
+        return result_type { cqe->res };
+    }
+};
+
+/*
+ * Retrieves the attributes selected by mask of the file at path, relative to
+ * directoryFd, into buffer
+ */
+struct Statx {
+    using result_type = Result<int>;
+
+    const char* path;
+    struct statx* buffer;
+    unsigned mask = STATX_SIZE;
+    int flags = 0;
+    int directoryFd = AT_FDCWD;
+    bool hardLink = false;
+
+    auto prepare(io_uring_sqe* sqe) const -> void
+    {
+        io_uring_prep_statx(sqe, directoryFd, path, flags, mask, buffer);
+        setHardLink(sqe, hardLink);
+    }
+
+    static auto result(const io_uring_cqe* cqe) -> result_type
+    {
+        return result_type { cqe->res };
+    }
+};
+
+struct alignas(8) CloseDirect {
+    using result_type = Result<std::int32_t>;
+
+    unsigned fileIndex;
+
+    auto prepare(io_uring_sqe* sqe) const -> void
+    {
+        io_uring_prep_close_direct(sqe, fileIndex);
+    }
+
+    static auto result(const io_uring_cqe* cqe) -> result_type
+    {
+        return result_type { cqe->res };
+    }
+};
+
+/*
+ * Hands buffers of a BufferPool (back) to the kernel
+ */
+struct ProvideBuffers {
+    using result_type = Result<std::int32_t>;
+
+    BufferPool* bufferPool;
+    std::size_t bufferIdx = 0;
+    std::size_t numberOfBuffers = 1;
+
+    auto prepare(io_uring_sqe* sqe) const -> void
+    {
+        io_uring_prep_provide_buffers(
+            sqe,
+            bufferPool->at(bufferIdx).data(),
+            bufferPool->buffer_size(),
+            numberOfBuffers,
+            bufferPool->group_id(),
+            bufferPool->first_buffer_id() + bufferIdx);
+    }
+
+    static auto result(const io_uring_cqe* cqe) -> result_type
+    {
+        return result_type { cqe->res };
+    }
+};
+
+} // namespace op
+
+template <class T> concept OperationType = requires(const T t, io_uring_sqe* sqe, const io_uring_cqe* cqe)
+{
+    typename T::result_type;
+    t.prepare(sqe);
+    { T::result(cqe) } -> std::same_as<typename T::result_type>;
+};
+
+//***************************************************************************
+// DISPATCH
+//***************************************************************************
+
+/*
+ * Helper to build a completion handler out of several lambdas:
+ *
+ *  Operations::dispatch(completion.get(), Overloaded {
+ *      [](ReadBlock& read, ReadBlock::result_type result) { ... },
+ *      [](WriteBlock& write, WriteBlock::result_type result) { ... } });
+ */
+template <class... Handlers> struct Overloaded : Handlers... {
+    using Handlers::operator()...;
+};
+template <class... Handlers> Overloaded(Handlers...) -> Overloaded<Handlers...>;
+
+/*
+ * Closed set of operation types which can be in flight on a ring at the same time.
+ *
+ * The index of the operation type in the set is encoded into the low bits of the
+ * user data, the remaining bits hold the address of the operation. On completion the
+ * tag selects the operation type, so the handler is resolved at compile time without
+ * virtual calls, type erasure or a runtime type field inside the operation.
+ */
+template <OperationType... Operations> class OperationSet {
+    static_assert(sizeof...(Operations) > 0, "OperationSet needs at least one operation");
+
+  public:
+    static constexpr std::size_t tagBits = std::bit_width(sizeof...(Operations) - 1);
+    static constexpr std::uint64_t tagMask = (std::uint64_t { 1 } << tagBits) - 1;
+
+    static_assert(
+        ((alignof(Operations) > tagMask) && ...),
+        "Operation alignment leaves not enough low bits to encode the operation tag");
+
+    template <class Operation> static constexpr auto tag() -> std::uint64_t
+    {
+        static_assert(
+            (std::is_same_v<Operation, Operations> || ...), "Operation is not part of the set");
+
+        std::uint64_t index = 0;
+        ((std::is_same_v<Operation, Operations> ? false : (++index, true)) && ...);
+        return index;
+    }
+
+    template <class Operation> static auto encode(Operation& operation) -> std::uint64_t
+    {
+        return reinterpret_cast<std::uintptr_t>(&operation) | tag<Operation>();
+    }
+
+    /*
+     * Calls visitor(operation, result) with the concrete operation type and its typed
+     * result for the operation the completion queue entry belongs to.
+     *
+     * @param[in] cqe completion queue entry of an operation prepared with this set
+     * @param[in] visitor callable which accepts each operation type of the set
+     */
+    template <class Visitor> static auto dispatch(const io_uring_cqe* cqe, Visitor&& visitor) -> void
+    {
+        dispatch(cqe, visitor, std::index_sequence_for<Operations...> {});
+    }
+
+  private:
+    template <class Visitor, std::size_t... Index>
+    static auto dispatch(const io_uring_cqe* cqe, Visitor& visitor, std::index_sequence<Index...>)
+        -> void
+    {
+        const auto tag = cqe->user_data & tagMask;
+        const auto address = cqe->user_data & ~tagMask;
+
+        ((tag == Index ? (invoke<Operations>(address, cqe, visitor), true) : false) || ...);
+    }
+
+    template <class Operation, class Visitor>
+    static auto invoke(std::uint64_t address, const io_uring_cqe* cqe, Visitor& visitor) -> void
+    {
+        auto& operation = *reinterpret_cast<Operation*>(address);
+        visitor(operation, Operation::result(cqe));
+    }
+};
+
+} // namespace uringpp
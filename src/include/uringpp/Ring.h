@@ -1,7 +1,12 @@
+#pragma once
+
+#include <poll.h>
+
 #include <cstring>
 #include <iostream>
 #include <memory>
 #include <optional>
+#include <span>
 #include <stdexcept>
 #include <vector>
 
@@ -9,6 +14,9 @@
 
 #include "uringpp/BufferPool.h"
 #include "uringpp/Completion.h"
+#include "uringpp/Operation.h"
+#include "uringpp/RingPolicy.h"
+#include "uringpp/WaitStrategy.h"
 
 namespace uringpp {
 
@@ -18,11 +26,23 @@ template <class T> concept ContinuousMemory = requires(T t)
     t.size();
 };
 
-template <class UserData> class Ring {
+/*
+ * @tparam UserData type of the user data attached to the prepared commands
+ * @tparam Policy compile time configuration, see RingPolicy
+ */
+template <class UserData, class Policy = DefaultRingPolicy> class Ring {
+    using Error = typename Policy::error;
+    using SqFull = typename Policy::sq_full;
+    using Instrumentation = typename Policy::instrumentation;
+    template <class T> using Result = typename Error::template result_type<T>;
+
     const std::size_t m_maxQueueEntries;
     io_uring m_ring;
     io_uring_cqe* m_cqe;
     io_uring_params m_params;
+    std::vector<iovec> m_iovecs;
+    [[no_unique_address]] SqFull m_sqFull;
+    [[no_unique_address]] Instrumentation m_instrumentation;
 
   public:
     /*
@@ -50,6 +70,8 @@ template <class UserData> class Ring {
             throw std::runtime_error(
                 std::string { "Failed to init uring queue: " } + strerror(-result));
         }
+
+        m_iovecs.resize(m_params.sq_entries);
     }
 
     ~Ring()
@@ -129,12 +151,13 @@ template <class UserData> class Ring {
     auto prepare_nop(const std::shared_ptr<UserData>& userData) -> bool
     {
         auto submissionQueueEntry = getSubmissionQueueEntry();
-        if (!submissionQueueEntry) {
+        if (missing(submissionQueueEntry)) {
             return false;
         }
 
         io_uring_prep_nop(submissionQueueEntry);
         io_uring_sqe_set_data(submissionQueueEntry, userData.get());
+        m_instrumentation.prepared(submissionQueueEntry);
 
         return true;
     }
@@ -156,15 +179,16 @@ template <class UserData> class Ring {
     {
         const std::size_t nBuffer = 1;
 
-        auto vec = makeIovec(buffer);
-
         auto submissionQueueEntry = getSubmissionQueueEntry();
-        if (!submissionQueueEntry) {
+        if (missing(submissionQueueEntry)) {
             return false;
         }
 
-        io_uring_prep_readv(submissionQueueEntry, fileDescriptor, vec.get(), nBuffer, offset);
+        auto vec = makeIovec(submissionQueueEntry, buffer);
+
+        io_uring_prep_readv(submissionQueueEntry, fileDescriptor, vec, nBuffer, offset);
         io_uring_sqe_set_data(submissionQueueEntry, userData.get());
+        m_instrumentation.prepared(submissionQueueEntry);
 
         return true;
     }
@@ -187,14 +211,84 @@ template <class UserData> class Ring {
         const std::size_t nBuffer = 1;
 
         auto submissionQueueEntry = getSubmissionQueueEntry();
-        if (!submissionQueueEntry) {
+        if (missing(submissionQueueEntry)) {
+            return false;
+        }
+
+        auto vec = makeIovec(submissionQueueEntry, buffer);
+
+        io_uring_prep_writev(submissionQueueEntry, fileDescriptor, vec, nBuffer, offset);
+        io_uring_sqe_set_data(submissionQueueEntry, userData.get());
+        m_instrumentation.prepared(submissionQueueEntry);
+
+        return true;
+    }
+
+    /*
+     * Pushes a writev system call of several buffers onto the uring submission queue
+     *
+     * @param[in] vecs buffers which are written one after another, the iovecs must
+     *            stay valid until the command was submitted
+     * @param[in] offset offset in the file where to start to write
+     */
+    auto prepare_writev(
+        int fileDescriptor,
+        std::span<const iovec> vecs,
+        std::uint64_t offset,
+        const std::shared_ptr<UserData>& userData) -> bool
+    {
+        auto submissionQueueEntry = getSubmissionQueueEntry();
+        if (missing(submissionQueueEntry)) {
             return false;
         }
 
-        auto vec = makeIovec(buffer);
+        io_uring_prep_writev(submissionQueueEntry, fileDescriptor, vecs.data(), vecs.size(), offset);
+        io_uring_sqe_set_data(submissionQueueEntry, userData.get());
+        m_instrumentation.prepared(submissionQueueEntry);
+
+        return true;
+    }
+
+    /*
+     * Pushes an fsync, or an fdatasync with dataSync, onto the uring submission queue
+     */
+    auto prepare_fsync(
+        int fileDescriptor, const std::shared_ptr<UserData>& userData, bool dataSync = false)
+        -> bool
+    {
+        auto submissionQueueEntry = getSubmissionQueueEntry();
+        if (missing(submissionQueueEntry)) {
+            return false;
+        }
 
-        io_uring_prep_writev(submissionQueueEntry, fileDescriptor, vec.get(), nBuffer, offset);
+        io_uring_prep_fsync(submissionQueueEntry, fileDescriptor, dataSync ? IORING_FSYNC_DATASYNC : 0);
         io_uring_sqe_set_data(submissionQueueEntry, userData.get());
+        m_instrumentation.prepared(submissionQueueEntry);
+
+        return true;
+    }
+
+    /*
+     * Pushes a sync_file_range which writes back and waits for the range
+     *
+     * @param[in] length length of the range, 0 covers the file up to its end
+     */
+    auto prepare_sync_file_range(
+        int fileDescriptor,
+        std::uint64_t offset,
+        unsigned length,
+        const std::shared_ptr<UserData>& userData) -> bool
+    {
+        auto submissionQueueEntry = getSubmissionQueueEntry();
+        if (missing(submissionQueueEntry)) {
+            return false;
+        }
+
+        const int flags
+            = SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER;
+        io_uring_prep_sync_file_range(submissionQueueEntry, fileDescriptor, length, offset, flags);
+        io_uring_sqe_set_data(submissionQueueEntry, userData.get());
+        m_instrumentation.prepared(submissionQueueEntry);
 
         return true;
     }
@@ -206,13 +300,203 @@ template <class UserData> class Ring {
         const std::shared_ptr<UserData>& userData)
     {
         auto submissionQueueEntry = getSubmissionQueueEntry();
-        if (!submissionQueueEntry) {
+        if (missing(submissionQueueEntry)) {
             return false;
         }
 
         const int flags = 0;
         io_uring_prep_accept(submissionQueueEntry, fileDescriptor, addr, addrlen, flags);
         io_uring_sqe_set_data(submissionQueueEntry, userData.get());
+        m_instrumentation.prepared(submissionQueueEntry);
+
+        return true;
+    }
+
+    /*
+     * Pushes a connect system call onto the uring submission queue
+     *
+     * @param[in] fileDescriptor socket to connect
+     * @param[in] addr address to connect to, must stay valid until the completion
+     * @param[in] addrlen length of the address
+     * @param[in] userData user data which will be returned on the completion
+     */
+    auto prepare_connect(
+        int fileDescriptor,
+        const struct sockaddr* addr,
+        socklen_t addrlen,
+        const std::shared_ptr<UserData>& userData)
+    {
+        auto submissionQueueEntry = getSubmissionQueueEntry();
+        if (missing(submissionQueueEntry)) {
+            return false;
+        }
+
+        io_uring_prep_connect(submissionQueueEntry, fileDescriptor, addr, addrlen);
+        io_uring_sqe_set_data(submissionQueueEntry, userData.get());
+        m_instrumentation.prepared(submissionQueueEntry);
+
+        return true;
+    }
+
+    /*
+     * Pushes a splice system call onto the uring submission queue, one of the file
+     * descriptors must be a pipe
+     *
+     * @param[in] offsetIn offset to read from, -1 for pipes and sockets
+     * @param[in] offsetOut offset to write to, -1 for pipes and sockets
+     * @param[in] length maximum number of bytes to move
+     * @param[in] spliceFlags SPLICE_F_* flags
+     * @param[in] userData user data which will be returned on the completion
+     */
+    auto prepare_splice(
+        int fileDescriptorIn,
+        std::int64_t offsetIn,
+        int fileDescriptorOut,
+        std::int64_t offsetOut,
+        unsigned length,
+        unsigned spliceFlags,
+        const std::shared_ptr<UserData>& userData)
+    {
+        auto submissionQueueEntry = getSubmissionQueueEntry();
+        if (missing(submissionQueueEntry)) {
+            return false;
+        }
+
+        io_uring_prep_splice(
+            submissionQueueEntry,
+            fileDescriptorIn,
+            offsetIn,
+            fileDescriptorOut,
+            offsetOut,
+            length,
+            spliceFlags);
+        io_uring_sqe_set_data(submissionQueueEntry, userData.get());
+        m_instrumentation.prepared(submissionQueueEntry);
+
+        return true;
+    }
+
+    /*
+     * Pushes a shutdown system call onto the uring submission queue
+     *
+     * @param[in] how SHUT_RD, SHUT_WR or SHUT_RDWR
+     */
+    auto prepare_shutdown(int fileDescriptor, int how, const std::shared_ptr<UserData>& userData)
+    {
+        auto submissionQueueEntry = getSubmissionQueueEntry();
+        if (missing(submissionQueueEntry)) {
+            return false;
+        }
+
+        io_uring_prep_shutdown(submissionQueueEntry, fileDescriptor, how);
+        io_uring_sqe_set_data(submissionQueueEntry, userData.get());
+        m_instrumentation.prepared(submissionQueueEntry);
+
+        return true;
+    }
+
+    /*
+     * Accepts a connection into a slot of the registered file table instead of the
+     * process file descriptor table, see register_files_sparse. The completion
+     * result is the direct descriptor, which is only usable with IOSQE_FIXED_FILE.
+     *
+     * @param[in] fileDescriptor listening socket
+     * @param[in] userData user data of the completion
+     * @param[in] fileIndex slot to install the socket in, by default the kernel
+     *            allocates a free slot
+     */
+    auto prepare_accept_direct(
+        int fileDescriptor,
+        const std::shared_ptr<UserData>& userData,
+        unsigned fileIndex = IORING_FILE_INDEX_ALLOC)
+    {
+        auto submissionQueueEntry = getSubmissionQueueEntry();
+        if (missing(submissionQueueEntry)) {
+            return false;
+        }
+
+        const int flags = 0;
+        io_uring_prep_accept_direct(
+            submissionQueueEntry, fileDescriptor, nullptr, nullptr, flags, fileIndex);
+        io_uring_sqe_set_data(submissionQueueEntry, userData.get());
+        m_instrumentation.prepared(submissionQueueEntry);
+
+        return true;
+    }
+
+    /*
+     * Accepts connections into kernel allocated slots of the registered file table
+     * until the command is cancelled or fails. Each connection posts its own
+     * completion, Completion::has_more() turns false on the last one.
+     *
+     * @param[in] fileDescriptor listening socket
+     * @param[in] userData user data of all completions
+     */
+    auto prepare_multishot_accept_direct(int fileDescriptor, const std::shared_ptr<UserData>& userData)
+    {
+        auto submissionQueueEntry = getSubmissionQueueEntry();
+        if (missing(submissionQueueEntry)) {
+            return false;
+        }
+
+        const int flags = 0;
+        io_uring_prep_multishot_accept_direct(
+            submissionQueueEntry, fileDescriptor, nullptr, nullptr, flags);
+        io_uring_sqe_set_data(submissionQueueEntry, userData.get());
+        m_instrumentation.prepared(submissionQueueEntry);
+
+        return true;
+    }
+
+    /*
+     * Opens a file into a slot of the registered file table
+     *
+     * @param[in] directoryFileDescriptor directory relative paths are resolved against
+     *            e.g. AT_FDCWD
+     * @param[in] path path which must stay valid until the command was submitted
+     * @param[in] flags open flags e.g. O_RDONLY
+     * @param[in] mode mode of created files
+     * @param[in] userData user data of the completion
+     * @param[in] fileIndex slot to install the file in, by default the kernel
+     *            allocates a free slot
+     */
+    auto prepare_openat_direct(
+        int directoryFileDescriptor,
+        const char* path,
+        int flags,
+        mode_t mode,
+        const std::shared_ptr<UserData>& userData,
+        unsigned fileIndex = IORING_FILE_INDEX_ALLOC)
+    {
+        auto submissionQueueEntry = getSubmissionQueueEntry();
+        if (missing(submissionQueueEntry)) {
+            return false;
+        }
+
+        io_uring_prep_openat_direct(
+            submissionQueueEntry, directoryFileDescriptor, path, flags, mode, fileIndex);
+        io_uring_sqe_set_data(submissionQueueEntry, userData.get());
+        m_instrumentation.prepared(submissionQueueEntry);
+
+        return true;
+    }
+
+    /*
+     * Closes the file in a slot of the registered file table and frees the slot
+     *
+     * @param[in] fileIndex direct descriptor
+     * @param[in] userData user data of the completion
+     */
+    auto prepare_close_direct(unsigned fileIndex, const std::shared_ptr<UserData>& userData)
+    {
+        auto submissionQueueEntry = getSubmissionQueueEntry();
+        if (missing(submissionQueueEntry)) {
+            return false;
+        }
+
+        io_uring_prep_close_direct(submissionQueueEntry, fileIndex);
+        io_uring_sqe_set_data(submissionQueueEntry, userData.get());
+        m_instrumentation.prepared(submissionQueueEntry);
 
         return true;
     }
@@ -222,7 +506,7 @@ template <class UserData> class Ring {
     prepare_send(int fileDescriptor, Container& buffer, const std::shared_ptr<UserData>& userData)
     {
         auto submissionQueueEntry = getSubmissionQueueEntry();
-        if (!submissionQueueEntry) {
+        if (missing(submissionQueueEntry)) {
             return false;
         }
 
@@ -230,6 +514,7 @@ template <class UserData> class Ring {
         io_uring_prep_send(
             submissionQueueEntry, fileDescriptor, buffer.data(), buffer.size(), flags);
         io_uring_sqe_set_data(submissionQueueEntry, userData.get());
+        m_instrumentation.prepared(submissionQueueEntry);
 
         return true;
     }
@@ -239,7 +524,7 @@ template <class UserData> class Ring {
         int fileDescriptor, Container&& buffer, const std::shared_ptr<UserData>& userData)
     {
         auto submissionQueueEntry = getSubmissionQueueEntry();
-        if (!submissionQueueEntry) {
+        if (missing(submissionQueueEntry)) {
             return false;
         }
 
@@ -247,6 +532,7 @@ template <class UserData> class Ring {
         io_uring_prep_send(
             submissionQueueEntry, fileDescriptor, buffer.data(), buffer.size(), flags);
         io_uring_sqe_set_data(submissionQueueEntry, userData.get());
+        m_instrumentation.prepared(submissionQueueEntry);
 
         return true;
     }
@@ -256,7 +542,7 @@ template <class UserData> class Ring {
     prepare_recv(int fileDescriptor, Container& buffer, const std::shared_ptr<UserData>& userData)
     {
         auto submissionQueueEntry = getSubmissionQueueEntry();
-        if (!submissionQueueEntry) {
+        if (missing(submissionQueueEntry)) {
             return false;
         }
 
@@ -264,6 +550,7 @@ template <class UserData> class Ring {
         io_uring_prep_recv(
             submissionQueueEntry, fileDescriptor, buffer.data(), buffer.size(), flags);
         io_uring_sqe_set_data(submissionQueueEntry, userData.get());
+        m_instrumentation.prepared(submissionQueueEntry);
 
         return true;
     }
@@ -272,7 +559,7 @@ template <class UserData> class Ring {
         int fileDescriptor, BufferPool& bufferPool, const std::shared_ptr<UserData>& userData)
     {
         auto submissionQueueEntry = getSubmissionQueueEntry();
-        if (!submissionQueueEntry) {
+        if (missing(submissionQueueEntry)) {
             return false;
         }
 
@@ -282,19 +569,184 @@ template <class UserData> class Ring {
         submissionQueueEntry->buf_group = bufferPool.group_id();
         io_uring_sqe_set_data(submissionQueueEntry, userData.get());
         io_uring_sqe_set_flags(submissionQueueEntry, IOSQE_BUFFER_SELECT);
+        m_instrumentation.prepared(submissionQueueEntry);
+
+        return true;
+    }
+
+    /*
+     * Receives a datagram including its source address and control messages
+     *
+     * @param[in] message buffers, address and control message storage which must
+     *            stay valid until the completion
+     */
+    auto prepare_recvmsg(
+        int fileDescriptor, msghdr* message, const std::shared_ptr<UserData>& userData)
+    {
+        auto submissionQueueEntry = getSubmissionQueueEntry();
+        if (missing(submissionQueueEntry)) {
+            return false;
+        }
+
+        const unsigned flags = 0;
+        io_uring_prep_recvmsg(submissionQueueEntry, fileDescriptor, message, flags);
+        io_uring_sqe_set_data(submissionQueueEntry, userData.get());
+        m_instrumentation.prepared(submissionQueueEntry);
+
+        return true;
+    }
+
+    /*
+     * Receives datagrams into buffers of the buffer pool until the command is
+     * cancelled or fails, see op::RecvMsgMultishot for the buffer layout
+     *
+     * @param[in] message msg_namelen and msg_controllen reserve the space for source
+     *            address and control messages in each buffer
+     */
+    auto prepare_recvmsg_multishot(
+        int fileDescriptor,
+        msghdr* message,
+        BufferPool& bufferPool,
+        const std::shared_ptr<UserData>& userData)
+    {
+        auto submissionQueueEntry = getSubmissionQueueEntry();
+        if (missing(submissionQueueEntry)) {
+            return false;
+        }
+
+        const unsigned flags = 0;
+        io_uring_prep_recvmsg_multishot(submissionQueueEntry, fileDescriptor, message, flags);
+        submissionQueueEntry->buf_group = bufferPool.group_id();
+        io_uring_sqe_set_data(submissionQueueEntry, userData.get());
+        io_uring_sqe_set_flags(submissionQueueEntry, IOSQE_BUFFER_SELECT);
+        m_instrumentation.prepared(submissionQueueEntry);
+
+        return true;
+    }
+
+    /*
+     * Sends the buffers of the message to its destination address e.g. a GsoBatch
+     *
+     * @param[in] message message which must stay valid until the completion
+     */
+    auto prepare_sendmsg(
+        int fileDescriptor, const msghdr* message, const std::shared_ptr<UserData>& userData)
+    {
+        auto submissionQueueEntry = getSubmissionQueueEntry();
+        if (missing(submissionQueueEntry)) {
+            return false;
+        }
+
+        const unsigned flags = 0;
+        io_uring_prep_sendmsg(submissionQueueEntry, fileDescriptor, message, flags);
+        io_uring_sqe_set_data(submissionQueueEntry, userData.get());
+        m_instrumentation.prepared(submissionQueueEntry);
 
         return true;
     }
 
     auto prepare_poll_add(int fileDescriptor, const std::shared_ptr<UserData>& userData)
+    {
+        return prepare_poll_add(fileDescriptor, POLLIN, userData);
+    }
+
+    /*
+     * Pushes a one shot poll onto the uring submission queue
+     *
+     * @param[in] fileDescriptor file descriptor to watch
+     * @param[in] pollMask events to watch e.g. POLLIN | POLLOUT | POLLRDHUP
+     * @param[in] userData user data which will be returned on the completion
+     */
+    auto prepare_poll_add(
+        int fileDescriptor, unsigned pollMask, const std::shared_ptr<UserData>& userData)
+    {
+        auto submissionQueueEntry = getSubmissionQueueEntry();
+        if (missing(submissionQueueEntry)) {
+            return false;
+        }
+
+        io_uring_prep_poll_add(submissionQueueEntry, fileDescriptor, pollMask);
+        io_uring_sqe_set_data(submissionQueueEntry, userData.get());
+        m_instrumentation.prepared(submissionQueueEntry);
+        return true;
+    }
+
+    /*
+     * Pushes a multishot poll onto the uring submission queue. The poll stays armed
+     * and posts a completion with IORING_CQE_F_MORE set for every readiness event.
+     * The last completion of the poll has no IORING_CQE_F_MORE set, see
+     * Completion::has_more().
+     *
+     * @param[in] fileDescriptor file descriptor to watch
+     * @param[in] pollMask events to watch e.g. POLLIN | POLLOUT | POLLRDHUP
+     * @param[in] userData user data which will be returned on each completion
+     */
+    auto prepare_poll_multishot(
+        int fileDescriptor, unsigned pollMask, const std::shared_ptr<UserData>& userData)
     {
         auto submissionQueueEntry = getSubmissionQueueEntry();
-        if (!submissionQueueEntry) {
+        if (missing(submissionQueueEntry)) {
             return false;
         }
 
-        io_uring_prep_poll_add(submissionQueueEntry, fileDescriptor, POLL_IN);
+        io_uring_prep_poll_multishot(submissionQueueEntry, fileDescriptor, pollMask);
         io_uring_sqe_set_data(submissionQueueEntry, userData.get());
+        m_instrumentation.prepared(submissionQueueEntry);
+        return true;
+    }
+
+    /*
+     * Pushes an update of an armed poll onto the uring submission queue
+     *
+     * @param[in] pollUserData user data of the poll to update
+     * @param[in] newPollUserData user data of the poll after the update
+     * @param[in] pollMask new events to watch
+     * @param[in] flags IORING_POLL_UPDATE_EVENTS, IORING_POLL_UPDATE_USER_DATA and
+     *                  IORING_POLL_ADD_MULTI to keep a multishot poll armed
+     * @param[in] userData user data which will be returned on the completion of the update
+     */
+    auto prepare_poll_update(
+        const std::shared_ptr<UserData>& pollUserData,
+        const std::shared_ptr<UserData>& newPollUserData,
+        unsigned pollMask,
+        unsigned flags,
+        const std::shared_ptr<UserData>& userData)
+    {
+        auto submissionQueueEntry = getSubmissionQueueEntry();
+        if (missing(submissionQueueEntry)) {
+            return false;
+        }
+
+        io_uring_prep_poll_update(
+            submissionQueueEntry,
+            reinterpret_cast<std::uint64_t>(pollUserData.get()),
+            reinterpret_cast<std::uint64_t>(newPollUserData.get()),
+            pollMask,
+            flags);
+        io_uring_sqe_set_data(submissionQueueEntry, userData.get());
+        m_instrumentation.prepared(submissionQueueEntry);
+        return true;
+    }
+
+    /*
+     * Pushes the removal of an armed poll onto the uring submission queue. The
+     * removed poll completes with -ECANCELED.
+     *
+     * @param[in] pollUserData user data of the poll to remove
+     * @param[in] userData user data which will be returned on the completion of the removal
+     */
+    auto prepare_poll_remove(
+        const std::shared_ptr<UserData>& pollUserData, const std::shared_ptr<UserData>& userData)
+    {
+        auto submissionQueueEntry = getSubmissionQueueEntry();
+        if (missing(submissionQueueEntry)) {
+            return false;
+        }
+
+        io_uring_prep_poll_remove(
+            submissionQueueEntry, reinterpret_cast<std::uint64_t>(pollUserData.get()));
+        io_uring_sqe_set_data(submissionQueueEntry, userData.get());
+        m_instrumentation.prepared(submissionQueueEntry);
         return true;
     }
 
@@ -306,7 +758,7 @@ template <class UserData> class Ring {
         const std::shared_ptr<UserData>& userData)
     {
         auto submissionQueueEntry = getSubmissionQueueEntry();
-        if (!submissionQueueEntry) {
+        if (missing(submissionQueueEntry)) {
             return false;
         }
 
@@ -314,10 +766,178 @@ template <class UserData> class Ring {
         io_uring_prep_epoll_ctl(
             submissionQueueEntry, epollFileDescriptor, fileDescriptor, op, epollEvent);
         io_uring_sqe_set_data(submissionQueueEntry, userData.get());
+        m_instrumentation.prepared(submissionQueueEntry);
+
+        return true;
+    }
+
+    /*
+     * Pushes a wait on a 32 bit private futex onto the uring submission queue
+     * (6.7). Completes with 0 once the futex is woken, e.g. by
+     * prepare_futex_wake or the futex system call from another thread, or with
+     * -EAGAIN if the futex did not hold expected.
+     */
+    auto prepare_futex_wait(
+        std::uint32_t* futex, std::uint32_t expected, const std::shared_ptr<UserData>& userData)
+    {
+        auto submissionQueueEntry = getSubmissionQueueEntry();
+        if (missing(submissionQueueEntry)) {
+            return false;
+        }
+
+        const unsigned flags = 0;
+        io_uring_prep_futex_wait(
+            submissionQueueEntry,
+            futex,
+            expected,
+            FUTEX_BITSET_MATCH_ANY,
+            FUTEX2_SIZE_U32 | FUTEX2_PRIVATE,
+            flags);
+        io_uring_sqe_set_data(submissionQueueEntry, userData.get());
+        m_instrumentation.prepared(submissionQueueEntry);
+        return true;
+    }
+
+    /*
+     * Pushes a wake of up to count waiters of a 32 bit private futex onto the
+     * uring submission queue (6.7)
+     */
+    auto prepare_futex_wake(
+        std::uint32_t* futex, std::uint32_t count, const std::shared_ptr<UserData>& userData)
+    {
+        auto submissionQueueEntry = getSubmissionQueueEntry();
+        if (missing(submissionQueueEntry)) {
+            return false;
+        }
+
+        const unsigned flags = 0;
+        io_uring_prep_futex_wake(
+            submissionQueueEntry,
+            futex,
+            count,
+            FUTEX_BITSET_MATCH_ANY,
+            FUTEX2_SIZE_U32 | FUTEX2_PRIVATE,
+            flags);
+        io_uring_sqe_set_data(submissionQueueEntry, userData.get());
+        m_instrumentation.prepared(submissionQueueEntry);
+        return true;
+    }
+
+    /*
+     * Pushes a wait on several futexes onto the uring submission queue (6.7).
+     * Completes with the index of the futex which was woken.
+     *
+     * @param[in] futexes address, expected value and flags of each futex, must stay
+     *                    valid until the completion
+     */
+    auto prepare_futex_waitv(
+        std::span<futex_waitv> futexes, const std::shared_ptr<UserData>& userData)
+    {
+        auto submissionQueueEntry = getSubmissionQueueEntry();
+        if (missing(submissionQueueEntry)) {
+            return false;
+        }
+
+        const unsigned flags = 0;
+        const auto count = static_cast<std::uint32_t>(futexes.size());
+        io_uring_prep_futex_waitv(submissionQueueEntry, futexes.data(), count, flags);
+        io_uring_sqe_set_data(submissionQueueEntry, userData.get());
+        m_instrumentation.prepared(submissionQueueEntry);
+        return true;
+    }
+
+    /*
+     * Pushes a statically typed operation onto the uring submission queue. The
+     * operation prepares its own submission queue entry and is tagged with its
+     * index in the operation set, so its completion can be dispatched with
+     * Operations::dispatch.
+     *
+     * @param[in] operation operation which must stay valid until its completion
+     */
+    template <class Operations, OperationType Operation>
+    auto prepare_operation(Operation& operation) -> bool
+    {
+        auto submissionQueueEntry = getSubmissionQueueEntry();
+        if (missing(submissionQueueEntry)) {
+            return false;
+        }
+
+        operation.prepare(submissionQueueEntry);
+        io_uring_sqe_set_data64(submissionQueueEntry, Operations::encode(operation));
+        m_instrumentation.prepared(submissionQueueEntry);
 
         return true;
     }
 
+    //***************************************************************************
+    // REGISTERED FILES
+    //***************************************************************************
+
+    /*
+     * Registers a file table of empty slots. Direct descriptors are allocated in
+     * these slots by the *_direct commands and avoid the process file descriptor
+     * table and the fd reference counting on each command.
+     *
+     * @param[in] numberOfFiles number of slots, limited by RLIMIT_NOFILE
+     */
+    auto register_files_sparse(unsigned numberOfFiles) -> void
+    {
+        const auto result = io_uring_register_files_sparse(&m_ring, numberOfFiles);
+        if (result < 0) {
+            throw std::runtime_error(
+                std::string { "Failed to register files: " } + strerror(-result));
+        }
+    }
+
+    /*
+     * Registers the files in the slots of a file table. Commands with IOSQE_FIXED_FILE
+     * address them by their index in fds.
+     */
+    auto register_files(std::span<const int> fds) -> void
+    {
+        const auto result = io_uring_register_files(&m_ring, fds.data(), fds.size());
+        if (result < 0) {
+            throw std::runtime_error(
+                std::string { "Failed to register files: " } + strerror(-result));
+        }
+    }
+
+    auto unregister_files() -> void
+    {
+        const auto result = io_uring_unregister_files(&m_ring);
+        if (result < 0) {
+            throw std::runtime_error(
+                std::string { "Failed to unregister files: " } + strerror(-result));
+        }
+    }
+
+    //***************************************************************************
+    // REGISTERED BUFFERS
+    //***************************************************************************
+
+    /*
+     * Maps and pins the buffers in the kernel once. Fixed reads and writes address a
+     * buffer by its index in buffers and skip mapping the user pages on each command.
+     * The buffers must stay valid until they are unregistered.
+     */
+    auto register_buffers(std::span<const iovec> buffers) -> void
+    {
+        const auto result = io_uring_register_buffers(&m_ring, buffers.data(), buffers.size());
+        if (result < 0) {
+            throw std::runtime_error(
+                std::string { "Failed to register buffers: " } + strerror(-result));
+        }
+    }
+
+    auto unregister_buffers() -> void
+    {
+        const auto result = io_uring_unregister_buffers(&m_ring);
+        if (result < 0) {
+            throw std::runtime_error(
+                std::string { "Failed to unregister buffers: " } + strerror(-result));
+        }
+    }
+
     //***************************************************************************
     // BUFFER UTILS
     //***************************************************************************
@@ -325,15 +945,15 @@ template <class UserData> class Ring {
     auto prepare_create_buffer_pool(
         std::size_t numberOfBuffers,
         std::size_t sizePerBuffer,
-        const std::shared_ptr<UserData>& userData) -> BufferPool
+        const std::shared_ptr<UserData>& userData,
+        std::size_t groupId = 0) -> BufferPool
     {
         auto submissionQueueEntry = getSubmissionQueueEntry();
-        if (!submissionQueueEntry) {
+        if (missing(submissionQueueEntry)) {
             throw std::runtime_error("Failed to get submission queue entry");
         }
 
-        auto bufferId = 0;
-        BufferPool bufferPool(numberOfBuffers, sizePerBuffer, bufferId);
+        BufferPool bufferPool(numberOfBuffers, sizePerBuffer, groupId);
 
         io_uring_prep_provide_buffers(
             submissionQueueEntry,
@@ -341,8 +961,9 @@ template <class UserData> class Ring {
             bufferPool.buffer_size(),
             bufferPool.pool_size(),
             bufferPool.group_id(),
-            0);
+            bufferPool.first_buffer_id());
         io_uring_sqe_set_data(submissionQueueEntry, userData.get());
+        m_instrumentation.prepared(submissionQueueEntry);
 
         return bufferPool;
     }
@@ -352,7 +973,7 @@ template <class UserData> class Ring {
         -> BufferPool
     {
         auto submissionQueueEntry = getSubmissionQueueEntry();
-        if (!submissionQueueEntry) {
+        if (missing(submissionQueueEntry)) {
             throw std::runtime_error("Failed to get submission queue entry");
         }
 
@@ -363,8 +984,9 @@ template <class UserData> class Ring {
             bufferPool.at(bufferIdx).size(),
             1,
             bufferPool.group_id(),
-            bufferIdx);
+            bufferPool.first_buffer_id() + bufferIdx);
         io_uring_sqe_set_data(submissionQueueEntry, userData.get());
+        m_instrumentation.prepared(submissionQueueEntry);
 
         return bufferPool;
     }
@@ -376,13 +998,22 @@ template <class UserData> class Ring {
     /*
      * Submits the commands in the submission queue to the kernel. The kernel will
      * start to process the commands asynchronously of the submission call.
+     *
+     * @return number of submitted entries
      */
-    auto submit() -> void
+    auto submit() -> Result<std::uint32_t>
     {
+        flushPending();
+        m_instrumentation.submitting();
         auto result = io_uring_submit(&m_ring);
+        m_instrumentation.submitted(result);
+        flushPending();
         if (result < 0) {
-            throw std::runtime_error(std::string { "Failed to submit: " } + strerror(-result));
+            m_instrumentation.error();
+            return Error::template failure<std::uint32_t>("Failed to submit: ", -result);
         }
+
+        return static_cast<std::uint32_t>(result);
     }
 
     //***************************************************************************
@@ -395,17 +1026,32 @@ template <class UserData> class Ring {
      *
      * @return Completion
      */
-    auto wait() -> Completion<UserData>
+    auto wait() -> Result<Completion<UserData>>
     {
+        m_instrumentation.waiting();
         auto result = io_uring_wait_cqe(&m_ring, &m_cqe);
 
         if (result < 0) {
-            throw std::runtime_error(std::string { "Failed to wait: " } + strerror(-result));
+            m_instrumentation.error();
+            return Error::template failure<Completion<UserData>>("Failed to wait: ", -result);
         }
 
+        m_instrumentation.reaped(m_cqe);
         return Completion<UserData> { m_cqe };
     }
 
+    /*
+     * Waits for a completion with the given strategy e.g. SpinThenBlockWait or
+     * AdaptiveSpinWait, which poll the completion queue before they block.
+     *
+     * @param[in] strategy wait strategy, see WaitStrategy.h
+     * @return Completion
+     */
+    template <class Strategy> auto wait(Strategy& strategy) -> Result<Completion<UserData>>
+    {
+        return strategy.wait(*this);
+    }
+
     /*
      * Returns a completion if available otherwise a nullptr
      *
@@ -419,6 +1065,7 @@ template <class UserData> class Ring {
             return {};
         }
 
+        m_instrumentation.reaped(m_cqe);
         return Completion<UserData> { m_cqe };
     }
 
@@ -429,6 +1076,7 @@ template <class UserData> class Ring {
      */
     auto seen(const Completion<UserData>& completion) -> void
     {
+        m_instrumentation.completed(completion.get());
         io_uring_cqe_seen(&m_ring, completion.get());
     }
 
@@ -456,18 +1104,73 @@ template <class UserData> class Ring {
         return io_uring_cq_ready(&m_ring);
     }
 
+    /*
+     * Returns the instrumentation of the ring policy e.g. the event counters
+     * of policy::CountingInstrumentation
+     */
+    auto instrumentation() -> Instrumentation&
+    {
+        return m_instrumentation;
+    }
+
+    /*
+     * Returns the submission queue full policy e.g. the pending queue of
+     * policy::QueueWhenFull to configure watermarks and backpressure callback
+     */
+    auto sq_full_policy() -> SqFull&
+    {
+        return m_sqFull;
+    }
+
   private:
     auto getSubmissionQueueEntry() -> io_uring_sqe*
     {
-        return io_uring_get_sqe(&m_ring);
+        return m_sqFull.template acquire<Error>(&m_ring, m_instrumentation);
+    }
+
+    /*
+     * Checks for a missing submission queue entry, compiled out if the full
+     * submission queue policy always returns an entry
+     */
+    static auto missing(const io_uring_sqe* submissionQueueEntry) -> bool
+    {
+        if constexpr (SqFull::may_fail) {
+            return !submissionQueueEntry;
+        } else {
+            return false;
+        }
     }
 
-    template <class Container> auto makeIovec(Container& buffer) -> std::shared_ptr<iovec>
+    /*
+     * Returns the iovec of a vectored command. The iovec must stay valid until the
+     * kernel consumed the submission queue entry, so it is bound to the slot of the entry.
+     */
+    template <class Container>
+    auto makeIovec(io_uring_sqe* submissionQueueEntry, Container& buffer) -> iovec*
     {
-        auto vec = std::make_shared<iovec>();
+        auto vec = iovecFor(submissionQueueEntry);
         vec->iov_base = buffer.data();
         vec->iov_len = buffer.size();
         return vec;
     }
+
+    auto iovecFor(io_uring_sqe* submissionQueueEntry) -> iovec*
+    {
+        const auto slot = reinterpret_cast<std::uintptr_t>(submissionQueueEntry)
+            - reinterpret_cast<std::uintptr_t>(m_ring.sq.sqes);
+        if constexpr (requires { m_sqFull.iovec_for(submissionQueueEntry); }) {
+            if (slot >= m_iovecs.size() * sizeof(io_uring_sqe)) {
+                return m_sqFull.iovec_for(submissionQueueEntry);
+            }
+        }
+        return &m_iovecs[slot / sizeof(io_uring_sqe)];
+    }
+
+    auto flushPending() -> void
+    {
+        if constexpr (requires { m_sqFull.flush(&m_ring, m_iovecs.data()); }) {
+            m_sqFull.flush(&m_ring, m_iovecs.data());
+        }
+    }
 };
 } // namespace uringpp
\ No newline at end of file
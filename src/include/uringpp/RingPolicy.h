@@ -0,0 +1,540 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "liburing.h"
+
+#include "uringpp/CpuRelax.h"
+
+namespace uringpp {
+
+/*
+ * Tag of the error constructor of Expected, which would otherwise clash with the
+ * value constructor of Expected<int>
+ */
+struct Unexpected {
+    explicit Unexpected() = default;
+};
+
+/*
+ * Minimal stand-in for std::expected which is not available in C++20.
+ * Holds either a value or an errno value.
+ */
+template <class T> class Expected {
+  public:
+    Expected(T value)
+        : m_value(std::move(value))
+        , m_error(0)
+    {
+    }
+
+    static auto failure(int error) -> Expected
+    {
+        return Expected(Unexpected {}, error);
+    }
+
+    auto has_value() const -> bool
+    {
+        return m_error == 0;
+    }
+
+    explicit operator bool() const
+    {
+        return has_value();
+    }
+
+    /*
+     * Returns the value, aborts if the Expected holds an error
+     */
+    auto value() -> T&
+    {
+        checkValue();
+        return *m_value;
+    }
+
+    auto value() const -> const T&
+    {
+        checkValue();
+        return *m_value;
+    }
+
+    auto operator*() -> T&
+    {
+        return *m_value;
+    }
+
+    auto operator->() -> T*
+    {
+        return &*m_value;
+    }
+
+    auto error() const -> int
+    {
+        return m_error;
+    }
+
+  private:
+    Expected(Unexpected, int error)
+        : m_error(error)
+    {
+    }
+
+    auto checkValue() const -> void
+    {
+        if (!has_value()) [[unlikely]] {
+            std::fprintf(stderr, "Expected holds no value but error: %s\n", strerror(m_error));
+            std::abort();
+        }
+    }
+
+    std::optional<T> m_value;
+    int m_error;
+};
+
+namespace policy {
+
+//***************************************************************************
+// ERROR HANDLING
+//***************************************************************************
+
+/*
+ * Throws std::runtime_error on failed submit and wait calls
+ *
+ * fatal() handles failures of calls which can not report an error, e.g. the submit
+ * of a full submission queue policy behind a prepare_* call which never fails.
+ */
+struct ThrowOnError {
+    template <class T> using result_type = T;
+
+    template <class T>
+    [[noreturn, gnu::cold, gnu::noinline]] static auto failure(const char* what, int error) -> T
+    {
+        throw std::runtime_error(std::string { what } + strerror(error));
+    }
+
+    [[noreturn]] static auto fatal(const char* what, int error) -> void
+    {
+        failure<void>(what, error);
+    }
+};
+
+/*
+ * Prints the error and aborts the process. Failing calls do not allocate and
+ * the call sites do not need to be prepared for unwinding.
+ */
+struct AbortOnError {
+    template <class T> using result_type = T;
+
+    template <class T>
+    [[noreturn, gnu::cold, gnu::noinline]] static auto failure(const char* what, int error) -> T
+    {
+        std::fprintf(stderr, "%s%s\n", what, strerror(error));
+        std::abort();
+    }
+
+    [[noreturn]] static auto fatal(const char* what, int error) -> void
+    {
+        failure<void>(what, error);
+    }
+};
+
+/*
+ * Returns an Expected which holds the errno value on failure, throws
+ * std::runtime_error on failures which can not be returned
+ */
+struct ExpectedOnError {
+    template <class T> using result_type = Expected<T>;
+
+    template <class T> static auto failure(const char*, int error) -> Expected<T>
+    {
+        return Expected<T>::failure(error);
+    }
+
+    [[noreturn, gnu::cold, gnu::noinline]] static auto fatal(const char* what, int error) -> void
+    {
+        throw std::runtime_error(std::string { what } + strerror(error));
+    }
+};
+
+//***************************************************************************
+// SUBMISSION QUEUE FULL BEHAVIOUR
+//***************************************************************************
+
+// A policy which never returns a null entry declares may_fail = false, the ring
+// then compiles the check of prepare_* for a missing entry out.
+
+/*
+ * Returns no submission queue entry when the submission queue is full,
+ * prepare_* calls return false in this case.
+ */
+struct FailWhenFull {
+    static constexpr bool may_fail = true;
+
+    template <class Error, class Instrumentation>
+    static auto acquire(io_uring* ring, Instrumentation& instrumentation) -> io_uring_sqe*
+    {
+        auto sqe = io_uring_get_sqe(ring);
+        if (!sqe) {
+            instrumentation.sq_full();
+        }
+        return sqe;
+    }
+};
+
+/*
+ * Submits on behalf of a full submission queue, with the instrumentation hooks of
+ * Ring::submit
+ *
+ * @return result of io_uring_submit, the negative errno value if the submit failed
+ */
+template <class Instrumentation>
+auto submitWhenFull(io_uring* ring, Instrumentation& instrumentation) -> int
+{
+    instrumentation.submitting();
+    const auto result = io_uring_submit(ring);
+    instrumentation.submitted(result);
+    if (result < 0) {
+        instrumentation.error();
+    }
+    return result;
+}
+
+/*
+ * Submits the prepared entries when the submission queue is full and retries once.
+ * prepare_* calls return false if the submit failed.
+ */
+struct FlushWhenFull {
+    static constexpr bool may_fail = true;
+
+    template <class Error, class Instrumentation>
+    static auto acquire(io_uring* ring, Instrumentation& instrumentation) -> io_uring_sqe*
+    {
+        auto sqe = io_uring_get_sqe(ring);
+        if (!sqe) {
+            instrumentation.sq_full();
+            if (submitWhenFull(ring, instrumentation) < 0) {
+                return nullptr;
+            }
+            sqe = io_uring_get_sqe(ring);
+        }
+        return sqe;
+    }
+};
+
+/*
+ * Submits and retries until a submission queue entry becomes available, so
+ * prepare_* never fails. Without IORING_SETUP_SQPOLL the first submit empties the
+ * submission queue, with it the submit is repeated until the kernel thread consumed
+ * an entry. A failed submit is handed to fatal() of the error policy, retrying it
+ * would spin forever.
+ */
+struct SpinWhenFull {
+    static constexpr bool may_fail = false;
+
+    template <class Error, class Instrumentation>
+    static auto acquire(io_uring* ring, Instrumentation& instrumentation) -> io_uring_sqe*
+    {
+        auto sqe = io_uring_get_sqe(ring);
+        if (!sqe) {
+            instrumentation.sq_full();
+        }
+        while (!sqe) {
+            if (const auto result = submitWhenFull(ring, instrumentation); result < 0) {
+                Error::fatal("Failed to submit full submission queue: ", -result);
+            }
+            cpuRelax();
+            sqe = io_uring_get_sqe(ring);
+        }
+        return sqe;
+    }
+};
+
+/*
+ * Absorbs prepared commands in a pending queue while the submission queue is full.
+ * The ring moves pending commands into the submission queue around each submit, so
+ * prepare_* never fails and keeps the order of the prepared commands.
+ *
+ * Linked commands (IOSQE_IO_LINK, IOSQE_IO_HARDLINK) are moved into the submission
+ * queue as a whole chain, so a chain is never split across two submits. A chain
+ * which starts in the submission queue and does not fit into it is rejected with
+ * std::runtime_error, reserve its entries before preparing it.
+ *
+ * The pending queue raises backpressure when it grows to the high watermark and
+ * releases it when it drained to the low watermark. Producers either poll
+ * backpressured() or register a callback which is called on both transitions.
+ */
+class QueueWhenFull {
+    // io_uring_sqe ends in a flexible array member and can not be embedded directly
+    struct PendingEntry {
+        alignas(io_uring_sqe) std::uint8_t sqe[sizeof(io_uring_sqe)];
+        iovec vec;
+
+        auto get() -> io_uring_sqe*
+        {
+            return reinterpret_cast<io_uring_sqe*>(sqe);
+        }
+    };
+
+  public:
+    using BackpressureCallback = std::function<void(bool backpressured)>;
+
+    static constexpr bool may_fail = false;
+
+    template <class Error, class Instrumentation>
+    auto acquire(io_uring* ring, Instrumentation& instrumentation) -> io_uring_sqe*
+    {
+        // Once commands are pending new ones queue up behind them to keep the order
+        if (m_pending.empty()) {
+            if (auto sqe = io_uring_get_sqe(ring)) {
+                return sqe;
+            }
+            instrumentation.sq_full();
+
+            // The entry would continue the chain in the submission queue behind the
+            // next submit
+            if (ring->sq.sqe_tail != ring->sq.sqe_head
+                && linked(&ring->sq.sqes[(ring->sq.sqe_tail - 1) & ring->sq.ring_mask])) {
+                throw std::runtime_error("Linked chain does not fit into the submission queue");
+            }
+        }
+
+        auto& entry = m_pending.emplace_back();
+        std::memset(&entry, 0, sizeof(entry));
+
+        if (!m_backpressured && m_pending.size() >= m_highWatermark) {
+            setBackpressured(true);
+        }
+
+        return entry.get();
+    }
+
+    /*
+     * Returns iovec storage for a pending submission queue entry
+     */
+    auto iovec_for(io_uring_sqe* sqe) -> iovec*
+    {
+        return &reinterpret_cast<PendingEntry*>(sqe)->vec;
+    }
+
+    /*
+     * Moves pending commands into the free slots of the submission queue, chains
+     * only if all of their commands fit
+     *
+     * @param[in] ring ring to fill
+     * @param[in] slotIovecs iovec storage of the submission queue slots
+     */
+    auto flush(io_uring* ring, iovec* slotIovecs) -> void
+    {
+        while (!m_pending.empty()) {
+            const auto chain = chainLength();
+            if (!chain) {
+                // The chain is still being prepared
+                break;
+            }
+            if (chain > ring->sq.ring_entries) {
+                throw std::runtime_error("Linked chain is longer than the submission queue");
+            }
+            if (chain > io_uring_sq_space_left(ring)) {
+                break;
+            }
+
+            for (std::size_t i = 0; i < chain; i++) {
+                auto sqe = io_uring_get_sqe(ring);
+                auto& entry = m_pending.front();
+                std::memcpy(sqe, entry.sqe, sizeof(entry.sqe));
+                if (sqe->addr == reinterpret_cast<std::uint64_t>(&entry.vec)) {
+                    auto& slotIovec = slotIovecs[sqe - ring->sq.sqes];
+                    slotIovec = entry.vec;
+                    sqe->addr = reinterpret_cast<std::uint64_t>(&slotIovec);
+                }
+                m_pending.pop_front();
+            }
+        }
+
+        if (m_backpressured && m_pending.size() <= m_lowWatermark) {
+            setBackpressured(false);
+        }
+    }
+
+    /*
+     * @param[in] high number of pending commands which raises backpressure
+     * @param[in] low number of pending commands which releases backpressure
+     */
+    auto set_watermarks(std::size_t high, std::size_t low) -> void
+    {
+        m_highWatermark = high;
+        m_lowWatermark = low;
+    }
+
+    auto on_backpressure(BackpressureCallback callback) -> void
+    {
+        m_callback = std::move(callback);
+    }
+
+    auto backpressured() const -> bool
+    {
+        return m_backpressured;
+    }
+
+    auto pending() const -> std::size_t
+    {
+        return m_pending.size();
+    }
+
+  private:
+    static auto linked(const io_uring_sqe* sqe) -> bool
+    {
+        return sqe->flags & (IOSQE_IO_LINK | IOSQE_IO_HARDLINK);
+    }
+
+    /*
+     * Returns the number of commands of the chain at the front of the pending
+     * queue, 1 for an unlinked command and 0 if its last command is not yet prepared
+     */
+    auto chainLength() -> std::size_t
+    {
+        for (std::size_t i = 0; i < m_pending.size(); i++) {
+            if (!linked(m_pending[i].get())) {
+                return i + 1;
+            }
+        }
+        return 0;
+    }
+
+    auto setBackpressured(bool backpressured) -> void
+    {
+        m_backpressured = backpressured;
+        if (m_callback) {
+            m_callback(backpressured);
+        }
+    }
+
+    std::deque<PendingEntry> m_pending;
+    std::size_t m_highWatermark = std::numeric_limits<std::size_t>::max();
+    std::size_t m_lowWatermark = 0;
+    bool m_backpressured = false;
+    BackpressureCallback m_callback;
+};
+
+//***************************************************************************
+// INSTRUMENTATION
+//***************************************************************************
+
+/*
+ * Instrumentation hooks which compile to nothing
+ */
+struct NoInstrumentation {
+    auto prepared(const io_uring_sqe*) -> void
+    {
+    }
+    auto submitting() -> void
+    {
+    }
+    auto submitted(int) -> void
+    {
+    }
+    auto waiting() -> void
+    {
+    }
+    auto reaped(const io_uring_cqe*) -> void
+    {
+    }
+    auto completed(const io_uring_cqe*) -> void
+    {
+    }
+    auto sq_full() -> void
+    {
+    }
+    auto error() -> void
+    {
+    }
+};
+
+/*
+ * Counts the ring events
+ */
+struct CountingInstrumentation {
+    auto prepared(const io_uring_sqe*) -> void
+    {
+        preparedEntries++;
+    }
+    auto submitting() -> void
+    {
+    }
+    auto submitted(int entries) -> void
+    {
+        submits++;
+        submittedEntries += entries > 0 ? entries : 0;
+    }
+    auto waiting() -> void
+    {
+    }
+    auto reaped(const io_uring_cqe*) -> void
+    {
+    }
+    auto completed(const io_uring_cqe*) -> void
+    {
+        completedEntries++;
+    }
+    auto sq_full() -> void
+    {
+        sqFullEvents++;
+    }
+    auto error() -> void
+    {
+        errors++;
+    }
+
+    std::uint64_t preparedEntries = 0;
+    std::uint64_t submits = 0;
+    std::uint64_t submittedEntries = 0;
+    std::uint64_t completedEntries = 0;
+    std::uint64_t sqFullEvents = 0;
+    std::uint64_t errors = 0;
+};
+
+} // namespace policy
+
+/*
+ * Compile time configuration of a Ring
+ *
+ * @tparam Error error handling of submit and wait (ThrowOnError, AbortOnError, ExpectedOnError)
+ * @tparam SqFull behaviour of prepare_* on a full submission queue
+ *                (FailWhenFull, FlushWhenFull, SpinWhenFull, QueueWhenFull)
+ * @tparam Instrumentation hooks called on ring events (NoInstrumentation, CountingInstrumentation,
+ *                         TracingInstrumentation)
+ */
+template <
+    class Error = policy::ThrowOnError,
+    class SqFull = policy::FailWhenFull,
+    class Instrumentation = policy::NoInstrumentation>
+struct RingPolicy {
+    using error = Error;
+    using sq_full = SqFull;
+    using instrumentation = Instrumentation;
+};
+
+using DefaultRingPolicy = RingPolicy<>;
+
+/*
+ * Policy for hot loops: no exceptions, no instrumentation and prepare_* never fails,
+ * so it does not check for a full submission queue.
+ */
+using FastRingPolicy = RingPolicy<policy::AbortOnError, policy::SpinWhenFull>;
+
+/*
+ * Policy which queues commands instead of failing on a full submission queue
+ */
+using OverflowRingPolicy = RingPolicy<policy::ThrowOnError, policy::QueueWhenFull>;
+
+} // namespace uringpp
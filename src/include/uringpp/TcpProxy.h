@@ -0,0 +1,639 @@
+#pragma once
+
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "uringpp/BufferPoolManager.h"
+#include "uringpp/Capabilities.h"
+#include "uringpp/Operation.h"
+#include "uringpp/Ring.h"
+
+namespace uringpp {
+
+struct ProxyOptions {
+    std::size_t queueDepth = 256;
+    // Bytes moved per splice, the pipe of each direction is resized to it
+    std::size_t pipeSize = 64 * 1024;
+    // Forward through pipes with splice if the kernel supports it, otherwise or if
+    // false through provided buffers
+    bool splice = true;
+    std::size_t bufferSize = 16 * 1024;
+    std::size_t numberOfBuffers = 256;
+};
+
+struct ProxyStatistics {
+    std::uint64_t sessions = 0;
+    std::uint64_t activeSessions = 0;
+    std::uint64_t failedConnects = 0;
+    // Bytes forwarded from the clients to the upstream and back
+    std::uint64_t bytesUpstream = 0;
+    std::uint64_t bytesDownstream = 0;
+};
+
+/*
+ * Layer 4 proxy which forwards the TCP connections accepted on a listening socket
+ * to an upstream address.
+ *
+ * Each direction of a session is forwarded with a splice from the source socket
+ * into a pipe hard linked to a splice from the pipe into the destination socket,
+ * so the data never crosses into user space. The kernel runs the blocking splice
+ * from the socket on an io-wq worker. Without splice support the data is received
+ * into provided buffers and sent from them.
+ *
+ * Half-close is forwarded: once one side shut down its sending side, the proxy
+ * shuts down the sending side towards the other side and keeps forwarding the
+ * other direction. A session ends when both directions ended or one side failed.
+ *
+ * run() serves until stop() is called from any thread.
+ */
+class TcpProxy {
+  public:
+    /*
+     * @param[in] listenFd listening socket, owned by the caller
+     * @param[in] upstream address the accepted connections are forwarded to
+     */
+    TcpProxy(
+        int listenFd,
+        const sockaddr_in& upstream,
+        ProxyOptions options = {},
+        const Capabilities& capabilities = Capabilities::get())
+        : m_listenFd(listenFd)
+        , m_upstream(upstream)
+        , m_options(options)
+        , m_splice(options.splice && capabilities.has_splice())
+        , m_shutdownOp(capabilities.has_shutdown())
+        , m_ring(options.queueDepth)
+    {
+        if (!m_splice) {
+            if (!capabilities.has_provide_buffers()) {
+                throw std::runtime_error("TcpProxy needs splice or provided buffers");
+            }
+            m_buffers.emplace(
+                std::vector<SizeClass> { { options.bufferSize, options.numberOfBuffers } });
+        }
+
+        m_eventFd = eventfd(0, EFD_CLOEXEC);
+        if (m_eventFd < 0) {
+            throw std::runtime_error(std::string("Failed to create eventfd: ") + strerror(errno));
+        }
+        logSelectedPath("tcp proxy", m_splice ? "splice" : "provided buffers");
+    }
+
+    TcpProxy(const TcpProxy&) = delete;
+    auto operator=(const TcpProxy&) -> TcpProxy& = delete;
+
+    ~TcpProxy()
+    {
+        // Runs before any member is destroyed, so the descriptors are closed while
+        // operations of the sessions may still be in flight. A submitted operation
+        // holds its own reference to the socket or pipe, which is only dropped once
+        // the destruction of m_ring cancelled the operation.
+        for (auto& session : m_sessions) {
+            closeDescriptors(*session);
+        }
+        close(m_eventFd);
+    }
+
+    /*
+     * Accepts and forwards connections until stop() is called. Returns once all
+     * sessions were closed.
+     */
+    auto run() -> void
+    {
+        m_stopping = false;
+        if (!m_acceptArmed) {
+            m_acceptOp.fd = m_listenFd;
+            prepare(m_acceptOp);
+            m_acceptArmed = true;
+        }
+        prepareWake();
+        if (m_buffers) {
+            m_buffers->provide<Operations>(m_ring);
+        }
+
+        auto handler = Overloaded {
+            [this](AcceptOp&, AcceptOp::result_type result) { onAccepted(result); },
+            [this](ConnectOp& connect, ConnectOp::result_type result) {
+                onConnected(*connect.session, result);
+            },
+            [this](SpliceOp& splice, SpliceOp::result_type result) { onSpliced(splice, result); },
+            [this](RecvOp& recv, RecvOp::result_type result) {
+                onReceived(*recv.direction, result);
+            },
+            [this](SendOp& send, SendOp::result_type result) { onSent(send, result); },
+            [this](ShutdownOp& shutdown, ShutdownOp::result_type) {
+                onShutdown(*shutdown.direction);
+            },
+            [this](WakeOp&, WakeOp::result_type) { onStop(); },
+            [this](ProvideBuffersOp& provide, ProvideBuffersOp::result_type result) {
+                if (!result.ok()) {
+                    throw std::runtime_error(
+                        std::string("Failed to provide buffers: ") + strerror(result.error()));
+                }
+                m_parked.provided(
+                    *m_buffers, provide, [this](Direction* direction) { forward(*direction); });
+            }
+        };
+
+        while (!m_stopping || !m_sessions.empty()) {
+            m_ring.submit();
+            auto completion = m_ring.wait();
+            Operations::dispatch(completion.get(), handler);
+            m_ring.seen(completion);
+        }
+    }
+
+    /*
+     * Makes run() close all sessions and return, may be called from any thread
+     */
+    auto stop() -> void
+    {
+        const std::uint64_t one = 1;
+        if (write(m_eventFd, &one, sizeof(one)) != sizeof(one)) {
+            throw std::runtime_error(std::string("Failed to stop proxy: ") + strerror(errno));
+        }
+    }
+
+    auto uses_splice() const -> bool
+    {
+        return m_splice;
+    }
+
+    /*
+     * Returns the statistics, consistent while run() is not running
+     */
+    auto statistics() const -> ProxyStatistics
+    {
+        return m_statistics;
+    }
+
+  private:
+    struct Session;
+    struct Direction;
+
+    struct AcceptOp : op::Accept {
+    };
+
+    struct ConnectOp : op::Connect {
+        Session* session;
+    };
+
+    struct SpliceOp : op::Splice {
+        Direction* direction;
+        // Splice from the pipe into the destination socket
+        bool out;
+    };
+
+    struct RecvOp : op::RecvBp {
+        Direction* direction;
+    };
+
+    struct SendOp : op::Send {
+        Direction* direction;
+        std::size_t bufferId;
+    };
+
+    struct ShutdownOp : op::Shutdown {
+        Direction* direction;
+    };
+
+    struct WakeOp : op::Read {
+    };
+
+    using ProvideBuffersOp = BufferPoolManager::ProvideBuffersOp;
+    using Operations = OperationSet<
+        AcceptOp,
+        ConnectOp,
+        SpliceOp,
+        RecvOp,
+        SendOp,
+        ShutdownOp,
+        WakeOp,
+        ProvideBuffersOp>;
+
+    struct Direction {
+        Session* session;
+        int from = -1;
+        int to = -1;
+        int pipe[2] = { -1, -1 };
+        unsigned pipeSize = 0;
+        std::size_t inPipe = 0;
+        bool eof = false;
+        bool failed = false;
+        bool done = false;
+        std::uint64_t* bytes;
+        SpliceOp in {};
+        SpliceOp out {};
+        RecvOp recv {};
+        SendOp send {};
+        ShutdownOp shutdown {};
+    };
+
+    struct Session {
+        int client = -1;
+        int upstream = -1;
+        std::size_t index = 0;
+        // Operations in flight, the session is freed once it is closing and none is left
+        std::size_t pending = 0;
+        bool closing = false;
+        ConnectOp connect {};
+        Direction toUpstream;
+        Direction toClient;
+    };
+
+    //***************************************************************************
+    // SESSIONS
+    //***************************************************************************
+
+    auto onAccepted(AcceptOp::result_type result) -> void
+    {
+        m_acceptArmed = false;
+        if (m_stopping) {
+            if (result.ok()) {
+                close(result.value());
+            }
+            return;
+        }
+        prepare(m_acceptOp);
+        m_acceptArmed = true;
+
+        if (!result.ok()) {
+            // e.g. EMFILE, the next accept tries again
+            return;
+        }
+
+        auto& session = *m_sessions.emplace_back(std::make_unique<Session>());
+        session.index = m_sessions.size() - 1;
+        session.client = result.value();
+        session.upstream = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        m_statistics.sessions++;
+        m_statistics.activeSessions++;
+        if (session.upstream < 0) {
+            closeSession(session);
+            return;
+        }
+
+        const int one = 1;
+        setsockopt(session.client, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        setsockopt(session.upstream, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        session.connect.fd = session.upstream;
+        session.connect.addr = reinterpret_cast<const sockaddr*>(&m_upstream);
+        session.connect.addrlen = sizeof(m_upstream);
+        session.connect.session = &session;
+        prepare(session, session.connect);
+    }
+
+    auto onConnected(Session& session, ConnectOp::result_type result) -> void
+    {
+        session.pending--;
+        if (!result.ok()) {
+            m_statistics.failedConnects++;
+        }
+        if (!result.ok() || session.closing) {
+            closeSession(session);
+            return;
+        }
+
+        session.toUpstream.bytes = &m_statistics.bytesUpstream;
+        session.toClient.bytes = &m_statistics.bytesDownstream;
+        if (!initDirection(session, session.toUpstream, session.client, session.upstream)
+            || !initDirection(session, session.toClient, session.upstream, session.client)) {
+            closeSession(session);
+            return;
+        }
+
+        forward(session.toUpstream);
+        forward(session.toClient);
+    }
+
+    auto initDirection(Session& session, Direction& direction, int from, int to) -> bool
+    {
+        direction.session = &session;
+        direction.from = from;
+        direction.to = to;
+        direction.in.direction = &direction;
+        direction.out.direction = &direction;
+        direction.out.out = true;
+        direction.recv.direction = &direction;
+        direction.send.direction = &direction;
+        direction.shutdown.direction = &direction;
+
+        if (m_splice) {
+            if (pipe2(direction.pipe, O_CLOEXEC) < 0) {
+                return false;
+            }
+            // Larger pipes than pipe-max-size need CAP_SYS_RESOURCE, keep the default then
+            fcntl(direction.pipe[1], F_SETPIPE_SZ, static_cast<int>(m_options.pipeSize));
+            direction.pipeSize = static_cast<unsigned>(fcntl(direction.pipe[1], F_GETPIPE_SZ));
+        }
+        return true;
+    }
+
+    /*
+     * Continues forwarding the direction after its last operation completed
+     */
+    auto forward(Direction& direction) -> void
+    {
+        auto& session = *direction.session;
+        if (session.closing) {
+            finishIfIdle(session);
+        } else if (direction.failed) {
+            closeSession(session);
+        } else if (direction.inPipe) {
+            drainPipe(direction);
+        } else if (direction.eof) {
+            shutdownWrite(direction);
+        } else if (m_splice) {
+            spliceThroughPipe(direction);
+        } else {
+            receive(direction);
+        }
+    }
+
+    /*
+     * Shuts the sending side of the destination down after the source did so
+     */
+    auto shutdownWrite(Direction& direction) -> void
+    {
+        if (m_shutdownOp) {
+            direction.shutdown.fd = direction.to;
+            direction.shutdown.how = SHUT_WR;
+            prepare(*direction.session, direction.shutdown);
+            return;
+        }
+        shutdown(direction.to, SHUT_WR);
+        onShutdown(direction);
+    }
+
+    auto onShutdown(Direction& direction) -> void
+    {
+        auto& session = *direction.session;
+        if (m_shutdownOp) {
+            session.pending--;
+        }
+        direction.done = true;
+        if (session.toUpstream.done && session.toClient.done) {
+            closeSession(session);
+        } else {
+            finishIfIdle(session);
+        }
+    }
+
+    /*
+     * Shuts both sockets down, which completes the blocked operations of the session
+     */
+    auto closeSession(Session& session) -> void
+    {
+        if (!session.closing) {
+            session.closing = true;
+            if (session.client >= 0) {
+                shutdown(session.client, SHUT_RDWR);
+            }
+            if (session.upstream >= 0) {
+                shutdown(session.upstream, SHUT_RDWR);
+            }
+        }
+        finishIfIdle(session);
+    }
+
+    auto finishIfIdle(Session& session) -> void
+    {
+        if (!session.closing || session.pending) {
+            return;
+        }
+
+        m_parked.remove(&session.toUpstream);
+        m_parked.remove(&session.toClient);
+        closeDescriptors(session);
+        m_statistics.activeSessions--;
+
+        const auto index = session.index;
+        std::swap(m_sessions[index], m_sessions.back());
+        m_sessions[index]->index = index;
+        m_sessions.pop_back();
+    }
+
+    static auto closeDescriptors(Session& session) -> void
+    {
+        for (auto fd : { session.client,
+                         session.upstream,
+                         session.toUpstream.pipe[0],
+                         session.toUpstream.pipe[1],
+                         session.toClient.pipe[0],
+                         session.toClient.pipe[1] }) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+
+    auto onStop() -> void
+    {
+        m_stopping = true;
+        for (std::size_t index = m_sessions.size(); index > 0; index--) {
+            closeSession(*m_sessions[index - 1]);
+        }
+    }
+
+    //***************************************************************************
+    // SPLICE PATH
+    //***************************************************************************
+
+    /*
+     * Splices what arrived on the source into the pipe and, hard linked so it also
+     * runs after a short splice, on from the pipe into the destination. The second
+     * splice does not block, what the destination did not take is drained after.
+     */
+    auto spliceThroughPipe(Direction& direction) -> void
+    {
+        direction.in.fdIn = direction.from;
+        direction.in.fdOut = direction.pipe[1];
+        direction.in.length = direction.pipeSize;
+        direction.in.flags = SPLICE_F_MOVE;
+        direction.in.hardLink = true;
+
+        direction.out.fdIn = direction.pipe[0];
+        direction.out.fdOut = direction.to;
+        direction.out.length = direction.pipeSize;
+        direction.out.flags = SPLICE_F_MOVE | SPLICE_F_NONBLOCK;
+
+        // Both entries must be submitted together to stay linked
+        reserve(2);
+        prepare(*direction.session, direction.in);
+        prepare(*direction.session, direction.out);
+    }
+
+    auto drainPipe(Direction& direction) -> void
+    {
+        direction.out.length = static_cast<unsigned>(direction.inPipe);
+        direction.out.flags = SPLICE_F_MOVE;
+        prepare(*direction.session, direction.out);
+    }
+
+    auto onSpliced(SpliceOp& splice, SpliceOp::result_type result) -> void
+    {
+        auto& direction = *splice.direction;
+        direction.session->pending--;
+
+        if (!splice.out) {
+            if (!result.ok()) {
+                direction.failed = true;
+            } else if (result.value() == 0) {
+                direction.eof = true;
+            } else {
+                direction.inPipe += result.value();
+            }
+            // The linked splice out of the pipe completes next
+            return;
+        }
+
+        if (result.ok()) {
+            direction.inPipe -= result.value();
+            *direction.bytes += result.value();
+        } else if (result.error() != EAGAIN) {
+            direction.failed = true;
+        }
+        forward(direction);
+    }
+
+    //***************************************************************************
+    // PROVIDED BUFFER PATH
+    //***************************************************************************
+
+    auto receive(Direction& direction) -> void
+    {
+        direction.recv.fd = direction.from;
+        direction.recv.bufferPool = &m_buffers->pool(0);
+        prepare(*direction.session, direction.recv);
+    }
+
+    auto onReceived(Direction& direction, RecvOp::result_type result) -> void
+    {
+        auto& session = *direction.session;
+        session.pending--;
+
+        if (result.ok() && result.value() > 0) {
+            m_buffers->acquired(0, result.value());
+            if (session.closing) {
+                releaseBuffer(result.buffer_idx());
+                finishIfIdle(session);
+                return;
+            }
+
+            direction.send.fd = direction.to;
+            direction.send.buffer = m_buffers->buffer(0, result.buffer_idx()).first(result.value());
+            direction.send.bufferId = result.buffer_idx();
+            prepare(session, direction.send);
+            return;
+        }
+
+        if (result.error() == ENOBUFS && !session.closing) {
+            // All buffers are in flight, forwarding continues once buffers are provided
+            reserve(1);
+            m_parked.park<Operations>(m_ring, *m_buffers, 0, &direction);
+            return;
+        }
+
+        if (!result.ok()) {
+            direction.failed = true;
+        } else {
+            direction.eof = true;
+        }
+        forward(direction);
+    }
+
+    auto onSent(SendOp& send, SendOp::result_type result) -> void
+    {
+        auto& direction = *send.direction;
+        auto& session = *direction.session;
+        session.pending--;
+
+        if (result.ok()) {
+            *direction.bytes += result.value();
+            if (result.value() < send.buffer.size() && !session.closing) {
+                send.buffer = send.buffer.subspan(result.value());
+                prepare(session, send);
+                return;
+            }
+        } else {
+            direction.failed = true;
+        }
+
+        releaseBuffer(send.bufferId);
+        forward(direction);
+    }
+
+    auto releaseBuffer(std::size_t bufferId) -> void
+    {
+        reserve(1);
+        m_buffers->release<Operations>(m_ring, 0, bufferId);
+    }
+
+    //***************************************************************************
+    // SUBMISSION
+    //***************************************************************************
+
+    /*
+     * Submits the prepared entries if less than count entries are free
+     */
+    auto reserve(unsigned count) -> void
+    {
+        if (m_ring.capacity() < count) {
+            m_ring.submit();
+        }
+    }
+
+    template <class Operation> auto prepare(Operation& operation) -> void
+    {
+        reserve(1);
+        m_ring.prepare_operation<Operations>(operation);
+    }
+
+    template <class Operation> auto prepare(Session& session, Operation& operation) -> void
+    {
+        prepare(operation);
+        session.pending++;
+    }
+
+    auto prepareWake() -> void
+    {
+        m_wakeOp.fd = m_eventFd;
+        m_wakeOp.buffer
+            = std::span(reinterpret_cast<std::uint8_t*>(&m_wakeCount), sizeof(m_wakeCount));
+        prepare(m_wakeOp);
+    }
+
+    int m_listenFd;
+    sockaddr_in m_upstream;
+    ProxyOptions m_options;
+    bool m_splice;
+    bool m_shutdownOp;
+    int m_eventFd = -1;
+    bool m_stopping = false;
+    bool m_acceptArmed = false;
+    AcceptOp m_acceptOp {};
+    WakeOp m_wakeOp {};
+    std::uint64_t m_wakeCount = 0;
+    std::optional<BufferPoolManager> m_buffers;
+    // Directions whose receive ran out of buffers
+    ParkedReceives<Direction*> m_parked;
+    std::vector<std::unique_ptr<Session>> m_sessions;
+    ProxyStatistics m_statistics;
+    // Declared last, so it is destroyed first and cancels the operations in flight
+    Ring<void> m_ring;
+};
+
+} // namespace uringpp
@@ -0,0 +1,530 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <optional>
+
+#include "uringpp/Capabilities.h"
+#include "uringpp/Operation.h"
+
+namespace uringpp {
+
+class TimerWheel;
+
+/*
+ * Timer of a TimerWheel. Applications embed it into their state, e.g. a
+ * connection, or derive from it and cast back in the expiry handler:
+ *
+ *  struct Connection : uringpp::Timer { ... };
+ *  wheel.expire(now, [](uringpp::Timer& timer) { static_cast<Connection&>(timer)... });
+ *
+ * A timer is a node of an intrusive list, scheduling and cancelling neither
+ * allocates nor searches. Destroying a scheduled timer cancels it.
+ */
+class Timer {
+  public:
+    Timer() = default;
+    Timer(const Timer&) = delete;
+    auto operator=(const Timer&) -> Timer& = delete;
+
+    ~Timer();
+
+    auto scheduled() const -> bool
+    {
+        return m_next;
+    }
+
+  private:
+    friend class TimerWheel;
+
+    auto unlink() -> void
+    {
+        if (m_next) {
+            m_prev->m_next = m_next;
+            m_next->m_prev = m_prev;
+            m_next = nullptr;
+            m_prev = nullptr;
+        }
+    }
+
+    Timer* m_next = nullptr;
+    Timer* m_prev = nullptr;
+    std::uint64_t m_tick = 0;
+    TimerWheel* m_wheel = nullptr;
+};
+
+/*
+ * Hierarchical timer wheel for many timers with one ring timeout.
+ *
+ * Time advances in ticks of the resolution. The wheel has four levels of 64
+ * slots, a slot of level n covers 64^n ticks, so 64^4 ticks (4.6 hours at 1 ms)
+ * are covered by the levels and later deadlines wait in an overflow list.
+ * Scheduling puts the timer into the slot of its deadline and cancelling unlinks
+ * it, both O(1). When time enters a slot of a higher level, its timers cascade
+ * into the lower levels. Occupancy masks per level let expire() skip empty slots
+ * and next_deadline() find the earliest occupied slot without scanning.
+ *
+ * Timers never expire early: a deadline is rounded up to the next tick, and expire
+ * hands out timers in batches per tick.
+ *
+ * With a ring the wheel keeps a single absolute timeout armed at its earliest
+ * deadline (TimeoutOp, to be added to the OperationSet of the ring). arm() moves
+ * it with a timeout update when an earlier timer was scheduled; kernels before
+ * 5.11 remove the timeout and arm it again.
+ */
+class TimerWheel {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::size_t levels = 4;
+    static constexpr std::size_t slotBits = 6;
+    static constexpr std::size_t slots = std::size_t { 1 } << slotBits;
+
+    /*
+     * Timeout or timeout update of the wheel, results are passed to complete()
+     */
+    struct TimeoutOp {
+        using result_type = Result<int>;
+
+        enum class Kind {
+            Timeout,
+            Update,
+            Remove
+        };
+
+        Kind kind = Kind::Timeout;
+        op::Timeout timeout { .absolute = true };
+        op::TimeoutUpdate update { .absolute = true };
+        op::TimeoutRemove remove;
+
+        auto prepare(io_uring_sqe* sqe) const -> void
+        {
+            switch (kind) {
+            case Kind::Timeout:
+                timeout.prepare(sqe);
+                break;
+            case Kind::Update:
+                update.prepare(sqe);
+                break;
+            case Kind::Remove:
+                remove.prepare(sqe);
+                break;
+            }
+        }
+
+        static auto result(const io_uring_cqe* cqe) -> result_type
+        {
+            return result_type { cqe->res };
+        }
+    };
+
+    /*
+     * @param[in] resolution length of a tick
+     * @param[in] start time of tick 0
+     */
+    explicit TimerWheel(
+        std::chrono::nanoseconds resolution = std::chrono::milliseconds(1),
+        Clock::time_point start = Clock::now(),
+        const Capabilities& capabilities = Capabilities::get())
+        : m_resolution(resolution)
+        , m_start(start)
+        , m_timeoutUpdate(capabilities.has_timeout_update())
+    {
+        for (auto& level : m_slots) {
+            for (auto& slot : level) {
+                initList(slot);
+            }
+        }
+        initList(m_overflow);
+        initList(m_due);
+        m_updateOp.kind = m_timeoutUpdate ? TimeoutOp::Kind::Update : TimeoutOp::Kind::Remove;
+    }
+
+    TimerWheel(const TimerWheel&) = delete;
+    auto operator=(const TimerWheel&) -> TimerWheel& = delete;
+
+    ~TimerWheel()
+    {
+        // Detach the timers, they must not point to the destroyed list heads
+        for (auto& level : m_slots) {
+            for (auto& slot : level) {
+                detachList(slot);
+            }
+        }
+        detachList(m_overflow);
+        detachList(m_due);
+    }
+
+    /*
+     * Schedules the timer, or reschedules it if it is scheduled already
+     */
+    auto schedule(Timer& timer, Clock::time_point deadline) -> void
+    {
+        if (timer.scheduled()) {
+            timer.m_wheel->cancel(timer);
+        }
+        timer.m_tick = tickAtOrAfter(deadline);
+        timer.m_wheel = this;
+        insert(timer);
+        m_size++;
+
+        if (timer.m_tick < m_armedTick) {
+            m_rearm = true;
+        }
+    }
+
+    auto schedule_after(Timer& timer, Clock::duration delay) -> void
+    {
+        schedule(timer, Clock::now() + delay);
+    }
+
+    auto cancel(Timer& timer) -> void
+    {
+        if (timer.scheduled()) {
+            timer.unlink();
+            m_size--;
+        }
+    }
+
+    /*
+     * Advances the wheel to now and calls onExpired(Timer&) for each timer whose
+     * deadline passed. The expired timers are collected first, so the handler may
+     * schedule and cancel any timer.
+     *
+     * @return number of expired timers
+     */
+    template <class OnExpired>
+    auto expire(Clock::time_point now, OnExpired&& onExpired) -> std::size_t
+    {
+        Timer expired;
+        initList(expired);
+
+        const auto target = tickAtOrBefore(now);
+        while (m_now < target) {
+            // Jump to the next occupied slot of level 0 or the end of its rotation
+            const auto index = m_now & (slots - 1);
+            const auto ahead
+                = index == slots - 1 ? 0 : m_occupied[0] & (~std::uint64_t { 0 } << (index + 1));
+            const auto next = ahead
+                ? (m_now & ~std::uint64_t { slots - 1 }) + std::countr_zero(ahead)
+                : (m_now | (slots - 1)) + 1;
+            if (next > target) {
+                m_now = target;
+                break;
+            }
+
+            m_now = next;
+            if ((m_now & (slots - 1)) == 0) {
+                cascade();
+            }
+            const auto slot = m_now & (slots - 1);
+            spliceList(m_slots[0][slot], expired);
+            m_occupied[0] &= ~(std::uint64_t { 1 } << slot);
+        }
+        spliceList(m_due, expired);
+
+        std::size_t count = 0;
+        while (expired.m_next != &expired) {
+            auto& timer = *expired.m_next;
+            timer.unlink();
+            m_size--;
+            count++;
+            onExpired(timer);
+        }
+        return count;
+    }
+
+    /*
+     * Returns the earliest time at which expire() may hand out a timer. It can be
+     * early once the timers of a slot were cancelled or while the timers of a
+     * higher level did not cascade yet, but never late.
+     */
+    auto next_deadline() const -> std::optional<Clock::time_point>
+    {
+        const auto tick = nextTick();
+        if (tick == noTick) {
+            return std::nullopt;
+        }
+        return timeOf(tick);
+    }
+
+    auto size() const -> std::size_t
+    {
+        return m_size;
+    }
+
+    auto empty() const -> bool
+    {
+        return m_size == 0;
+    }
+
+    //***************************************************************************
+    // RING
+    //***************************************************************************
+
+    /*
+     * Arms the ring timeout at the earliest deadline, or moves it there if an
+     * earlier timer was scheduled since. To be called before each submit.
+     *
+     * @return false if the submission queue was full, arm() has to be called again
+     */
+    template <class Operations, class Ring> auto arm(Ring& ring) -> bool
+    {
+        if (m_armed && !m_rearm) {
+            return true;
+        }
+
+        const auto tick = nextTick();
+        if (tick == noTick || (m_armed && tick >= m_armedTick)) {
+            m_rearm = false;
+            return true;
+        }
+
+        if (!m_armed) {
+            if (!prepareTimeout<Operations>(ring, tick)) {
+                return false;
+            }
+        } else if (m_timeoutUpdate) {
+            m_updateOp.update.ts = timespecOf(tick);
+            m_updateOp.update.userData = Operations::encode(m_timeoutOp);
+            if (!ring.template prepare_operation<Operations>(m_updateOp)) {
+                return false;
+            }
+        } else {
+            // Removal completes the armed timeout with -ECANCELED, then the timeout
+            // is armed again with the same user data
+            if (ring.capacity() < 2) {
+                return false;
+            }
+            m_updateOp.remove.userData = Operations::encode(m_timeoutOp);
+            ring.template prepare_operation<Operations>(m_updateOp);
+            prepareTimeout<Operations>(ring, tick);
+        }
+
+        m_armed = true;
+        m_armedTick = tick;
+        m_rearm = false;
+        m_arms++;
+        return true;
+    }
+
+    /*
+     * Handles the completion of a TimeoutOp and calls onExpired(Timer&) for each
+     * expired timer once the armed timeout fired
+     *
+     * @return number of expired timers
+     */
+    template <class OnExpired>
+    auto complete(TimeoutOp& operation, TimeoutOp::result_type result, OnExpired&& onExpired)
+        -> std::size_t
+    {
+        // Completions of updates and of removed timeouts carry no expiry
+        if (&operation != &m_timeoutOp || result.error() == ECANCELED) {
+            return 0;
+        }
+        m_armed = false;
+        m_armedTick = noTick;
+        return expire(Clock::now(), onExpired);
+    }
+
+    /*
+     * Number of timeouts armed or moved on the ring, a measure for the submission
+     * queue entries the wheel needed
+     */
+    auto arms() const -> std::uint64_t
+    {
+        return m_arms;
+    }
+
+  private:
+    static constexpr std::uint64_t noTick = std::numeric_limits<std::uint64_t>::max();
+
+    static auto initList(Timer& head) -> void
+    {
+        head.m_next = &head;
+        head.m_prev = &head;
+    }
+
+    static auto detachList(Timer& head) -> void
+    {
+        for (auto timer = head.m_next; timer != &head;) {
+            auto next = timer->m_next;
+            timer->m_next = nullptr;
+            timer->m_prev = nullptr;
+            timer = next;
+        }
+        initList(head);
+    }
+
+    static auto pushList(Timer& head, Timer& timer) -> void
+    {
+        timer.m_prev = head.m_prev;
+        timer.m_next = &head;
+        head.m_prev->m_next = &timer;
+        head.m_prev = &timer;
+    }
+
+    /*
+     * Moves all timers of from to the end of to
+     */
+    static auto spliceList(Timer& from, Timer& to) -> void
+    {
+        if (from.m_next == &from) {
+            return;
+        }
+        from.m_next->m_prev = to.m_prev;
+        to.m_prev->m_next = from.m_next;
+        from.m_prev->m_next = &to;
+        to.m_prev = from.m_prev;
+        initList(from);
+    }
+
+    auto insert(Timer& timer) -> void
+    {
+        if (timer.m_tick <= m_now) {
+            pushList(m_due, timer);
+            return;
+        }
+
+        const auto delta = timer.m_tick - m_now;
+        for (std::size_t level = 0; level < levels; level++) {
+            if (delta < std::uint64_t { 1 } << (slotBits * (level + 1))) {
+                const auto slot = (timer.m_tick >> (slotBits * level)) & (slots - 1);
+                pushList(m_slots[level][slot], timer);
+                m_occupied[level] |= std::uint64_t { 1 } << slot;
+                return;
+            }
+        }
+        pushList(m_overflow, timer);
+    }
+
+    /*
+     * Moves the timers of the slots of the higher levels which m_now entered into
+     * the lower levels
+     */
+    auto cascade() -> void
+    {
+        for (std::size_t level = 1; level < levels; level++) {
+            const auto slot = (m_now >> (slotBits * level)) & (slots - 1);
+            reinsert(m_slots[level][slot]);
+            m_occupied[level] &= ~(std::uint64_t { 1 } << slot);
+            if (slot != 0) {
+                return;
+            }
+        }
+        reinsert(m_overflow);
+    }
+
+    auto reinsert(Timer& head) -> void
+    {
+        Timer timers;
+        initList(timers);
+        spliceList(head, timers);
+        while (timers.m_next != &timers) {
+            auto& timer = *timers.m_next;
+            timer.unlink();
+            insert(timer);
+        }
+    }
+
+    auto nextTick() const -> std::uint64_t
+    {
+        if (m_due.m_next != &m_due) {
+            return m_now;
+        }
+
+        auto tick = noTick;
+        for (std::size_t level = 0; level < levels; level++) {
+            const auto mask = m_occupied[level];
+            if (!mask) {
+                continue;
+            }
+            // Distance in slots to the next occupied slot after the current one,
+            // the current slot itself is reached after a full rotation
+            const auto shift = slotBits * level;
+            const auto index = (m_now >> shift) & (slots - 1);
+            const auto rotated = std::rotr(mask, static_cast<int>(index + 1));
+            const auto distance = static_cast<std::uint64_t>(std::countr_zero(rotated)) + 1;
+            tick = std::min(tick, ((m_now >> shift) + distance) << shift);
+        }
+        if (m_overflow.m_next != &m_overflow) {
+            const auto shift = slotBits * levels;
+            tick = std::min(tick, ((m_now >> shift) + 1) << shift);
+        }
+        return tick;
+    }
+
+    auto tickAtOrAfter(Clock::time_point time) const -> std::uint64_t
+    {
+        if (time <= m_start) {
+            return 0;
+        }
+        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(time - m_start);
+        return (elapsed.count() + m_resolution.count() - 1) / m_resolution.count();
+    }
+
+    auto tickAtOrBefore(Clock::time_point time) const -> std::uint64_t
+    {
+        if (time <= m_start) {
+            return 0;
+        }
+        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(time - m_start);
+        return elapsed.count() / m_resolution.count();
+    }
+
+    auto timeOf(std::uint64_t tick) const -> Clock::time_point
+    {
+        return m_start + std::chrono::duration_cast<Clock::duration>(m_resolution * tick);
+    }
+
+    /*
+     * CLOCK_MONOTONIC time of the tick, which steady_clock is based on
+     */
+    auto timespecOf(std::uint64_t tick) const -> __kernel_timespec
+    {
+        const auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            timeOf(tick).time_since_epoch());
+        return { .tv_sec = time.count() / 1000000000, .tv_nsec = time.count() % 1000000000 };
+    }
+
+    template <class Operations, class Ring>
+    auto prepareTimeout(Ring& ring, std::uint64_t tick) -> bool
+    {
+        m_timeoutOp.timeout.ts = timespecOf(tick);
+        return ring.template prepare_operation<Operations>(m_timeoutOp);
+    }
+
+    std::chrono::nanoseconds m_resolution;
+    Clock::time_point m_start;
+    bool m_timeoutUpdate;
+    // Last tick which was expired
+    std::uint64_t m_now = 0;
+    std::size_t m_size = 0;
+    std::array<std::array<Timer, slots>, levels> m_slots;
+    std::array<std::uint64_t, levels> m_occupied {};
+    Timer m_overflow;
+    // Timers scheduled at or before m_now, they expire with the next expire()
+    Timer m_due;
+
+    TimeoutOp m_timeoutOp;
+    TimeoutOp m_updateOp;
+    bool m_armed = false;
+    bool m_rearm = false;
+    std::uint64_t m_armedTick = noTick;
+    std::uint64_t m_arms = 0;
+};
+
+inline Timer::~Timer()
+{
+    if (m_wheel && scheduled()) {
+        m_wheel->cancel(*this);
+    }
+    unlink();
+}
+
+} // namespace uringpp
@@ -0,0 +1,404 @@
+#pragma once
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "liburing.h"
+
+namespace uringpp {
+
+enum class TraceEventType : std::uint8_t {
+    Prepare,
+    SubmitBegin,
+    SubmitEnd,
+    WaitBegin,
+    Reap,
+    Seen,
+};
+
+struct TraceEvent {
+    std::uint64_t timestampNs;
+    std::uint64_t userData;
+    std::int32_t fd;
+    // Result of submit, reap and seen
+    std::int32_t result;
+    std::uint32_t flags;
+    TraceEventType type;
+    std::uint8_t opcode;
+};
+
+/*
+ * Ring buffer of the trace events of one thread. Only the owning thread writes,
+ * the oldest events are overwritten once the buffer is full.
+ */
+class TraceBuffer {
+  public:
+    static constexpr std::size_t capacity = 1 << 16;
+
+    explicit TraceBuffer(int threadId)
+        : m_threadId(threadId)
+        , m_events(capacity)
+    {
+    }
+
+    auto push(const TraceEvent& event) -> void
+    {
+        const auto head = m_head.load(std::memory_order_relaxed);
+        m_events[head & (capacity - 1)] = event;
+        m_head.store(head + 1, std::memory_order_release);
+    }
+
+    /*
+     * Returns the retained events, oldest first
+     */
+    auto events() const -> std::vector<TraceEvent>
+    {
+        const auto head = m_head.load(std::memory_order_acquire);
+        const auto first = head > capacity ? head - capacity : 0;
+
+        std::vector<TraceEvent> events;
+        events.reserve(head - first);
+        for (auto index = first; index < head; index++) {
+            events.push_back(m_events[index & (capacity - 1)]);
+        }
+        return events;
+    }
+
+    auto clear() -> void
+    {
+        m_head.store(0, std::memory_order_release);
+    }
+
+    auto thread_id() const -> int
+    {
+        return m_threadId;
+    }
+
+  private:
+    int m_threadId;
+    std::vector<TraceEvent> m_events;
+    std::atomic<std::uint64_t> m_head { 0 };
+};
+
+/*
+ * Process wide timeline of the ring events of all threads.
+ *
+ * Rings with the TracingInstrumentation policy record their events into a buffer
+ * of the calling thread while tracing is enabled. Recording takes no lock, only
+ * the first event of a thread registers its buffer. While tracing is disabled a
+ * hook costs one relaxed atomic load.
+ *
+ * write_chrome_trace() writes the Chrome trace event JSON, which chrome://tracing
+ * and Perfetto open. It should be called after tracing was disabled, events which
+ * are recorded meanwhile may be torn.
+ */
+class Tracer {
+  public:
+    static auto enable() -> void
+    {
+        s_enabled.store(true, std::memory_order_relaxed);
+    }
+
+    static auto disable() -> void
+    {
+        s_enabled.store(false, std::memory_order_relaxed);
+    }
+
+    static auto enabled() -> bool
+    {
+        return s_enabled.load(std::memory_order_relaxed);
+    }
+
+    static auto record(
+        TraceEventType type,
+        std::uint8_t opcode,
+        std::int32_t fd,
+        std::uint64_t userData,
+        std::int32_t result,
+        std::uint32_t flags = 0) -> void
+    {
+        const auto timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now().time_since_epoch())
+                                   .count();
+        threadBuffer().push({ static_cast<std::uint64_t>(timestamp),
+                              userData,
+                              fd,
+                              result,
+                              flags,
+                              type,
+                              opcode });
+    }
+
+    /*
+     * Drops the recorded events of all threads
+     */
+    static auto clear() -> void
+    {
+        std::lock_guard lock(s_mutex);
+        for (auto& buffer : s_buffers) {
+            buffer->clear();
+        }
+    }
+
+    /*
+     * Writes the recorded events as Chrome trace event JSON:
+     *  - submit and wait calls as complete events on the thread
+     *  - each operation as async span from prepare to its last completion, with
+     *    an instant for each completion of a multishot operation
+     *  - the handling of each completion, from reap to seen, as complete event
+     */
+    static auto write_chrome_trace(std::ostream& stream) -> void
+    {
+        std::lock_guard lock(s_mutex);
+        const char* separator = "\n";
+        auto emit = [&](const std::string& event) {
+            stream << separator << event;
+            separator = ",\n";
+        };
+
+        // Operations may be reaped by another thread than they were prepared on
+        std::unordered_map<std::uint64_t, std::uint8_t> opcodes;
+
+        stream << "{\"traceEvents\":[";
+        for (const auto& buffer : s_buffers) {
+            const auto tid = std::to_string(buffer->thread_id());
+            const auto common = "\"pid\":" + std::to_string(getpid()) + ",\"tid\":" + tid;
+
+            std::unordered_map<std::uint64_t, std::uint64_t> reaped;
+            std::uint64_t submitBegin = 0;
+            std::uint64_t waitBegin = 0;
+
+            for (const auto& event : buffer->events()) {
+                const auto ts = microseconds(event.timestampNs);
+                const auto id = "\"id\":\"0x" + hex(event.userData) + "\"";
+
+                switch (event.type) {
+                case TraceEventType::Prepare:
+                    opcodes[event.userData] = event.opcode;
+                    emit("{\"name\":\"" + opcodeName(event.opcode) + "\",\"cat\":\"sqe\",\"ph\":\"b\","
+                         + id + ",\"ts\":" + ts + "," + common + ",\"args\":{\"fd\":"
+                         + std::to_string(event.fd) + "}}");
+                    break;
+                case TraceEventType::SubmitBegin:
+                    submitBegin = event.timestampNs;
+                    break;
+                case TraceEventType::SubmitEnd:
+                    emit(completeEvent("submit", "ring", submitBegin, event.timestampNs, common)
+                         + ",\"args\":{\"submitted\":" + std::to_string(event.result) + "}}");
+                    break;
+                case TraceEventType::WaitBegin:
+                    waitBegin = event.timestampNs;
+                    break;
+                case TraceEventType::Reap: {
+                    if (waitBegin) {
+                        emit(completeEvent("wait", "ring", waitBegin, event.timestampNs, common)
+                             + "}");
+                        waitBegin = 0;
+                    }
+                    reaped[event.userData] = event.timestampNs;
+
+                    auto opcode = opcodes.find(event.userData);
+                    const auto name = opcode == opcodes.end() ? std::string("unknown")
+                                                              : opcodeName(opcode->second);
+                    const bool more = event.flags & IORING_CQE_F_MORE;
+                    emit("{\"name\":\"" + name + "\",\"cat\":\"sqe\",\"ph\":\"" + (more ? "n" : "e")
+                         + "\"," + id + ",\"ts\":" + ts + "," + common
+                         + ",\"args\":{\"result\":" + std::to_string(event.result) + "}}");
+                    if (!more && opcode != opcodes.end()) {
+                        opcodes.erase(opcode);
+                    }
+                    break;
+                }
+                case TraceEventType::Seen: {
+                    auto reap = reaped.find(event.userData);
+                    if (reap != reaped.end()) {
+                        emit(completeEvent("handle", "cqe", reap->second, event.timestampNs, common)
+                             + ",\"args\":{\"user_data\":\"0x" + hex(event.userData)
+                             + "\",\"result\":" + std::to_string(event.result) + "}}");
+                        reaped.erase(reap);
+                    }
+                    break;
+                }
+                }
+            }
+        }
+        stream << "\n],\"displayTimeUnit\":\"ns\"}\n";
+    }
+
+  private:
+    static auto threadBuffer() -> TraceBuffer&
+    {
+        thread_local TraceBuffer* buffer = nullptr;
+        if (!buffer) {
+            // Buffers outlive their threads, so the events of exited threads can be written
+            auto owned = std::make_shared<TraceBuffer>(static_cast<int>(syscall(SYS_gettid)));
+            std::lock_guard lock(s_mutex);
+            s_buffers.push_back(owned);
+            buffer = owned.get();
+        }
+        return *buffer;
+    }
+
+    static auto microseconds(std::uint64_t nanoseconds) -> std::string
+    {
+        return std::to_string(nanoseconds / 1000) + "." + std::to_string(nanoseconds % 1000 / 100)
+            + std::to_string(nanoseconds % 100 / 10) + std::to_string(nanoseconds % 10);
+    }
+
+    static auto hex(std::uint64_t value) -> std::string
+    {
+        constexpr char digits[] = "0123456789abcdef";
+        std::string text;
+        do {
+            text.insert(text.begin(), digits[value & 0xf]);
+            value >>= 4;
+        } while (value);
+        return text;
+    }
+
+    static auto completeEvent(
+        const std::string& name,
+        const std::string& category,
+        std::uint64_t begin,
+        std::uint64_t end,
+        const std::string& common) -> std::string
+    {
+        const auto duration = end > begin ? end - begin : 0;
+        return "{\"name\":\"" + name + "\",\"cat\":\"" + category + "\",\"ph\":\"X\",\"ts\":"
+            + microseconds(begin) + ",\"dur\":" + microseconds(duration) + "," + common;
+    }
+
+    static auto opcodeName(std::uint8_t opcode) -> std::string
+    {
+        switch (opcode) {
+        case IORING_OP_NOP:
+            return "NOP";
+        case IORING_OP_READV:
+            return "READV";
+        case IORING_OP_WRITEV:
+            return "WRITEV";
+        case IORING_OP_FSYNC:
+            return "FSYNC";
+        case IORING_OP_READ_FIXED:
+            return "READ_FIXED";
+        case IORING_OP_WRITE_FIXED:
+            return "WRITE_FIXED";
+        case IORING_OP_POLL_ADD:
+            return "POLL_ADD";
+        case IORING_OP_POLL_REMOVE:
+            return "POLL_REMOVE";
+        case IORING_OP_SYNC_FILE_RANGE:
+            return "SYNC_FILE_RANGE";
+        case IORING_OP_SENDMSG:
+            return "SENDMSG";
+        case IORING_OP_RECVMSG:
+            return "RECVMSG";
+        case IORING_OP_TIMEOUT:
+            return "TIMEOUT";
+        case IORING_OP_TIMEOUT_REMOVE:
+            return "TIMEOUT_REMOVE";
+        case IORING_OP_ACCEPT:
+            return "ACCEPT";
+        case IORING_OP_ASYNC_CANCEL:
+            return "ASYNC_CANCEL";
+        case IORING_OP_LINK_TIMEOUT:
+            return "LINK_TIMEOUT";
+        case IORING_OP_CONNECT:
+            return "CONNECT";
+        case IORING_OP_FALLOCATE:
+            return "FALLOCATE";
+        case IORING_OP_OPENAT:
+            return "OPENAT";
+        case IORING_OP_CLOSE:
+            return "CLOSE";
+        case IORING_OP_STATX:
+            return "STATX";
+        case IORING_OP_READ:
+            return "READ";
+        case IORING_OP_WRITE:
+            return "WRITE";
+        case IORING_OP_SEND:
+            return "SEND";
+        case IORING_OP_RECV:
+            return "RECV";
+        case IORING_OP_EPOLL_CTL:
+            return "EPOLL_CTL";
+        case IORING_OP_SPLICE:
+            return "SPLICE";
+        case IORING_OP_PROVIDE_BUFFERS:
+            return "PROVIDE_BUFFERS";
+        case IORING_OP_SHUTDOWN:
+            return "SHUTDOWN";
+        default:
+            return "OP_" + std::to_string(opcode);
+        }
+    }
+
+    static inline std::atomic<bool> s_enabled { false };
+    static inline std::mutex s_mutex;
+    static inline std::vector<std::shared_ptr<TraceBuffer>> s_buffers;
+};
+
+namespace policy {
+
+/*
+ * Records the ring events into the Tracer while tracing is enabled
+ */
+struct TracingInstrumentation {
+    auto prepared(const io_uring_sqe* sqe) -> void
+    {
+        if (Tracer::enabled()) {
+            Tracer::record(TraceEventType::Prepare, sqe->opcode, sqe->fd, sqe->user_data, 0);
+        }
+    }
+    auto submitting() -> void
+    {
+        if (Tracer::enabled()) {
+            Tracer::record(TraceEventType::SubmitBegin, 0, -1, 0, 0);
+        }
+    }
+    auto submitted(int entries) -> void
+    {
+        if (Tracer::enabled()) {
+            Tracer::record(TraceEventType::SubmitEnd, 0, -1, 0, entries);
+        }
+    }
+    auto waiting() -> void
+    {
+        if (Tracer::enabled()) {
+            Tracer::record(TraceEventType::WaitBegin, 0, -1, 0, 0);
+        }
+    }
+    auto reaped(const io_uring_cqe* cqe) -> void
+    {
+        if (Tracer::enabled()) {
+            Tracer::record(TraceEventType::Reap, 0, -1, cqe->user_data, cqe->res, cqe->flags);
+        }
+    }
+    auto completed(const io_uring_cqe* cqe) -> void
+    {
+        if (Tracer::enabled()) {
+            Tracer::record(TraceEventType::Seen, 0, -1, cqe->user_data, cqe->res, cqe->flags);
+        }
+    }
+    auto sq_full() -> void
+    {
+    }
+    auto error() -> void
+    {
+    }
+};
+
+} // namespace policy
+
+} // namespace uringpp
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+#include "uringpp/CpuRelax.h"
+
+namespace uringpp {
+
+/*
+ * Strategies for Ring::wait(strategy).
+ *
+ * Spinning strategies poll the completion queue with peek() before they fall back
+ * to a blocking wait(). Completions only show up in the completion queue without
+ * entering the kernel if the ring was created without IORING_SETUP_COOP_TASKRUN
+ * and IORING_SETUP_DEFER_TASKRUN, otherwise spinning only burns cpu.
+ */
+
+/*
+ * Always enters the kernel and sleeps until a completion arrives
+ */
+struct BlockingWait {
+    template <class Ring> auto wait(Ring& ring)
+    {
+        return ring.wait();
+    }
+};
+
+/*
+ * Busy polls the completion queue for a fixed budget of iterations and time
+ * before it falls back to a blocking wait.
+ */
+class SpinThenBlockWait {
+  public:
+    /*
+     * @param[in] maxIterations maximum number of peeks before blocking
+     * @param[in] maxDuration maximum time spent spinning before blocking
+     */
+    explicit SpinThenBlockWait(
+        std::uint64_t maxIterations,
+        std::chrono::nanoseconds maxDuration = std::chrono::nanoseconds::max())
+        : m_maxIterations(maxIterations)
+        , m_maxDuration(maxDuration)
+    {
+    }
+
+    template <class Ring> auto wait(Ring& ring) -> decltype(ring.wait())
+    {
+        if (auto completion = spin(ring, m_maxIterations, m_maxDuration)) {
+            return *completion;
+        }
+        return ring.wait();
+    }
+
+    /*
+     * Peeks until a completion arrives or the budget is exhausted. The clock is
+     * only read every few iterations to keep the loop tight.
+     */
+    template <class Ring>
+    static auto spin(Ring& ring, std::uint64_t maxIterations, std::chrono::nanoseconds maxDuration)
+        -> decltype(ring.peek())
+    {
+        constexpr std::uint64_t clockInterval = 16;
+        const auto start = std::chrono::steady_clock::now();
+
+        for (std::uint64_t iteration = 0; iteration < maxIterations; iteration++) {
+            if (auto completion = ring.peek()) {
+                return completion;
+            }
+            if (iteration % clockInterval == clockInterval - 1
+                && std::chrono::steady_clock::now() - start >= maxDuration) {
+                break;
+            }
+            cpuRelax();
+        }
+        return {};
+    }
+
+  private:
+    std::uint64_t m_maxIterations;
+    std::chrono::nanoseconds m_maxDuration;
+};
+
+/*
+ * Spins for a budget derived from the recent completion inter-arrival times.
+ *
+ * The moving average of the inter-arrival time predicts when the next completion
+ * arrives. If it is expected within the maximum budget the strategy spins for a
+ * multiple of the average, otherwise it blocks right away instead of burning cpu.
+ */
+class AdaptiveSpinWait {
+  public:
+    /*
+     * @param[in] maxBudget upper bound of the spin time
+     * @param[in] minBudget lower bound of the spin time when spinning at all
+     */
+    explicit AdaptiveSpinWait(
+        std::chrono::nanoseconds maxBudget = std::chrono::microseconds(50),
+        std::chrono::nanoseconds minBudget = std::chrono::microseconds(1))
+        : m_maxBudget(maxBudget)
+        , m_minBudget(minBudget)
+        , m_averageInterArrival(minBudget)
+        , m_lastCompletion(std::chrono::steady_clock::now())
+    {
+    }
+
+    template <class Ring> auto wait(Ring& ring) -> decltype(ring.wait())
+    {
+        const auto budget = this->budget();
+        if (budget.count()) {
+            if (auto completion = SpinThenBlockWait::spin(
+                    ring, std::numeric_limits<std::uint64_t>::max(), budget)) {
+                observe();
+                return *completion;
+            }
+        }
+
+        auto completion = ring.wait();
+        observe();
+        return completion;
+    }
+
+    /*
+     * Returns the current spin budget, zero if the strategy blocks right away
+     */
+    auto budget() const -> std::chrono::nanoseconds
+    {
+        if (m_averageInterArrival > m_maxBudget) {
+            return std::chrono::nanoseconds { 0 };
+        }
+        return std::clamp(m_averageInterArrival * 2, m_minBudget, m_maxBudget);
+    }
+
+  private:
+    auto observe() -> void
+    {
+        // Exponential moving average with weight 1/8 for the new sample
+        const auto now = std::chrono::steady_clock::now();
+        const auto interArrival
+            = std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_lastCompletion);
+        m_averageInterArrival += (interArrival - m_averageInterArrival) / 8;
+        m_lastCompletion = now;
+    }
+
+    std::chrono::nanoseconds m_maxBudget;
+    std::chrono::nanoseconds m_minBudget;
+    std::chrono::nanoseconds m_averageInterArrival;
+    std::chrono::steady_clock::time_point m_lastCompletion;
+};
+
+} // namespace uringpp
@@ -2,4 +2,23 @@
 
 #pragma once
 
-#include "uringpp/Ring.h"
\ No newline at end of file
+#include "uringpp/AsyncAppendLog.h"
+#include "uringpp/AsyncFileReader.h"
+#include "uringpp/BufferPoolManager.h"
+#include "uringpp/Capabilities.h"
+#include "uringpp/ConnectionTable.h"
+#include "uringpp/CopyEngine.h"
+#include "uringpp/Datagram.h"
+#include "uringpp/FileLoader.h"
+#include "uringpp/Framing.h"
+#include "uringpp/FutexSync.h"
+#include "uringpp/Generator.h"
+#include "uringpp/KeyValueServer.h"
+#include "uringpp/KeyValueStore.h"
+#include "uringpp/LatencyHistogram.h"
+#include "uringpp/LineSplitter.h"
+#include "uringpp/MemcacheParser.h"
+#include "uringpp/Ring.h"
+#include "uringpp/TcpProxy.h"
+#include "uringpp/TimerWheel.h"
+#include "uringpp/Tracer.h"
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "tests_base.h"
+#include "uringpp/uringpp.h"
+
+using namespace uringpp;
+
+class AsyncAppendLogTests : public TemporaryDirectoryTest {
+  protected:
+    AsyncAppendLogTests()
+        : TemporaryDirectoryTest("uringpp_append_log_tests")
+        , m_file(m_directory / "append.log")
+    {
+        for (int record = 0; record < 20; record++) {
+            m_records.push_back("record " + std::to_string(record) + "\n");
+        }
+    }
+
+    auto expectedContent() const -> std::string
+    {
+        std::string content;
+        for (const auto& record : m_records) {
+            content += record;
+        }
+        return content;
+    }
+
+  protected:
+    std::filesystem::path m_file;
+    std::vector<std::string> m_records;
+};
+
+TEST_F(AsyncAppendLogTests, should_notify_appends_in_order_once_durable)
+{
+    AsyncAppendLog log(m_file);
+    std::vector<std::size_t> durable;
+
+    for (std::size_t record = 0; record < m_records.size(); record++) {
+        log.append(bytes(m_records[record]), [&, record](int error) {
+            ASSERT_EQ(0, error);
+            durable.push_back(record);
+        });
+    }
+    ASSERT_EQ(m_records.size(), log.pending());
+    log.flush();
+
+    ASSERT_EQ(m_records.size(), durable.size());
+    ASSERT_TRUE(std::is_sorted(durable.begin(), durable.end()));
+    ASSERT_EQ(log.size(), log.durable_size());
+    ASSERT_EQ(expectedContent(), readText(m_file));
+}
+
+TEST_F(AsyncAppendLogTests, should_cover_appends_with_one_sync_per_group)
+{
+    AsyncAppendLog log(m_file, { .maxGroupAppends = 8, .maxGroupsInFlight = 1 });
+    for (const auto& record : m_records) {
+        log.append(bytes(record), [](int) {});
+    }
+    log.flush();
+
+    ASSERT_EQ(3u, log.groups_committed());
+    ASSERT_EQ(expectedContent(), readText(m_file));
+}
+
+TEST_F(AsyncAppendLogTests, should_sync_file_range)
+{
+    AsyncAppendLog log(m_file, { .durability = Durability::SyncFileRange });
+    int notified = 0;
+    for (const auto& record : m_records) {
+        log.append(bytes(record), [&](int error) { notified += error == 0; });
+    }
+    log.flush();
+
+    ASSERT_EQ(static_cast<int>(m_records.size()), notified);
+    ASSERT_EQ(expectedContent(), readText(m_file));
+}
+
+TEST_F(AsyncAppendLogTests, should_append_at_end_of_existing_log)
+{
+    {
+        AsyncAppendLog log(m_file);
+        log.append(bytes(m_records[0]), [](int) {});
+        log.flush();
+    }
+
+    AsyncAppendLog log(m_file);
+    ASSERT_EQ(m_records[0].size(), log.append(bytes(m_records[1]), [](int) {}));
+    log.flush();
+
+    ASSERT_EQ(m_records[0] + m_records[1], readText(m_file));
+}
@@ -0,0 +1,114 @@
+#include <fcntl.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "tests_base.h"
+#include "uringpp/uringpp.h"
+
+using namespace uringpp;
+
+class AsyncFileReaderTests : public TemporaryDirectoryTest {
+  protected:
+    AsyncFileReaderTests()
+        : TemporaryDirectoryTest("uringpp_async_file_reader_tests")
+        , m_file(m_directory / "lines.txt")
+    {
+        for (int line = 0; line < 100; line++) {
+            m_content += "line " + std::to_string(line) + "\n";
+        }
+        m_content += "last line without newline";
+        std::ofstream(m_file, std::ios::binary) << m_content;
+    }
+
+    auto readAll(AsyncFileReader& reader) -> std::string
+    {
+        std::string content;
+        while (auto chunk = reader.next()) {
+            content += text(*chunk);
+        }
+        return content;
+    }
+
+  protected:
+    std::filesystem::path m_file;
+    std::string m_content;
+};
+
+TEST_F(AsyncFileReaderTests, should_read_chunks_in_order)
+{
+    AsyncFileReader reader(m_file, { .readAhead = 4, .chunkSize = 7 });
+
+    ASSERT_EQ(m_content, readAll(reader));
+    ASSERT_FALSE(reader.next());
+}
+
+TEST_F(AsyncFileReaderTests, should_read_file_smaller_than_read_ahead)
+{
+    AsyncFileReader reader(m_file, { .readAhead = 8, .chunkSize = 64 * 1024 });
+
+    ASSERT_EQ(m_content, readAll(reader));
+}
+
+TEST_F(AsyncFileReaderTests, should_read_from_offset_of_borrowed_descriptor)
+{
+    auto fd = open(m_file.c_str(), O_RDONLY);
+    {
+        AsyncFileReader reader(fd, { .readAhead = 2, .chunkSize = 16 }, 10);
+        ASSERT_EQ(m_content.substr(10), readAll(reader));
+    }
+    ASSERT_EQ(0, close(fd));
+}
+
+TEST_F(AsyncFileReaderTests, should_split_lines_across_chunks)
+{
+    AsyncFileReader reader(m_file, { .readAhead = 3, .chunkSize = 5 });
+    LineSplitter splitter;
+    std::vector<std::string> lines;
+    auto onLine = [&](std::string_view line) { lines.emplace_back(line); };
+
+    while (auto chunk = reader.next()) {
+        splitter.feed(*chunk, onLine);
+    }
+    splitter.finish(onLine);
+
+    ASSERT_EQ(101u, lines.size());
+    ASSERT_EQ("line 0", lines.front());
+    ASSERT_EQ("line 99", lines[99]);
+    ASSERT_EQ("last line without newline", lines.back());
+}
+
+TEST_F(AsyncFileReaderTests, should_throw_on_missing_file)
+{
+    ASSERT_THROW(AsyncFileReader("does_not_exist.txt"), std::runtime_error);
+}
+
+TEST(LineSplitterTests, should_find_byte_in_every_position)
+{
+    std::vector<std::uint8_t> buffer(40, 'x');
+    for (std::size_t position = 0; position < buffer.size(); position++) {
+        buffer[position] = '\n';
+        ASSERT_EQ(buffer.data() + position, findByte(buffer.data(), buffer.data() + buffer.size(), '\n'));
+        buffer[position] = 'x';
+    }
+    ASSERT_EQ(buffer.data() + buffer.size(), findByte(buffer.data(), buffer.data() + buffer.size(), '\n'));
+}
+
+TEST(LineSplitterTests, should_carry_incomplete_record)
+{
+    LineSplitter splitter;
+    std::vector<std::string> lines;
+    auto onLine = [&](std::string_view line) { lines.emplace_back(line); };
+
+    ASSERT_EQ(1u, splitter.feed(bytes("a\nb"), onLine));
+    ASSERT_EQ(1u, splitter.carried());
+    ASSERT_EQ(0u, splitter.feed(bytes("cd"), onLine));
+    ASSERT_EQ(2u, splitter.feed(bytes("\n\n"), onLine));
+    ASSERT_EQ(0u, splitter.finish(onLine));
+
+    ASSERT_EQ((std::vector<std::string> { "a", "bcd", "" }), lines);
+}
@@ -0,0 +1,239 @@
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <array>
+#include <sstream>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "uringpp/uringpp.h"
+
+using namespace uringpp;
+
+namespace {
+struct RecvOp : op::RecvBp {
+    std::size_t sizeClass;
+};
+
+using Operations = OperationSet<RecvOp, BufferPoolManager::ProvideBuffersOp>;
+}
+
+class BufferPoolManagerTests : public ::testing::Test {
+  protected:
+    BufferPoolManagerTests()
+        : m_ring(8)
+        , m_buffers({ { 256, 2 }, { 4096, 2 }, { 65536, 1 } }, 1)
+    {
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, m_sockets.data()) < 0) {
+            throw std::runtime_error("Failed to create socket pair");
+        }
+    }
+
+    ~BufferPoolManagerTests()
+    {
+        close(m_sockets[0]);
+        close(m_sockets[1]);
+    }
+
+    auto provide() -> void
+    {
+        m_buffers.provide<Operations>(m_ring);
+        m_ring.submit();
+        for (std::size_t i = 0; i < m_buffers.size_classes(); i++) {
+            auto completion = m_ring.wait();
+            ASSERT_GE(completion.result(), 0);
+            m_ring.seen(completion);
+        }
+    }
+
+    /*
+     * Waits for a provide buffers operation and returns it
+     */
+    auto completeProvide() -> BufferPoolManager::ProvideBuffersOp*
+    {
+        m_ring.submit();
+        auto completion = m_ring.wait();
+        BufferPoolManager::ProvideBuffersOp* provide = nullptr;
+        Operations::dispatch(
+            completion.get(),
+            Overloaded { [](RecvOp&, RecvOp::result_type) {},
+                         [&](BufferPoolManager::ProvideBuffersOp& op,
+                             BufferPoolManager::ProvideBuffersOp::result_type result) {
+                             EXPECT_TRUE(result.ok());
+                             m_buffers.provided(op);
+                             provide = &op;
+                         } });
+        m_ring.seen(completion);
+        return provide;
+    }
+
+    auto recv(std::size_t sizeClass) -> RecvOp::result_type
+    {
+        RecvOp recv {};
+        recv.fd = m_sockets[0];
+        recv.bufferPool = &m_buffers.pool(sizeClass);
+        recv.sizeClass = sizeClass;
+        m_ring.prepare_operation<Operations>(recv);
+        m_ring.submit();
+
+        auto completion = m_ring.wait();
+        auto result = RecvOp::result(completion.get());
+        m_ring.seen(completion);
+        return result;
+    }
+
+  protected:
+    std::array<int, 2> m_sockets;
+    Ring<void> m_ring;
+    BufferPoolManager m_buffers;
+};
+
+TEST_F(BufferPoolManagerTests, should_select_smallest_fitting_size_class)
+{
+    ASSERT_EQ(0u, m_buffers.size_class_for(0));
+    ASSERT_EQ(0u, m_buffers.size_class_for(256));
+    ASSERT_EQ(1u, m_buffers.size_class_for(257));
+    ASSERT_EQ(2u, m_buffers.size_class_for(65536));
+    ASSERT_EQ(2u, m_buffers.size_class_for(1 << 20));
+}
+
+TEST_F(BufferPoolManagerTests, should_assign_group_id_per_size_class)
+{
+    ASSERT_EQ(1u, m_buffers.pool(0).group_id());
+    ASSERT_EQ(2u, m_buffers.pool(1).group_id());
+    ASSERT_EQ(3u, m_buffers.pool(2).group_id());
+}
+
+TEST(SizeClassSelectorTests, should_follow_observed_message_sizes)
+{
+    SizeClassSelector selector;
+    ASSERT_EQ(0u, selector.expected_size());
+
+    selector.observe(100, false);
+    ASSERT_EQ(100u, selector.expected_size());
+
+    selector.observe(256, true);
+    ASSERT_EQ(512u, selector.expected_size());
+
+    for (int i = 0; i < 64; i++) {
+        selector.observe(100, false);
+    }
+    ASSERT_LT(selector.expected_size(), 128u);
+}
+
+TEST_F(BufferPoolManagerTests, should_receive_into_size_class)
+{
+    provide();
+
+    const std::string message = "hello";
+    ASSERT_EQ(5, write(m_sockets[1], message.data(), message.size()));
+
+    auto result = recv(0);
+    ASSERT_TRUE(result.ok());
+    ASSERT_EQ(message.size(), result.value());
+
+    auto buffer = m_buffers.buffer(0, result.buffer_idx());
+    ASSERT_EQ(256u, buffer.size());
+    ASSERT_EQ(message, std::string(reinterpret_cast<const char*>(buffer.data()), result.value()));
+}
+
+TEST_F(BufferPoolManagerTests, should_grow_size_class_when_out_of_buffers)
+{
+    provide();
+
+    const char byte = '!';
+    for (int i = 0; i < 3; i++) {
+        ASSERT_EQ(1, write(m_sockets[1], &byte, 1));
+        auto result = recv(0);
+        if (i < 2) {
+            ASSERT_TRUE(result.ok());
+            m_buffers.acquired(0, result.value());
+            continue;
+        }
+
+        ASSERT_EQ(ENOBUFS, result.error());
+        ASSERT_TRUE(m_buffers.grow<Operations>(m_ring, 0));
+        completeProvide();
+
+        result = recv(0);
+        ASSERT_TRUE(result.ok());
+        ASSERT_GE(result.buffer_idx(), 2u);
+        m_buffers.acquired(0, result.value());
+    }
+
+    const auto usage = m_buffers.usage();
+    ASSERT_EQ(4u, usage[0].buffers);
+    ASSERT_EQ(3u, usage[0].inUse);
+    ASSERT_EQ(1u, usage[0].grows);
+    ASSERT_EQ(1u, usage[0].noBuffers);
+    ASSERT_EQ(3u, usage[0].receives);
+
+    std::stringstream report;
+    m_buffers.report(report);
+    ASSERT_NE(std::string::npos, report.str().find("size class 256 B"));
+}
+
+TEST_F(BufferPoolManagerTests, should_release_buffer_to_the_kernel)
+{
+    provide();
+
+    const char byte = '!';
+    ASSERT_EQ(1, write(m_sockets[1], &byte, 1));
+    auto result = recv(2);
+    ASSERT_TRUE(result.ok());
+    m_buffers.acquired(2, result.value());
+
+    ASSERT_TRUE(m_buffers.release<Operations>(m_ring, 2, result.buffer_idx()));
+    m_ring.submit();
+    auto completion = m_ring.wait();
+    ASSERT_GE(completion.result(), 0);
+    m_ring.seen(completion);
+    ASSERT_EQ(0u, m_buffers.usage()[2].inUse);
+
+    ASSERT_EQ(1, write(m_sockets[1], &byte, 1));
+    ASSERT_TRUE(recv(2).ok());
+}
+
+TEST_F(BufferPoolManagerTests, should_grow_once_per_shortage)
+{
+    provide();
+
+    ASSERT_TRUE(m_buffers.grow<Operations>(m_ring, 0));
+    ASSERT_TRUE(m_buffers.grow<Operations>(m_ring, 0));
+    ASSERT_EQ(4u, m_buffers.usage()[0].buffers);
+
+    ASSERT_NE(nullptr, completeProvide());
+    ASSERT_TRUE(m_buffers.grow<Operations>(m_ring, 0));
+    completeProvide();
+
+    const auto usage = m_buffers.usage();
+    ASSERT_EQ(6u, usage[0].buffers);
+    ASSERT_EQ(2u, usage[0].grows);
+    ASSERT_EQ(3u, usage[0].noBuffers);
+}
+
+TEST_F(BufferPoolManagerTests, should_resume_parked_receives_when_buffers_are_provided)
+{
+    provide();
+    ParkedReceives<int> parked(m_buffers.size_classes());
+    std::vector<int> resumed;
+    const auto resume = [&](int receiver) { resumed.push_back(receiver); };
+
+    for (int receiver = 0; receiver < 4; receiver++) {
+        parked.park<Operations>(m_ring, m_buffers, 0, receiver);
+    }
+    ASSERT_TRUE(parked.remove(1));
+    ASSERT_EQ(1u, m_buffers.usage()[0].grows);
+
+    // The grown chunk of two buffers serves two receivers
+    parked.provided(m_buffers, *completeProvide(), resume);
+    ASSERT_EQ((std::vector<int> { 0, 2 }), resumed);
+
+    // A released buffer serves one
+    m_buffers.acquired(0, 1);
+    m_buffers.release<Operations>(m_ring, 0, 0);
+    parked.provided(m_buffers, *completeProvide(), resume);
+    ASSERT_EQ((std::vector<int> { 0, 2, 3 }), resumed);
+    ASSERT_EQ(0u, parked.size());
+}
@@ -0,0 +1,114 @@
+#include <set>
+
+#include <gtest/gtest.h>
+
+#include "uringpp/ConnectionTable.h"
+
+using namespace uringpp;
+
+struct State {
+    int value = 0;
+};
+
+class ConnectionTableTests : public ::testing::Test {
+  protected:
+    ConnectionTableTests()
+        : m_connections(4)
+    {
+    }
+
+  protected:
+    ConnectionTable<State> m_connections;
+};
+
+TEST_F(ConnectionTableTests, should_open_connection_by_index)
+{
+    m_connections.open(2).value = 42;
+
+    ASSERT_TRUE(m_connections.contains(2));
+    ASSERT_EQ(42, m_connections.at(2).value);
+    ASSERT_EQ(1u, m_connections.size());
+}
+
+TEST_F(ConnectionTableTests, should_fail_to_open_connection_twice)
+{
+    m_connections.open(2);
+    ASSERT_THROW(m_connections.open(2), std::logic_error);
+}
+
+TEST_F(ConnectionTableTests, should_fail_to_open_connection_beyond_capacity)
+{
+    ASSERT_THROW(m_connections.open(4), std::out_of_range);
+}
+
+TEST_F(ConnectionTableTests, should_allocate_free_slots)
+{
+    m_connections.open(0);
+    ASSERT_EQ(1, m_connections.allocate());
+    ASSERT_EQ(2, m_connections.allocate());
+    ASSERT_EQ(3, m_connections.allocate());
+    ASSERT_EQ(-1, m_connections.allocate());
+}
+
+TEST_F(ConnectionTableTests, should_release_closed_connection_without_pending_ops)
+{
+    m_connections.open(1).value = 42;
+
+    ASSERT_TRUE(m_connections.close(1));
+    ASSERT_FALSE(m_connections.contains(1));
+    ASSERT_EQ(0, m_connections.open(1).value);
+}
+
+TEST_F(ConnectionTableTests, should_release_closed_connection_after_last_pending_op)
+{
+    m_connections.open(1);
+    m_connections.acquire(1);
+    m_connections.acquire(1);
+
+    ASSERT_FALSE(m_connections.close(1));
+    ASSERT_TRUE(m_connections.closing(1));
+    ASSERT_FALSE(m_connections.release(1));
+    ASSERT_TRUE(m_connections.release(1));
+    ASSERT_FALSE(m_connections.contains(1));
+    ASSERT_EQ(0u, m_connections.size());
+}
+
+TEST_F(ConnectionTableTests, should_fail_to_release_connection_without_pending_op)
+{
+    m_connections.open(1);
+    m_connections.acquire(1);
+    m_connections.close(1);
+    ASSERT_TRUE(m_connections.release(1));
+
+    ASSERT_THROW(m_connections.release(1), std::logic_error);
+    ASSERT_THROW(m_connections.release(2), std::logic_error);
+}
+
+TEST_F(ConnectionTableTests, should_fail_to_close_connection_twice)
+{
+    m_connections.open(1);
+    m_connections.acquire(1);
+    m_connections.close(1);
+    ASSERT_THROW(m_connections.close(1), std::logic_error);
+    ASSERT_TRUE(m_connections.release(1));
+
+    ASSERT_THROW(m_connections.close(1), std::logic_error);
+    ASSERT_THROW(m_connections.close(2), std::logic_error);
+
+    // Each slot is handed out once
+    std::set<std::int32_t> allocated;
+    for (std::size_t i = 0; i < m_connections.capacity(); i++) {
+        allocated.insert(m_connections.allocate());
+    }
+    ASSERT_EQ(m_connections.capacity(), allocated.size());
+    ASSERT_EQ(-1, m_connections.allocate());
+}
+
+TEST_F(ConnectionTableTests, should_place_connections_on_separate_cache_lines)
+{
+    auto first = reinterpret_cast<std::uintptr_t>(&m_connections.at(0));
+    auto second = reinterpret_cast<std::uintptr_t>(&m_connections.at(1));
+
+    ASSERT_EQ(0u, first % 64);
+    ASSERT_EQ(0u, second % 64);
+}
@@ -0,0 +1,173 @@
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "tests_base.h"
+#include "uringpp/uringpp.h"
+
+using namespace uringpp;
+
+class CopyEngineTests : public TemporaryDirectoryTest {
+  protected:
+    CopyEngineTests()
+        : TemporaryDirectoryTest("uringpp_copy_engine_tests")
+        , m_input("test2.txt")
+        , m_output(m_directory / "output.txt")
+    {
+    }
+
+  protected:
+    std::filesystem::path m_input;
+    std::filesystem::path m_output;
+};
+
+TEST(CapabilitiesTests, should_probe_kernel_once)
+{
+    ASSERT_EQ(&Capabilities::get(), &Capabilities::get());
+    ASSERT_TRUE(Capabilities::get().probed());
+    ASSERT_TRUE(Capabilities::get().supports(IORING_OP_NOP));
+    ASSERT_FALSE(Capabilities::get().supports(-1));
+}
+
+TEST(CapabilitiesTests, should_support_nothing_without_probe)
+{
+    ASSERT_FALSE(Capabilities::none().probed());
+    ASSERT_FALSE(Capabilities::none().supports(IORING_OP_NOP));
+    ASSERT_FALSE(Capabilities::none().has_read_write());
+}
+
+TEST_F(CopyEngineTests, should_copy_file_with_blocks_smaller_than_file)
+{
+    CopyEngine copyEngine({ .queueDepth = 2, .blockSize = 3 });
+    ASSERT_EQ(CopyPath::ReadWrite, copyEngine.path());
+
+    ASSERT_EQ(std::filesystem::file_size(m_input), copyEngine.copy(m_input, m_output));
+    ASSERT_EQ(readText(m_input), readText(m_output));
+}
+
+TEST_F(CopyEngineTests, should_fall_back_to_readv_writev)
+{
+    CopyEngine copyEngine({ .queueDepth = 4, .blockSize = 5 }, Capabilities::none());
+    ASSERT_EQ(CopyPath::ReadvWritev, copyEngine.path());
+
+    ASSERT_EQ(std::filesystem::file_size(m_input), copyEngine.copy(m_input, m_output));
+    ASSERT_EQ(readText(m_input), readText(m_output));
+}
+
+TEST_F(CopyEngineTests, should_reuse_engine_for_multiple_copies)
+{
+    CopyEngine copyEngine({ .queueDepth = 2, .blockSize = 4 });
+    copyEngine.copy(m_input, m_output);
+    copyEngine.copy(m_input, m_output);
+
+    ASSERT_EQ(readText(m_input), readText(m_output));
+}
+
+TEST_F(CopyEngineTests, should_only_copy_data_extents_of_sparse_file)
+{
+    const auto sparseInput = m_directory / "sparse_input.img";
+    const std::size_t size = 16 * 1024 * 1024;
+    {
+        std::ofstream stream(sparseInput, std::ios::binary);
+        stream << "head";
+        stream.seekp(size / 2);
+        stream << "middle";
+    }
+    std::filesystem::resize_file(sparseInput, size);
+
+    CopyEngine copyEngine;
+    const auto copied = copyEngine.copy(sparseInput, m_output);
+
+    ASSERT_EQ(size, std::filesystem::file_size(m_output));
+    ASSERT_EQ(readText(sparseInput), readText(m_output));
+    ASSERT_LT(copied, size);
+
+    struct stat outputStat;
+    stat(m_output.c_str(), &outputStat);
+    ASSERT_LT(static_cast<std::size_t>(outputStat.st_blocks) * 512, size);
+}
+
+TEST_F(CopyEngineTests, should_punch_holes_into_existing_output)
+{
+    const auto sparseInput = m_directory / "sparse_input.img";
+    const std::size_t size = 1024 * 1024;
+    std::ofstream(sparseInput, std::ios::binary).close();
+    std::filesystem::resize_file(sparseInput, size);
+    std::ofstream(m_output, std::ios::binary) << std::string(size, 'x');
+
+    auto input = open(sparseInput.c_str(), O_RDONLY);
+    auto output = open(m_output.c_str(), O_WRONLY);
+    CopyEngine copyEngine;
+    ASSERT_EQ(0u, copyEngine.copy(input, output, 0, size));
+    close(input);
+    close(output);
+
+    ASSERT_EQ(readText(sparseInput), readText(m_output));
+}
+
+TEST_F(CopyEngineTests, should_compute_digest_while_copying)
+{
+    for (std::size_t checksumThreads : { 0, 2 }) {
+        CopyEngine copyEngine({ .queueDepth = 4,
+                                .blockSize = 5,
+                                .checksum = true,
+                                .checksumThreads = checksumThreads });
+        copyEngine.copy(m_input, m_output);
+
+        const auto content = readText(m_input);
+        ASSERT_EQ(crc32c(bytes(content)), copyEngine.digest());
+        ASSERT_EQ(content, readText(m_output));
+    }
+}
+
+TEST_F(CopyEngineTests, should_include_holes_in_digest)
+{
+    const auto sparseInput = m_directory / "sparse_input.img";
+    {
+        std::ofstream stream(sparseInput, std::ios::binary);
+        stream.seekp(1024 * 1024);
+        stream << "data";
+    }
+    std::filesystem::resize_file(sparseInput, 2 * 1024 * 1024);
+
+    CopyEngine copyEngine({ .checksum = true });
+    copyEngine.copy(sparseInput, m_output);
+
+    const auto content = readText(sparseInput);
+    ASSERT_EQ(crc32c(bytes(content)), copyEngine.digest());
+}
+
+TEST_F(CopyEngineTests, should_tune_queue_depth_and_block_size_within_memory_limit)
+{
+    const auto largeInput = m_directory / "tune_input.bin";
+    {
+        std::ofstream stream(largeInput, std::ios::binary);
+        for (int i = 0; i < 48 * 1024; i++) {
+            stream << std::string(1023, static_cast<char>('a' + i % 26)) << '\n';
+        }
+    }
+
+    const std::size_t memoryLimit = 1024 * 1024;
+    CopyEngine copyEngine({ .autoTune = true, .memoryLimit = memoryLimit });
+    copyEngine.copy(largeInput, m_output);
+
+    ASSERT_EQ(readText(largeInput), readText(m_output));
+    ASSERT_FALSE(copyEngine.probes().empty());
+    for (const auto& probe : copyEngine.probes()) {
+        ASSERT_LE(probe.queueDepth * probe.blockSize, memoryLimit);
+        ASSERT_GT(probe.bytesPerSecond, 0);
+    }
+    ASSERT_LE(copyEngine.options().queueDepth * copyEngine.options().blockSize, memoryLimit);
+}
+
+TEST_F(CopyEngineTests, should_throw_on_missing_input)
+{
+    CopyEngine copyEngine;
+    ASSERT_THROW(copyEngine.copy("does_not_exist.txt", m_output), std::runtime_error);
+}
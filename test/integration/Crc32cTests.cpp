@@ -0,0 +1,44 @@
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "tests_base.h"
+#include "uringpp/Crc32c.h"
+
+using namespace uringpp;
+
+TEST(Crc32cTests, should_compute_check_value)
+{
+    ASSERT_EQ(0xE3069283u, crc32c(bytes("123456789")));
+    ASSERT_EQ(0u, crc32c(bytes("")));
+}
+
+TEST(Crc32cTests, should_match_table_implementation_for_large_buffers)
+{
+    std::vector<std::uint8_t> data(100 * 1024 + 7);
+    for (std::size_t i = 0; i < data.size(); i++) {
+        data[i] = static_cast<std::uint8_t>(i * 31 + 7);
+    }
+
+    ASSERT_EQ(~detail::crc32cSoftware(~0u, data.data(), data.size()), crc32c(data));
+}
+
+TEST(Crc32cTests, should_continue_and_combine_crcs)
+{
+    const std::string first = "hello ";
+    const std::string second = "world";
+    const auto crc = crc32c(bytes(first + second));
+
+    ASSERT_EQ(crc, crc32c(bytes(second), crc32c(bytes(first))));
+    ASSERT_EQ(crc, crc32cCombine(crc32c(bytes(first)), crc32c(bytes(second)), second.size()));
+}
+
+TEST(Crc32cTests, should_append_zeros)
+{
+    const std::string data = "data";
+    const std::string zeros(1000, '\0');
+
+    ASSERT_EQ(crc32c(bytes(data + zeros)), crc32cAppendZeros(crc32c(bytes(data)), zeros.size()));
+    ASSERT_EQ(crc32c(bytes(zeros)), crc32cAppendZeros(0, zeros.size()));
+}
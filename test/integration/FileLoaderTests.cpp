@@ -0,0 +1,85 @@
+#include <cerrno>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "tests_base.h"
+#include "uringpp/uringpp.h"
+
+using namespace uringpp;
+
+class FileLoaderTests : public TemporaryDirectoryTest {
+  protected:
+    FileLoaderTests()
+        : TemporaryDirectoryTest("uringpp_file_loader_tests")
+    {
+    }
+
+    auto write(const std::string& name, const std::string& content) -> std::filesystem::path
+    {
+        auto path = m_directory / name;
+        std::ofstream(path, std::ios::binary) << content;
+        m_paths.push_back(path);
+        m_contents.push_back(content);
+        return path;
+    }
+
+  protected:
+    std::vector<std::filesystem::path> m_paths;
+    std::vector<std::string> m_contents;
+};
+
+TEST_F(FileLoaderTests, should_load_files_in_order_of_paths)
+{
+    for (int i = 0; i < 1000; i++) {
+        write(std::to_string(i) + ".conf", "value " + std::to_string(i) + "\n");
+    }
+
+    const auto files = load_all(m_paths, { .batchSize = 16, .readSize = 64, .blockSize = 1024 });
+
+    ASSERT_EQ(m_paths.size(), files.size());
+    std::size_t bytes = 0;
+    for (std::size_t i = 0; i < files.size(); i++) {
+        ASSERT_TRUE(files[i].ok()) << strerror(files[i].error);
+        ASSERT_EQ(m_contents[i], text(files[i].data));
+        bytes += m_contents[i].size();
+    }
+    ASSERT_EQ(bytes, files.bytes());
+}
+
+TEST_F(FileLoaderTests, should_load_empty_and_files_larger_than_staging_buffer)
+{
+    write("empty", "");
+    write("exact", std::string(4096, 'e'));
+    write("large", std::string(3 * 4096 + 17, 'l'));
+    write("huge", std::string(100000, 'h'));
+
+    FileLoader loader({ .batchSize = 2, .readSize = 4096, .blockSize = 16384 });
+    const auto files = loader.load_all(m_paths);
+
+    for (std::size_t i = 0; i < files.size(); i++) {
+        ASSERT_TRUE(files[i].ok()) << strerror(files[i].error);
+        ASSERT_EQ(m_contents[i], text(files[i].data));
+    }
+}
+
+TEST_F(FileLoaderTests, should_report_error_of_missing_file_and_load_the_others)
+{
+    write("first", "first");
+    m_paths.push_back(m_directory / "missing");
+    m_contents.push_back("");
+    write("last", "last");
+
+    FileLoader loader({ .batchSize = 4 });
+    for (int run = 0; run < 2; run++) {
+        const auto files = loader.load_all(m_paths);
+
+        ASSERT_EQ("first", text(files[0].data));
+        ASSERT_EQ(ENOENT, files[1].error);
+        ASSERT_TRUE(files[1].data.empty());
+        ASSERT_EQ("last", text(files[2].data));
+    }
+}
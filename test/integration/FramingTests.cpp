@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+
+#include "uringpp/Framing.h"
+
+#include <string>
+#include <vector>
+
+using namespace uringpp;
+
+namespace {
+auto bytes(std::string_view data) -> std::span<const std::uint8_t>
+{
+    return { reinterpret_cast<const std::uint8_t*>(data.data()), data.size() };
+}
+
+auto lengthPrefixed(const std::vector<std::string>& payloads) -> std::string
+{
+    LengthPrefixFraming framing;
+    std::string stream;
+    for (const auto& payload : payloads) {
+        std::uint8_t prefix[4];
+        framing.encode(payload.size(), prefix);
+        stream.append(reinterpret_cast<const char*>(prefix), sizeof(prefix));
+        stream += payload;
+    }
+    return stream;
+}
+
+/*
+ * Feeds the stream as buffers of bufferSize bytes with consecutive buffer ids and
+ * checks that every buffer is released once, in order
+ */
+template <class Framing>
+auto decode(FrameDecoder<Framing>& decoder, std::string_view stream, std::size_t bufferSize)
+    -> std::vector<std::string>
+{
+    std::vector<std::string> frames;
+    std::size_t released = 0;
+    std::size_t bufferId = 0;
+    for (std::size_t offset = 0; offset < stream.size(); offset += bufferSize, bufferId++) {
+        const auto ok = decoder.feed(
+            bufferId,
+            bytes(stream.substr(offset, bufferSize)),
+            [&](std::span<const std::uint8_t> frame) {
+                frames.emplace_back(reinterpret_cast<const char*>(frame.data()), frame.size());
+            },
+            [&](std::size_t id) { EXPECT_EQ(released++, id); });
+        EXPECT_TRUE(ok);
+    }
+    EXPECT_EQ(bufferId - decoder.held_buffers(), released);
+    return frames;
+}
+}
+
+TEST(FramingTests, should_encode_big_endian_length_prefix)
+{
+    std::uint8_t prefix[4];
+
+    ASSERT_EQ(4u, LengthPrefixFraming {}.encode(0x01020304, prefix));
+    ASSERT_EQ((std::vector<std::uint8_t> { 1, 2, 3, 4 }), std::vector(prefix, prefix + 4));
+}
+
+TEST(FramingTests, should_hand_out_frames_within_buffer_without_copy)
+{
+    const auto stream = lengthPrefixed({ "first", "", "second" });
+    FrameDecoder<LengthPrefixFraming> decoder;
+    std::vector<const std::uint8_t*> frames;
+    std::vector<std::size_t> released;
+
+    decoder.feed(
+        7,
+        bytes(stream),
+        [&](std::span<const std::uint8_t> frame) { frames.push_back(frame.data()); },
+        [&](std::size_t bufferId) { released.push_back(bufferId); });
+
+    ASSERT_EQ(3u, frames.size());
+    ASSERT_EQ(bytes(stream).data() + 4, frames[0]);
+    ASSERT_EQ(bytes(stream).data() + 17, frames[2]);
+    ASSERT_EQ(0u, decoder.gathered());
+    ASSERT_EQ(std::vector<std::size_t> { 7 }, released);
+}
+
+TEST(FramingTests, should_gather_frames_straddling_buffers)
+{
+    const std::vector<std::string> payloads {
+        "a", "frame of some length", "", std::string(300, 'x')
+    };
+    const auto stream = lengthPrefixed(payloads);
+
+    for (std::size_t bufferSize = 1; bufferSize <= stream.size(); bufferSize++) {
+        FrameDecoder<LengthPrefixFraming> decoder(LengthPrefixFraming {}, 1000);
+        ASSERT_EQ(payloads, decode(decoder, stream, bufferSize)) << bufferSize;
+        ASSERT_EQ(0u, decoder.buffered());
+    }
+}
+
+TEST(FramingTests, should_compact_partial_frame_holding_too_many_buffers)
+{
+    const std::vector<std::string> payloads { std::string(10000, 'x'), "small" };
+    const auto stream = lengthPrefixed(payloads);
+    FrameDecoder<LengthPrefixFraming> decoder(LengthPrefixFraming {}, 4);
+    std::size_t maxHeld = 0;
+
+    std::vector<std::string> frames;
+    std::size_t bufferId = 0;
+    for (std::size_t offset = 0; offset < stream.size(); offset += 100) {
+        decoder.feed(
+            bufferId++,
+            bytes(std::string_view(stream).substr(offset, 100)),
+            [&](std::span<const std::uint8_t> frame) {
+                frames.emplace_back(reinterpret_cast<const char*>(frame.data()), frame.size());
+            },
+            [](std::size_t) {});
+        maxHeld = std::max(maxHeld, decoder.held_buffers());
+    }
+
+    ASSERT_EQ(payloads, frames);
+    ASSERT_LE(maxHeld, 4u);
+}
+
+TEST(FramingTests, should_split_delimited_frames)
+{
+    const std::string stream = "GET /\r\nHost: x\r\n\r\n" + std::string(500, 'y') + "\r\n";
+
+    for (std::size_t bufferSize = 1; bufferSize <= stream.size(); bufferSize++) {
+        FrameDecoder<DelimiterFraming> decoder(DelimiterFraming { '\n', 1024 }, 1000);
+        const std::vector<std::string> expected {
+            "GET /\r", "Host: x\r", "\r", std::string(500, 'y') + "\r"
+        };
+        ASSERT_EQ(expected, decode(decoder, stream, bufferSize)) << bufferSize;
+    }
+}
+
+TEST(FramingTests, should_reject_frames_exceeding_maximum_size)
+{
+    auto ignore = [](auto) {};
+
+    FrameDecoder<LengthPrefixFraming> lengthDecoder(LengthPrefixFraming { 2, 100 });
+    ASSERT_FALSE(lengthDecoder.feed(0, bytes(std::string_view("\x00\x65", 2)), ignore, ignore));
+
+    FrameDecoder<DelimiterFraming> delimiterDecoder(DelimiterFraming { '\n', 100 });
+    ASSERT_TRUE(delimiterDecoder.feed(0, bytes(std::string(100, 'x')), ignore, ignore));
+    ASSERT_FALSE(delimiterDecoder.feed(1, bytes("x"), ignore, ignore));
+}
+
+TEST(FramingTests, should_find_bytes_across_segments)
+{
+    SegmentedBuffer buffer;
+    buffer.append(0, bytes("abc"));
+    buffer.append(1, bytes(""));
+    buffer.append(2, bytes("def"));
+
+    ASSERT_EQ(4u, buffer.find('e'));
+    ASSERT_EQ(4u, buffer.find('e', 4));
+    ASSERT_EQ(SegmentedBuffer::npos, buffer.find('e', 5));
+    ASSERT_EQ(SegmentedBuffer::npos, buffer.find('x'));
+}
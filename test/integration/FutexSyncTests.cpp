@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+
+#include "uringpp/uringpp.h"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace uringpp;
+
+namespace {
+using Operations = OperationSet<op::FutexWait, op::FutexWake, op::FutexWaitv>;
+
+/*
+ * Waits for the completion of a futex operation of the ring
+ */
+template <class Ring> auto waitForFutex(Ring& ring) -> int
+{
+    auto completion = ring.wait();
+    int result = 0;
+    Operations::dispatch(
+        completion.get(),
+        Overloaded {
+            [&](op::FutexWait&, op::FutexWait::result_type r) { result = r.error(); },
+            [&](op::FutexWake&, op::FutexWake::result_type r) { result = r.error(); },
+            [&](op::FutexWaitv&, op::FutexWaitv::result_type r) {
+                result = static_cast<int>(r.value());
+            } });
+    ring.seen(completion);
+    return result;
+}
+}
+
+class FutexSyncTests : public ::testing::Test {
+  protected:
+    void SetUp() override
+    {
+        if (!Capabilities::get().has_futex()) {
+            GTEST_SKIP() << "io_uring futex operations need Linux 6.7";
+        }
+    }
+
+    Ring<void> m_ring { 8 };
+};
+
+TEST(AsyncMutexTests, should_exclude_threads_which_lock_blocking)
+{
+    AsyncMutex mutex;
+    std::uint64_t counter = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 100000; i++) {
+                std::lock_guard lock(mutex);
+                counter++;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(400000u, counter);
+}
+
+TEST_F(FutexSyncTests, should_lock_mutex_on_ring_once_unlocked)
+{
+    AsyncMutex mutex;
+    mutex.lock();
+
+    op::FutexWait wait;
+    ASSERT_EQ(AcquireStatus::Waiting, mutex.lock<Operations>(m_ring, wait));
+    m_ring.submit();
+
+    std::thread unlocker([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        mutex.unlock();
+    });
+    auto status = AcquireStatus::Waiting;
+    while (status == AcquireStatus::Waiting) {
+        waitForFutex(m_ring);
+        status = mutex.complete<Operations>(m_ring, wait);
+        m_ring.submit();
+    }
+    unlocker.join();
+
+    ASSERT_EQ(AcquireStatus::Acquired, status);
+    ASSERT_FALSE(mutex.try_lock());
+    mutex.unlock();
+    ASSERT_TRUE(mutex.try_lock());
+}
+
+TEST_F(FutexSyncTests, should_hand_items_of_producer_thread_to_ring_consumer)
+{
+    AsyncQueue<int> queue;
+    constexpr int count = 10000;
+    std::thread producer([&] {
+        for (int i = 0; i < count; i++) {
+            queue.push(i);
+        }
+    });
+
+    op::FutexWait wait;
+    for (int expected = 0; expected < count; expected++) {
+        int value = -1;
+        auto status = queue.pop<Operations>(m_ring, wait, value);
+        while (status != AcquireStatus::Acquired) {
+            m_ring.submit();
+            waitForFutex(m_ring);
+            status = queue.complete<Operations>(m_ring, wait, value);
+        }
+        ASSERT_EQ(expected, value);
+    }
+    producer.join();
+    ASSERT_FALSE(queue.try_pop());
+}
+
+TEST_F(FutexSyncTests, should_wake_waiter_of_other_ring_with_ring_wake)
+{
+    AsyncSemaphore semaphore;
+    std::thread waiter([&] {
+        Ring<void> ring(8);
+        op::FutexWait wait;
+        auto status = semaphore.acquire<Operations>(ring, wait);
+        while (status != AcquireStatus::Acquired) {
+            ring.submit();
+            waitForFutex(ring);
+            status = semaphore.complete<Operations>(ring, wait);
+        }
+    });
+
+    // Give the waiter time to register, so the release prepares a wake
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    op::FutexWake wake;
+    semaphore.release<Operations>(m_ring, wake);
+    m_ring.submit();
+    waiter.join();
+    ASSERT_EQ(0u, semaphore.available());
+}
+
+TEST_F(FutexSyncTests, should_complete_waitv_with_index_of_woken_futex)
+{
+    std::atomic<std::uint32_t> words[2] = { 0, 0 };
+    futex_waitv futexes[2] {};
+    for (int i = 0; i < 2; i++) {
+        futexes[i].uaddr = reinterpret_cast<std::uint64_t>(futexWord(words[i]));
+        futexes[i].flags = FUTEX2_SIZE_U32 | FUTEX2_PRIVATE;
+    }
+    op::FutexWaitv waitv { futexes, 2 };
+    m_ring.prepare_operation<Operations>(waitv);
+    m_ring.submit();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    words[1] = 1;
+    futexWake(words[1], 1);
+    ASSERT_EQ(1, waitForFutex(m_ring));
+}
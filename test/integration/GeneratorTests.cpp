@@ -0,0 +1,122 @@
+#include <filesystem>
+#include <fstream>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "tests_base.h"
+#include "uringpp/uringpp.h"
+
+using namespace uringpp;
+
+namespace {
+auto count(int last) -> Generator<int>
+{
+    for (int i = 0; i <= last; i++) {
+        co_yield i;
+    }
+}
+
+auto failAfter(int values) -> Generator<int>
+{
+    for (int i = 0; i < values; i++) {
+        co_yield i;
+    }
+    throw std::runtime_error("failed");
+}
+}
+
+TEST(GeneratorTests, should_yield_values_lazily_through_adapters)
+{
+    std::vector<int> values;
+    for (auto value : count(1'000'000) | std::views::filter([](int i) { return i % 2; })
+             | std::views::transform([](int i) { return i * 10; }) | std::views::take(3)) {
+        values.push_back(value);
+    }
+
+    ASSERT_EQ((std::vector<int> { 10, 30, 50 }), values);
+}
+
+TEST(GeneratorTests, should_rethrow_exception_of_coroutine)
+{
+    std::vector<int> values;
+    auto generator = failAfter(2);
+
+    ASSERT_THROW(
+        {
+            for (auto value : generator) {
+                values.push_back(value);
+            }
+        },
+        std::runtime_error);
+    ASSERT_EQ((std::vector<int> { 0, 1 }), values);
+}
+
+TEST(GeneratorTests, should_be_empty_when_default_constructed)
+{
+    Generator<int> generator;
+
+    ASSERT_TRUE(generator.begin() == generator.end());
+}
+
+TEST(GeneratorTests, should_continue_after_move_of_started_generator)
+{
+    auto generator = count(3);
+    auto it = generator.begin();
+    ASSERT_EQ(0, *it);
+
+    auto moved = std::move(generator);
+    std::vector<int> values;
+    for (auto value : moved) {
+        values.push_back(value);
+    }
+
+    ASSERT_EQ((std::vector<int> { 0, 1, 2, 3 }), values);
+}
+
+class ReadChunksTests : public TemporaryDirectoryTest {
+  protected:
+    ReadChunksTests()
+        : TemporaryDirectoryTest("uringpp_read_chunks_tests")
+        , m_file(m_directory / "lines.txt")
+    {
+        for (int line = 0; line < 10000; line++) {
+            m_content += "line " + std::to_string(line) + "\n";
+        }
+        std::ofstream(m_file, std::ios::binary) << m_content;
+    }
+
+  protected:
+    std::filesystem::path m_file;
+    std::string m_content;
+};
+
+TEST_F(ReadChunksTests, should_yield_chunks_in_file_order)
+{
+    std::string content;
+    std::size_t chunks = 0;
+    for (auto chunk : readChunks(m_file, { .readAhead = 4, .chunkSize = 4096 })) {
+        content += text(chunk);
+        chunks++;
+    }
+
+    ASSERT_EQ(m_content, content);
+    ASSERT_EQ((m_content.size() + 4095) / 4096, chunks);
+}
+
+TEST_F(ReadChunksTests, should_compose_with_transform_and_stop_early)
+{
+    auto sizes = readChunks(m_file, { .readAhead = 2, .chunkSize = 1000 })
+        | std::views::transform([](auto chunk) { return chunk.size(); });
+
+    std::size_t bytes = 0;
+    for (auto size : std::move(sizes) | std::views::take(5)) {
+        bytes += size;
+    }
+
+    ASSERT_EQ(5000u, bytes);
+}
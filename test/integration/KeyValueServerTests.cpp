@@ -0,0 +1,101 @@
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "tests_base.h"
+#include "uringpp/uringpp.h"
+
+using namespace uringpp;
+
+class KeyValueServerTests : public ::testing::Test {
+  protected:
+    KeyValueServerTests()
+        : m_listenFd(listenOnLoopback())
+    {
+    }
+
+    ~KeyValueServerTests()
+    {
+        close(m_listenFd);
+    }
+
+    /*
+     * Sends the requests, shuts the sending side down and returns all responses
+     * until the server closed the connection
+     */
+    auto exchange(KeyValueServer& server, const std::string& requests) -> std::string
+    {
+        std::thread serverThread([&] { server.run(); });
+
+        const auto client = connectTo(m_listenFd);
+        std::thread writer([&] {
+            writeAll(client, requests);
+            shutdown(client, SHUT_WR);
+        });
+        auto responses = readAll(client);
+
+        writer.join();
+        close(client);
+        server.stop();
+        serverThread.join();
+        return responses;
+    }
+
+  protected:
+    int m_listenFd;
+};
+
+TEST_F(KeyValueServerTests, should_answer_pipelined_requests_in_order)
+{
+    KeyValueServer server(m_listenFd);
+
+    const auto responses = exchange(
+        server,
+        "set a 1 0 3\r\nfoo\r\nget a b\r\ndelete a\r\ndelete a\r\nget a\r\n"
+        "set b 0 0 1 noreply\r\nx\r\nget b\r\nbogus\r\n");
+
+    ASSERT_EQ(
+        "STORED\r\nVALUE a 1 3\r\nfoo\r\nEND\r\nDELETED\r\nNOT_FOUND\r\nEND\r\n"
+        "VALUE b 0 1\r\nx\r\nEND\r\nERROR\r\n",
+        responses);
+    ASSERT_EQ(1u, server.statistics().connections);
+    ASSERT_EQ(0u, server.statistics().activeConnections);
+    ASSERT_EQ(4u, server.statistics().gets);
+    ASSERT_EQ(2u, server.statistics().getHits);
+}
+
+TEST_F(KeyValueServerTests, should_serve_many_requests_and_values_larger_than_buffers)
+{
+    KeyValueServer server(m_listenFd, { .bufferSize = 1024, .numberOfBuffers = 8 });
+    const std::string value(10000, 'v');
+    server.store().set("big", 0, value);
+
+    std::string requests;
+    std::string expected;
+    for (int i = 0; i < 1000; i++) {
+        requests += "get big\r\n";
+        expected += "VALUE big 0 10000\r\n" + value + "\r\nEND\r\n";
+    }
+    // The data block spans several receive buffers
+    requests += "set other 0 0 10000\r\n" + value + "\r\nget other\r\n";
+    expected += "STORED\r\nVALUE other 0 10000\r\n" + value + "\r\nEND\r\n";
+
+    ASSERT_EQ(expected, exchange(server, requests));
+    // Responses of pipelined requests share a sendmsg
+    ASSERT_LT(server.statistics().sends, 1002u);
+}
+
+TEST_F(KeyValueServerTests, should_close_connection_on_protocol_error)
+{
+    KeyValueServer server(m_listenFd);
+
+    const auto responses = exchange(server, "get a\r\nset a 0 0 1\r\nxyz\r\nget a\r\n");
+
+    ASSERT_EQ("END\r\nCLIENT_ERROR bad data chunk\r\n", responses);
+    ASSERT_EQ(0u, server.store().size());
+}
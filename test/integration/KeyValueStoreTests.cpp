@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include "uringpp/KeyValueStore.h"
+
+#include <string>
+
+using namespace uringpp;
+
+TEST(KeyValueStoreTests, should_store_item_in_get_response_format)
+{
+    KeyValueStore store;
+    store.set("key", 42, "value");
+
+    auto item = store.get("key");
+    ASSERT_TRUE(item);
+    ASSERT_EQ("key", item->key());
+    ASSERT_EQ("value", item->data());
+    ASSERT_EQ(42u, item->flags());
+    ASSERT_EQ("VALUE key 42 5\r\nvalue\r\n", item->response());
+    ASSERT_FALSE(store.get("other"));
+}
+
+TEST(KeyValueStoreTests, should_replace_and_erase_items)
+{
+    KeyValueStore store;
+    store.set("key", 0, "first");
+    store.set("key", 0, "second");
+
+    ASSERT_EQ(1u, store.size());
+    ASSERT_EQ("second", store.get("key")->data());
+    ASSERT_TRUE(store.erase("key"));
+    ASSERT_FALSE(store.erase("key"));
+    ASSERT_FALSE(store.get("key"));
+    ASSERT_EQ(0u, store.size());
+}
+
+TEST(KeyValueStoreTests, should_keep_replaced_item_alive_while_referenced)
+{
+    KeyValueStore store;
+    store.set("key", 0, "first");
+    auto first = store.get("key");
+
+    store.set("key", 0, "second");
+    store.erase("key");
+
+    ASSERT_EQ("first", first->data());
+}
+
+TEST(KeyValueStoreTests, should_find_all_keys_after_growing_and_erasing)
+{
+    KeyValueStore store(8);
+    for (int i = 0; i < 10000; i++) {
+        store.set("key" + std::to_string(i), 0, std::to_string(i));
+    }
+    ASSERT_EQ(10000u, store.size());
+    ASSERT_GE(store.capacity(), 10000u * 4 / 3);
+
+    // Erasing every other key shifts entries back within the probe sequences
+    for (int i = 0; i < 10000; i += 2) {
+        ASSERT_TRUE(store.erase("key" + std::to_string(i)));
+    }
+    for (int i = 0; i < 10000; i++) {
+        auto item = store.get("key" + std::to_string(i));
+        if (i % 2) {
+            ASSERT_TRUE(item) << i;
+            ASSERT_EQ(std::to_string(i), item->data());
+        } else {
+            ASSERT_FALSE(item) << i;
+        }
+    }
+}
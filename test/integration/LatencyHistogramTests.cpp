@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include "uringpp/LatencyHistogram.h"
+
+using namespace uringpp;
+
+TEST(LatencyHistogramTests, should_count_small_values_exactly)
+{
+    LatencyHistogram histogram;
+    for (std::uint64_t value = 1; value <= 50; value++) {
+        histogram.record(value);
+    }
+
+    ASSERT_EQ(50u, histogram.count());
+    ASSERT_EQ(1u, histogram.min());
+    ASSERT_EQ(50u, histogram.max());
+    ASSERT_EQ(25u, histogram.percentile(50));
+    ASSERT_EQ(50u, histogram.percentile(100));
+    ASSERT_DOUBLE_EQ(25.5, histogram.mean());
+}
+
+TEST(LatencyHistogramTests, should_bound_relative_error_of_large_values)
+{
+    for (std::uint64_t value : { 1000ull, 123456ull, 987654321ull, 1ull << 40, (1ull << 62) + 12345 }) {
+        LatencyHistogram histogram;
+        histogram.record(value);
+        histogram.record(value * 2);
+
+        const auto p50 = histogram.percentile(50);
+        ASSERT_LE(p50 > value ? p50 - value : value - p50, value / 64) << value;
+    }
+}
+
+TEST(LatencyHistogramTests, should_return_percentiles_of_uniform_values)
+{
+    LatencyHistogram histogram;
+    for (std::uint64_t value = 1; value <= 100000; value++) {
+        histogram.record(value * 1000);
+    }
+
+    for (double percentile : { 50.0, 90.0, 99.0, 99.9 }) {
+        const auto expected = percentile * 1000 * 1000;
+        ASSERT_NEAR(expected, static_cast<double>(histogram.percentile(percentile)), expected / 64);
+    }
+    ASSERT_EQ(100000000u, histogram.percentile(100));
+}
+
+TEST(LatencyHistogramTests, should_add_samples_omitted_by_a_stall)
+{
+    // A closed loop client sends every 1ms, one response stalls for 100ms
+    LatencyHistogram histogram;
+    for (int i = 0; i < 99; i++) {
+        histogram.record_corrected(1'000'000, 1'000'000);
+    }
+    histogram.record_corrected(100'000'000, 1'000'000);
+
+    // The 99 requests which were not sent during the stall would have waited 99ms .. 1ms
+    ASSERT_EQ(199u, histogram.count());
+    ASSERT_GT(histogram.percentile(75), 40'000'000u);
+}
+
+TEST(LatencyHistogramTests, should_correct_recorded_histogram_like_record_corrected)
+{
+    LatencyHistogram raw;
+    LatencyHistogram corrected;
+    for (std::uint64_t value : { 10ull, 20ull, 35ull, 7ull }) {
+        raw.record(value);
+        corrected.record_corrected(value, 8);
+    }
+
+    const auto copy = raw.corrected(8);
+    ASSERT_EQ(corrected.count(), copy.count());
+    ASSERT_EQ(corrected.percentile(50), copy.percentile(50));
+    ASSERT_EQ(raw.max(), copy.max());
+}
+
+TEST(LatencyHistogramTests, should_merge_histograms)
+{
+    LatencyHistogram first;
+    LatencyHistogram second;
+    first.record(10);
+    second.record(30, 3);
+
+    first.merge(second);
+
+    ASSERT_EQ(4u, first.count());
+    ASSERT_EQ(10u, first.min());
+    ASSERT_EQ(30u, first.max());
+    ASSERT_EQ(30u, first.percentile(50));
+}
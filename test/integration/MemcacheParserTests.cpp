@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+
+#include "uringpp/MemcacheParser.h"
+
+#include <string>
+#include <vector>
+
+using namespace uringpp;
+
+namespace {
+auto bytes(std::string_view data) -> std::span<const std::uint8_t>
+{
+    return { reinterpret_cast<const std::uint8_t*>(data.data()), data.size() };
+}
+
+/*
+ * Feeds the stream in chunks of chunkSize and describes each request as
+ * "<command> <key> <flags> <data> <noreply>"
+ */
+auto parse(std::string_view stream, std::size_t chunkSize, bool* ok = nullptr)
+    -> std::vector<std::string>
+{
+    MemcacheParser parser(1024);
+    std::vector<std::string> requests;
+    auto onRequest = [&](const MemcacheRequest& request) {
+        const char* commands[] = { "get", "set", "delete", "invalid" };
+        requests.push_back(
+            std::string(commands[static_cast<int>(request.command)]) + " "
+            + std::string(request.key) + " " + std::to_string(request.flags) + " "
+            + std::string(request.data) + (request.noreply ? " noreply" : ""));
+    };
+
+    bool result = true;
+    for (std::size_t offset = 0; offset < stream.size() && result; offset += chunkSize) {
+        result = parser.feed(bytes(stream.substr(offset, chunkSize)), onRequest);
+    }
+    if (ok) {
+        *ok = result;
+    }
+    return requests;
+}
+}
+
+TEST(MemcacheParserTests, should_parse_pipelined_requests)
+{
+    const auto stream = "get a b\r\nset key 7 0 5\r\nhello\r\ndelete key noreply\r\nflush_all\r\n";
+    const std::vector<std::string> expected {
+        "get a b 0 ", "set key 7 hello", "delete key 0  noreply", "invalid  0 "
+    };
+
+    ASSERT_EQ(expected, parse(stream, 4096));
+}
+
+TEST(MemcacheParserTests, should_parse_requests_in_place_within_chunk)
+{
+    const std::string stream = "set key 0 0 3\r\nabc\r\nget key\r\n";
+    MemcacheParser parser;
+    std::vector<const char*> data;
+
+    parser.feed(bytes(stream), [&](const MemcacheRequest& request) {
+        data.push_back(request.key.data());
+    });
+
+    ASSERT_EQ(stream.data() + 4, data[0]);
+    ASSERT_EQ(stream.data() + 24, data[1]);
+    ASSERT_EQ(0u, parser.carried());
+}
+
+TEST(MemcacheParserTests, should_parse_requests_crossing_chunk_boundaries)
+{
+    const std::string stream
+        = "set key 1 0 10\r\n0123456789\r\nget key other\r\nset k 0 0 0\r\n\r\n";
+    const auto expected = parse(stream, stream.size());
+
+    ASSERT_EQ(3u, expected.size());
+    for (std::size_t chunkSize = 1; chunkSize < stream.size(); chunkSize++) {
+        ASSERT_EQ(expected, parse(stream, chunkSize)) << chunkSize;
+    }
+}
+
+TEST(MemcacheParserTests, should_iterate_keys_of_get)
+{
+    MemcacheRequest request;
+    request.command = MemcacheCommand::Get;
+    request.key = "a  bb ccc";
+    std::vector<std::string_view> keys;
+
+    request.for_each_key([&](std::string_view key) { keys.push_back(key); });
+
+    ASSERT_EQ((std::vector<std::string_view> { "a", "bb", "ccc" }), keys);
+}
+
+TEST(MemcacheParserTests, should_fail_on_unrecoverable_errors)
+{
+    bool ok;
+    parse("set key 0 0 3\r\nabcd\r\n", 4096, &ok);
+    ASSERT_FALSE(ok);
+
+    parse("set key 0 0 2048\r\n", 4096, &ok);
+    ASSERT_FALSE(ok);
+
+    parse("set key x 0 3\r\nabc\r\n", 4096, &ok);
+    ASSERT_FALSE(ok);
+
+    parse(std::string(4096, 'x'), 100, &ok);
+    ASSERT_FALSE(ok);
+}
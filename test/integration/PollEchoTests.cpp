@@ -0,0 +1,58 @@
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "tcp_echo_poll/PollEcho.h"
+#include "tests_base.h"
+
+class PollEchoTests : public ::testing::Test {
+  protected:
+    PollEchoTests()
+        : m_listenFd(listenOnLoopback())
+    {
+    }
+
+    ~PollEchoTests()
+    {
+        close(m_listenFd);
+    }
+
+    /*
+     * Sends the payload to a server with the given number of buffers, shuts the
+     * sending side down and returns everything which was echoed
+     */
+    auto echoRoundTrip(std::size_t bufferPoolSize, const std::string& payload) -> std::string
+    {
+        Ring ring { 64 };
+        std::thread server([&] { echo(ring, bufferPoolSize, m_listenFd, 1); });
+
+        const auto client = connectTo(m_listenFd);
+        std::thread writer([&] {
+            writeAll(client, payload);
+            shutdown(client, SHUT_WR);
+        });
+        auto echoed = readAll(client);
+
+        writer.join();
+        server.join();
+        close(client);
+        return echoed;
+    }
+
+  protected:
+    int m_listenFd;
+};
+
+TEST_F(PollEchoTests, should_echo_all_data_of_shut_down_peer_with_single_buffer)
+{
+    std::string payload;
+    for (int line = 0; payload.size() < 10 * 1024; line++) {
+        payload += "line " + std::to_string(line) + "\n";
+    }
+
+    ASSERT_EQ(payload, echoRoundTrip(1, payload));
+}
@@ -0,0 +1,135 @@
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "tests_base.h"
+#include "uringpp/uringpp.h"
+
+using namespace uringpp;
+
+class TcpProxyTests : public ::testing::Test {
+  protected:
+    TcpProxyTests()
+        : m_backendFd(listenOnLoopback())
+        , m_proxyFd(listenOnLoopback())
+    {
+    }
+
+    ~TcpProxyTests()
+    {
+        close(m_backendFd);
+        close(m_proxyFd);
+    }
+
+    /*
+     * Echoes what the client sends, answers "bye" once the client shut its
+     * sending side down and closes
+     */
+    auto serveBackend() -> std::thread
+    {
+        return std::thread([this] {
+            const auto fd = accept(m_backendFd, nullptr, nullptr);
+            char buffer[4096];
+            for (ssize_t result; (result = read(fd, buffer, sizeof(buffer))) > 0;) {
+                writeAll(fd, std::string(buffer, result));
+            }
+            writeAll(fd, "bye");
+            close(fd);
+        });
+    }
+
+    /*
+     * Sends the payload through the proxy, shuts the sending side down and returns
+     * everything which came back
+     */
+    auto roundTrip(TcpProxy& proxy, const std::string& payload) -> std::string
+    {
+        std::thread proxyThread([&] { proxy.run(); });
+        auto backend = serveBackend();
+
+        const auto client = connectTo(m_proxyFd);
+        std::thread writer([&] {
+            writeAll(client, payload);
+            shutdown(client, SHUT_WR);
+        });
+        auto received = readAll(client);
+
+        writer.join();
+        backend.join();
+        close(client);
+        proxy.stop();
+        proxyThread.join();
+        return received;
+    }
+
+    auto payload(std::size_t size) -> std::string
+    {
+        std::string data(size, '\0');
+        for (std::size_t i = 0; i < size; i++) {
+            data[i] = static_cast<char>('a' + i % 26);
+        }
+        return data;
+    }
+
+  protected:
+    int m_backendFd;
+    int m_proxyFd;
+};
+
+TEST_F(TcpProxyTests, should_forward_both_directions_with_splice)
+{
+    TcpProxy proxy(m_proxyFd, addressOf(m_backendFd));
+    const auto data = payload(1 << 20);
+
+    ASSERT_EQ(data + "bye", roundTrip(proxy, data));
+    ASSERT_EQ(1u, proxy.statistics().sessions);
+    ASSERT_EQ(0u, proxy.statistics().activeSessions);
+    ASSERT_EQ(data.size(), proxy.statistics().bytesUpstream);
+    ASSERT_EQ(data.size() + 3, proxy.statistics().bytesDownstream);
+}
+
+TEST_F(TcpProxyTests, should_forward_both_directions_with_provided_buffers)
+{
+    TcpProxy proxy(m_proxyFd, addressOf(m_backendFd), { .splice = false, .bufferSize = 4096 });
+    const auto data = payload(1 << 20);
+
+    ASSERT_FALSE(proxy.uses_splice());
+    ASSERT_EQ(data + "bye", roundTrip(proxy, data));
+    ASSERT_EQ(data.size(), proxy.statistics().bytesUpstream);
+}
+
+TEST_F(TcpProxyTests, should_forward_half_close)
+{
+    // The backend only answers after it saw the end of the client's data
+    TcpProxy proxy(m_proxyFd, addressOf(m_backendFd));
+
+    ASSERT_EQ("bye", roundTrip(proxy, ""));
+}
+
+TEST_F(TcpProxyTests, should_close_client_when_upstream_refuses)
+{
+    // Bound but not listening, so connects are refused
+    const auto refusing = socket(AF_INET, SOCK_STREAM, 0);
+    auto address = addressOf(m_backendFd);
+    address.sin_port = 0;
+    bind(refusing, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+
+    TcpProxy proxy(m_proxyFd, addressOf(refusing));
+    std::thread proxyThread([&] { proxy.run(); });
+
+    const auto client = connectTo(m_proxyFd);
+    ASSERT_EQ("", readAll(client));
+
+    close(client);
+    proxy.stop();
+    proxyThread.join();
+    close(refusing);
+
+    ASSERT_EQ(1u, proxy.statistics().failedConnects);
+    ASSERT_EQ(0u, proxy.statistics().activeSessions);
+}
@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+
+#include "uringpp/uringpp.h"
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace uringpp;
+using namespace std::chrono_literals;
+
+namespace {
+using Clock = TimerWheel::Clock;
+
+struct TestTimer : Timer {
+    int id = 0;
+    Clock::time_point deadline;
+};
+
+auto ids(TimerWheel& wheel, Clock::time_point now) -> std::vector<int>
+{
+    std::vector<int> expired;
+    wheel.expire(now, [&](Timer& timer) {
+        expired.push_back(static_cast<TestTimer&>(timer).id);
+    });
+    return expired;
+}
+}
+
+class TimerWheelTests : public ::testing::Test {
+  protected:
+    Clock::time_point m_start = Clock::time_point {} + 1h;
+    TimerWheel m_wheel { 1ms, m_start, Capabilities::none() };
+};
+
+TEST_F(TimerWheelTests, should_expire_timers_in_deadline_order_and_not_early)
+{
+    TestTimer timers[3];
+    for (int i = 0; i < 3; i++) {
+        timers[i].id = i;
+    }
+    m_wheel.schedule(timers[0], m_start + 30ms);
+    m_wheel.schedule(timers[1], m_start + 10ms);
+    m_wheel.schedule(timers[2], m_start + 10500us);
+    ASSERT_EQ(3u, m_wheel.size());
+
+    ASSERT_TRUE(ids(m_wheel, m_start + 9ms).empty());
+    ASSERT_EQ(std::vector<int> { 1 }, ids(m_wheel, m_start + 10ms));
+    ASSERT_TRUE(ids(m_wheel, m_start + 10999us).empty());
+    ASSERT_EQ((std::vector<int> { 2, 0 }), ids(m_wheel, m_start + 1s));
+    ASSERT_TRUE(m_wheel.empty());
+    ASSERT_FALSE(timers[0].scheduled());
+}
+
+TEST_F(TimerWheelTests, should_not_expire_cancelled_or_destroyed_timers)
+{
+    TestTimer cancelled;
+    m_wheel.schedule(cancelled, m_start + 5ms);
+    {
+        TestTimer destroyed;
+        m_wheel.schedule(destroyed, m_start + 5ms);
+    }
+    m_wheel.cancel(cancelled);
+
+    ASSERT_TRUE(m_wheel.empty());
+    ASSERT_EQ(0u, m_wheel.expire(m_start + 10ms, [](Timer&) { FAIL(); }));
+}
+
+TEST_F(TimerWheelTests, should_reschedule_timers_also_from_expiry_handler)
+{
+    TestTimer keepalive;
+    m_wheel.schedule(keepalive, m_start + 10ms);
+    m_wheel.schedule(keepalive, m_start + 100ms);
+    ASSERT_EQ(1u, m_wheel.size());
+    ASSERT_TRUE(ids(m_wheel, m_start + 50ms).empty());
+
+    int expirations = 0;
+    auto now = m_start + 100ms;
+    for (int i = 0; i < 3; i++, now += 100ms) {
+        m_wheel.expire(now, [&](Timer& timer) {
+            expirations++;
+            m_wheel.schedule(timer, now + 100ms);
+        });
+    }
+    ASSERT_EQ(3, expirations);
+    ASSERT_TRUE(keepalive.scheduled());
+}
+
+TEST_F(TimerWheelTests, should_expire_timers_of_all_levels_and_the_overflow)
+{
+    std::mt19937_64 random { 47 };
+    // Up to twice the span of the levels, 64^4 ticks
+    std::uniform_int_distribution<std::int64_t> deadlines { 0, 2 * (1 << 24) };
+    std::vector<std::unique_ptr<TestTimer>> timers;
+    for (int i = 0; i < 2000; i++) {
+        auto timer = std::make_unique<TestTimer>();
+        timer->id = i;
+        timer->deadline = m_start + std::chrono::milliseconds(deadlines(random));
+        m_wheel.schedule(*timer, timer->deadline);
+        timers.push_back(std::move(timer));
+    }
+
+    auto now = m_start;
+    std::uniform_int_distribution<std::int64_t> steps { 1, 50000 };
+    while (!m_wheel.empty()) {
+        const auto next = m_wheel.next_deadline();
+        ASSERT_TRUE(next);
+        for (const auto& timer : timers) {
+            if (timer->scheduled()) {
+                ASSERT_LE(*next, timer->deadline);
+            }
+        }
+
+        now += std::chrono::milliseconds(steps(random));
+        m_wheel.expire(now, [&](Timer& timer) {
+            ASSERT_LE(static_cast<TestTimer&>(timer).deadline, now);
+        });
+        for (const auto& timer : timers) {
+            if (timer->deadline <= now) {
+                ASSERT_FALSE(timer->scheduled()) << timer->id;
+            }
+        }
+    }
+}
+
+TEST_F(TimerWheelTests, should_expire_timers_scheduled_in_the_past_next)
+{
+    ids(m_wheel, m_start + 1s);
+
+    TestTimer timer;
+    timer.id = 1;
+    m_wheel.schedule(timer, m_start);
+    ASSERT_EQ(m_start + 1s, m_wheel.next_deadline());
+    ASSERT_EQ(std::vector<int> { 1 }, ids(m_wheel, m_start + 1s));
+    ASSERT_FALSE(m_wheel.next_deadline());
+}
+
+TEST(TimerWheelRingTests, should_expire_timers_with_one_armed_timeout)
+{
+    using Operations = OperationSet<TimerWheel::TimeoutOp>;
+    Ring<void> ring(8);
+    TimerWheel wheel;
+
+    std::vector<TestTimer> timers(101);
+    const auto start = Clock::now();
+    for (std::size_t i = 1; i < timers.size(); i++) {
+        timers[i].deadline = start + 5ms + std::chrono::microseconds(100 * i);
+        wheel.schedule(timers[i], timers[i].deadline);
+    }
+    ASSERT_TRUE(wheel.arm<Operations>(ring));
+    ring.submit();
+
+    // An earlier timer moves the armed timeout
+    timers[0].deadline = start + 1ms;
+    wheel.schedule(timers[0], timers[0].deadline);
+    ASSERT_TRUE(wheel.arm<Operations>(ring));
+    ring.submit();
+
+    std::size_t expired = 0;
+    auto onExpired = [](Timer& timer) {
+        ASSERT_LE(static_cast<TestTimer&>(timer).deadline, Clock::now());
+    };
+    while (expired < timers.size()) {
+        auto completion = ring.wait();
+        Operations::dispatch(
+            completion.get(),
+            [&](TimerWheel::TimeoutOp& timeout, TimerWheel::TimeoutOp::result_type result) {
+                expired += wheel.complete(timeout, result, onExpired);
+            });
+        ring.seen(completion);
+        ASSERT_TRUE(wheel.arm<Operations>(ring));
+        ring.submit();
+    }
+    ASSERT_TRUE(wheel.empty());
+    // One timeout per tick with expiring timers, not one per timer
+    ASSERT_LT(wheel.arms(), timers.size() / 4);
+}
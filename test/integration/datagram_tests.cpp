@@ -0,0 +1,210 @@
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <array>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "uringpp/uringpp.h"
+
+using namespace uringpp;
+
+namespace {
+struct RecvOp : op::RecvMsgMultishot {
+};
+
+struct SendOp : op::SendMsg {
+};
+
+struct ProvideBuffersOp : op::ProvideBuffers {
+};
+
+using Operations = OperationSet<RecvOp, SendOp, ProvideBuffersOp>;
+
+auto bytes(const std::string& text) -> std::span<const std::uint8_t>
+{
+    return { reinterpret_cast<const std::uint8_t*>(text.data()), text.size() };
+}
+}
+
+class DatagramTests : public ::testing::Test {
+  protected:
+    DatagramTests()
+        : m_userData(std::make_shared<int>(0))
+        , m_ring(8)
+        , m_receiver(bindLoopback())
+        , m_sender(bindLoopback())
+    {
+    }
+
+    ~DatagramTests()
+    {
+        close(m_receiver);
+        close(m_sender);
+    }
+
+    static auto bindLoopback() -> int
+    {
+        auto fd = socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in address {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+            throw std::runtime_error("Failed to bind udp socket");
+        }
+        return fd;
+    }
+
+    static auto addressOf(int fd) -> sockaddr_in
+    {
+        sockaddr_in address {};
+        socklen_t length = sizeof(address);
+        getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length);
+        return address;
+    }
+
+    auto sendTo(int fd, const std::string& datagram) -> void
+    {
+        const auto address = addressOf(fd);
+        ASSERT_EQ(
+            static_cast<ssize_t>(datagram.size()),
+            sendto(
+                m_sender,
+                datagram.data(),
+                datagram.size(),
+                0,
+                reinterpret_cast<const sockaddr*>(&address),
+                sizeof(address)));
+    }
+
+  protected:
+    std::shared_ptr<int> m_userData;
+    Ring<int> m_ring;
+    int m_receiver;
+    int m_sender;
+};
+
+TEST_F(DatagramTests, should_recvmsg_with_source_address)
+{
+    sendTo(m_receiver, "hello");
+
+    std::array<char, 16> buffer {};
+    iovec vec { buffer.data(), buffer.size() };
+    sockaddr_in source {};
+    msghdr message {};
+    message.msg_name = &source;
+    message.msg_namelen = sizeof(source);
+    message.msg_iov = &vec;
+    message.msg_iovlen = 1;
+
+    ASSERT_TRUE(m_ring.prepare_recvmsg(m_receiver, &message, m_userData));
+    m_ring.submit();
+    auto completion = m_ring.wait();
+    ASSERT_EQ(5, completion.result());
+    m_ring.seen(completion);
+
+    ASSERT_EQ("hello", std::string(buffer.data(), 5));
+    ASSERT_EQ(addressOf(m_sender).sin_port, source.sin_port);
+}
+
+TEST_F(DatagramTests, should_receive_datagrams_with_multishot_recvmsg)
+{
+    BufferPool bufferPool(4, sizeof(io_uring_recvmsg_out) + sizeof(sockaddr_storage) + 64, 0);
+    ProvideBuffersOp provide {};
+    provide.bufferPool = &bufferPool;
+    provide.numberOfBuffers = bufferPool.pool_size();
+    m_ring.prepare_operation<Operations>(provide);
+
+    msghdr message {};
+    message.msg_namelen = sizeof(sockaddr_storage);
+    RecvOp recv {};
+    recv.fd = m_receiver;
+    recv.msg = &message;
+    recv.bufferPool = &bufferPool;
+    m_ring.prepare_operation<Operations>(recv);
+    m_ring.submit();
+    m_ring.seen(m_ring.wait());
+
+    sendTo(m_receiver, "first");
+    sendTo(m_receiver, "second");
+
+    for (std::string expected : { "first", "second" }) {
+        auto completion = m_ring.wait();
+        auto result = RecvOp::result(completion.get());
+        m_ring.seen(completion);
+        ASSERT_TRUE(result.ok());
+        ASSERT_TRUE(result.has_more());
+
+        RecvMsgOut datagram(bufferPool.at(result.buffer_idx()), result.value(), message);
+        ASSERT_TRUE(datagram.valid());
+        ASSERT_FALSE(datagram.payload_truncated());
+        auto payload = datagram.payload();
+        ASSERT_EQ(expected, std::string(reinterpret_cast<const char*>(payload.data()), payload.size()));
+
+        auto source = reinterpret_cast<const sockaddr_in*>(datagram.name());
+        ASSERT_EQ(sizeof(sockaddr_in), datagram.name_length());
+        ASSERT_EQ(addressOf(m_sender).sin_port, source->sin_port);
+    }
+}
+
+TEST(GsoBatchTests, should_only_accept_short_datagram_last)
+{
+    GsoBatch batch(4, 3);
+    ASSERT_TRUE(batch.empty());
+    ASSERT_TRUE(batch.append(bytes("abcd")));
+    ASSERT_FALSE(batch.append(bytes("abcde")));
+    ASSERT_TRUE(batch.append(bytes("ab")));
+    ASSERT_TRUE(batch.full());
+    ASSERT_FALSE(batch.append(bytes("abcd")));
+    ASSERT_EQ(2u, batch.segments());
+    ASSERT_EQ(6u, batch.bytes());
+
+    batch.clear();
+    ASSERT_TRUE(batch.empty());
+}
+
+TEST(GsoBatchTests, should_add_segment_size_control_message)
+{
+    GsoBatch batch(4);
+    batch.append(bytes("abcd"));
+    ASSERT_EQ(nullptr, batch.message()->msg_control);
+
+    batch.append(bytes("efgh"));
+    auto message = batch.message();
+    auto cmsg = CMSG_FIRSTHDR(message);
+    ASSERT_NE(nullptr, cmsg);
+    ASSERT_EQ(SOL_UDP, cmsg->cmsg_level);
+    ASSERT_EQ(UDP_SEGMENT, cmsg->cmsg_type);
+    std::uint16_t segmentSize;
+    std::memcpy(&segmentSize, CMSG_DATA(cmsg), sizeof(segmentSize));
+    ASSERT_EQ(4, segmentSize);
+}
+
+TEST_F(DatagramTests, should_send_gso_batch_as_separate_datagrams)
+{
+    GsoBatch batch(4);
+    const auto address = addressOf(m_receiver);
+    batch.set_destination(reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+    batch.append(bytes("abcd"));
+    batch.append(bytes("efgh"));
+    batch.append(bytes("ij"));
+
+    SendOp send {};
+    send.fd = m_sender;
+    send.msg = batch.message();
+    m_ring.prepare_operation<Operations>(send);
+    m_ring.submit();
+    auto completion = m_ring.wait();
+    auto result = SendOp::result(completion.get());
+    m_ring.seen(completion);
+    ASSERT_TRUE(result.ok());
+    ASSERT_EQ(10u, result.value());
+
+    for (std::string expected : { "abcd", "efgh", "ij" }) {
+        std::array<char, 16> buffer;
+        const auto received = ::recv(m_receiver, buffer.data(), buffer.size(), 0);
+        ASSERT_EQ(expected, std::string(buffer.data(), received));
+    }
+}
@@ -0,0 +1,128 @@
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "tests_base.h"
+#include "uringpp/uringpp.h"
+
+using namespace uringpp;
+
+namespace {
+struct OpenOp : op::OpenAtDirect {
+};
+
+struct ReadOp : op::Read {
+};
+
+struct CloseOp : op::CloseDirect {
+};
+
+struct AcceptOp : op::AcceptDirect {
+};
+
+using Operations = OperationSet<OpenOp, ReadOp, CloseOp, AcceptOp>;
+}
+
+class DirectDescriptorTests : public ::testing::Test {
+  protected:
+    DirectDescriptorTests()
+        : m_file("test2.txt")
+        , m_buffer(std::filesystem::file_size(m_file), '!')
+        , m_ring(4)
+    {
+        m_ring.register_files_sparse(4);
+    }
+
+    template <class Operation> auto run(Operation& operation) -> typename Operation::result_type
+    {
+        m_ring.prepare_operation<Operations>(operation);
+        m_ring.submit();
+        auto completion = m_ring.wait();
+        auto result = Operation::result(completion.get());
+        m_ring.seen(completion);
+        return result;
+    }
+
+  protected:
+    std::filesystem::path m_file;
+    std::vector<std::uint8_t> m_buffer;
+    Ring<void> m_ring;
+};
+
+TEST_F(DirectDescriptorTests, should_open_read_and_close_direct_descriptor)
+{
+    OpenOp open {};
+    open.path = m_file.c_str();
+    auto opened = run(open);
+    ASSERT_TRUE(opened.ok());
+    ASSERT_LT(opened.value(), 4);
+
+    ReadOp read {};
+    read.fd = opened.value();
+    read.buffer = m_buffer;
+    read.fixedFile = true;
+    auto readResult = run(read);
+    ASSERT_TRUE(readResult.ok());
+    ASSERT_EQ(m_buffer.size(), readResult.value());
+
+    CloseOp close {};
+    close.fileIndex = opened.value();
+    ASSERT_TRUE(run(close).ok());
+}
+
+TEST_F(DirectDescriptorTests, should_open_into_requested_slot)
+{
+    OpenOp open {};
+    open.path = m_file.c_str();
+    open.fileIndex = 2;
+    ASSERT_TRUE(run(open).ok());
+
+    ReadOp read {};
+    read.fd = 2;
+    read.buffer = m_buffer;
+    read.fixedFile = true;
+    ASSERT_TRUE(run(read).ok());
+}
+
+TEST_F(DirectDescriptorTests, should_fail_to_read_closed_direct_descriptor)
+{
+    ReadOp read {};
+    read.fd = 1;
+    read.buffer = m_buffer;
+    read.fixedFile = true;
+    ASSERT_EQ(EBADF, run(read).error());
+}
+
+TEST_F(DirectDescriptorTests, should_accept_multishot_into_direct_descriptors)
+{
+    const auto listenFd = listenOnLoopback();
+
+    AcceptOp accept {};
+    accept.fd = listenFd;
+    accept.multishot = true;
+    m_ring.prepare_operation<Operations>(accept);
+    m_ring.submit();
+
+    const auto client1 = connectTo(listenFd);
+    const auto client2 = connectTo(listenFd);
+
+    std::vector<int> accepted;
+    for (int i = 0; i < 2; i++) {
+        auto completion = m_ring.wait();
+        auto result = AcceptOp::result(completion.get());
+        m_ring.seen(completion);
+        ASSERT_TRUE(result.ok());
+        ASSERT_TRUE(result.has_more());
+        accepted.push_back(result.value());
+    }
+    ASSERT_NE(accepted[0], accepted[1]);
+
+    close(client1);
+    close(client2);
+    close(listenFd);
+}
@@ -0,0 +1,206 @@
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "tests_base.h"
+#include "uringpp/uringpp.h"
+
+using namespace uringpp;
+
+struct TaggedNop : op::Nop {
+    int id;
+};
+
+struct TaggedRead : op::Read {
+    int id;
+};
+
+using Operations = OperationSet<TaggedNop, TaggedRead>;
+
+class OperationTests : public ::testing::Test {
+  protected:
+    OperationTests()
+        : m_file("test2.txt")
+        , m_fd(getFileDescriptor(m_file))
+        , m_buffer(std::filesystem::file_size(m_file), '!')
+        , m_maxQueueEntries(2)
+        , m_ring(m_maxQueueEntries)
+    {
+    }
+
+  protected:
+    std::filesystem::path m_file;
+    int m_fd;
+    std::vector<std::uint8_t> m_buffer;
+    const std::size_t m_maxQueueEntries;
+    Ring<void> m_ring;
+};
+
+TEST_F(OperationTests, should_encode_operation_type_into_low_bits)
+{
+    TaggedNop nop {};
+    TaggedRead read {};
+
+    ASSERT_EQ(0u, Operations::encode(nop) & Operations::tagMask);
+    ASSERT_EQ(1u, Operations::encode(read) & Operations::tagMask);
+}
+
+TEST_F(OperationTests, should_prepare_operation)
+{
+    TaggedNop nop {};
+    ASSERT_TRUE(m_ring.prepare_operation<Operations>(nop));
+    ASSERT_EQ(1u, m_ring.preparedQueueEntries());
+}
+
+TEST_F(OperationTests, should_dispatch_completion_to_typed_handler)
+{
+    TaggedNop nop {};
+    nop.id = 42;
+    m_ring.prepare_operation<Operations>(nop);
+    m_ring.submit();
+
+    auto completion = m_ring.wait();
+    int nopId = 0;
+    bool readCalled = false;
+    Operations::dispatch(
+        completion.get(),
+        Overloaded { [&](TaggedNop& nop, TaggedNop::result_type result) {
+                        ASSERT_TRUE(result.ok());
+                        nopId = nop.id;
+                    },
+                     [&](TaggedRead&, TaggedRead::result_type) { readCalled = true; } });
+    m_ring.seen(completion);
+
+    ASSERT_EQ(42, nopId);
+    ASSERT_FALSE(readCalled);
+}
+
+TEST_F(OperationTests, should_dispatch_typed_read_result)
+{
+    TaggedRead read {};
+    read.fd = m_fd;
+    read.buffer = m_buffer;
+    m_ring.prepare_operation<Operations>(read);
+    m_ring.submit();
+
+    auto completion = m_ring.wait();
+    std::size_t bytesRead = 0;
+    Operations::dispatch(
+        completion.get(),
+        Overloaded { [&](TaggedNop&, TaggedNop::result_type) {},
+                     [&](TaggedRead&, TaggedRead::result_type result) {
+                         bytesRead = result.value();
+                     } });
+    m_ring.seen(completion);
+
+    ASSERT_EQ(std::filesystem::file_size(m_file), bytesRead);
+    ASSERT_EQ(readFile(m_file), m_buffer);
+}
+
+TEST_F(OperationTests, should_read_into_registered_buffer_from_registered_file)
+{
+    using FixedOperations = OperationSet<op::ReadFixed>;
+
+    const iovec registered { m_buffer.data(), m_buffer.size() };
+    m_ring.register_buffers({ &registered, 1 });
+    m_ring.register_files({ &m_fd, 1 });
+
+    op::ReadFixed read {};
+    read.fd = 0;
+    read.fixedFile = true;
+    read.buffer = m_buffer;
+    m_ring.prepare_operation<FixedOperations>(read);
+    m_ring.submit();
+
+    auto completion = m_ring.wait();
+    auto result = op::ReadFixed::result(completion.get());
+    m_ring.seen(completion);
+
+    ASSERT_TRUE(result.ok());
+    ASSERT_EQ(std::filesystem::file_size(m_file), result.value());
+    ASSERT_EQ(readFile(m_file), m_buffer);
+
+    m_ring.unregister_files();
+    m_ring.unregister_buffers();
+}
+
+TEST_F(OperationTests, should_connect_to_loopback_listener)
+{
+    const auto listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    ASSERT_EQ(0, bind(listenFd, reinterpret_cast<sockaddr*>(&address), length));
+    ASSERT_EQ(0, listen(listenFd, 1));
+    getsockname(listenFd, reinterpret_cast<sockaddr*>(&address), &length);
+
+    const auto fd = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_TRUE(m_ring.prepare_connect(fd, reinterpret_cast<sockaddr*>(&address), length, nullptr));
+    m_ring.submit();
+    auto completion = m_ring.wait();
+    ASSERT_EQ(0, completion.result());
+    m_ring.seen(completion);
+
+    const auto accepted = accept(listenFd, nullptr, nullptr);
+    ASSERT_GE(accepted, 0);
+
+    close(accepted);
+    close(fd);
+    close(listenFd);
+}
+
+TEST_F(OperationTests, should_dispatch_connect_result)
+{
+    using NetworkOperations = OperationSet<op::Connect, op::Timeout>;
+
+    // Nothing listens on the port of a socket which was bound but not listening
+    const auto unused = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    bind(unused, reinterpret_cast<sockaddr*>(&address), length);
+    getsockname(unused, reinterpret_cast<sockaddr*>(&address), &length);
+
+    op::Connect connect {};
+    connect.fd = socket(AF_INET, SOCK_STREAM, 0);
+    connect.addr = reinterpret_cast<sockaddr*>(&address);
+    connect.addrlen = length;
+    m_ring.prepare_operation<NetworkOperations>(connect);
+    m_ring.submit();
+
+    auto completion = m_ring.wait();
+    bool dispatched = false;
+    NetworkOperations::dispatch(completion.get(), Overloaded {
+        [&](op::Connect&, op::Connect::result_type result) {
+            dispatched = true;
+            ASSERT_EQ(ECONNREFUSED, result.error());
+        },
+        [&](op::Timeout&, op::Timeout::result_type) { FAIL(); },
+    });
+    m_ring.seen(completion);
+    ASSERT_TRUE(dispatched);
+
+    close(connect.fd);
+    close(unused);
+}
+
+TEST_F(OperationTests, should_expire_timeout)
+{
+    using TimerOperations = OperationSet<op::Timeout>;
+
+    op::Timeout timeout {};
+    timeout.ts.tv_nsec = 1'000'000;
+    m_ring.prepare_operation<TimerOperations>(timeout);
+    m_ring.submit();
+
+    auto completion = m_ring.wait();
+    ASSERT_EQ(ETIME, op::Timeout::result(completion.get()).error());
+    m_ring.seen(completion);
+}
@@ -0,0 +1,127 @@
+#include <poll.h>
+#include <unistd.h>
+
+#include <array>
+
+#include <gtest/gtest.h>
+
+#include "uringpp/uringpp.h"
+
+using namespace uringpp;
+
+class PollTests : public ::testing::Test {
+  protected:
+    PollTests()
+        : m_maxQueueEntries(4)
+        , m_pollUserData(std::make_shared<int>(1))
+        , m_userData(std::make_shared<int>(2))
+        , m_ring(m_maxQueueEntries)
+    {
+        if (pipe(m_pipe.data()) < 0) {
+            throw std::runtime_error("Failed to create pipe");
+        }
+    }
+
+    ~PollTests()
+    {
+        close(m_pipe[0]);
+        close(m_pipe[1]);
+    }
+
+    auto writeToPipe() -> void
+    {
+        const char byte = '!';
+        ASSERT_EQ(1, write(m_pipe[1], &byte, 1));
+    }
+
+    auto readFromPipe() -> void
+    {
+        char byte;
+        ASSERT_EQ(1, read(m_pipe[0], &byte, 1));
+    }
+
+  protected:
+    const std::size_t m_maxQueueEntries;
+    std::array<int, 2> m_pipe;
+    std::shared_ptr<int> m_pollUserData;
+    std::shared_ptr<int> m_userData;
+    Ring<int> m_ring;
+};
+
+TEST_F(PollTests, should_poll_with_event_mask)
+{
+    ASSERT_TRUE(m_ring.prepare_poll_add(m_pipe[1], POLLOUT, m_pollUserData));
+    m_ring.submit();
+
+    auto completion = m_ring.wait();
+    ASSERT_TRUE(completion.result() & POLLOUT);
+    ASSERT_FALSE(completion.has_more());
+    m_ring.seen(completion);
+}
+
+TEST_F(PollTests, should_post_multiple_completions_for_multishot_poll)
+{
+    ASSERT_TRUE(m_ring.prepare_poll_multishot(m_pipe[0], POLLIN, m_pollUserData));
+    m_ring.submit();
+
+    for (auto i = 0; i < 2; i++) {
+        writeToPipe();
+        auto completion = m_ring.wait();
+        ASSERT_EQ(1, *completion.userData());
+        ASSERT_TRUE(completion.result() & POLLIN);
+        ASSERT_TRUE(completion.has_more());
+        m_ring.seen(completion);
+        readFromPipe();
+    }
+}
+
+TEST_F(PollTests, should_remove_multishot_poll)
+{
+    m_ring.prepare_poll_multishot(m_pipe[0], POLLIN, m_pollUserData);
+    m_ring.prepare_poll_remove(m_pollUserData, m_userData);
+    m_ring.submit();
+
+    bool pollCanceled = false;
+    bool removeCompleted = false;
+    for (auto i = 0; i < 2; i++) {
+        auto completion = m_ring.wait();
+        if (*completion.userData() == 1) {
+            ASSERT_EQ(-ECANCELED, completion.result());
+            ASSERT_FALSE(completion.has_more());
+            pollCanceled = true;
+        } else {
+            ASSERT_EQ(0, completion.result());
+            removeCompleted = true;
+        }
+        m_ring.seen(completion);
+    }
+
+    ASSERT_TRUE(pollCanceled);
+    ASSERT_TRUE(removeCompleted);
+}
+
+TEST_F(PollTests, should_update_poll_event_mask)
+{
+    m_ring.prepare_poll_multishot(m_pipe[1], 0, m_pollUserData);
+    m_ring.submit();
+    m_ring.prepare_poll_update(
+        m_pollUserData,
+        m_pollUserData,
+        POLLOUT,
+        IORING_POLL_UPDATE_EVENTS | IORING_POLL_ADD_MULTI,
+        m_userData);
+    m_ring.submit();
+
+    bool writable = false;
+    bool updateCompleted = false;
+    while (!writable || !updateCompleted) {
+        auto completion = m_ring.wait();
+        if (*completion.userData() == 1) {
+            writable = completion.result() & POLLOUT;
+        } else {
+            ASSERT_EQ(0, completion.result());
+            updateCompleted = true;
+        }
+        m_ring.seen(completion);
+    }
+}
@@ -0,0 +1,285 @@
+#include <unistd.h>
+
+#include <cerrno>
+
+#include <array>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "uringpp/uringpp.h"
+
+using namespace uringpp;
+
+namespace {
+struct LinkedNop {
+    using result_type = Result<std::int32_t>;
+
+    bool link = false;
+
+    auto prepare(io_uring_sqe* sqe) const -> void
+    {
+        io_uring_prep_nop(sqe);
+        op::setLink(sqe, link);
+    }
+
+    static auto result(const io_uring_cqe* cqe) -> result_type
+    {
+        return result_type { cqe->res };
+    }
+};
+
+using LinkedNops = OperationSet<LinkedNop>;
+}
+
+class RingPolicyTests : public ::testing::Test {
+  protected:
+    RingPolicyTests()
+        : m_maxQueueEntries(1)
+        , m_userData(std::make_shared<int>(0))
+    {
+    }
+
+  protected:
+    const std::size_t m_maxQueueEntries;
+    std::shared_ptr<int> m_userData;
+};
+
+TEST_F(RingPolicyTests, should_count_ring_events)
+{
+    Ring<int, RingPolicy<policy::ThrowOnError, policy::FailWhenFull, policy::CountingInstrumentation>>
+        ring { m_maxQueueEntries };
+
+    ring.prepare_nop(m_userData);
+    ring.prepare_nop(m_userData);
+    ring.submit();
+    ring.seen(ring.wait());
+
+    ASSERT_EQ(1u, ring.instrumentation().preparedEntries);
+    ASSERT_EQ(1u, ring.instrumentation().sqFullEvents);
+    ASSERT_EQ(1u, ring.instrumentation().submits);
+    ASSERT_EQ(1u, ring.instrumentation().submittedEntries);
+    ASSERT_EQ(1u, ring.instrumentation().completedEntries);
+}
+
+TEST_F(RingPolicyTests, should_flush_when_submission_queue_is_full)
+{
+    Ring<int, RingPolicy<policy::ThrowOnError, policy::FlushWhenFull>> ring { m_maxQueueEntries };
+
+    ASSERT_TRUE(ring.prepare_nop(m_userData));
+    ASSERT_TRUE(ring.prepare_nop(m_userData));
+    ring.submit();
+    ring.seen(ring.wait());
+    ring.seen(ring.wait());
+}
+
+TEST_F(RingPolicyTests, should_count_submit_of_flush_when_full)
+{
+    Ring<int, RingPolicy<policy::ThrowOnError, policy::FlushWhenFull, policy::CountingInstrumentation>>
+        ring { m_maxQueueEntries };
+
+    ASSERT_TRUE(ring.prepare_nop(m_userData));
+    ASSERT_TRUE(ring.prepare_nop(m_userData));
+    ring.submit();
+    ring.seen(ring.wait());
+    ring.seen(ring.wait());
+
+    ASSERT_EQ(1u, ring.instrumentation().sqFullEvents);
+    ASSERT_EQ(2u, ring.instrumentation().submits);
+    ASSERT_EQ(2u, ring.instrumentation().submittedEntries);
+}
+
+TEST(ExpectedTests, should_hold_int_value_or_error)
+{
+    Expected<int> value = 5;
+    ASSERT_TRUE(value.has_value());
+    ASSERT_EQ(5, value.value());
+
+    auto failure = Expected<int>::failure(EBUSY);
+    ASSERT_FALSE(failure);
+    ASSERT_EQ(EBUSY, failure.error());
+}
+
+TEST(ExpectedTests, should_abort_on_value_of_error)
+{
+    auto failure = Expected<int>::failure(EBUSY);
+    ASSERT_DEATH(failure.value(), "Expected holds no value");
+}
+
+TEST_F(RingPolicyTests, should_return_number_of_submitted_entries_as_expected)
+{
+    Ring<int, RingPolicy<policy::ExpectedOnError>> ring { m_maxQueueEntries };
+
+    ring.prepare_nop(m_userData);
+    auto submitted = ring.submit();
+
+    ASSERT_TRUE(submitted.has_value());
+    ASSERT_EQ(1u, submitted.value());
+
+    auto completion = ring.wait();
+    ASSERT_TRUE(completion.has_value());
+    ring.seen(*completion);
+}
+
+TEST_F(RingPolicyTests, should_not_throw_on_fast_policy)
+{
+    Ring<int, FastRingPolicy> ring { m_maxQueueEntries };
+
+    ring.prepare_nop(m_userData);
+    ASSERT_EQ(1u, ring.submit());
+    ring.seen(ring.wait());
+}
+
+TEST_F(RingPolicyTests, should_never_fail_to_prepare_on_fast_policy)
+{
+    static_assert(!policy::SpinWhenFull::may_fail);
+    Ring<int, FastRingPolicy> ring { m_maxQueueEntries };
+
+    ASSERT_TRUE(ring.prepare_nop(m_userData));
+    ASSERT_TRUE(ring.prepare_nop(m_userData));
+    ring.submit();
+    ring.seen(ring.wait());
+    ring.seen(ring.wait());
+}
+
+TEST_F(RingPolicyTests, should_queue_commands_when_submission_queue_is_full)
+{
+    Ring<int, OverflowRingPolicy> ring { m_maxQueueEntries };
+
+    ASSERT_TRUE(ring.prepare_nop(m_userData));
+    ASSERT_TRUE(ring.prepare_nop(m_userData));
+    ASSERT_TRUE(ring.prepare_nop(m_userData));
+    ASSERT_EQ(2u, ring.sq_full_policy().pending());
+
+    std::size_t completed = 0;
+    while (completed < 3) {
+        ring.submit();
+        ring.seen(ring.wait());
+        completed++;
+    }
+    ASSERT_EQ(0u, ring.sq_full_policy().pending());
+}
+
+TEST_F(RingPolicyTests, should_move_queued_chain_into_submission_queue_as_a_whole)
+{
+    Ring<int, OverflowRingPolicy> ring { 2 };
+    LinkedNop nop;
+    LinkedNop link { .link = true };
+
+    ASSERT_TRUE(ring.prepare_operation<LinkedNops>(nop));
+    ASSERT_TRUE(ring.prepare_operation<LinkedNops>(nop));
+    ASSERT_TRUE(ring.prepare_operation<LinkedNops>(nop));
+    ASSERT_TRUE(ring.prepare_operation<LinkedNops>(link));
+    ASSERT_TRUE(ring.prepare_operation<LinkedNops>(nop));
+    ASSERT_EQ(3u, ring.sq_full_policy().pending());
+
+    // Only the unlinked command fits behind the submit, the chain waits for the next
+    ring.submit();
+    ASSERT_EQ(2u, ring.sq_full_policy().pending());
+    ASSERT_EQ(1u, ring.submit());
+    ASSERT_EQ(0u, ring.sq_full_policy().pending());
+    ASSERT_EQ(2u, ring.submit());
+
+    for (int i = 0; i < 5; i++) {
+        auto completion = ring.wait();
+        ASSERT_EQ(0, completion.result());
+        ring.seen(completion);
+    }
+}
+
+TEST_F(RingPolicyTests, should_reject_chain_which_would_be_split_from_the_submission_queue)
+{
+    Ring<int, OverflowRingPolicy> ring { 2 };
+    LinkedNop nop;
+    LinkedNop link { .link = true };
+
+    ASSERT_TRUE(ring.prepare_operation<LinkedNops>(nop));
+    ASSERT_TRUE(ring.prepare_operation<LinkedNops>(link));
+    ASSERT_THROW(ring.prepare_operation<LinkedNops>(nop), std::runtime_error);
+}
+
+TEST_F(RingPolicyTests, should_signal_backpressure_at_watermarks)
+{
+    Ring<int, OverflowRingPolicy> ring { m_maxQueueEntries };
+    std::vector<bool> transitions;
+    ring.sq_full_policy().set_watermarks(2, 0);
+    ring.sq_full_policy().on_backpressure(
+        [&transitions](bool backpressured) { transitions.push_back(backpressured); });
+
+    ring.prepare_nop(m_userData);
+    ring.prepare_nop(m_userData);
+    ASSERT_FALSE(ring.sq_full_policy().backpressured());
+    ring.prepare_nop(m_userData);
+    ASSERT_TRUE(ring.sq_full_policy().backpressured());
+
+    for (auto i = 0; i < 3; i++) {
+        ring.submit();
+        ring.seen(ring.wait());
+    }
+
+    ASSERT_FALSE(ring.sq_full_policy().backpressured());
+    ASSERT_EQ((std::vector<bool> { true, false }), transitions);
+}
+
+TEST_F(RingPolicyTests, should_keep_iovec_of_queued_readv_valid)
+{
+    Ring<int, OverflowRingPolicy> ring { m_maxQueueEntries };
+    std::array<int, 2> pipeFds;
+    ASSERT_EQ(0, pipe(pipeFds.data()));
+    std::string message = "uringpp";
+    ASSERT_EQ(static_cast<ssize_t>(message.size()), write(pipeFds[1], message.data(), message.size()));
+    std::vector<std::uint8_t> buffer(message.size());
+
+    ring.prepare_nop(m_userData);
+    ring.prepare_readv(pipeFds[0], buffer, 0, m_userData);
+    ring.submit();
+    ring.seen(ring.wait());
+    ring.submit();
+    auto completion = ring.wait();
+    ASSERT_EQ(static_cast<std::int32_t>(message.size()), completion.result());
+    ring.seen(completion);
+
+    ASSERT_EQ(message, std::string(buffer.begin(), buffer.end()));
+    close(pipeFds[0]);
+    close(pipeFds[1]);
+}
+
+TEST_F(RingPolicyTests, should_trace_ring_events_as_chrome_trace)
+{
+    Ring<int, RingPolicy<policy::ThrowOnError, policy::FailWhenFull, policy::TracingInstrumentation>>
+        ring { m_maxQueueEntries };
+
+    Tracer::clear();
+    Tracer::enable();
+    ring.prepare_nop(m_userData);
+    ring.submit();
+    ring.seen(ring.wait());
+    Tracer::disable();
+
+    std::ostringstream trace;
+    Tracer::write_chrome_trace(trace);
+
+    ASSERT_NE(std::string::npos, trace.str().find("\"name\":\"NOP\",\"cat\":\"sqe\",\"ph\":\"b\""));
+    ASSERT_NE(std::string::npos, trace.str().find("\"name\":\"NOP\",\"cat\":\"sqe\",\"ph\":\"e\""));
+    ASSERT_NE(std::string::npos, trace.str().find("\"name\":\"submit\""));
+    ASSERT_NE(std::string::npos, trace.str().find("\"name\":\"wait\""));
+    ASSERT_NE(std::string::npos, trace.str().find("\"name\":\"handle\""));
+}
+
+TEST_F(RingPolicyTests, should_not_trace_when_tracing_is_disabled)
+{
+    Ring<int, RingPolicy<policy::ThrowOnError, policy::FailWhenFull, policy::TracingInstrumentation>>
+        ring { m_maxQueueEntries };
+
+    Tracer::clear();
+    ring.prepare_nop(m_userData);
+    ring.submit();
+    ring.seen(ring.wait());
+
+    std::ostringstream trace;
+    Tracer::write_chrome_trace(trace);
+
+    ASSERT_EQ(std::string::npos, trace.str().find("\"ph\""));
+}
@@ -1,11 +1,22 @@
 #pragma once
 
 #include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
 #include <filesystem>
 #include <fstream>
+#include <iterator>
+#include <span>
+#include <stdexcept>
 #include <stdio.h>
+#include <string>
+#include <string_view>
 #include <vector>
 
+#include <gtest/gtest.h>
+
 inline auto getFileDescriptor(const std::filesystem::path& file) -> int
 {
     auto fd = open(file.c_str(), O_RDWR);
@@ -27,3 +38,102 @@ inline auto readFile(const std::filesystem::path& path) -> std::vector<std::uint
 
     return fileContent;
 }
+
+/*
+ * Returns the whole content of the file, newlines included
+ */
+inline auto readText(const std::filesystem::path& path) -> std::string
+{
+    std::ifstream stream(path, std::ios::binary);
+    return { std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>() };
+}
+
+inline auto bytes(std::string_view text) -> std::span<const std::uint8_t>
+{
+    return { reinterpret_cast<const std::uint8_t*>(text.data()), text.size() };
+}
+
+inline auto text(std::span<const std::uint8_t> data) -> std::string
+{
+    return { reinterpret_cast<const char*>(data.data()), data.size() };
+}
+
+/*
+ * Fixture of tests which work on files, provides an empty directory which is
+ * removed with its content after the test
+ */
+class TemporaryDirectoryTest : public ::testing::Test {
+  protected:
+    explicit TemporaryDirectoryTest(const std::string& name)
+        : m_directory(std::filesystem::temp_directory_path() / name)
+    {
+        std::filesystem::remove_all(m_directory);
+        std::filesystem::create_directories(m_directory);
+    }
+
+    ~TemporaryDirectoryTest()
+    {
+        std::filesystem::remove_all(m_directory);
+    }
+
+  protected:
+    std::filesystem::path m_directory;
+};
+
+inline auto listenOnLoopback() -> int
+{
+    auto fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0
+        || listen(fd, 16) < 0) {
+        throw std::runtime_error("Failed to listen on loopback");
+    }
+    return fd;
+}
+
+inline auto addressOf(int fd) -> sockaddr_in
+{
+    sockaddr_in address {};
+    socklen_t length = sizeof(address);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length);
+    return address;
+}
+
+inline auto connectTo(int listenFd) -> int
+{
+    auto address = addressOf(listenFd);
+    auto fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        throw std::runtime_error("Failed to connect");
+    }
+    return fd;
+}
+
+/*
+ * Writes all data to the socket, stops early if the peer went away
+ */
+inline auto writeAll(int fd, std::string_view data) -> void
+{
+    for (std::size_t written = 0; written < data.size();) {
+        auto result = write(fd, data.data() + written, data.size() - written);
+        if (result <= 0) {
+            return;
+        }
+        written += result;
+    }
+}
+
+/*
+ * Reads from the socket until the peer shut its sending side down
+ */
+inline auto readAll(int fd) -> std::string
+{
+    std::string data;
+    char buffer[4096];
+    for (ssize_t result; (result = read(fd, buffer, sizeof(buffer))) > 0;) {
+        data.append(buffer, result);
+    }
+    return data;
+}
@@ -0,0 +1,68 @@
+#include <chrono>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "uringpp/uringpp.h"
+
+using namespace uringpp;
+
+class WaitStrategyTests : public ::testing::Test {
+  protected:
+    WaitStrategyTests()
+        : m_maxQueueEntries(1)
+        , m_userData(std::make_shared<int>(0))
+        , m_ring(m_maxQueueEntries)
+    {
+    }
+
+  protected:
+    const std::size_t m_maxQueueEntries;
+    std::shared_ptr<int> m_userData;
+    Ring<int> m_ring;
+};
+
+TEST_F(WaitStrategyTests, should_wait_blocking)
+{
+    BlockingWait strategy;
+    m_ring.prepare_nop(m_userData);
+    m_ring.submit();
+    auto completion = m_ring.wait(strategy);
+    ASSERT_EQ(0, completion.result());
+    m_ring.seen(completion);
+}
+
+TEST_F(WaitStrategyTests, should_find_completion_while_spinning)
+{
+    SpinThenBlockWait strategy { 1000 };
+    m_ring.prepare_nop(m_userData);
+    m_ring.submit();
+    auto completion = m_ring.wait(strategy);
+    ASSERT_EQ(0, completion.result());
+    m_ring.seen(completion);
+}
+
+TEST_F(WaitStrategyTests, should_fall_back_to_blocking_wait_after_spin_budget)
+{
+    SpinThenBlockWait strategy { 0 };
+    m_ring.prepare_nop(m_userData);
+    m_ring.submit();
+    auto completion = m_ring.wait(strategy);
+    ASSERT_EQ(0, completion.result());
+    m_ring.seen(completion);
+}
+
+TEST_F(WaitStrategyTests, should_stop_adaptive_spinning_for_rare_completions)
+{
+    AdaptiveSpinWait strategy { std::chrono::microseconds(10), std::chrono::microseconds(1) };
+    ASSERT_NE(0, strategy.budget().count());
+
+    for (auto i = 0; i < 32; i++) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        m_ring.prepare_nop(m_userData);
+        m_ring.submit();
+        m_ring.seen(m_ring.wait(strategy));
+    }
+
+    ASSERT_EQ(0, strategy.budget().count());
+}